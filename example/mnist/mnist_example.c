@@ -1,6 +1,5 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <stdint.h>
 #include <time.h>
 
 #include "util.h"
@@ -9,6 +8,8 @@
 #include "loss.h"
 #include "random.h"
 #include "data.h"
+#include "dataset.h"
+#include "cache.h"
 
 // the number of data
 #define TRAIN_DATA_NUM 60000
@@ -20,196 +21,38 @@
 // the number of classes
 #define CLASS_NUM 10
 
-// load MNIST label data: "***-labels-idx1-ubyte"
-float **load_mnist_labels(const char *filename, float **labels, const int num)
+// open MNIST images and labels through a cache of normalized samples next to the image file:
+// "***-images-idx3-ubyte" and "***-labels-idx1-ubyte", or their ".gz" files,
+// the cache is built at the first run and mapped into memory at the following runs
+Dataset *open_mnist(const char *label_filename, const char *image_filename, const int num)
 {
-    FILE *fp = fopen(filename, "rb");
-    if (fp == NULL) {
-        fprintf(stderr, "failed to open file: %s\n", filename);
-    }
-
-    // check magic number
-    int32_t magic_number = 0;
-    for (int i = 0; i < 4; i++) {
-        uint8_t byte;
-        fread(&byte, sizeof(uint8_t), 1, fp);
-        magic_number = (magic_number << 8) | byte;
-    }
-    if (magic_number != 2049) {
-        fprintf(stderr, "magic number %d mismatch to 2049d\n", magic_number);
-        goto FCLOSE;
-    }
-
-    // check the number of data
-    int32_t num_data = 0;
-    for (int i = 0; i < 4; i++) {
-        uint8_t byte;
-        fread(&byte, sizeof(uint8_t), 1, fp);
-        num_data = (num_data << 8) | byte;
-    }
-    if (num_data != num) {
-        fprintf(stderr, "the number of items %d mismatch to %d\n", num_data, num);
-        goto FCLOSE;
-    }
-
-    // get labels
-    for (int i = 0; i < num_data; i++) {
-        uint8_t label;
-        fread(&label, sizeof(uint8_t), 1, fp);
-        // convert as one-hot vector
-        for (int j = 0; j < CLASS_NUM; j++) {
-            labels[i][j] = (j == label) ? 1.0f : 0.0f;
-        }
-    }
-
-    return labels;
-
-FCLOSE:
-    fclose(fp);
-
-    return NULL;
-}
-
-// load MNIST image data: "***-images-idx3-ubyte"
-float **load_mnist_images(const char *filename, float **images, const int num)
-{
-    FILE *fp = fopen(filename, "rb");
-    if (fp == NULL) {
-        fprintf(stderr, "failed to open file: %s\n", filename);
-        goto FCLOSE;
-    }
-
-    // check magic number
-    int32_t magic_number = 0;
-    for (int i = 0; i < 4; i++) {
-        uint8_t byte;
-        fread(&byte, sizeof(uint8_t), 1, fp);
-        magic_number = (magic_number << 8) | byte;
-    }
-    if (magic_number != 2051) {
-        fprintf(stderr, "magic number %d mismatch to 2051\n", magic_number);
-        goto FCLOSE;
-    }
-
-    // check the number of data
-    int32_t num_data = 0;
-    for (int i = 0; i < 4; i++) {
-        uint8_t byte;
-        fread(&byte, sizeof(uint8_t), 1, fp);
-        num_data = (num_data << 8) | byte;
-    }
-    if (num_data != num) {
-        fprintf(stderr, "the number of items %d mismatch to %d\n", num_data, num);
-        goto FCLOSE;
-    }
-
-    // get rows and cols (28x28)
-    int32_t num_rows = 0;
-    for (int i = 0; i < 4; i++) {
-        uint8_t byte;
-        fread(&byte, sizeof(uint8_t), 1, fp);
-        num_rows = (num_rows << 8) | byte;
-    }
-    if (num_rows != DATA_SIZE) {
-        fprintf(stderr, "number of rows %d mismatch to 28\n", num_rows);
-        goto FCLOSE;
-    }
-    int32_t num_cols = 0;
-    for (int i = 0; i < 4; i++) {
-        uint8_t byte;
-        fread(&byte, sizeof(uint8_t), 1, fp);
-        num_cols = (num_cols << 8) | byte;
-    }
-    if (num_cols != DATA_SIZE) {
-        fprintf(stderr, "number of columns %d mismatch to 28\n", num_cols);
-        goto FCLOSE;
-    }
-
-    // get pixels as vector
-    for (int i = 0; i < num_data; i++) {
-        for (int j = 0; j < (DATA_SIZE * DATA_SIZE); j++) {
-            uint8_t pixel;
-            fread(&pixel, sizeof(uint8_t), 1, fp);
-            // normalize to [0,1]
-            images[i][j] = (float)pixel / 255;
-        }
-    }
-
-    return images;
-
-FCLOSE:
-    fclose(fp);
-
-    return NULL;
-}
-
-float **load_mnist_train_labels(const char *filename)
-{
-    // allocate memory for dataset
-    float **train_labels = malloc(sizeof(float*) * TRAIN_DATA_NUM);
-    if (train_labels == NULL) {
+    char cache_filename[FILENAME_MAX];
+    if (snprintf(cache_filename, sizeof(cache_filename), "%s.cache", image_filename) >= (int)sizeof(cache_filename)) {
+        fprintf(stderr, "too long path: %s\n", image_filename);
         return NULL;
     }
-    for (int i = 0; i < TRAIN_DATA_NUM; i++) {
-        train_labels[i] = malloc(sizeof(float) * CLASS_NUM);
-        if (train_labels[i] == NULL) {
-            return NULL;
-        }
-    }
-
-    return load_mnist_labels(filename, train_labels, TRAIN_DATA_NUM);
-}
 
-float **load_mnist_train_images(const char *filename)
-{
-    // allocate memory for dataset
-    float **train_images = malloc(sizeof(float*) * TRAIN_DATA_NUM);
-    if (train_images == NULL) {
+    Dataset *dataset = dataset_cache_load(cache_filename, image_filename, label_filename, CLASS_NUM);
+    if (dataset == NULL) {
+        fprintf(stderr, "failed to open data files: %s, %s\n", image_filename, label_filename);
         return NULL;
     }
-    for (int i = 0; i < TRAIN_DATA_NUM; i++) {
-        train_images[i] = malloc(sizeof(float) * DATA_SIZE * DATA_SIZE);
-        if (train_images[i] == NULL) {
-            return NULL;
-        }
-    }
 
-    return load_mnist_images(filename, train_images, TRAIN_DATA_NUM);
-}
-
-float **load_mnist_test_labels(const char *filename)
-{
-    // allocate memory for dataset
-    float **test_labels  = malloc(sizeof(float*) * TEST_DATA_NUM);
-    if (test_labels == NULL) {
+    // check the number of data and the size of images (28x28)
+    CacheHeader header;
+    if ((dataset_cache_read_header(cache_filename, &header) != 0) ||
+        (header.n_dims != 2) || (header.dims[0] != DATA_SIZE) || (header.dims[1] != DATA_SIZE)) {
+        fprintf(stderr, "size of images mismatch to %dx%d\n", DATA_SIZE, DATA_SIZE);
+        dataset_free(&dataset);
         return NULL;
     }
-    for (int i = 0; i < TEST_DATA_NUM; i++) {
-        test_labels[i] = malloc(sizeof(float) * CLASS_NUM);
-        if (test_labels[i] == NULL) {
-            return NULL;
-        }
-    }
-
-    return load_mnist_labels(filename, test_labels, TEST_DATA_NUM);
-}
-
-float **load_mnist_test_images(const char *filename)
-{
-    // allocate memory for dataset
-    float **test_images  = malloc(sizeof(float*) * TEST_DATA_NUM);
-    if (test_images == NULL) {
+    if (dataset->size != num) {
+        fprintf(stderr, "the number of items %d mismatch to %d\n", dataset->size, num);
+        dataset_free(&dataset);
         return NULL;
     }
 
-    for (int i = 0; i < TEST_DATA_NUM; i++) {
-        test_images[i] = malloc(sizeof(float) * DATA_SIZE * DATA_SIZE);
-        if (test_images[i] == NULL) {
-            return NULL;
-        }
-    }
-
-    return load_mnist_images(filename, test_images, TEST_DATA_NUM);
+    return dataset;
 }
 
 int main(int argc, char *argv[])
@@ -220,13 +63,10 @@ int main(int argc, char *argv[])
         exit(EXIT_FAILURE);
     }
 
-    // load dataset to allocated memory
-    float **train_labels = load_mnist_train_labels(argv[1]);
-    float **train_images = load_mnist_train_images(argv[2]);
-    float **test_labels  = load_mnist_test_labels(argv[3]);
-    float **test_images  = load_mnist_test_images(argv[4]);
-    if ((train_labels == NULL) || (train_images == NULL) ||
-        (test_labels == NULL)  || (test_images == NULL)) {
+    // map caches into memory
+    Dataset *train_data = open_mnist(argv[1], argv[2], TRAIN_DATA_NUM);
+    Dataset *test_data  = open_mnist(argv[3], argv[4], TEST_DATA_NUM);
+    if ((train_data == NULL) || (test_data == NULL)) {
         goto FREE_MEMORY;
     }
 
@@ -246,41 +86,36 @@ int main(int argc, char *argv[])
 
     net_init_layer_params(net);
 
+    // fuse successive layers into single passes
+    net_optimize(net);
+
     // training
     printf("start training ...\n");
 
-    train_sgd(
+    Optimizer *optimizer = optimizer_create(
+        net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_SGD, .learning_rate=0.1)
+    );
+
+    train_dataset(
         net,
-        train_images,
-        train_labels,
-        test_images,
-        test_labels,
-        0.1,
-        20,
-        TRAIN_DATA_NUM,
-        TEST_DATA_NUM,
-        cross_entropy_loss
+        train_data,
+        test_data,
+        SET_TRAIN_PARAM(.epoch=20, .optimizer=optimizer, .loss_func=cross_entropy_loss, .prefetch=2)
     );
 
+    optimizer_free(&optimizer);
+
     printf("finished\n");
 
+    // available if built with NNC_PROFILE
+    net_profile_report(net, stdout, PROFILE_FORMAT_TABLE);
+
     net_free(&net);
 
 FREE_MEMORY:
     // free memory
-    for (int i = 0; i < TRAIN_DATA_NUM; i++) {
-        FREE_WITH_NULL(&train_labels[i]);
-        FREE_WITH_NULL(&train_images[i]);
-    }
-    for (int i = 0; i < TEST_DATA_NUM; i++) {
-        FREE_WITH_NULL(&test_labels[i]);
-        FREE_WITH_NULL(&test_images[i]);
-    }
-
-    FREE_WITH_NULL(&train_labels);
-    FREE_WITH_NULL(&train_images);
-    FREE_WITH_NULL(&test_labels);
-    FREE_WITH_NULL(&test_images);
+    dataset_free(&train_data);
+    dataset_free(&test_data);
 
     return EXIT_SUCCESS;
 }
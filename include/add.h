@@ -0,0 +1,19 @@
+/**
+ * @file add.h
+ * @brief Add layer
+ * 
+ */
+#ifndef ADD_H
+#define ADD_H
+
+#include "layer.h"
+
+/**
+ * @brief allocate Add layer, which sums up multiple inputs of the same size
+ * 
+ * @param[in] layer_param layer parameter, .in: size of each input, .n_in: num of inputs
+ * @return Layer* pointer to layer structure
+ */
+Layer *add_layer(const LayerParameter layer_param);
+
+#endif // ADD_H
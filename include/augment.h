@@ -0,0 +1,95 @@
+/**
+ * @file augment.h
+ * @brief random geometric augmentation of image batches
+ * 
+ */
+#ifndef AUGMENT_H
+#define AUGMENT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "thread_pool.h"
+
+/**
+ * @brief augmentation parameter structure
+ * 
+ */
+typedef struct AugmentParameter {
+    int channels;       //!< num of channels of a sample, 1 if 0
+    int height;         //!< height of a sample
+    int width;          //!< width of a sample
+    int max_shift;      //!< max translation along each axis [pixel]
+    float min_crop;     //!< min ratio of side of a random crop resized to the sample, not cropped if 0 or 1
+    float max_rotation; //!< max rotation around the center [degree]
+    bool flip;          //!< flip horizontally with probability of 0.5
+    float fill;         //!< value of pixels sampled from outside of the source
+    uint32_t seed;      //!< seed of random streams
+    int n_threads;      //!< num of worker threads, samples are augmented by the caller if 0 or 1
+} AugmentParameter;
+
+/**
+ * @brief macro to set AugmentParameter
+ * 
+ */
+#define SET_AUGMENT_PARAM(...) (AugmentParameter){ __VA_ARGS__ }
+
+/**
+ * @brief range of a batch augmented by a worker thread
+ * 
+ */
+typedef struct AugmentTask {
+    const struct Augmenter *augmenter;  //!< parent augmenter
+    float *x;           //!< samples of the range
+    int size;           //!< num of samples of the range
+    uint64_t position;  //!< position of the first sample in epoch
+    int epoch;          //!< index of epoch
+    float *scratch;     //!< copy of a source sample
+} AugmentTask;
+
+/**
+ * @struct
+ * @brief augmenter structure
+ * 
+ */
+typedef struct Augmenter {
+    AugmentParameter param; //!< augmentation parameter
+    int x_size;             //!< num of elements of a sample
+    ThreadPool *pool;       //!< worker threads, NULL if samples are augmented by the caller
+    int n_tasks;            //!< num of ranges a batch is split into
+    AugmentTask *tasks;     //!< ranges of the batch in use
+    float *scratch;         //!< copies of source samples, x_size elements per task
+} Augmenter;
+
+/**
+ * @brief create augmenter and start its worker threads
+ * 
+ * @param[in] param augmentation parameter
+ * @return Augmenter* pointer to augmenter, NULL if parameter is invalid
+ */
+Augmenter *augmenter_create(const AugmentParameter param);
+
+/**
+ * @brief augment samples of a batch in place
+ * @note each sample is shifted, cropped, rotated and flipped by a random affine transform
+ *       and resampled bilinearly, random values of a sample are drawn from its own stream
+ *       derived from the seed, epoch and position of the sample, so results are
+ *       reproducible regardless of the num of threads and the size of batches,
+ *       an augmenter augments one batch at a time
+ * 
+ * @param[in,out] augmenter target augmenter
+ * @param[in,out] x samples in CHW order, size x x_size elements
+ * @param[in] size num of samples
+ * @param[in] epoch index of epoch
+ * @param[in] position position of the first sample in epoch
+ */
+void augment_batch(Augmenter *augmenter, float *x, const int size, const int epoch, const uint64_t position);
+
+/**
+ * @brief stop worker threads and deallocate augmenter
+ * 
+ * @param[in,out] augmenter augmenter to be deallocated
+ */
+void augmenter_free(Augmenter **augmenter);
+
+#endif // AUGMENT_H
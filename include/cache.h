@@ -0,0 +1,103 @@
+/**
+ * @file cache.h
+ * @brief binary cache of preprocessed dataset mapped into memory
+ * 
+ */
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdint.h>
+
+#include "dataset.h"
+#include "idx.h"
+
+/**
+ * @brief magic number at the beginning of cache file
+ * 
+ */
+#define CACHE_MAGIC "NNCCACHE"
+
+/**
+ * @brief version of cache format, caches of other versions are rejected
+ * 
+ */
+#define CACHE_VERSION 1
+
+/**
+ * @brief marker of byte order of cache file, written in native byte order
+ * 
+ */
+#define CACHE_BYTE_ORDER 0x01020304
+
+/**
+ * @struct
+ * @brief header of cache file
+ * @note the header is followed by the sample matrix and the labels,
+ *       both of which begin at offsets aligned to DATA_ALIGN,
+ *       values are in native byte order of the machine which built the cache
+ * 
+ */
+typedef struct CacheHeader {
+    char magic[8];          //!< CACHE_MAGIC without null terminator
+    uint32_t version;       //!< CACHE_VERSION
+    uint32_t byte_order;    //!< CACHE_BYTE_ORDER
+    uint32_t x_type;        //!< element type of samples, IDX_TYPE_FLOAT
+    uint32_t t_type;        //!< element type of labels, IDX_TYPE_UBYTE for class indices, IDX_TYPE_FLOAT for label vectors
+    int32_t size;           //!< num of samples
+    int32_t x_size;         //!< num of elements of a sample
+    int32_t t_size;         //!< num of classes, or num of elements of a label vector
+    int32_t n_dims;         //!< num of dimensions of a sample
+    int32_t dims[IDX_MAX_DIMS]; //!< size of each dimension of a sample
+    uint64_t x_offset;      //!< offset of sample matrix [byte]
+    uint64_t t_offset;      //!< offset of labels [byte]
+    uint64_t file_size;     //!< size of cache file [byte]
+} CacheHeader;
+
+/**
+ * @brief write samples and labels of dataset into cache file
+ * @note samples are converted to floats as they are gathered, labels are kept as class indices
+ *       if the dataset has them, the cache is written into a temporary file next to it
+ *       and renamed, so an existing cache is replaced atomically
+ * 
+ * @param[in] dataset source dataset
+ * @param[in] n_dims num of dimensions of a sample, 1 dimension of x_size if 0
+ * @param[in] dims size of each dimension of a sample, whose product must be x_size, NULL if n_dims is 0
+ * @param[in] filename path to cache file
+ * @return int 0 if succeeded, -1 if failed
+ */
+int dataset_cache_build(const Dataset *dataset, const int n_dims, const int *dims, const char *filename);
+
+/**
+ * @brief read and validate header of cache file
+ * 
+ * @param[in] filename path to cache file
+ * @param[out] header header of cache file
+ * @return int 0 if succeeded, -1 if the file is not a valid cache
+ */
+int dataset_cache_read_header(const char *filename, CacheHeader *header);
+
+/**
+ * @brief map cache file into memory as a dataset without copy
+ * @note samples and labels are read-only, rows are accessible through xs
+ *       and ts unless labels are class indices
+ * 
+ * @param[in] filename path to cache file
+ * @return Dataset* pointer to dataset, deallocated with dataset_free(), NULL if failed
+ */
+Dataset *dataset_cache_open(const char *filename);
+
+/**
+ * @brief open cache of IDX files of byte images and labels, building it if needed
+ * @note the cache is built with samples normalized to [0, 1] and class labels
+ *       if it does not exist, is invalid, or is older than either of the IDX files,
+ *       which are read only then, and the cache is used alone if they are removed
+ * 
+ * @param[in] filename path to cache file
+ * @param[in] images path to IDX file of images, unsigned bytes
+ * @param[in] labels path to IDX file of labels, unsigned bytes of 1 dimension
+ * @param[in] n_classes num of classes, larger than every label
+ * @return Dataset* pointer to dataset, deallocated with dataset_free(), NULL if failed
+ */
+Dataset *dataset_cache_load(const char *filename, const char *images, const char *labels, const int n_classes);
+
+#endif // CACHE_H
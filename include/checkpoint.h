@@ -0,0 +1,207 @@
+/**
+ * @file checkpoint.h
+ * @brief binary checkpoint of network topology and parameters
+ * 
+ */
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "net.h"
+#include "optimizer.h"
+
+/**
+ * @brief magic number at the beginning of checkpoint file
+ * 
+ */
+#define CHECKPOINT_MAGIC "NNCMODEL"
+
+/**
+ * @brief version of checkpoint format, checkpoints of other versions are rejected
+ * 
+ */
+#define CHECKPOINT_VERSION 3
+
+/**
+ * @brief marker of byte order of checkpoint file, written in native byte order
+ * 
+ */
+#define CHECKPOINT_BYTE_ORDER 0x01020304
+
+/**
+ * @brief alignment of parameter blobs in checkpoint file [byte]
+ * 
+ */
+#define CHECKPOINT_ALIGN 64
+
+/**
+ * @struct
+ * @brief header of checkpoint file
+ * @note the header is followed by n_layers records of CheckpointLayer in order of layer ID,
+ *       and then blobs of layers at offsets aligned to CHECKPOINT_ALIGN,
+ *       values are in native byte order of the machine which wrote the checkpoint
+ * 
+ */
+typedef struct CheckpointHeader {
+    char magic[8];          //!< CHECKPOINT_MAGIC without null terminator
+    uint32_t version;       //!< CHECKPOINT_VERSION
+    uint32_t byte_order;    //!< CHECKPOINT_BYTE_ORDER
+    int32_t n_layers;       //!< num of layers
+    uint32_t layer_size;    //!< size of a layer record [byte]
+    uint64_t file_size;     //!< size of checkpoint file [byte]
+    int32_t has_optimizer;  //!< 1 if state of optimizer is written, 0 otherwise
+    OptimizerParameter optimizer;   //!< parameter of optimizer, zeros if has_optimizer is 0
+    int64_t step;           //!< num of update steps of optimizer
+} CheckpointHeader;
+
+/**
+ * @brief blob of a layer in checkpoint file, in order of layout
+ * 
+ */
+typedef enum CheckpointBlob {
+    CHECKPOINT_BLOB_W,      //!< weights
+    CHECKPOINT_BLOB_B,      //!< biases
+    CHECKPOINT_BLOB_MW,     //!< 1st moment (or velocity) of weights
+    CHECKPOINT_BLOB_VW,     //!< 2nd moment of weights
+    CHECKPOINT_BLOB_MB,     //!< 1st moment (or velocity) of biases
+    CHECKPOINT_BLOB_VB,     //!< 2nd moment of biases
+    CHECKPOINT_N_BLOBS      //!< num of blobs of a layer
+} CheckpointBlob;
+
+/**
+ * @brief record of a layer in checkpoint file
+ * @note blobs of weights and their moments have w_size elements,
+ *       and blobs of biases and their moments have b_size elements
+ * 
+ */
+typedef struct CheckpointLayer {
+    int32_t type;                       //!< LayerType
+    int32_t n_in;                       //!< num of inputs
+    int32_t in_ids[LAYER_IN_MAX];       //!< IDs of input layers, -1 for network input
+    int32_t in_ports[LAYER_IN_MAX];     //!< output ports of input layers
+    LayerParameter param;               //!< parameter given at allocation
+    int32_t w_size;                     //!< num of weights
+    int32_t b_size;                     //!< num of biases
+    uint64_t offsets[CHECKPOINT_N_BLOBS];   //!< offset of each blob [byte], 0 if the layer does not have it
+} CheckpointLayer;
+
+/**
+ * @struct
+ * @brief checkpointer writing snapshots of training in background
+ * 
+ */
+typedef struct Checkpointer {
+    char *filename;             //!< path to checkpoint file
+
+    CheckpointHeader header;    //!< header of snapshot
+    CheckpointLayer *records;   //!< records of layers of snapshot
+    const float **blobs;        //!< blobs of layers in arena, CHECKPOINT_N_BLOBS per layer, NULL if absent
+    int capacity;               //!< num of layers records and blobs are allocated for
+    float *arena;               //!< copies of parameters and optimizer state
+    size_t arena_size;          //!< num of elements of arena
+
+    bool pending;               //!< snapshot is taken and not written yet
+    bool failed;                //!< a write failed since the last checkpointer_wait()
+    bool stop;                  //!< flag to stop writer thread
+    int written;                //!< num of checkpoints written
+
+    pthread_t thread;           //!< writer thread
+    pthread_mutex_t lock;       //!< lock for the state
+    pthread_cond_t cond;        //!< signaled when the state changes
+} Checkpointer;
+
+/**
+ * @brief write topology and parameters of network into checkpoint file
+ * @note the checkpoint is written into a temporary file next to it and renamed,
+ *       so an existing checkpoint is replaced atomically,
+ *       layers with custom types (LAYER_TYPE_NONE) cannot be written
+ * 
+ * @param[in] net target network
+ * @param[in] filename path to checkpoint file
+ * @return int 0 if succeeded, -1 if failed
+ */
+int net_save(const Net *net, const char *filename);
+
+/**
+ * @brief write network and state of optimizer into checkpoint file
+ * @note same as net_save() with moments and the step count of the optimizer,
+ *       so that training is resumed exactly from the checkpoint
+ * 
+ * @param[in] net target network
+ * @param[in] optimizer optimizer of the network, state is not written if NULL
+ * @param[in] filename path to checkpoint file
+ * @return int 0 if succeeded, -1 if failed
+ */
+int net_save_with_optimizer(const Net *net, const Optimizer *optimizer, const char *filename);
+
+/**
+ * @brief create network from checkpoint file with copies of parameters
+ * 
+ * @param[in] filename path to checkpoint file
+ * @return Net* pointer to network, NULL if failed
+ */
+Net *net_load(const char *filename);
+
+/**
+ * @brief create network from checkpoint file mapped into memory
+ * @note weights and biases of layers point into the mapping without copy,
+ *       so pages are read on demand at the first propagations,
+ *       the parameters are read-only and the network is for inference,
+ *       the mapping is released by net_free()
+ * 
+ * @param[in] filename path to checkpoint file
+ * @return Net* pointer to network, NULL if failed
+ */
+Net *net_load_mmap(const char *filename);
+
+/**
+ * @brief create optimizer of network with state restored from checkpoint file
+ * @note the network must have the topology of the checkpoint, e.g. loaded by net_load()
+ * 
+ * @param[in] net target network
+ * @param[in] filename path to checkpoint file written with state of optimizer
+ * @return Optimizer* pointer to optimizer, NULL if failed
+ */
+Optimizer *optimizer_load(const Net *net, const char *filename);
+
+/**
+ * @brief create checkpointer and start its writer thread
+ * 
+ * @param[in] filename path to checkpoint file, replaced by each checkpoint
+ * @return Checkpointer* pointer to checkpointer, NULL if failed
+ */
+Checkpointer *checkpointer_create(const char *filename);
+
+/**
+ * @brief take snapshot of network and optimizer to be written in background
+ * @note parameters and moments are copied into the arena of the checkpointer,
+ *       so training continues while the writer thread writes the checkpoint
+ *       as net_save_with_optimizer() does, blocks only until the previous snapshot is written
+ * 
+ * @param[in,out] checkpointer target checkpointer
+ * @param[in] net target network
+ * @param[in] optimizer optimizer of the network, state is not written if NULL
+ * @return int 0 if succeeded, -1 if the snapshot cannot be taken
+ */
+int checkpointer_snapshot(Checkpointer *checkpointer, const Net *net, const Optimizer *optimizer);
+
+/**
+ * @brief wait until the last snapshot is written
+ * 
+ * @param[in,out] checkpointer target checkpointer
+ * @return int 0 if all writes since the last call succeeded, -1 otherwise
+ */
+int checkpointer_wait(Checkpointer *checkpointer);
+
+/**
+ * @brief write the pending snapshot, stop writer thread and deallocate checkpointer
+ * 
+ * @param[in,out] checkpointer checkpointer to be deallocated
+ */
+void checkpointer_free(Checkpointer **checkpointer);
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,19 @@
+/**
+ * @file concat.h
+ * @brief Concat layer
+ * 
+ */
+#ifndef CONCAT_H
+#define CONCAT_H
+
+#include "layer.h"
+
+/**
+ * @brief allocate Concat layer, which concatenates multiple inputs into one output
+ * 
+ * @param[in] layer_param layer parameter, .n_in: num of inputs, .ins: size of each input
+ * @return Layer* pointer to layer structure
+ */
+Layer *concat_layer(const LayerParameter layer_param);
+
+#endif // CONCAT_H
@@ -7,6 +7,10 @@
 #define DATA_H
 
 #include <stddef.h>
+#include <stdint.h>
+
+// alignment of arrays allocated by fdata_alloc_aligned() [byte], size of a cache line
+#define DATA_ALIGN 64
 
 /**
  * @brief allocate float data array
@@ -16,6 +20,14 @@
  */
 float* fdata_alloc(const size_t size);
 
+/**
+ * @brief allocate float data array aligned to DATA_ALIGN
+ * 
+ * @param[in] size num of elements
+ * @return float* pointer to array, deallocated with free()
+ */
+float* fdata_alloc_aligned(const size_t size);
+
 /**
  * @brief copy float data from src to dest
  * 
@@ -25,6 +37,18 @@ float* fdata_alloc(const size_t size);
  */
 void fdata_copy(const float *src, const size_t size, float *dest);
 
+/**
+ * @brief convert bytes to float data, dest = src * scale + offset
+ * @note vectorized with SSE2 if it is available
+ * 
+ * @param[in] src source bytes
+ * @param[in] size num of elements
+ * @param[in] scale scale of bytes
+ * @param[in] offset offset added after scaling
+ * @param[out] dest destination array
+ */
+void fdata_from_bytes(const uint8_t *src, const size_t size, const float scale, const float offset, float *dest);
+
 /**
  * @brief randomize data array with uniform distribution [0, 1]
  * 
@@ -0,0 +1,176 @@
+/**
+ * @file dataset.h
+ * @brief dataset of samples and labels in contiguous matrices
+ * 
+ */
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "idx.h"
+
+/**
+ * @struct
+ * @brief dataset structure
+ * @note a dataset created by dataset_create() owns aligned sample and label matrices,
+ *       one created by dataset_create_bytes() owns byte samples and class indices,
+ *       views and wrapped pointer arrays borrow the memory of others,
+ *       rows are accessible through xs and ts unless the dataset is backed by bytes,
+ *       which are converted only when they are gathered by dataset_gather(),
+ *       a dataset opened by dataset_cache_open() refers to a cache file mapped into memory
+ * 
+ */
+typedef struct Dataset {
+    int size;       //!< num of samples
+    int x_size;     //!< num of elements of a sample
+    int t_size;     //!< num of elements of a label
+
+    float *x;       //!< sample matrix, size x x_size, NULL if samples are not contiguous
+    float *t;       //!< label matrix, size x t_size, NULL if labels are not contiguous
+
+    float **xs;     //!< pointers to samples
+    float **ts;     //!< pointers to labels
+
+    uint8_t *x_u8;  //!< byte samples, size x x_size, NULL if samples are floats, read-only if mapped from a file
+    uint8_t *t_u8;  //!< class indices of labels, size, NULL if labels are floats, read-only if mapped from a file
+    float x_scale;  //!< scale of byte samples
+    float x_offset; //!< offset added to scaled byte samples
+
+    bool owner;     //!< matrices, bytes and pointer arrays are deallocated with the dataset
+
+    void *map;      //!< mapped region of cache file, NULL if not mapped, unmapped with the dataset
+    size_t map_size;    //!< size of mapped region [byte]
+} Dataset;
+
+/**
+ * @brief create dataset with uninitialized contiguous matrices
+ * 
+ * @param[in] size num of samples
+ * @param[in] x_size num of elements of a sample
+ * @param[in] t_size num of elements of a label
+ * @return Dataset* pointer to dataset, NULL if failed
+ */
+Dataset *dataset_create(const int size, const int x_size, const int t_size);
+
+/**
+ * @brief create dataset with uninitialized byte samples and class indices
+ * @note samples are converted to x_u8 * scale + offset and labels are expanded to one-hot vectors
+ *       when they are gathered, keeping samples 4 times and labels 4 x n_classes times smaller than floats,
+ *       class indices filled by the caller must be less than n_classes, see dataset_check_labels()
+ * 
+ * @param[in] size num of samples
+ * @param[in] x_size num of elements of a sample
+ * @param[in] n_classes num of classes, 256 at most
+ * @param[in] scale scale of byte samples
+ * @param[in] offset offset added to scaled byte samples
+ * @return Dataset* pointer to dataset, NULL if failed
+ */
+Dataset *dataset_create_bytes(const int size, const int x_size, const int n_classes, const float scale, const float offset);
+
+/**
+ * @brief create dataset with contiguous copies of arrays of samples and labels
+ * 
+ * @param[in] x array of samples
+ * @param[in] t array of labels
+ * @param[in] size num of samples
+ * @param[in] x_size num of elements of a sample
+ * @param[in] t_size num of elements of a label
+ * @return Dataset* pointer to dataset, NULL if failed
+ */
+Dataset *dataset_from_arrays(float **x, float **t, const int size, const int x_size, const int t_size);
+
+/**
+ * @brief wrap arrays of samples and labels without copy
+ * @note the result borrows the arrays and must not be deallocated
+ * 
+ * @param[in] x array of samples
+ * @param[in] t array of labels
+ * @param[in] size num of samples
+ * @param[in] x_size num of elements of a sample
+ * @param[in] t_size num of elements of a label
+ * @return Dataset dataset referring to the arrays
+ */
+Dataset dataset_wrap(float **x, float **t, const int size, const int x_size, const int t_size);
+
+/**
+ * @brief create dataset backed by IDX files of byte images and labels without copy
+ * @note samples are normalized to [0, 1] and labels are expanded to one-hot vectors
+ *       when they are gathered, the files must be kept open while the dataset is used
+ * 
+ * @param[in] images IDX file of images, unsigned bytes
+ * @param[in] labels IDX file of labels, unsigned bytes of 1 dimension
+ * @param[in] n_classes num of classes, larger than every label
+ * @return Dataset* pointer to dataset, NULL if failed
+ */
+Dataset *dataset_from_idx(const IdxFile *images, const IdxFile *labels, const int n_classes);
+
+/**
+ * @brief check that rows of dataset are float arrays accessible through xs and ts
+ * 
+ * @param[in] dataset target dataset
+ * @return true if rows are in memory as floats
+ */
+bool dataset_in_memory(const Dataset *dataset);
+
+/**
+ * @brief check that labels of dataset are class indices
+ * 
+ * @param[in] dataset target dataset
+ * @return true if labels are class indices
+ */
+bool dataset_has_class_labels(const Dataset *dataset);
+
+/**
+ * @brief check that class indices of dataset are less than num of classes
+ * @note trainers, loaders and caches reject datasets failing this check,
+ *       as class indices are expanded without bounds checks when they are gathered
+ * 
+ * @param[in] dataset target dataset
+ * @return true if every class index is in range or labels are not class indices
+ */
+bool dataset_check_labels(const Dataset *dataset);
+
+/**
+ * @brief gather samples and labels into contiguous buffers, converting bytes to floats
+ * 
+ * @param[in] dataset source dataset
+ * @param[in] indices indices of samples to be gathered
+ * @param[in] count num of samples to be gathered
+ * @param[out] x buffer of count x x_size elements
+ * @param[out] t buffer of count x t_size elements, NULL not to gather labels
+ */
+void dataset_gather(const Dataset *dataset, const int *indices, const int count, float *x, float *t);
+
+/**
+ * @brief gather class indices of labels
+ * 
+ * @param[in] dataset source dataset with class labels passing dataset_check_labels()
+ * @param[in] indices indices of samples to be gathered
+ * @param[in] count num of samples to be gathered
+ * @param[out] labels buffer of count class indices
+ */
+void dataset_gather_labels(const Dataset *dataset, const int *indices, const int count, int *labels);
+
+/**
+ * @brief get view of successive samples without copy
+ * @note the result borrows the memory of the dataset and must not be deallocated,
+ *       the range is clipped to the dataset
+ * 
+ * @param[in] dataset source dataset
+ * @param[in] begin index of the first sample
+ * @param[in] size num of samples
+ * @return Dataset view of the samples, empty if begin is out of range
+ */
+Dataset dataset_view(const Dataset *dataset, const int begin, const int size);
+
+/**
+ * @brief deallocate dataset created by dataset_create(), dataset_from_arrays() or dataset_cache_open()
+ * 
+ * @param[in,out] dataset dataset to be deallocated
+ */
+void dataset_free(Dataset **dataset);
+
+#endif // DATASET_H
@@ -0,0 +1,148 @@
+/**
+ * @file dist.h
+ * @brief multi-process communication for data-parallel training
+ * @note processes are on the same host and communicate with POSIX shared memory,
+ *       or Unix domain sockets as a fallback
+ * 
+ */
+#ifndef DIST_H
+#define DIST_H
+
+#include <stdbool.h>
+
+/**
+ * @brief timeout of waiting for a message from a peer if timeout is 0 [s]
+ * 
+ */
+#define DIST_TIMEOUT 300
+
+/**
+ * @brief transport between processes
+ * 
+ */
+typedef enum DistTransport {
+    DIST_TRANSPORT_AUTO,    //!< shared memory if available, Unix domain sockets otherwise
+    DIST_TRANSPORT_SHM,     //!< POSIX shared memory
+    DIST_TRANSPORT_SOCKET,  //!< Unix domain sockets
+} DistTransport;
+
+/**
+ * @brief configuration of a process group
+ * 
+ */
+typedef struct DistParameter {
+    int rank;                   //!< rank of the process, 0 to world_size - 1
+    int world_size;             //!< num of processes
+    DistTransport transport;    //!< transport
+    const char *name;           //!< name of the process group, need to be unique per job
+    int timeout;                //!< timeout of waiting for a message from a peer [s], DIST_TIMEOUT if 0
+    int cpus_per_rank;          //!< num of CPUs each child of dist_launch() is pinned to, not pinned if 0
+} DistParameter;
+
+/**
+ * @brief macro to set DistParameter
+ * 
+ */
+#define SET_DIST_PARAM(...) (DistParameter){ __VA_ARGS__ }
+
+/**
+ * @struct
+ * @brief process group structure
+ * 
+ */
+typedef struct Dist {
+    int rank;                   //!< rank of the process
+    int world_size;             //!< num of processes
+    DistTransport transport;    //!< transport in use, AUTO is resolved
+    int timeout;                //!< timeout of waiting for a message from a peer [s]
+
+    void *shm;                  //!< mapped shared memory
+    unsigned long shm_size;     //!< size of shared memory [byte]
+    unsigned long n_sent;       //!< num of messages sent to the next rank
+    unsigned long n_received;   //!< num of messages received from the previous rank
+
+    int next_fd;                //!< socket connected to the next rank
+    int prev_fd;                //!< socket connected from the previous rank
+
+    float *buffer;              //!< receive buffer
+    int buffer_size;            //!< num of elements of receive buffer
+
+    bool (*send)(struct Dist *self, const float *data, const int size);  //!< send message to the next rank
+    bool (*recv)(struct Dist *self, float *data, const int size);        //!< receive message from the previous rank
+} Dist;
+
+/**
+ * @brief join process group, blocks until all processes join
+ * 
+ * @param[in] param configuration of the process group
+ * @return Dist* pointer to process group, NULL if failed
+ */
+Dist *dist_create(const DistParameter param);
+
+/**
+ * @brief read configuration from environment variables
+ * @note NNC_RANK, NNC_WORLD_SIZE, NNC_DIST_NAME and NNC_DIST_TRANSPORT ("shm" or "socket"),
+ *       the name is required since a fixed default would collide between concurrent jobs
+ * 
+ * @param[out] param configuration of the process group, name points to the environment
+ * @return int 0 if succeeded, -1 if rank, world size or name is not given or invalid
+ */
+int dist_param_from_env(DistParameter *param);
+
+/**
+ * @brief sum array over all processes with ring all-reduce
+ * @note the order of additions of each element depends only on the num of processes,
+ *       so results are identical across runs and processes,
+ *       fails if a peer does not respond within the timeout
+ * 
+ * @param[in,out] dist process group
+ * @param[in,out] data array to be summed, overwritten with the sum
+ * @param[in] size num of elements
+ * @return int 0 if succeeded, -1 if failed
+ */
+int dist_allreduce(Dist *dist, float *data, const int size);
+
+/**
+ * @brief copy array of rank 0 to all processes
+ * @note the array is passed along the ring in pieces
+ * 
+ * @param[in,out] dist process group
+ * @param[in,out] data array to be sent from rank 0, overwritten in other ranks
+ * @param[in] size num of elements
+ * @return int 0 if succeeded, -1 if failed
+ */
+int dist_broadcast(Dist *dist, float *data, const int size);
+
+/**
+ * @brief wait until all processes reach
+ * 
+ * @param[in,out] dist process group
+ * @return int 0 if succeeded, -1 if failed
+ */
+int dist_barrier(Dist *dist);
+
+/**
+ * @brief leave process group and deallocate it
+ * 
+ * @param[in,out] dist process group to be deallocated
+ */
+void dist_free(Dist **dist);
+
+/**
+ * @brief run function in world_size child processes
+ * @note each child is forked with its rank set to param, and the environment variables
+ *       read by dist_param_from_env() are set, a unique name is given if name is NULL,
+ *       the other children are killed if one of them fails,
+ *       if cpus_per_rank is set, the child of rank r is pinned to the (r * cpus_per_rank)-th
+ *       and following CPUs allowed to the caller (wrapping around), so that ranks run on
+ *       disjoint cores which are usually on the same NUMA node as consecutive IDs,
+ *       and its memory is placed near them by first touch
+ * 
+ * @param[in] param configuration of the process group, rank is ignored
+ * @param[in] func function run in each child, returns 0 if succeeded
+ * @param[in] arg argument of function
+ * @return int 0 if all children succeeded, -1 otherwise
+ */
+int dist_launch(const DistParameter param, int (*func)(const DistParameter param, void *arg), void *arg);
+
+#endif // DIST_H
@@ -0,0 +1,24 @@
+/**
+ * @file export.h
+ * @brief export of trained network into C source
+ * 
+ */
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include "net.h"
+
+/**
+ * @brief write standalone C source of inference function of network
+ * @note the function is specialized to the layer dimensions and parameters at the time,
+ *       declared as void func_name(const float *x, float *y),
+ *       it has no dependencies other than libm and allocates nothing but stack arrays
+ * 
+ * @param[in] net trained network
+ * @param[in] filename path of C source file to be written
+ * @param[in] func_name name of inference function, must be a valid C identifier
+ * @return int 0 if succeeded, -1 if failed
+ */
+int net_export_c(Net *net, const char *filename, const char *func_name);
+
+#endif // EXPORT_H
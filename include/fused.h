@@ -0,0 +1,43 @@
+/**
+ * @file fused.h
+ * @brief fused layers, which compute two successive layers in one pass
+ * 
+ */
+#ifndef FUSED_H
+#define FUSED_H
+
+#include "layer.h"
+
+/**
+ * @brief allocate fused Fully connected and Sigmoid layer
+ * 
+ * @param[in] layer_param layer parameter of Fully connected layer
+ * @return Layer* pointer to layer structure
+ */
+Layer *fc_sigmoid_layer(const LayerParameter layer_param);
+
+/**
+ * @brief allocate fused Fully connected and ReLU layer
+ * 
+ * @param[in] layer_param layer parameter of Fully connected layer
+ * @return Layer* pointer to layer structure
+ */
+Layer *fc_relu_layer(const LayerParameter layer_param);
+
+/**
+ * @brief allocate fused Fully connected and Softmax layer
+ * 
+ * @param[in] layer_param layer parameter of Fully connected layer
+ * @return Layer* pointer to layer structure
+ */
+Layer *fc_softmax_layer(const LayerParameter layer_param);
+
+/**
+ * @brief allocate fused Sigmoid and Softmax layer
+ * 
+ * @param[in] layer_param layer parameter of Sigmoid layer
+ * @return Layer* pointer to layer structure
+ */
+Layer *sigmoid_softmax_layer(const LayerParameter layer_param);
+
+#endif // FUSED_H
@@ -0,0 +1,103 @@
+/**
+ * @file idx.h
+ * @brief memory-mapped reader of IDX files, optionally compressed with gzip
+ * 
+ */
+#ifndef IDX_H
+#define IDX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// max num of dimensions of an IDX file
+#define IDX_MAX_DIMS 8
+
+/**
+ * @brief element types of IDX file
+ * 
+ */
+typedef enum IdxType {
+    IDX_TYPE_UBYTE  = 0x08, //!< unsigned byte
+    IDX_TYPE_BYTE   = 0x09, //!< signed byte
+    IDX_TYPE_SHORT  = 0x0B, //!< 16-bit integer
+    IDX_TYPE_INT    = 0x0C, //!< 32-bit integer
+    IDX_TYPE_FLOAT  = 0x0D, //!< 32-bit float
+    IDX_TYPE_DOUBLE = 0x0E  //!< 64-bit float
+} IdxType;
+
+/**
+ * @struct
+ * @brief IDX file mapped into memory
+ * @note elements are exposed in the file without copy, multi-byte elements are big endian,
+ *       elements of gzip-compressed file are decoded into buffer
+ * 
+ */
+typedef struct IdxFile {
+    IdxType type;               //!< element type
+    int n_dims;                 //!< num of dimensions
+    int dims[IDX_MAX_DIMS];     //!< size of each dimension
+    int size;                   //!< num of items, size of the first dimension
+    int item_size;              //!< num of elements of an item
+    const uint8_t *data;        //!< elements following the header
+
+    void *map;                  //!< mapped region of the file
+    size_t map_size;            //!< size of mapped region [byte]
+    uint8_t *buffer;            //!< decoded elements of gzip-compressed file, NULL if elements are mapped
+} IdxFile;
+
+/**
+ * @brief get size of an element
+ * 
+ * @param[in] type element type
+ * @return int size of an element [byte], 0 if type is unknown
+ */
+int idx_type_size(const IdxType type);
+
+/**
+ * @brief map IDX file into memory and validate its header
+ * @note the file is rejected if its magic number is unknown,
+ *       or it is shorter than the elements the header describes,
+ *       gzip-compressed file is decoded at once and verified with its CRC-32
+ * 
+ * @param[in] filename path to IDX file
+ * @return IdxFile* pointer to IDX file, NULL if failed
+ */
+IdxFile *idx_open(const char *filename);
+
+/**
+ * @brief read and validate header of IDX file without mapping it
+ * @note data and map of the result are NULL, elements are read by caller
+ *       from the offset of idx_header_size(), in decoded bytes if the file is compressed with gzip,
+ *       whose elements are not checked to be in the file until they are decoded
+ * 
+ * @param[in] filename path to IDX file
+ * @param[out] file header of IDX file
+ * @return int 0 if succeeded, -1 if failed
+ */
+int idx_read_header(const char *filename, IdxFile *file);
+
+/**
+ * @brief get size of header of IDX file
+ * 
+ * @param[in] file IDX file
+ * @return size_t size of header [byte], offset of the first element
+ */
+size_t idx_header_size(const IdxFile *file);
+
+/**
+ * @brief get elements of an item
+ * 
+ * @param[in] file IDX file
+ * @param[in] index index of item
+ * @return const uint8_t* pointer to the first element of the item, NULL if out of range
+ */
+const uint8_t *idx_item(const IdxFile *file, const int index);
+
+/**
+ * @brief unmap IDX file and deallocate it
+ * 
+ * @param[in,out] file IDX file to be closed
+ */
+void idx_close(IdxFile **file);
+
+#endif // IDX_H
@@ -0,0 +1,119 @@
+/**
+ * @file inflate.h
+ * @brief decoder of gzip files compressed with DEFLATE
+ * 
+ */
+#ifndef INFLATE_H
+#define INFLATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief num of bits of codes looked up at once in Huffman tables
+ * 
+ */
+#define INFLATE_FAST_BITS 9
+
+/**
+ * @brief size of history window of DEFLATE [byte]
+ * 
+ */
+#define INFLATE_WINDOW_SIZE 32768
+
+/**
+ * @brief states of inflater
+ * 
+ */
+typedef enum InflateState {
+    INFLATE_STATE_MEMBER,   //!< header of a gzip member
+    INFLATE_STATE_BLOCK,    //!< header of a DEFLATE block
+    INFLATE_STATE_STORED,   //!< bytes of a stored block
+    INFLATE_STATE_CODES,    //!< codes of a Huffman block
+    INFLATE_STATE_TRAILER,  //!< CRC-32 and size following a member
+    INFLATE_STATE_DONE,     //!< end of file
+    INFLATE_STATE_ERROR     //!< corrupted file
+} InflateState;
+
+/**
+ * @brief canonical Huffman code with lookup table of short codes
+ * 
+ */
+typedef struct InflateHuffman {
+    uint16_t fast[1 << INFLATE_FAST_BITS];  //!< (length << 9) | symbol indexed by bit-reversed code, 0 if longer
+    uint32_t max_code[17];                  //!< end of codes of each length, left aligned to 16 bits
+    uint16_t first_code[16];                //!< the first code of each length
+    uint16_t first_symbol[16];              //!< index of the first symbol of each length in symbols
+    uint16_t symbols[288];                  //!< symbols sorted by code
+} InflateHuffman;
+
+/**
+ * @struct
+ * @brief inflater of gzip file in memory
+ * @note output is produced in pieces of any size, and only the history window is kept,
+ *       concatenated members are decoded as a single file
+ * 
+ */
+typedef struct Inflater {
+    const uint8_t *src;         //!< compressed file
+    size_t src_size;            //!< size of compressed file [byte]
+    size_t pos;                 //!< position of the next byte loaded into bits
+    uint64_t bits;              //!< bit buffer, the next bit is LSB
+    int n_bits;                 //!< num of bits in bit buffer
+    int n_padding;              //!< num of zero bits padded after the end of file
+
+    InflateState state;         //!< state of decoding
+    bool last_block;            //!< the current block is the last one of the member
+    size_t stored;              //!< num of remaining bytes of stored block
+    int length;                 //!< num of remaining bytes of the current match
+    int distance;               //!< distance of the current match
+    InflateHuffman literals;    //!< code of literals and lengths
+    InflateHuffman distances;   //!< code of distances
+
+    uint8_t window[INFLATE_WINDOW_SIZE];    //!< history of output
+    size_t window_pos;                      //!< num of bytes of output of the member
+
+    uint32_t crc;               //!< CRC-32 of output of the member
+    uint32_t crc_table[256];    //!< lookup table of CRC-32
+} Inflater;
+
+/**
+ * @brief check magic number of gzip
+ * 
+ * @param[in] src the first bytes of file
+ * @param[in] size num of bytes in src
+ * @return true if src is a gzip file
+ */
+bool gzip_check(const uint8_t *src, const size_t size);
+
+/**
+ * @brief create inflater of gzip file
+ * @note src is referenced until the inflater is deallocated
+ * 
+ * @param[in] src compressed file
+ * @param[in] size size of compressed file [byte]
+ * @return Inflater* pointer to inflater, NULL if src is not a gzip file
+ */
+Inflater *inflater_create(const uint8_t *src, const size_t size);
+
+/**
+ * @brief decode the next bytes
+ * @note CRC-32 and size of each member are verified at its end
+ * 
+ * @param[in,out] inflater target inflater
+ * @param[out] dest destination of decoded bytes
+ * @param[in] size num of bytes to decode
+ * @param[out] n_read num of bytes decoded, less than size at the end of file
+ * @return int 0 if succeeded, -1 if the file is corrupted
+ */
+int inflater_read(Inflater *inflater, uint8_t *dest, const size_t size, size_t *n_read);
+
+/**
+ * @brief deallocate inflater
+ * 
+ * @param[in,out] inflater inflater to be deallocated
+ */
+void inflater_free(Inflater **inflater);
+
+#endif // INFLATE_H
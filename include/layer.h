@@ -6,8 +6,16 @@
 #ifndef LAYER_H
 #define LAYER_H
 
+#include <stdbool.h>
+
+#include "profile.h"
+#include "sparse.h"
+
 #define N_DIM 4 //!< num of data dimensions, fixed to 4 for CNN
 
+#define LAYER_IN_MAX  8 //!< max num of inputs of a layer
+#define LAYER_OUT_MAX 8 //!< max num of output ports/consumers of a layer
+
 /**
  * @brief set dimension of matrix array
  * 
@@ -19,6 +27,58 @@
     (x)[3] = w;\
 }
 
+/**
+ * @brief type of layer
+ * 
+ */
+typedef enum LayerType {
+    LAYER_TYPE_NONE,            //!< basic layer
+    LAYER_TYPE_FC,              //!< Fully connected
+    LAYER_TYPE_SIGMOID,         //!< Sigmoid
+    LAYER_TYPE_SOFTMAX,         //!< Softmax
+    LAYER_TYPE_RELU,            //!< ReLU
+    LAYER_TYPE_ADD,             //!< Add
+    LAYER_TYPE_CONCAT,          //!< Concat
+    LAYER_TYPE_SPLIT,           //!< Split
+    LAYER_TYPE_FC_SIGMOID,      //!< fused Fully connected and Sigmoid
+    LAYER_TYPE_FC_RELU,         //!< fused Fully connected and ReLU
+    LAYER_TYPE_FC_SOFTMAX,      //!< fused Fully connected and Softmax
+    LAYER_TYPE_SIGMOID_SOFTMAX, //!< fused Sigmoid and Softmax
+} LayerType;
+
+/**
+ * @brief layer parameter structure
+ * 
+ */
+typedef struct LayerParameter {
+    int in;     //!< num of layer input
+    int out;    //!< num of layer output
+    int n_in;                   //!< num of inputs of multi-input layer
+    int ins[LAYER_IN_MAX];      //!< num of each input of multi-input layer
+    int n_out;                  //!< num of outputs of multi-output layer
+    int outs[LAYER_OUT_MAX];    //!< num of each output of multi-output layer
+} LayerParameter;
+
+/**
+ * @brief macro to set LayerParameter
+ * 
+ */
+#define SET_PARAM(...) (LayerParameter){ __VA_ARGS__ }
+
+/**
+ * @brief rows of dw written by sparse input
+ * @note a row is the weights of an input element, w_size / x_size elements,
+ *       and dw is zero except the rows in ids while sparse is true,
+ *       so gradients are cleared and parameters are updated only at them
+ * 
+ */
+typedef struct LayerRows {
+    int *ids;       //!< indices of written rows in order of the first write, NULL if not allocated
+    bool *marked;   //!< whether each row is in ids
+    int size;       //!< num of rows in ids
+    bool sparse;    //!< dw is zero except the rows in ids, false after a dense write of dw
+} LayerRows;
+
 /**
  * @struct 
  * @brief basic layer structure
@@ -27,7 +87,11 @@
 typedef struct Layer {
     int id;             //!< layer ID internal network
 
+    LayerType type;         //!< type of layer
+    LayerParameter param;   //!< parameter given at allocation
+
     const float *x;     //!< layer input matrix
+    const SparseMatrix *sx; //!< sparse input from network, x is NULL if it is set
     int x_dim[N_DIM];   //!< dimension of x
     int x_size;         //!< num of elements of x
 
@@ -46,9 +110,29 @@ typedef struct Layer {
     float *dx;  //!< differential of x
     float *dw;  //!< differential of w
     float *db;  //!< differential of b
+    float *dz;  //!< differential of pre-activation output of fused layers
+
+    bool accumulate;    //!< add gradients to dw and db instead of overwriting
+    LayerRows rows;     //!< rows of dw written by sparse input since the gradients were cleared
+
+    bool shared_params; //!< w and b are owned by another layer and not deallocated
 
-    int prev_id;    //!< ID of previous layer
-    int next_id;    //!< ID of next layer
+    int n_in;                       //!< num of inputs
+    int in_ids[LAYER_IN_MAX];       //!< IDs of input layers, -1 for network input
+    int in_ports[LAYER_IN_MAX];     //!< output ports of input layers
+    const float *xs[LAYER_IN_MAX];  //!< input matrices, xs[0] is same as x
+    int xs_size[LAYER_IN_MAX];      //!< num of elements of each input
+    float *dxs[LAYER_IN_MAX];       //!< differential of each input
+
+    int n_ys;                       //!< num of output ports
+    int ys_offset[LAYER_OUT_MAX];   //!< offset of each output port in y
+    int ys_size[LAYER_OUT_MAX];     //!< num of elements of each output port
+
+    int n_out;                      //!< num of consumer layers
+    int out_ids[LAYER_OUT_MAX];     //!< IDs of consumer layers
+    float *dy;                      //!< sum of diffs from consumers, used if not exactly one
+
+    LayerProfile profile;   //!< profiling statistics, collected if NNC_PROFILE is defined
 
     void (*forward)(struct Layer *self, const float *x);     //!< forward propagation
     void (*backward)(struct Layer *self, const float *dy);   //!< backward propagation
@@ -58,26 +142,74 @@ typedef struct Layer {
 } Layer;
 
 /**
- * @brief layer parameter structure
+ * @brief allocate basic layer structure
  * 
+ * @return Layer* poiner to layer structure
  */
-typedef struct LayerParameter {
-    int in;     //!< num of layer input
-    int out;    //!< num of layer output
-} LayerParameter;
+Layer *layer_alloc(void);
 
 /**
- * @brief macro to set LayerParameter
+ * @brief create layer of specified type
  * 
+ * @param[in] type layer type, other than LAYER_TYPE_NONE
+ * @param[in] layer_param layer parameter
+ * @return Layer* pointer to layer, NULL if failed
  */
-#define SET_PARAM(...) (LayerParameter){ __VA_ARGS__ }
+Layer *layer_create(const LayerType type, const LayerParameter layer_param);
 
 /**
- * @brief allocate basic layer structure
+ * @brief get name of layer type
  * 
- * @return Layer* poiner to layer structure
+ * @param[in] type layer type
+ * @return const char* name of layer type
  */
-Layer *layer_alloc(void);
+const char *layer_type_name(const LayerType type);
+
+/**
+ * @brief get theoretical cost of a call of forward/backward propagation
+ * @note bytes are counted as compulsory traffic of each array read or written once
+ * 
+ * @param[in] layer target layer
+ * @param[in] backward cost of backward propagation if true, forward otherwise
+ * @param[out] flops num of floating point operations
+ * @param[out] bytes num of bytes read and written
+ */
+void layer_cost(const Layer *layer, const bool backward, double *flops, double *bytes);
+
+/**
+ * @brief allocate tracking of rows of dw written by sparse input
+ * @note rows are tracked from the next clear of dw
+ * 
+ * @param[in,out] layer target layer
+ * @return int 0 if succeeded or already allocated, -1 if failed
+ */
+int layer_alloc_rows(Layer *layer);
+
+/**
+ * @brief add gradient of weights by sparse input to dw, x^T dy
+ * @note dw is cleared first unless gradients are accumulated,
+ *       only its rows written since the last clear if they are tracked,
+ *       so the cost scales with nonzeros of inputs
+ * 
+ * @param[in,out] layer target layer whose sx is set
+ * @param[in] dy diff of the output of the weights
+ */
+void layer_sparse_grad(Layer *layer, const float *dy);
+
+/**
+ * @brief clear dw and db, only the rows of dw written by sparse input if they are tracked
+ * 
+ * @param[in,out] layer target layer
+ */
+void layer_zero_grad(Layer *layer);
+
+/**
+ * @brief scale dw and db, only the rows of dw written by sparse input if they are tracked
+ * 
+ * @param[in,out] layer target layer
+ * @param[in] k scale
+ */
+void layer_scale_grad(Layer *layer, const float k);
 
 /**
  * @brief deallocate layer structure
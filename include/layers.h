@@ -6,8 +6,13 @@
 #ifndef LAYERS_H
 #define LAYERS_H
 
+#include "add.h"
+#include "concat.h"
 #include "fc.h"
+#include "fused.h"
+#include "relu.h"
 #include "sigmoid.h"
 #include "softmax.h"
+#include "split.h"
 
 #endif // LAYERS_H
@@ -0,0 +1,120 @@
+/**
+ * @file loader.h
+ * @brief background loader gathering shuffled batches into staging buffers
+ * 
+ */
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "augment.h"
+#include "dataset.h"
+#include "stream.h"
+
+/**
+ * @brief batch gathered into contiguous buffers
+ * 
+ */
+typedef struct LoaderBatch {
+    float *x;   //!< data of samples, size x x_size elements aligned to cache line
+    float *t;   //!< labels of samples, size x t_size elements aligned to cache line, not gathered with class labels
+    int *labels;    //!< class indices of samples, NULL if labels are gathered into t
+    int size;   //!< num of samples
+    int index;  //!< index of batch in epoch
+} LoaderBatch;
+
+/**
+ * @struct
+ * @brief loader structure
+ * 
+ */
+typedef struct Loader {
+    const Dataset *dataset; //!< source dataset, NULL if samples are read from stream
+    Stream *stream;         //!< source stream, NULL if samples are gathered from dataset
+    int data_size;      //!< num of data
+    int x_size;         //!< num of elements of a data
+    int t_size;         //!< num of elements of a label
+    int batch_size;     //!< num of samples of a batch
+    int depth;          //!< num of batches gathered ahead
+    bool class_labels;  //!< class indices are gathered instead of one-hot vectors
+    Augmenter *augmenter;   //!< augmenter of gathered samples, NULL if not augmented
+
+    LoaderBatch *batches;   //!< staging buffers, depth + 1 batches
+    const int *indices;     //!< order of data in current epoch
+    int n_batches;          //!< num of batches in current epoch
+    int epoch;              //!< num of epochs started before current epoch
+    int produced;           //!< num of batches gathered in current epoch
+    int consumed;           //!< num of batches taken in current epoch
+    bool busy;              //!< loader thread is gathering a batch
+    bool stop;              //!< flag to stop loader thread
+
+    pthread_t thread;       //!< loader thread
+    pthread_mutex_t lock;   //!< lock for the state
+    pthread_cond_t cond;    //!< signaled when the state changes
+} Loader;
+
+/**
+ * @brief create loader and start its thread
+ * @note byte samples and labels of the dataset are converted to floats in the loader thread
+ * 
+ * @param[in] dataset source dataset, kept by caller until the loader is deallocated
+ * @param[in] batch_size num of samples of a batch
+ * @param[in] depth num of batches gathered ahead of the batch in use
+ * @param[in] class_labels gather class indices of labels into labels of batches,
+ *                         the dataset must have class labels
+ * @return Loader* pointer to loader
+ */
+Loader *loader_create(const Dataset *dataset, const int batch_size, const int depth, const bool class_labels);
+
+/**
+ * @brief create loader reading batches from stream and start its thread
+ * @note the stream is read only by the loader thread while the loader is used
+ * 
+ * @param[in,out] stream source stream, kept by caller until the loader is deallocated
+ * @param[in] batch_size num of samples of a batch
+ * @param[in] depth num of batches read ahead of the batch in use
+ * @param[in] class_labels read class indices of labels into labels of batches instead of one-hot vectors
+ * @return Loader* pointer to loader
+ */
+Loader *loader_create_stream(Stream *stream, const int batch_size, const int depth, const bool class_labels);
+
+/**
+ * @brief set augmenter applied to samples of each batch in the loader thread
+ * @note samples are augmented after they are gathered, with random streams
+ *       derived from the num of started epochs and positions of samples in epoch,
+ *       the augmenter must fit samples and is used only by the loader until it is unset
+ * 
+ * @param[in,out] loader target loader, between epochs
+ * @param[in,out] augmenter augmenter, NULL to stop augmentation
+ */
+void loader_set_augmenter(Loader *loader, Augmenter *augmenter);
+
+/**
+ * @brief start an epoch, batches are gathered in the order of indices
+ * @note batches of the previous epoch not taken yet are discarded,
+ *       a stream is rewound and indices are ignored
+ * 
+ * @param[in,out] loader target loader
+ * @param[in] indices order of data, kept by caller until the epoch ends, NULL for stream
+ */
+void loader_start(Loader *loader, const int *indices);
+
+/**
+ * @brief take the next batch, blocks until it is gathered
+ * @note the batch is valid until the next call, which releases its buffer to the loader
+ * 
+ * @param[in,out] loader target loader
+ * @return const LoaderBatch* next batch, NULL at the end of epoch
+ */
+const LoaderBatch *loader_next(Loader *loader);
+
+/**
+ * @brief stop loader thread and deallocate loader
+ * 
+ * @param[in,out] loader loader to be deallocated
+ */
+void loader_free(Loader **loader);
+
+#endif // LOADER_H
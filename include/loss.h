@@ -6,6 +6,18 @@
 #ifndef LOSS_H
 #define LOSS_H
 
+/**
+ * @brief loss function of a vector of target values
+ * 
+ */
+typedef float (*LossFunc)(const float*, const float*, const int);
+
+/**
+ * @brief loss function of a class index, same as LossFunc with a one-hot vector
+ * 
+ */
+typedef float (*LabelLossFunc)(const float*, const int, const int);
+
 /**
  * @brief mean squared loss (MSE)
  * 
@@ -26,4 +38,32 @@ float mean_squared_loss(const float *y, const float *t, const int size);
  */
 float cross_entropy_loss(const float *y, const float *t, const int size);
 
+/**
+ * @brief mean squared loss (MSE) of a class index
+ * 
+ * @param y vector of predicted values
+ * @param label class index of target
+ * @param size size of vector
+ * @return float loss value, same as mean_squared_loss() with one-hot vector of label
+ */
+float mean_squared_loss_label(const float *y, const int label, const int size);
+
+/**
+ * @brief cross entropy loss of a class index
+ * 
+ * @param y vector of predicted values
+ * @param label class index of target
+ * @param size size of vector
+ * @return float loss value, same as cross_entropy_loss() with one-hot vector of label
+ */
+float cross_entropy_loss_label(const float *y, const int label, const int size);
+
+/**
+ * @brief get loss function of class indices corresponding to a loss function
+ * 
+ * @param loss_func loss function
+ * @return LabelLossFunc loss function of class indices, NULL if there is no corresponding one
+ */
+LabelLossFunc loss_label_func(const LossFunc loss_func);
+
 #endif // LOSS_H
@@ -58,6 +58,19 @@ float *mat_mul(const float *a, const float *b, float *c, const int m, const int
  */
 float *mat_mul_trans_a(const float *a, const float *b, float *c, const int m, const int n, const int p);
 
+/**
+ * @brief multiply MxN matrix A and MxP matrix B and accumulate to C: C=(A^T)B+C
+ * 
+ * @param[in] a MxN matrix A
+ * @param[in] b MxP matrix B
+ * @param[in,out] c NxP matrix C
+ * @param[in] m num of rows of matrix A/rows of matrix B
+ * @param[in] n num of columns of matrix A
+ * @param[in] p num of columns of matrix B
+ * @return float* pointer to matrix C
+ */
+float *mat_mul_trans_a_acc(const float *a, const float *b, float *c, const int m, const int n, const int p);
+
 /**
  * @brief multiply MxN matrix A and PxN matrix B: C=A(B^T)
  * 
@@ -6,22 +6,85 @@
 #ifndef NET_H
 #define NET_H
 
+#include <stddef.h>
+#include <stdio.h>
+
 #include "layer.h"
+#include "profile.h"
+#include "thread_pool.h"
 
-#define NET_LAYER_MAX_SIZE 256  //!< max size of layers
+struct NetTask;
 
 /**
  * @struct
  * @brief network structure
+ * @note layers form a directed acyclic graph,
+ *       a layer can only take the outputs of previously appended layers as its inputs
  * 
  */
 typedef struct Net {
-    int   size;                        //!< num of layers
-    Layer *layers[NET_LAYER_MAX_SIZE]; //!< list of layers
+    int   size;             //!< num of layers
+    int   capacity;         //!< allocated length of layers
+    Layer **layers;         //!< list of layers, indexed by layer ID
     Layer *input_layer;     //!< input layer
     Layer *output_layer;    //!< output layer
+
+    int *order;             //!< layer IDs sorted by topological level, NULL if not scheduled
+    int *level_start;       //!< start index of each level in order, n_levels + 1 elements
+    int n_levels;           //!< num of topological levels
+    struct NetTask *tasks;  //!< arguments of layer tasks, indexed by layer ID
+
+    ThreadPool *pool;       //!< thread pool to run independent layers, NULL to run serially
+
+    void *map;              //!< mapped checkpoint holding parameters of layers, NULL if parameters are allocated
+    size_t map_size;        //!< size of mapped checkpoint [byte]
 } Net;
 
+/**
+ * @brief evaluation parameter structure
+ * 
+ */
+typedef struct EvalParameter {
+    float (*loss_func)(const float*, const float*, const int);  //!< loss function, NULL not to calculate loss
+    int top_k;      //!< k of top-k accuracy, 1 if 0
+    int n_threads;  //!< num of threads if the network has no thread pool, 1 if 0
+} EvalParameter;
+
+/**
+ * @brief macro to set EvalParameter
+ * 
+ */
+#define SET_EVAL_PARAM(...) (EvalParameter){ __VA_ARGS__ }
+
+/**
+ * @brief result of evaluation
+ * 
+ */
+typedef struct EvalResult {
+    int   count;            //!< num of evaluated samples
+    float loss;             //!< mean loss, 0 if loss function is not given
+    float accuracy;         //!< top-1 accuracy
+    float top_k_accuracy;   //!< top-k accuracy
+    int   top_k;            //!< k of top-k accuracy
+    int   n_classes;        //!< num of classes
+    int   *confusion;       //!< confusion matrix, n_classes x n_classes, rows are labels and columns are predictions
+} EvalResult;
+
+/**
+ * @struct
+ * @brief evaluator keeping replicas of a network across evaluations
+ * @note replicas share parameters with the network, so updates of the network
+ *       are visible to them, but the layers of the network must not be modified
+ * 
+ */
+typedef struct Evaluator {
+    const Net *net;         //!< evaluated network
+    ThreadPool *pool;       //!< thread pool of the network or own_pool, NULL to evaluate serially
+    ThreadPool *own_pool;   //!< thread pool created by the evaluator, NULL if not created
+    int n_replicas;         //!< num of replicas, size of the thread pool or 1
+    Net **replicas;         //!< replicas of the network each evaluating a range of samples
+} Evaluator;
+
 /**
  * @brief allocate network
  * 
@@ -39,7 +102,7 @@ Net *net_alloc(void);
 Net *net_create(const int size, Layer *layers[]);
 
 /**
- * @brief append layer to network
+ * @brief append layer to network, connected to the output of the last layer
  * 
  * @param[in,out] net target network
  * @param[in] layer layer to be appended
@@ -47,6 +110,49 @@ Net *net_create(const int size, Layer *layers[]);
  */
 Net *net_append(Net *net, Layer *layer);
 
+/**
+ * @brief append layer to network, connected to the specified layers
+ * 
+ * @param[in,out] net target network
+ * @param[in] layer layer to be appended
+ * @param[in] n_in num of inputs, must be equal to that of the layer
+ * @param[in] in_ids IDs of input layers, -1 for network input
+ * @param[in] in_ports output ports of input layers, NULL to use port 0 for all
+ * @return Net* pointer to the network structure
+ */
+Net *net_connect(Net *net, Layer *layer, const int n_in, const int in_ids[], const int in_ports[]);
+
+/**
+ * @brief set thread pool to run independent layers in parallel
+ * 
+ * @param[in,out] net target network
+ * @param[in] pool thread pool, NULL to run serially
+ */
+void net_set_thread_pool(Net *net, ThreadPool *pool);
+
+/**
+ * @brief rewrite successive layers into fused layers
+ * @note patterns are matched from the output side:
+ *       FC->Sigmoid, FC->ReLU, FC->Softmax and Sigmoid->Softmax,
+ *       layer IDs are renumbered and the fused layers take over parameters
+ * 
+ * @param[in,out] net target network
+ * @return int num of fused pairs, -1 if failed
+ */
+int net_optimize(Net *net);
+
+/**
+ * @brief create replica of network which shares weights and biases with the source
+ * @note the replica has its own outputs and diffs of layers, so it can be
+ *       propagated in parallel with the source, and updating parameters of
+ *       one of them is visible to the other,
+ *       the replica must be deallocated before the source
+ * 
+ * @param[in] net source network
+ * @return Net* pointer to the replica, NULL if failed
+ */
+Net *net_replicate(const Net *net);
+
 /**
  * @brief initialize layer parameters in network
  * 
@@ -54,6 +160,30 @@ Net *net_append(Net *net, Layer *layer);
  */
 void net_init_layer_params(Net *net);
 
+/**
+ * @brief set whether layers add gradients to dw and db instead of overwriting them
+ * @note set again after net_optimize(), fused layers are created without this flag
+ * 
+ * @param[in,out] net target network
+ * @param[in] accumulate accumulate gradients if true
+ */
+void net_set_accumulate(Net *net, const bool accumulate);
+
+/**
+ * @brief clear gradients of parameters of all layers
+ * 
+ * @param[in,out] net target network
+ */
+void net_zero_grad(Net *net);
+
+/**
+ * @brief multiply gradients of parameters of all layers by a scalar
+ * 
+ * @param[in,out] net target network
+ * @param[in] k coefficient
+ */
+void net_scale_grad(Net *net, const float k);
+
 /**
  * @brief forward propagation of network
  * 
@@ -62,6 +192,19 @@ void net_init_layer_params(Net *net);
  */
 void net_forward(Net *net, const float *x);
 
+/**
+ * @brief forward propagation of network with sparse input
+ * @note layers taking network input must be Fully connected or fused with it,
+ *       their cost scales with nonzeros of input and their dx is not calculated,
+ *       rows of their dw written by sparse input are tracked (see LayerRows),
+ *       the input is referenced until the next forward propagation
+ * 
+ * @param[in,out] net network structure
+ * @param[in] x sparse network input of a row
+ * @return int 0 if succeeded, -1 if the network does not accept sparse input or allocation failed
+ */
+int net_forward_sparse(Net *net, const SparseMatrix *x);
+
 /**
  * @brief backward propagation of network
  * 
@@ -70,6 +213,91 @@ void net_forward(Net *net, const float *x);
  */
 void net_backward(Net *net, const float *t);
 
+/**
+ * @brief backward propagation of network with a class index
+ * @note same as net_backward() with one-hot vector of label
+ * 
+ * @param[in,out] net network structure
+ * @param[in] label class index of training label
+ */
+void net_backward_label(Net *net, const int label);
+
+/**
+ * @brief evaluate network over data without backward propagation
+ * @note samples are split into contiguous ranges propagated in parallel by replicas
+ *       (see net_replicate()) on the thread pool of the network, or a temporary one,
+ *       diffs of layers are not touched, and partial results are summed in the order of ranges,
+ *       a class is the index of the max element of a label or an output,
+ *       or whether the element is larger than 0.5 if the output has a single element
+ * 
+ * @param[in] net target network
+ * @param[in] x array of data
+ * @param[in] t array of labels
+ * @param[in] data_size num of data
+ * @param[in] eval_param evaluation parameter
+ * @return EvalResult* pointer to result, NULL if failed
+ */
+EvalResult *net_evaluate(const Net *net, float **x, float **t, const int data_size, const EvalParameter eval_param);
+
+/**
+ * @brief create evaluator of network to evaluate it repeatedly without replicating it each time
+ * @note samples are propagated one by one by each replica, as the network has no batched propagation
+ * 
+ * @param[in] net target network, it must outlive the evaluator
+ * @param[in] n_threads num of threads if the network has no thread pool, 1 if 0
+ * @return Evaluator* pointer to evaluator, NULL if failed
+ */
+Evaluator *evaluator_create(const Net *net, const int n_threads);
+
+/**
+ * @brief evaluate network of evaluator over data
+ * @note same as net_evaluate() with the replicas and the thread pool of the evaluator,
+ *       n_threads of eval_param is ignored
+ * 
+ * @param[in,out] evaluator target evaluator
+ * @param[in] x array of data
+ * @param[in] t array of labels
+ * @param[in] data_size num of data
+ * @param[in] eval_param evaluation parameter
+ * @return EvalResult* pointer to result, NULL if failed
+ */
+EvalResult *evaluator_run(
+    Evaluator *evaluator, float **x, float **t, const int data_size, const EvalParameter eval_param);
+
+/**
+ * @brief deallocate evaluator and its replicas
+ * 
+ * @param[in,out] evaluator evaluator to be deallocated
+ */
+void evaluator_free(Evaluator **evaluator);
+
+/**
+ * @brief deallocate result of evaluation
+ * 
+ * @param[in,out] result result to be deallocated
+ */
+void net_eval_result_free(EvalResult **result);
+
+/**
+ * @brief clear profiling statistics of all layers
+ * 
+ * @param[in,out] net target network
+ */
+void net_profile_reset(Net *net);
+
+/**
+ * @brief write profiling statistics of all layers
+ * @note statistics are collected only if the library is built with NNC_PROFILE,
+ *       achieved FLOP/s and bytes/s are derived from the theoretical cost of layer_cost(),
+ *       hardware counters are reported only if built with NNC_PROFILE_PERF and available
+ * 
+ * @param[in] net target network
+ * @param[in] fp output stream
+ * @param[in] format report format
+ * @return int 0 if succeeded, -1 if profiling is disabled or failed
+ */
+int net_profile_report(const Net *net, FILE *fp, const ProfileFormat format);
+
 /**
  * @brief deallocate network
  * 
@@ -0,0 +1,117 @@
+/**
+ * @file optimizer.h
+ * @brief optimizers to update network parameters
+ * 
+ */
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "net.h"
+
+/**
+ * @brief type of optimizer
+ * 
+ */
+typedef enum OptimizerType {
+    OPTIMIZER_TYPE_SGD,         //!< SGD, with update hook of each layer
+    OPTIMIZER_TYPE_MOMENTUM,    //!< SGD with momentum
+    OPTIMIZER_TYPE_NESTEROV,    //!< SGD with Nesterov momentum
+    OPTIMIZER_TYPE_ADAM,        //!< Adam
+    OPTIMIZER_TYPE_ADAMW,       //!< Adam with decoupled weight decay
+} OptimizerType;
+
+/**
+ * @brief flags of hyper parameters given as 0 to be kept 0
+ * 
+ */
+typedef enum OptimizerZero {
+    OPTIMIZER_ZERO_MOMENTUM     = 1 << 0,   //!< momentum
+    OPTIMIZER_ZERO_BETA1        = 1 << 1,   //!< beta1
+    OPTIMIZER_ZERO_BETA2        = 1 << 2,   //!< beta2
+    OPTIMIZER_ZERO_EPSILON      = 1 << 3,   //!< epsilon
+    OPTIMIZER_ZERO_WEIGHT_DECAY = 1 << 4    //!< weight_decay
+} OptimizerZero;
+
+/**
+ * @brief optimizer parameter structure
+ * @note hyper parameters given as 0 are set to the default values unless flagged in zeros
+ * 
+ */
+typedef struct OptimizerParameter {
+    OptimizerType type;     //!< type of optimizer
+    float learning_rate;    //!< learning rate
+    float momentum;         //!< coefficient of momentum, 0.9 by default
+    float beta1;            //!< decay rate of 1st moment of Adam, 0.9 by default
+    float beta2;            //!< decay rate of 2nd moment of Adam, 0.999 by default
+    float epsilon;          //!< term to avoid division by zero of Adam, 1e-8 by default
+    float weight_decay;     //!< coefficient of decoupled weight decay of AdamW, 0.01 by default
+    int zeros;              //!< OptimizerZero flags of hyper parameters kept 0, e.g. OPTIMIZER_ZERO_WEIGHT_DECAY
+} OptimizerParameter;
+
+/**
+ * @brief macro to set OptimizerParameter
+ * 
+ */
+#define SET_OPTIMIZER_PARAM(...) (OptimizerParameter){ __VA_ARGS__ }
+
+/**
+ * @brief state of optimizer for parameters of a layer
+ * 
+ */
+typedef struct OptimizerState {
+    float *mw;  //!< 1st moment (or velocity) of weights
+    float *vw;  //!< 2nd moment of weights
+    float *mb;  //!< 1st moment (or velocity) of biases
+    float *vb;  //!< 2nd moment of biases
+} OptimizerState;
+
+/**
+ * @struct
+ * @brief optimizer structure
+ * 
+ */
+typedef struct Optimizer {
+    OptimizerParameter param;   //!< parameter with default values applied
+    long step;                  //!< num of update steps
+    int size;                   //!< num of layers of the target network
+    OptimizerState *states;     //!< state of each layer, indexed by layer ID
+} Optimizer;
+
+/**
+ * @brief create optimizer for network
+ * @note states are allocated for the layers of the network at the creation,
+ *       so the network must not be modified (e.g. by net_optimize()) afterward
+ * 
+ * @param[in] net target network
+ * @param[in] param optimizer parameter
+ * @return Optimizer* pointer to optimizer
+ */
+Optimizer *optimizer_create(const Net *net, const OptimizerParameter param);
+
+/**
+ * @brief get name of optimizer type
+ * 
+ * @param[in] type optimizer type
+ * @return const char* name of optimizer type
+ */
+const char *optimizer_type_name(const OptimizerType type);
+
+/**
+ * @brief update parameters of all layers with their diffs
+ * @note weights of layers given sparse input are updated only at the rows written
+ *       since the gradients were cleared (see LayerRows), lazily without decaying moments
+ *       or weights of the other rows, and without the update hook of the layer for SGD
+ * 
+ * @param[in,out] optimizer target optimizer
+ * @param[in,out] net target network
+ */
+void optimizer_step(Optimizer *optimizer, Net *net);
+
+/**
+ * @brief deallocate optimizer
+ * 
+ * @param[in,out] optimizer optimizer to be deallocated
+ */
+void optimizer_free(Optimizer **optimizer);
+
+#endif // OPTIMIZER_H
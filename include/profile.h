@@ -0,0 +1,136 @@
+/**
+ * @file profile.h
+ * @brief per-layer profiling
+ * @note instrumentation is compiled in only if NNC_PROFILE is defined,
+ *       hardware counters are sampled additionally if NNC_PROFILE_PERF is defined
+ * 
+ */
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief hardware performance counters
+ * 
+ */
+typedef enum ProfileCounter {
+    PROFILE_COUNTER_CYCLES,         //!< CPU cycles
+    PROFILE_COUNTER_INSTRUCTIONS,   //!< retired instructions
+    PROFILE_COUNTER_LLC_MISSES,     //!< last level cache misses
+    PROFILE_COUNTER_BRANCH_MISSES,  //!< mispredicted branches
+    PROFILE_COUNTER_NUM             //!< num of counters
+} ProfileCounter;
+
+/**
+ * @brief sample of clock and counters at a point
+ * 
+ */
+typedef struct ProfileSample {
+    double   time;                              //!< time of monotonic clock [s]
+    uint64_t counters[PROFILE_COUNTER_NUM];     //!< values of counters
+    bool     has_counters;                      //!< counters are sampled
+} ProfileSample;
+
+/**
+ * @brief statistics of elapsed time and counters of a function
+ * 
+ */
+typedef struct ProfileStat {
+    long   count;   //!< num of calls
+    double total;   //!< total elapsed time [s]
+    double min;     //!< min elapsed time [s]
+    double max;     //!< max elapsed time [s]
+
+    long     counted;                           //!< num of calls with counters sampled
+    uint64_t counters[PROFILE_COUNTER_NUM];     //!< total of counters
+} ProfileStat;
+
+/**
+ * @brief profiling statistics of a layer
+ * 
+ */
+typedef struct LayerProfile {
+    ProfileStat forward;    //!< statistics of forward propagation
+    ProfileStat backward;   //!< statistics of backward propagation
+} LayerProfile;
+
+/**
+ * @brief format of profiling report
+ * 
+ */
+typedef enum ProfileFormat {
+    PROFILE_FORMAT_TABLE,   //!< human readable table
+    PROFILE_FORMAT_JSON,    //!< JSON array of layers
+} ProfileFormat;
+
+#ifdef NNC_PROFILE
+
+/**
+ * @brief start measurement, declare a variable to hold the start sample
+ * 
+ */
+#define PROFILE_BEGIN(start) ProfileSample start; profile_sample(&start)
+
+/**
+ * @brief finish measurement and accumulate difference from the start to statistics
+ * 
+ */
+#define PROFILE_END(stat, start) profile_stat_add_since(&(stat), &(start))
+
+#else
+
+#define PROFILE_BEGIN(start)
+#define PROFILE_END(stat, start)
+
+#endif // NNC_PROFILE
+
+/**
+ * @brief get time of monotonic clock
+ * 
+ * @return double time [s]
+ */
+double profile_now(void);
+
+/**
+ * @brief take sample of clock, and counters of the calling thread if NNC_PROFILE_PERF is defined
+ * @note counters are opened with perf_event_open() at the first call in each thread,
+ *       has_counters is false if they are not available
+ * 
+ * @param[out] sample sample
+ */
+void profile_sample(ProfileSample *sample);
+
+/**
+ * @brief get name of counter
+ * 
+ * @param[in] counter counter
+ * @return const char* name of counter
+ */
+const char *profile_counter_name(const ProfileCounter counter);
+
+/**
+ * @brief clear statistics
+ * 
+ * @param[out] stat target statistics
+ */
+void profile_stat_reset(ProfileStat *stat);
+
+/**
+ * @brief accumulate elapsed time to statistics
+ * 
+ * @param[in,out] stat target statistics
+ * @param[in] elapsed elapsed time [s]
+ */
+void profile_stat_add(ProfileStat *stat, const double elapsed);
+
+/**
+ * @brief accumulate difference from start sample to now to statistics
+ * 
+ * @param[in,out] stat target statistics
+ * @param[in] start sample at the start
+ */
+void profile_stat_add_since(ProfileStat *stat, const ProfileSample *start);
+
+#endif // PROFILE_H
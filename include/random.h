@@ -22,6 +22,35 @@ void rand_seed(uint32_t seed);
  */
 uint32_t rand_xorshift(void);
 
+/**
+ * @brief get unbiased pseudorandom integer in [0, n)
+ * 
+ * @param[in] n upper bound, larger than 0
+ * @return uint32_t pseudorandom number within [0, n)
+ */
+uint32_t rand_range(const uint32_t n);
+
+/**
+ * @brief shuffle array into a uniformly random permutation by Fisher-Yates
+ * 
+ * @param[in,out] array target array
+ * @param[in] size num of elements
+ */
+void rand_shuffle(int *array, const int size);
+
+/**
+ * @brief fill array with a permutation of [0, size) shuffled block by block
+ * @note blocks of block_size successive values, the last one can be shorter,
+ *       are placed in random order, and values are shuffled within each block,
+ *       so the values in a block are still close to each other
+ * 
+ * @param[out] array target array
+ * @param[in] size num of elements
+ * @param[in] block_size num of elements of a block
+ * @return int 0 if succeeded, -1 if failed
+ */
+int rand_block_shuffle(int *array, const int size, const int block_size);
+
 /**
  * @brief get pseudorandom number from uniform distribution [0, 1]
  * 
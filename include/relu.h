@@ -0,0 +1,19 @@
+/**
+ * @file relu.h
+ * @brief ReLU layer
+ * 
+ */
+#ifndef RELU_H
+#define RELU_H
+
+#include "layer.h"
+
+/**
+ * @brief allocate ReLU layer
+ * 
+ * @param[in] layer_param layer parameter
+ * @return Layer* pointer to layer structure
+ */
+Layer *relu_layer(const LayerParameter layer_param);
+
+#endif // RELU_H
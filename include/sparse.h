@@ -0,0 +1,99 @@
+/**
+ * @file sparse.h
+ * @brief sparse matrix in CSR format and its operations
+ * 
+ */
+#ifndef SPARSE_H
+#define SPARSE_H
+
+/**
+ * @struct
+ * @brief sparse matrix in CSR (compressed sparse row) format
+ * @note nonzeros of row i are values[row_ptr[i]] to values[row_ptr[i + 1] - 1]
+ *       at columns of col_idx in ascending order
+ * 
+ */
+typedef struct SparseMatrix {
+    int n_rows;     //!< num of rows
+    int n_cols;     //!< num of columns
+    int nnz;        //!< num of nonzeros
+    int *row_ptr;   //!< offset of the first nonzero of each row, n_rows + 1 elements
+    int *col_idx;   //!< column of each nonzero, nnz elements
+    float *values;  //!< value of each nonzero, nnz elements
+    int capacity;   //!< allocated num of nonzeros, 0 if arrays are borrowed
+} SparseMatrix;
+
+/**
+ * @brief create sparse matrix with no nonzeros
+ * 
+ * @param[in] n_rows num of rows
+ * @param[in] n_cols num of columns
+ * @param[in] capacity num of nonzeros to be allocated
+ * @return SparseMatrix* pointer to sparse matrix, NULL if failed
+ */
+SparseMatrix *sparse_create(const int n_rows, const int n_cols, const int capacity);
+
+/**
+ * @brief load sparse samples and labels from text file in libsvm (svmlight) format
+ * @note each line is "<label> <index>:<value> ...", indices start from 1 and ascend in a line,
+ *       labels are integer class indices and -1 of binary labels is read as class 0,
+ *       "qid:" fields and comments starting with '#' are ignored
+ * 
+ * @param[in] filename path to text file
+ * @param[in] n_features num of columns, the largest index in the file if 0
+ * @param[out] labels allocated array of class index of each row
+ * @return SparseMatrix* pointer to sparse matrix of samples, NULL if failed
+ */
+SparseMatrix *sparse_load_libsvm(const char *filename, const int n_features, int **labels);
+
+/**
+ * @brief get view of a row without copy
+ * @note the result borrows the arrays of the matrix and must not be deallocated
+ * 
+ * @param[in] matrix source matrix
+ * @param[in] row index of row
+ * @return SparseMatrix 1xN matrix of the row
+ */
+SparseMatrix sparse_row(const SparseMatrix *matrix, const int row);
+
+/**
+ * @brief convert sparse matrix to dense matrix
+ * 
+ * @param[in] matrix source matrix
+ * @param[out] dense n_rows x n_cols matrix
+ * @return float* pointer to dense matrix
+ */
+float *sparse_to_dense(const SparseMatrix *matrix, float *dense);
+
+/**
+ * @brief multiply MxN sparse matrix A and NxP matrix B: C=AB
+ * @note rows of B are read only for nonzeros of A
+ * 
+ * @param[in] a MxN sparse matrix A
+ * @param[in] b NxP matrix B
+ * @param[out] c MxP matrix C
+ * @param[in] p num of columns of matrix B
+ * @return float* pointer to matrix C
+ */
+float *sparse_mat_mul(const SparseMatrix *a, const float *b, float *c, const int p);
+
+/**
+ * @brief multiply MxN sparse matrix A and MxP matrix B and accumulate to C: C=(A^T)B+C
+ * @note only rows of C at columns of nonzeros of A are updated
+ * 
+ * @param[in] a MxN sparse matrix A
+ * @param[in] b MxP matrix B
+ * @param[in,out] c NxP matrix C
+ * @param[in] p num of columns of matrix B
+ * @return float* pointer to matrix C
+ */
+float *sparse_mat_mul_trans_a_acc(const SparseMatrix *a, const float *b, float *c, const int p);
+
+/**
+ * @brief deallocate sparse matrix
+ * 
+ * @param[in,out] matrix sparse matrix to be deallocated
+ */
+void sparse_free(SparseMatrix **matrix);
+
+#endif // SPARSE_H
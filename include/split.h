@@ -0,0 +1,19 @@
+/**
+ * @file split.h
+ * @brief Split layer
+ * 
+ */
+#ifndef SPLIT_H
+#define SPLIT_H
+
+#include "layer.h"
+
+/**
+ * @brief allocate Split layer, which splits an input into multiple output ports
+ * 
+ * @param[in] layer_param layer parameter, .in: size of input, .n_out: num of outputs, .outs: size of each output
+ * @return Layer* pointer to layer structure
+ */
+Layer *split_layer(const LayerParameter layer_param);
+
+#endif // SPLIT_H
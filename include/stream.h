@@ -0,0 +1,158 @@
+/**
+ * @file stream.h
+ * @brief streaming reader of sharded IDX files with a bounded shuffle buffer
+ * 
+ */
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "inflate.h"
+
+/**
+ * @brief num of samples of shuffle buffer if shuffle_size is 0
+ * 
+ */
+#define STREAM_SHUFFLE_SIZE 4096
+
+/**
+ * @brief size of a read if read_size is 0 [byte]
+ * 
+ */
+#define STREAM_READ_SIZE (1 << 20)
+
+/**
+ * @brief alignment of read buffers and size of reads [byte], for O_DIRECT
+ * 
+ */
+#define STREAM_ALIGN 4096
+
+/**
+ * @brief stream parameter structure
+ * 
+ */
+typedef struct StreamParameter {
+    int shuffle_size;   //!< num of samples of shuffle buffer, STREAM_SHUFFLE_SIZE if 0, 1 to keep the order of files and samples
+    int read_size;      //!< size of a read [byte] rounded up to STREAM_ALIGN, STREAM_READ_SIZE if 0
+    bool direct;        //!< read with O_DIRECT bypassing page cache, buffered reads are used if it is not supported
+    float scale;        //!< scale of byte samples, 1 / 255 if 0
+    float offset;       //!< offset added to scaled byte samples
+} StreamParameter;
+
+/**
+ * @brief macro to set StreamParameter
+ * 
+ */
+#define SET_STREAM_PARAM(...) (StreamParameter){ __VA_ARGS__ }
+
+/**
+ * @brief sequential reader of a file with aligned buffer
+ * @note gzip-compressed file is mapped and decoded into the buffer by each read
+ * 
+ */
+typedef struct StreamReader {
+    int fd;             //!< file descriptor, -1 if closed
+    uint8_t *buffer;    //!< read buffer aligned to STREAM_ALIGN
+    size_t begin;       //!< offset of unread bytes in buffer
+    size_t end;         //!< end of read bytes in buffer
+
+    Inflater *inflater; //!< inflater of compressed file, NULL if not compressed
+    void *map;          //!< mapped region of compressed file
+    size_t map_size;    //!< size of mapped region [byte]
+} StreamReader;
+
+/**
+ * @struct
+ * @brief stream structure
+ * @note samples of shards are read sequentially into the shuffle buffer,
+ *       and each sample taken from it is picked at random and replaced with the next one,
+ *       so memory use depends on shuffle_size, not on num of samples
+ * 
+ */
+typedef struct Stream {
+    int n_shards;           //!< num of shards
+    char **image_files;     //!< paths to IDX files of images of shards
+    char **label_files;     //!< paths to IDX files of labels of shards
+    int *shard_sizes;       //!< num of samples of each shard
+    size_t *image_offsets;  //!< offset of the first image of each shard [byte]
+    size_t *label_offsets;  //!< offset of the first label of each shard [byte]
+
+    int size;               //!< num of samples of all shards
+    int x_size;             //!< num of elements of a sample
+    int n_classes;          //!< num of classes
+    StreamParameter param;  //!< stream parameter
+
+    int *order;             //!< order of shards in current epoch
+    int shard;              //!< position in order of the shard being read
+    int remaining;          //!< num of samples not read yet in the shard
+    StreamReader images;    //!< reader of images of the shard
+    StreamReader labels;    //!< reader of labels of the shard
+
+    uint8_t *pool_x;        //!< images of shuffle buffer
+    uint8_t *pool_t;        //!< labels of shuffle buffer
+    int filled;             //!< num of samples in shuffle buffer
+    uint32_t random;        //!< state of PRNG picking samples
+    bool failed;            //!< reading failed or a label is out of range in current epoch
+} Stream;
+
+/**
+ * @brief open stream of shards of IDX files, headers of all files are validated
+ * @note every shard is a pair of files of unsigned byte images and labels of 1 dimension,
+ *       with the same image size, and files may be compressed with gzip,
+ *       which are decoded by stream_read() in the loader thread
+ * 
+ * @param[in] image_files paths to IDX files of images
+ * @param[in] label_files paths to IDX files of labels
+ * @param[in] n_shards num of shards
+ * @param[in] n_classes num of classes
+ * @param[in] param stream parameter
+ * @return Stream* pointer to stream, NULL if failed
+ */
+Stream *stream_open(
+    const char **image_files,
+    const char **label_files,
+    const int n_shards,
+    const int n_classes,
+    const StreamParameter param);
+
+/**
+ * @brief restart stream from the beginning of an epoch
+ * @note order of shards is shuffled with rand_xorshift() unless shuffle_size is 1
+ * 
+ * @param[in,out] stream target stream
+ */
+void stream_rewind(Stream *stream);
+
+/**
+ * @brief read next samples converted to floats
+ * 
+ * @param[in,out] stream target stream
+ * @param[in] count num of samples to read
+ * @param[out] x buffer of count x x_size elements
+ * @param[out] t buffer of count x n_classes elements of one-hot vectors, NULL not to read
+ * @param[out] labels buffer of count class indices, NULL not to read
+ * @return int num of samples read, less than count at the end of epoch or failure of reading
+ * @note the epoch is stopped on failure of reading a file or a label not less than n_classes,
+ *       which is told from its end by stream_failed()
+ */
+int stream_read(Stream *stream, const int count, float *x, float *t, int *labels);
+
+/**
+ * @brief check if current epoch of stream was stopped by a failure
+ * 
+ * @param[in] stream target stream
+ * @return true if reading failed or an invalid label was read since the last rewind
+ */
+bool stream_failed(const Stream *stream);
+
+/**
+ * @brief close files of stream and deallocate it
+ * 
+ * @param[in,out] stream stream to be closed
+ */
+void stream_close(Stream **stream);
+
+#endif // STREAM_H
@@ -0,0 +1,74 @@
+/**
+ * @file thread_pool.h
+ * @brief fixed-size pool of worker threads
+ * 
+ */
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdbool.h>
+#include <pthread.h>
+
+/**
+ * @brief task executed by a worker thread
+ * 
+ */
+typedef struct ThreadPoolTask {
+    void (*func)(void *arg);    //!< task function
+    void *arg;                  //!< argument of task function
+} ThreadPoolTask;
+
+/**
+ * @struct
+ * @brief thread pool structure
+ * 
+ */
+typedef struct ThreadPool {
+    int       size;         //!< num of worker threads
+    pthread_t *threads;     //!< worker threads
+
+    ThreadPoolTask *queue;  //!< ring buffer of queued tasks
+    int capacity;           //!< capacity of the queue
+    int head;               //!< index of the next task to be taken
+    int count;              //!< num of queued tasks
+    int pending;            //!< num of queued and running tasks
+
+    pthread_mutex_t lock;   //!< lock for the queue
+    pthread_cond_t  ready;  //!< signaled when a task is queued
+    pthread_cond_t  done;   //!< signaled when all tasks are finished
+    bool stop;              //!< flag to stop worker threads
+} ThreadPool;
+
+/**
+ * @brief create thread pool
+ * 
+ * @param[in] size num of worker threads
+ * @return ThreadPool* pointer to thread pool
+ */
+ThreadPool *thread_pool_create(const int size);
+
+/**
+ * @brief submit task to thread pool
+ * 
+ * @param[in,out] pool target thread pool
+ * @param[in] func task function
+ * @param[in] arg argument of task function
+ * @return ThreadPool* pointer to the thread pool, NULL if failed
+ */
+ThreadPool *thread_pool_submit(ThreadPool *pool, void (*func)(void *arg), void *arg);
+
+/**
+ * @brief wait until all submitted tasks are finished
+ * 
+ * @param[in,out] pool target thread pool
+ */
+void thread_pool_wait(ThreadPool *pool);
+
+/**
+ * @brief stop worker threads and deallocate thread pool
+ * 
+ * @param[in,out] pool thread pool to be deallocated
+ */
+void thread_pool_free(ThreadPool **pool);
+
+#endif // THREAD_POOL_H
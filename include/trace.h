@@ -0,0 +1,113 @@
+/**
+ * @file trace.h
+ * @brief event tracing in Chrome Trace Event format
+ * @note events are recorded by the library only if NNC_TRACE is defined
+ * 
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+
+/**
+ * @brief category of trace event
+ * 
+ */
+typedef enum TraceCategory {
+    TRACE_CATEGORY_FORWARD,     //!< forward propagation of a layer
+    TRACE_CATEGORY_BACKWARD,    //!< backward propagation of a layer
+    TRACE_CATEGORY_OPTIMIZER,   //!< update of parameters
+    TRACE_CATEGORY_DATA,        //!< preparation of training data
+    TRACE_CATEGORY_TASK,        //!< task of thread pool
+    TRACE_CATEGORY_TRAIN,       //!< epoch and evaluation of training
+    TRACE_CATEGORY_NUM          //!< num of categories
+} TraceCategory;
+
+#ifdef NNC_TRACE
+
+/**
+ * @brief start event, declare a variable to hold the start time
+ * 
+ */
+#define TRACE_BEGIN(start) const double start = trace_now()
+
+/**
+ * @brief finish event and record it
+ * 
+ */
+#define TRACE_END(category, name, arg, start) trace_record((category), (name), (arg), (start))
+
+#else
+
+#define TRACE_BEGIN(start)
+#define TRACE_END(category, name, arg, start)
+
+#endif // NNC_TRACE
+
+/**
+ * @brief start tracing
+ * @note need to be called while no other thread is recording events,
+ *       events recorded so far are discarded
+ * 
+ * @param[in] filename file to be written by trace_dump(), can be NULL
+ * @param[in] capacity max num of events kept per thread, older events are overwritten
+ * @return int 0 if succeeded, -1 if failed
+ */
+int trace_enable(const char *filename, const int capacity);
+
+/**
+ * @brief stop recording events, recorded events are kept
+ * 
+ */
+void trace_disable(void);
+
+/**
+ * @brief get current time for trace event
+ * 
+ * @return double time [s], 0 if tracing is disabled
+ */
+double trace_now(void);
+
+/**
+ * @brief record an event from start time to now to the buffer of the calling thread
+ * @note lock-free, does nothing if tracing is disabled
+ * 
+ * @param[in] category category of event
+ * @param[in] name name of event, need to be a string which lives until the trace is written
+ * @param[in] arg integer argument of event (e.g. layer id), ignored if negative
+ * @param[in] start start time of event from trace_now()
+ */
+void trace_record(const TraceCategory category, const char *name, const int arg, const double start);
+
+/**
+ * @brief get name of category
+ * 
+ * @param[in] category category
+ * @return const char* name of category
+ */
+const char *trace_category_name(const TraceCategory category);
+
+/**
+ * @brief write recorded events as Chrome Trace Event JSON
+ * @note need to be called while no other thread is recording events
+ * 
+ * @param[in] fp output stream
+ * @return int num of written events, -1 if failed
+ */
+int trace_write(FILE *fp);
+
+/**
+ * @brief write recorded events to the file given to trace_enable()
+ * 
+ * @return int num of written events, -1 if tracing is not enabled with a file or failed
+ */
+int trace_dump(void);
+
+/**
+ * @brief stop tracing and deallocate all event buffers
+ * @note need to be called while no other thread is recording events
+ * 
+ */
+void trace_free(void);
+
+#endif // TRACE_H
@@ -6,10 +6,299 @@
 #ifndef TRAINER_H
 #define TRAINER_H
 
+#include "augment.h"
+#include "checkpoint.h"
+#include "dataset.h"
+#include "dist.h"
 #include "net.h"
+#include "optimizer.h"
+#include "stream.h"
+
+/**
+ * @brief num of samples gathered at once by the loader of train() if batch_size is 0
+ * 
+ */
+#define TRAIN_STAGING_SIZE 32
+
+/**
+ * @brief num of samples evaluated with TRAIN_LOSS_SAMPLED if loss_samples is 0
+ * 
+ */
+#define TRAIN_LOSS_SAMPLES 1000
+
+/**
+ * @brief num of samples converted at once to evaluate a dataset backed by bytes
+ * 
+ */
+#define TRAIN_EVAL_CHUNK 1024
+
+/**
+ * @brief calculation of training loss printed after each epoch
+ * 
+ */
+typedef enum TrainLossMode {
+    TRAIN_LOSS_RUNNING,     //!< mean of losses of forward outputs during the epoch, no extra propagation
+    TRAIN_LOSS_SAMPLED,     //!< loss of evenly spaced samples evaluated after the epoch
+    TRAIN_LOSS_FULL         //!< exact loss of all samples evaluated after the epoch
+} TrainLossMode;
+
+/**
+ * @brief training parameter structure
+ * 
+ */
+typedef struct TrainParameter {
+    int epoch;              //!< num of epochs
+    int batch_size;         //!< num of samples of a micro-batch of train_data_parallel() and train_distributed(), 1 if 0
+    Optimizer *optimizer;   //!< optimizer to update parameters
+    float (*loss_func)(const float*, const float*, const int);  //!< loss function
+    int prefetch;           //!< num of batches gathered ahead by a loader thread in train(), data is read in place if 0
+    TrainLossMode loss_mode;    //!< calculation of training loss
+    int loss_samples;           //!< num of samples evaluated with TRAIN_LOSS_SAMPLED, TRAIN_LOSS_SAMPLES if 0
+    int eval_threads;           //!< num of threads of evaluation after each epoch, 1 if 0
+    int shuffle_block;          //!< num of successive data shuffled as a block to keep reads mostly sequential, data is shuffled uniformly if 0
+    int accumulation;           //!< num of micro-batches whose gradients are accumulated per update, 1 if 0, a sample is a micro-batch in train() and train_hogwild()
+    Augmenter *augmenter;       //!< augmenter of training samples in the loader thread of train(), train_dataset() and train_stream(), not augmented if NULL
+    Checkpointer *checkpointer; //!< checkpointer of the network and the optimizer in train(), train_dataset(), train_stream() and train_sparse(), not checkpointed if NULL
+    int checkpoint_interval;    //!< num of epochs between snapshots of checkpointer, 1 if 0, the last epoch is always checkpointed
+} TrainParameter;
+
+/**
+ * @brief macro to set TrainParameter
+ * 
+ */
+#define SET_TRAIN_PARAM(...) (TrainParameter){ __VA_ARGS__ }
+
+/**
+ * @brief train network with optimizer
+ * @note if prefetch is set, a loader thread gathers the next shuffled batches
+ *       of batch_size samples (TRAIN_STAGING_SIZE if 0) into contiguous buffers
+ *       while the current batch is trained, parameters are still updated per sample,
+ *       if the library is built with NNC_TRACE, recorded events are written
+ *       to the file given to trace_enable() at the end of training,
+ *       if checkpointer is set, snapshots are taken after epochs and written in background,
+ *       and training waits for the last checkpoint to be written before it returns
+ * 
+ * @param[in,out] net target network
+ * @param[in] train_x array of training data
+ * @param[in] train_t array of training labels
+ * @param[in] test_x array of test data
+ * @param[in] test_t array of test labels
+ * @param[in] train_data_size num of training data
+ * @param[in] test_data_size num of test data
+ * @param[in] train_param training parameter
+ * @return int 0 if succeeded, -1 if failed
+ */
+int train(
+    Net *net,
+    float **train_x,
+    float **train_t,
+    float **test_x,
+    float **test_t,
+    const int train_data_size,
+    const int test_data_size,
+    const TrainParameter train_param);
+
+/**
+ * @brief train network in parallel with lock-free asynchronous updates (Hogwild)
+ * @note each thread propagates its own replica of the network (see net_replicate()),
+ *       and updates the shared parameters without lock, so results are not reproducible,
+ *       optimizer state such as moments is kept per thread and discarded at the end,
+ *       so the optimizer of train_param only gives the hyper parameters and is not modified,
+ *       throughput in samples/sec is printed with losses of each epoch
+ * 
+ * @param[in,out] net target network
+ * @param[in] train_x array of training data
+ * @param[in] train_t array of training labels
+ * @param[in] test_x array of test data
+ * @param[in] test_t array of test labels
+ * @param[in] train_data_size num of training data
+ * @param[in] test_data_size num of test data
+ * @param[in] train_param training parameter
+ * @param[in] n_threads num of worker threads
+ * @return int 0 if succeeded, -1 if failed
+ */
+int train_hogwild(
+    Net *net,
+    float **train_x,
+    float **train_t,
+    float **test_x,
+    float **test_t,
+    const int train_data_size,
+    const int test_data_size,
+    const TrainParameter train_param,
+    const int n_threads);
+
+/**
+ * @brief train network with synchronous data-parallel mini-batch updates
+ * @note each batch is split into contiguous ranges for the threads, each thread
+ *       sums gradients of its range into a private buffer, and the buffers are
+ *       summed with a tree reduction in fixed order before a single update with
+ *       the mean gradient, so results are bit-identical across runs with the same
+ *       num of threads
+ * 
+ * @param[in,out] net target network
+ * @param[in] train_x array of training data
+ * @param[in] train_t array of training labels
+ * @param[in] test_x array of test data
+ * @param[in] test_t array of test labels
+ * @param[in] train_data_size num of training data
+ * @param[in] test_data_size num of test data
+ * @param[in] train_param training parameter
+ * @param[in] n_threads num of worker threads
+ * @return int 0 if succeeded, -1 if failed
+ */
+int train_data_parallel(
+    Net *net,
+    float **train_x,
+    float **train_t,
+    float **test_x,
+    float **test_t,
+    const int train_data_size,
+    const int test_data_size,
+    const TrainParameter train_param,
+    const int n_threads);
+
+/**
+ * @brief train replicas of network in processes with synchronous data-parallel mini-batch updates
+ * @note each batch is split into contiguous ranges for the processes, and gradients are
+ *       summed with dist_allreduce() before a single update in each process,
+ *       parameters of rank 0 are copied to the other processes at the start, and all processes need
+ *       the same training data and random state to shuffle in the same order,
+ *       losses are printed only by rank 0
+ * 
+ * @param[in,out] net target network
+ * @param[in] train_x array of training data
+ * @param[in] train_t array of training labels
+ * @param[in] test_x array of test data
+ * @param[in] test_t array of test labels
+ * @param[in] train_data_size num of training data
+ * @param[in] test_data_size num of test data
+ * @param[in] train_param training parameter
+ * @param[in,out] dist process group
+ * @return int 0 if succeeded, -1 if failed
+ */
+int train_distributed(
+    Net *net,
+    float **train_x,
+    float **train_t,
+    float **test_x,
+    float **test_t,
+    const int train_data_size,
+    const int test_data_size,
+    const TrainParameter train_param,
+    Dist *dist);
+
+/**
+ * @brief train network with optimizer on datasets
+ * @note same as train() with rows of datasets,
+ *       sizes of samples and labels must match the input and output of the network,
+ *       datasets backed by bytes are converted when they are gathered,
+ *       training data of them is always read through a loader thread (prefetch is 1 at least),
+ *       as well as training data augmented by the augmenter of train_param,
+ *       class labels are given to the network as indices if loss_func has loss_label_func()
+ * 
+ * @param[in,out] net target network
+ * @param[in] train_data training dataset
+ * @param[in] test_data test dataset, NULL if not evaluated
+ * @param[in] train_param training parameter
+ * @return int 0 if succeeded, -1 if failed
+ */
+int train_dataset(Net *net, const Dataset *train_data, const Dataset *test_data, const TrainParameter train_param);
+
+/**
+ * @brief train network with optimizer on stream of samples larger than memory
+ * @note same as train_dataset() with samples read by a loader thread from the stream,
+ *       which is rewound and shuffled through its buffer at each epoch,
+ *       training loss is always the running loss
+ * 
+ * @param[in,out] net target network
+ * @param[in,out] stream training stream, its samples and classes must match the input and output of the network
+ * @param[in] test_data test dataset, NULL if not evaluated
+ * @param[in] train_param training parameter
+ * @return int 0 if succeeded, -1 if failed, including an epoch stopped by a failure of reading the stream
+ */
+int train_stream(Net *net, Stream *stream, const Dataset *test_data, const TrainParameter train_param);
+
+/**
+ * @brief train network with optimizer on sparse samples of class labels
+ * @note samples are given to the network by net_forward_sparse() without densifying them,
+ *       so cost of the first layers, including the updates of their weights, scales with nonzeros
+ *       (see optimizer_step()), loss_func must have loss_label_func(),
+ *       and batch_size and prefetch are not used, training loss is always the running loss
+ * 
+ * @param[in,out] net target network, whose layers taking input are Fully connected
+ * @param[in] train_x sparse training samples
+ * @param[in] train_labels class index of each training sample
+ * @param[in] test_x sparse test samples, NULL if not evaluated
+ * @param[in] test_labels class index of each test sample
+ * @param[in] train_param training parameter
+ * @return int 0 if succeeded, -1 if failed
+ */
+int train_sparse(
+    Net *net,
+    const SparseMatrix *train_x,
+    const int *train_labels,
+    const SparseMatrix *test_x,
+    const int *test_labels,
+    const TrainParameter train_param);
+
+/**
+ * @brief train network in parallel with lock-free asynchronous updates (Hogwild) on datasets
+ * @note same as train_hogwild() with rows of datasets, datasets backed by bytes are not supported
+ * 
+ * @param[in,out] net target network
+ * @param[in] train_data training dataset
+ * @param[in] test_data test dataset, NULL if not evaluated
+ * @param[in] train_param training parameter
+ * @param[in] n_threads num of worker threads
+ * @return int 0 if succeeded, -1 if failed
+ */
+int train_hogwild_dataset(
+    Net *net,
+    const Dataset *train_data,
+    const Dataset *test_data,
+    const TrainParameter train_param,
+    const int n_threads);
+
+/**
+ * @brief train network with synchronous data-parallel updates on datasets
+ * @note same as train_data_parallel() with rows of datasets, datasets backed by bytes are not supported
+ * 
+ * @param[in,out] net target network
+ * @param[in] train_data training dataset
+ * @param[in] test_data test dataset, NULL if not evaluated
+ * @param[in] train_param training parameter
+ * @param[in] n_threads num of worker threads
+ * @return int 0 if succeeded, -1 if failed
+ */
+int train_data_parallel_dataset(
+    Net *net,
+    const Dataset *train_data,
+    const Dataset *test_data,
+    const TrainParameter train_param,
+    const int n_threads);
+
+/**
+ * @brief train network with data-parallel updates over processes on datasets
+ * @note same as train_distributed() with rows of datasets, datasets backed by bytes are not supported
+ * 
+ * @param[in,out] net target network
+ * @param[in] train_data training dataset
+ * @param[in] test_data test dataset, NULL if not evaluated
+ * @param[in] train_param training parameter
+ * @param[in,out] dist process group
+ * @return int 0 if succeeded, -1 if failed
+ */
+int train_distributed_dataset(
+    Net *net,
+    const Dataset *train_data,
+    const Dataset *test_data,
+    const TrainParameter train_param,
+    Dist *dist);
 
 /**
  * @brief train network with SGD (Stochastic Gradient Descent)
+ * @note same as train() with an optimizer of OPTIMIZER_TYPE_SGD
  * 
  * @param[in,out] net target network
  * @param[in] train_x array of training data
@@ -0,0 +1,88 @@
+/**
+ * @file add.c
+ * @brief Add layer
+ * 
+ */
+#include "add.h"
+
+#include "data.h"
+#include "mat.h"
+
+/**
+ * @brief forward propagation of Add layer
+ * 
+ * @param self target layer
+ * @param x first layer input, the others are taken from self->xs
+ */
+static void forward(Layer *self, const float *x)
+{
+    self->x = x;
+
+    // y = x0 + x1 + ...
+    fdata_copy(self->xs[0], self->y_size, self->y);
+    for (int i = 1; i < self->n_in; i++) {
+        mat_add(self->y, self->xs[i], self->y, 1, self->y_size);
+    }
+}
+
+/**
+ * @brief backward propagation of Add layer
+ * 
+ * @param self target layer
+ * @param dy diff of next layer
+ */
+static void backward(Layer *self, const float *dy)
+{
+    // all of inputs share the same diff
+    fdata_copy(dy, self->y_size, self->dx);
+}
+
+Layer *add_layer(const LayerParameter layer_param)
+{
+    if ((layer_param.in < 1) || (layer_param.n_in < 2) || (layer_param.n_in > LAYER_IN_MAX)) {
+        return NULL;
+    }
+
+    Layer *layer = layer_alloc();
+    if (layer == NULL) {
+        return NULL;
+    }
+
+    int x_size = 1 * layer_param.in * 1 * 1;
+    SET_DIM(layer->x_dim, 1, layer_param.in, 1, 1);
+    layer->x_size = x_size;
+
+    int y_size = 1 * layer_param.in * 1 * 1;
+    SET_DIM(layer->y_dim, 1, layer_param.in, 1, 1);
+    layer->y_size = y_size;
+
+    layer->y = fdata_alloc(y_size);
+    if (layer->y == NULL) {
+        goto LAYER_FREE;
+    }
+
+    layer->dx = fdata_alloc(x_size);
+    if (layer->dx == NULL) {
+        goto LAYER_FREE;
+    }
+
+    layer->n_in = layer_param.n_in;
+    for (int i = 0; i < layer->n_in; i++) {
+        layer->xs_size[i] = x_size;
+        layer->dxs[i]     = layer->dx;
+    }
+    layer->ys_size[0] = y_size;
+
+    layer->type  = LAYER_TYPE_ADD;
+    layer->param = layer_param;
+
+    layer->forward  = forward;
+    layer->backward = backward;
+
+    return layer;
+
+LAYER_FREE:
+    layer_free(&layer);
+
+    return NULL;
+}
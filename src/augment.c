@@ -0,0 +1,357 @@
+/**
+ * @file augment.c
+ * @brief random geometric augmentation of image batches
+ * 
+ */
+#include "augment.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "data.h"
+#include "util.h"
+
+// pi constant
+static const float PI = 3.141592;
+
+/**
+ * @brief inverse affine transform from output pixels to source pixels
+ * @note source of pixel (u, v) is (a * u + b * v + c, d * u + e * v + f)
+ * 
+ */
+typedef struct Transform {
+    float a, b, c;
+    float d, e, f;
+} Transform;
+
+/**
+ * @brief mix bits of 64-bit value by SplitMix64
+ * 
+ * @param[in] value source value
+ * @return uint64_t mixed value
+ */
+static uint64_t mix(uint64_t value)
+{
+    value += 0x9e3779b97f4a7c15;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+
+    return value ^ (value >> 31);
+}
+
+/**
+ * @brief get next pseudorandom number of a stream by Xorshift
+ * 
+ * @param[in,out] state state of stream
+ * @return uint32_t pseudorandom number
+ */
+static uint32_t next_random(uint32_t *state)
+{
+    uint32_t r = *state;
+    r ^= r << 13;
+    r ^= r >> 17;
+    r ^= r << 5;
+    *state = r;
+
+    return r;
+}
+
+/**
+ * @brief get pseudorandom number of a stream within [-1, 1]
+ * 
+ * @param[in,out] state state of stream
+ * @return float pseudorandom number
+ */
+static float next_signed(uint32_t *state)
+{
+    return (float)(next_random(state) >> 8) / (float)(1 << 23) - 1.0f;
+}
+
+/**
+ * @brief draw random transform of a sample
+ * 
+ * @param[in] param augmentation parameter
+ * @param[in] epoch index of epoch
+ * @param[in] position position of sample in epoch
+ * @return Transform inverse transform of the sample
+ */
+static Transform draw_transform(const AugmentParameter *param, const int epoch, const uint64_t position)
+{
+    // stream of the sample, never zero
+    uint32_t state = (uint32_t)mix(mix(((uint64_t)param->seed << 32) | (uint32_t)epoch) ^ position) | 1;
+
+    float tx = 0;
+    float ty = 0;
+    if (param->max_shift > 0) {
+        const uint32_t n = 2 * (uint32_t)param->max_shift + 1;
+        tx = (float)(int)(next_random(&state) % n) - param->max_shift;
+        ty = (float)(int)(next_random(&state) % n) - param->max_shift;
+    }
+
+    // a crop of ratio k is resized by 1/k
+    float k = 1;
+    if ((param->min_crop > 0) && (param->min_crop < 1)) {
+        k = param->min_crop + (1 - param->min_crop) * (next_signed(&state) + 1) / 2;
+    }
+
+    float angle = 0;
+    if (param->max_rotation > 0) {
+        angle = param->max_rotation * next_signed(&state) * PI / 180;
+    }
+
+    const float flip = (param->flip && (next_random(&state) & 0x80000000)) ? -1 : 1;
+
+    // source is flip(R(-angle) * k * (output - center - shift)) + center
+    const float cos_k = cosf(angle) * k;
+    const float sin_k = sinf(angle) * k;
+    const float cx = (param->width - 1) / 2.0f;
+    const float cy = (param->height - 1) / 2.0f;
+    const float ox = -cx - tx;
+    const float oy = -cy - ty;
+
+    return (Transform){
+        .a = flip * cos_k,
+        .b = flip * sin_k,
+        .c = flip * (cos_k * ox + sin_k * oy) + cx,
+        .d = -sin_k,
+        .e = cos_k,
+        .f = -sin_k * ox + cos_k * oy + cy
+    };
+}
+
+/**
+ * @brief get pixel of source plane
+ * 
+ * @param[in] src source plane
+ * @param[in] width width of plane
+ * @param[in] height height of plane
+ * @param[in] x column of pixel
+ * @param[in] y row of pixel
+ * @param[in] fill value outside of plane
+ * @return float value of pixel
+ */
+static inline float pixel(
+    const float *src, const int width, const int height, const int x, const int y, const float fill)
+{
+    if ((x < 0) || (x >= width) || (y < 0) || (y >= height)) {
+        return fill;
+    }
+
+    return src[y * width + x];
+}
+
+/**
+ * @brief resample a row of output plane bilinearly
+ * 
+ * @param[in] src source plane
+ * @param[in] width width of plane
+ * @param[in] height height of plane
+ * @param[in] tf inverse transform
+ * @param[in] v row of output
+ * @param[in] fill value outside of source
+ * @param[out] dest row of output plane
+ */
+static void sample_row(
+    const float *src,
+    const int width,
+    const int height,
+    const Transform *tf,
+    const int v,
+    const float fill,
+    float *dest)
+{
+    const float row_x = tf->b * v + tf->c;
+    const float row_y = tf->e * v + tf->f;
+
+    int u = 0;
+#ifdef __SSE2__
+    // coordinates and weights of 4 pixels are computed at once,
+    // only 4 corners of each pixel are loaded one by one
+    const __m128 step   = _mm_set_ps(3, 2, 1, 0);
+    const __m128 one    = _mm_set1_ps(1);
+    const __m128 a4     = _mm_set1_ps(tf->a);
+    const __m128 d4     = _mm_set1_ps(tf->d);
+    const __m128 row_x4 = _mm_set1_ps(row_x);
+    const __m128 row_y4 = _mm_set1_ps(row_y);
+    for (; (u + 4) <= width; u += 4) {
+        const __m128 u4 = _mm_add_ps(_mm_set1_ps((float)u), step);
+        const __m128 sx = _mm_add_ps(_mm_mul_ps(a4, u4), row_x4);
+        const __m128 sy = _mm_add_ps(_mm_mul_ps(d4, u4), row_y4);
+
+        // floor by truncation corrected for negative coordinates
+        __m128 fx = _mm_cvtepi32_ps(_mm_cvttps_epi32(sx));
+        __m128 fy = _mm_cvtepi32_ps(_mm_cvttps_epi32(sy));
+        fx = _mm_sub_ps(fx, _mm_and_ps(_mm_cmpgt_ps(fx, sx), one));
+        fy = _mm_sub_ps(fy, _mm_and_ps(_mm_cmpgt_ps(fy, sy), one));
+
+        const __m128 wx = _mm_sub_ps(sx, fx);
+        const __m128 wy = _mm_sub_ps(sy, fy);
+
+        int32_t ix[4], iy[4];
+        _mm_storeu_si128((__m128i*)ix, _mm_cvttps_epi32(fx));
+        _mm_storeu_si128((__m128i*)iy, _mm_cvttps_epi32(fy));
+
+        float p00[4], p01[4], p10[4], p11[4];
+        for (int k = 0; k < 4; k++) {
+            p00[k] = pixel(src, width, height, ix[k],     iy[k],     fill);
+            p01[k] = pixel(src, width, height, ix[k] + 1, iy[k],     fill);
+            p10[k] = pixel(src, width, height, ix[k],     iy[k] + 1, fill);
+            p11[k] = pixel(src, width, height, ix[k] + 1, iy[k] + 1, fill);
+        }
+
+        const __m128 c00 = _mm_loadu_ps(p00);
+        const __m128 c10 = _mm_loadu_ps(p10);
+        const __m128 top    = _mm_add_ps(c00, _mm_mul_ps(wx, _mm_sub_ps(_mm_loadu_ps(p01), c00)));
+        const __m128 bottom = _mm_add_ps(c10, _mm_mul_ps(wx, _mm_sub_ps(_mm_loadu_ps(p11), c10)));
+
+        _mm_storeu_ps(&dest[u], _mm_add_ps(top, _mm_mul_ps(wy, _mm_sub_ps(bottom, top))));
+    }
+#endif
+    for (; u < width; u++) {
+        const float sx = tf->a * u + row_x;
+        const float sy = tf->d * u + row_y;
+        const float fx = floorf(sx);
+        const float fy = floorf(sy);
+        const float wx = sx - fx;
+        const float wy = sy - fy;
+        const int ix = (int)fx;
+        const int iy = (int)fy;
+
+        const float p00 = pixel(src, width, height, ix,     iy,     fill);
+        const float p01 = pixel(src, width, height, ix + 1, iy,     fill);
+        const float p10 = pixel(src, width, height, ix,     iy + 1, fill);
+        const float p11 = pixel(src, width, height, ix + 1, iy + 1, fill);
+
+        const float top    = p00 + wx * (p01 - p00);
+        const float bottom = p10 + wx * (p11 - p10);
+
+        dest[u] = top + wy * (bottom - top);
+    }
+}
+
+/**
+ * @brief augment a range of batch
+ * 
+ * @param[in,out] arg range of batch
+ */
+static void augment_task(void *arg)
+{
+    const AugmentTask *task = (const AugmentTask*)arg;
+    const AugmentParameter *param = &task->augmenter->param;
+
+    const int x_size = task->augmenter->x_size;
+    const int plane_size = param->height * param->width;
+
+    for (int i = 0; i < task->size; i++) {
+        float *x = task->x + (size_t)i * x_size;
+        const Transform tf = draw_transform(param, task->epoch, (task->position + i));
+
+        fdata_copy(x, x_size, task->scratch);
+
+        // all channels are transformed alike
+        for (int ch = 0; ch < param->channels; ch++) {
+            const float *src = task->scratch + ch * plane_size;
+            float *dest = x + ch * plane_size;
+            for (int v = 0; v < param->height; v++) {
+                sample_row(src, param->width, param->height, &tf, v, param->fill, (dest + v * param->width));
+            }
+        }
+    }
+}
+
+Augmenter *augmenter_create(const AugmentParameter param)
+{
+    AugmentParameter p = param;
+    if (p.channels == 0) {
+        p.channels = 1;
+    }
+
+    if ((p.channels < 1) || (p.height < 1) || (p.width < 1) || (p.max_shift < 0) ||
+        (p.min_crop < 0) || (p.min_crop > 1) || (p.max_rotation < 0) || (p.n_threads < 0)) {
+        return NULL;
+    }
+
+    Augmenter *augmenter = malloc(sizeof(Augmenter));
+    if (augmenter == NULL) {
+        return NULL;
+    }
+
+    augmenter->param   = p;
+    augmenter->x_size  = p.channels * p.height * p.width;
+    augmenter->pool    = NULL;
+    augmenter->n_tasks = (p.n_threads > 1) ? p.n_threads : 1;
+
+    augmenter->tasks   = malloc(sizeof(AugmentTask) * augmenter->n_tasks);
+    augmenter->scratch = fdata_alloc_aligned((size_t)augmenter->n_tasks * augmenter->x_size);
+    if ((augmenter->tasks == NULL) || (augmenter->scratch == NULL)) {
+        goto AUGMENTER_FREE;
+    }
+
+    if (p.n_threads > 1) {
+        augmenter->pool = thread_pool_create(p.n_threads);
+        if (augmenter->pool == NULL) {
+            goto AUGMENTER_FREE;
+        }
+    }
+
+    return augmenter;
+
+AUGMENTER_FREE:
+    augmenter_free(&augmenter);
+
+    return NULL;
+}
+
+void augment_batch(Augmenter *augmenter, float *x, const int size, const int epoch, const uint64_t position)
+{
+    if ((augmenter == NULL) || (x == NULL) || (size < 1)) {
+        return;
+    }
+
+    // contiguous ranges, one per thread
+    const int n_tasks = (size < augmenter->n_tasks) ? size : augmenter->n_tasks;
+    int begin = 0;
+    for (int i = 0; i < n_tasks; i++) {
+        const int end = (int)((int64_t)size * (i + 1) / n_tasks);
+
+        augmenter->tasks[i] = (AugmentTask){
+            .augmenter = augmenter,
+            .x         = x + (size_t)begin * augmenter->x_size,
+            .size      = end - begin,
+            .position  = position + begin,
+            .epoch     = epoch,
+            .scratch   = augmenter->scratch + (size_t)i * augmenter->x_size
+        };
+        begin = end;
+    }
+
+    if (augmenter->pool == NULL) {
+        augment_task(&augmenter->tasks[0]);
+        return;
+    }
+
+    for (int i = 0; i < n_tasks; i++) {
+        if (thread_pool_submit(augmenter->pool, augment_task, &augmenter->tasks[i]) == NULL) {
+            // run by the caller if the queue cannot grow
+            augment_task(&augmenter->tasks[i]);
+        }
+    }
+    thread_pool_wait(augmenter->pool);
+}
+
+void augmenter_free(Augmenter **augmenter)
+{
+    if (*augmenter == NULL) {
+        return;
+    }
+
+    thread_pool_free(&(*augmenter)->pool);
+    FREE_WITH_NULL(&(*augmenter)->tasks);
+    FREE_WITH_NULL(&(*augmenter)->scratch);
+
+    FREE_WITH_NULL(augmenter);
+}
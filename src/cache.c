@@ -0,0 +1,456 @@
+/**
+ * @file cache.c
+ * @brief binary cache of preprocessed dataset mapped into memory
+ * 
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "cache.h"
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "data.h"
+#include "util.h"
+
+// num of samples gathered and written at once
+#define CACHE_CHUNK 256
+
+// suffix of temporary file written before it replaces the cache
+#define CACHE_TMP_SUFFIX ".tmp"
+
+/**
+ * @brief round up offset to a multiple of DATA_ALIGN
+ * 
+ * @param[in] offset offset [byte]
+ * @return uint64_t aligned offset [byte]
+ */
+static uint64_t align_offset(const uint64_t offset)
+{
+    return (offset + DATA_ALIGN - 1) / DATA_ALIGN * DATA_ALIGN;
+}
+
+/**
+ * @brief get size of labels in cache
+ * 
+ * @param[in] header header of cache
+ * @return uint64_t size of labels [byte]
+ */
+static uint64_t labels_size(const CacheHeader *header)
+{
+    if (header->t_type == IDX_TYPE_UBYTE) {
+        return (uint64_t)header->size;
+    }
+
+    return (uint64_t)header->size * header->t_size * sizeof(float);
+}
+
+/**
+ * @brief set offsets and file size of header from its shape
+ * 
+ * @param[in,out] header header of cache
+ */
+static void set_layout(CacheHeader *header)
+{
+    header->x_offset  = align_offset(sizeof(CacheHeader));
+    header->t_offset  = align_offset(header->x_offset + (uint64_t)header->size * header->x_size * sizeof(float));
+    header->file_size = header->t_offset + labels_size(header);
+}
+
+/**
+ * @brief validate header of cache
+ * 
+ * @param[in] header header of cache
+ * @param[in] file_size actual size of cache file [byte]
+ * @return true if header is valid
+ */
+static bool check_header(const CacheHeader *header, const uint64_t file_size)
+{
+    if ((memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) != 0) ||
+        (header->version != CACHE_VERSION) || (header->byte_order != CACHE_BYTE_ORDER)) {
+        return false;
+    }
+
+    if ((header->x_type != IDX_TYPE_FLOAT) ||
+        ((header->t_type != IDX_TYPE_UBYTE) && (header->t_type != IDX_TYPE_FLOAT))) {
+        return false;
+    }
+    if ((header->size < 1) || (header->x_size < 1) || (header->t_size < 1) ||
+        ((header->t_type == IDX_TYPE_UBYTE) && (header->t_size > (UINT8_MAX + 1)))) {
+        return false;
+    }
+
+    if ((header->n_dims < 1) || (header->n_dims > IDX_MAX_DIMS)) {
+        return false;
+    }
+    int64_t n_elements = 1;
+    for (int i = 0; i < header->n_dims; i++) {
+        if ((header->dims[i] < 1) || (header->dims[i] > header->x_size)) {
+            return false;
+        }
+        n_elements *= header->dims[i];
+        if (n_elements > header->x_size) {
+            return false;
+        }
+    }
+    if (n_elements != header->x_size) {
+        return false;
+    }
+
+    // offsets are derived from the shape
+    CacheHeader layout = *header;
+    set_layout(&layout);
+
+    return (header->x_offset == layout.x_offset) &&
+           (header->t_offset == layout.t_offset) &&
+           (header->file_size == layout.file_size) &&
+           (file_size == layout.file_size);
+}
+
+/**
+ * @brief write zeros to fill the gap up to an offset
+ * 
+ * @param[in,out] fp target file
+ * @param[in] offset offset to be reached [byte]
+ * @return true if succeeded
+ */
+static bool write_padding(FILE *fp, const uint64_t offset)
+{
+    static const uint8_t zeros[DATA_ALIGN] = { 0 };
+
+    const long pos = ftell(fp);
+    if ((pos < 0) || ((uint64_t)pos > offset) || ((offset - pos) > DATA_ALIGN)) {
+        return false;
+    }
+
+    const size_t n = (size_t)(offset - pos);
+
+    return fwrite(zeros, 1, n, fp) == n;
+}
+
+/**
+ * @brief write samples and labels of dataset following header
+ * 
+ * @param[in,out] fp target file at its beginning
+ * @param[in] dataset source dataset
+ * @param[in] header header of cache
+ * @return true if succeeded
+ */
+static bool write_cache(FILE *fp, const Dataset *dataset, const CacheHeader *header)
+{
+    const bool class_labels = (header->t_type == IDX_TYPE_UBYTE);
+    const int x_size = dataset->x_size;
+    const int t_size = dataset->t_size;
+
+    int *indices  = malloc(sizeof(int) * CACHE_CHUNK);
+    float *x      = fdata_alloc_aligned((size_t)CACHE_CHUNK * x_size);
+    float *t      = class_labels ? NULL : fdata_alloc(labels_size(header) / sizeof(float));
+    int *labels   = class_labels ? malloc(sizeof(int) * CACHE_CHUNK) : NULL;
+    uint8_t *t_u8 = class_labels ? malloc(dataset->size) : NULL;
+
+    bool written = false;
+
+    if ((indices == NULL) || (x == NULL) || ((t == NULL) && (t_u8 == NULL)) || (class_labels && (labels == NULL))) {
+        goto WRITE_FREE;
+    }
+
+    if ((fwrite(header, sizeof(CacheHeader), 1, fp) != 1) || !write_padding(fp, header->x_offset)) {
+        goto WRITE_FREE;
+    }
+
+    // samples are written chunk by chunk, and labels are kept until the end
+    for (int begin = 0; begin < dataset->size; begin += CACHE_CHUNK) {
+        const int count = ((dataset->size - begin) < CACHE_CHUNK) ? (dataset->size - begin) : CACHE_CHUNK;
+        for (int i = 0; i < count; i++) {
+            indices[i] = begin + i;
+        }
+
+        if (class_labels) {
+            dataset_gather(dataset, indices, count, x, NULL);
+            dataset_gather_labels(dataset, indices, count, labels);
+            for (int i = 0; i < count; i++) {
+                t_u8[begin + i] = (uint8_t)labels[i];
+            }
+        } else {
+            dataset_gather(dataset, indices, count, x, (t + (size_t)begin * t_size));
+        }
+
+        if (fwrite(x, (sizeof(float) * x_size), count, fp) != (size_t)count) {
+            goto WRITE_FREE;
+        }
+    }
+
+    if (!write_padding(fp, header->t_offset)) {
+        goto WRITE_FREE;
+    }
+    if (class_labels) {
+        written = (fwrite(t_u8, 1, dataset->size, fp) == (size_t)dataset->size);
+    } else {
+        written = (fwrite(t, (sizeof(float) * t_size), dataset->size, fp) == (size_t)dataset->size);
+    }
+
+WRITE_FREE:
+    FREE_WITH_NULL(&indices);
+    FREE_WITH_NULL(&x);
+    FREE_WITH_NULL(&t);
+    FREE_WITH_NULL(&labels);
+    FREE_WITH_NULL(&t_u8);
+
+    return written;
+}
+
+int dataset_cache_build(const Dataset *dataset, const int n_dims, const int *dims, const char *filename)
+{
+    if ((dataset == NULL) || (filename == NULL) ||
+        (dataset->size < 1) || (dataset->x_size < 1) || (dataset->t_size < 1) ||
+        (n_dims < 0) || (n_dims > IDX_MAX_DIMS) || ((n_dims > 0) && (dims == NULL)) ||
+        !dataset_check_labels(dataset)) {
+        return -1;
+    }
+
+    CacheHeader header = {
+        .version    = CACHE_VERSION,
+        .byte_order = CACHE_BYTE_ORDER,
+        .x_type     = IDX_TYPE_FLOAT,
+        .t_type     = dataset_has_class_labels(dataset) ? IDX_TYPE_UBYTE : IDX_TYPE_FLOAT,
+        .size       = dataset->size,
+        .x_size     = dataset->x_size,
+        .t_size     = dataset->t_size,
+        .n_dims     = (n_dims > 0) ? n_dims : 1,
+        .dims       = { 0 }
+    };
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    if (n_dims > 0) {
+        memcpy(header.dims, dims, (sizeof(int32_t) * n_dims));
+    } else {
+        header.dims[0] = dataset->x_size;
+    }
+    set_layout(&header);
+
+    if (!check_header(&header, header.file_size)) {
+        return -1;
+    }
+
+    char *tmp_filename = malloc(strlen(filename) + sizeof(CACHE_TMP_SUFFIX));
+    if (tmp_filename == NULL) {
+        return -1;
+    }
+    strcpy(tmp_filename, filename);
+    strcat(tmp_filename, CACHE_TMP_SUFFIX);
+
+    FILE *fp = fopen(tmp_filename, "wb");
+    if (fp == NULL) {
+        FREE_WITH_NULL(&tmp_filename);
+        return -1;
+    }
+
+    // the cache is complete on disk before it replaces the old one
+    bool written = write_cache(fp, dataset, &header) && (fflush(fp) == 0) && (fsync(fileno(fp)) == 0);
+    written = (fclose(fp) == 0) && written;
+    if (written) {
+        written = (rename(tmp_filename, filename) == 0);
+    }
+    if (!written) {
+        remove(tmp_filename);
+    }
+
+    FREE_WITH_NULL(&tmp_filename);
+
+    return written ? 0 : -1;
+}
+
+/**
+ * @brief read and validate header of opened cache file
+ * 
+ * @param[in] fd file descriptor of cache file
+ * @param[out] header header of cache file
+ * @return true if the header is valid
+ */
+static bool read_header(const int fd, CacheHeader *header)
+{
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (st.st_size < (off_t)sizeof(CacheHeader))) {
+        return false;
+    }
+
+    if (pread(fd, header, sizeof(CacheHeader), 0) != (ssize_t)sizeof(CacheHeader)) {
+        return false;
+    }
+
+    return check_header(header, (uint64_t)st.st_size);
+}
+
+int dataset_cache_read_header(const char *filename, CacheHeader *header)
+{
+    if ((filename == NULL) || (header == NULL)) {
+        return -1;
+    }
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    const bool valid = read_header(fd, header);
+    close(fd);
+
+    return valid ? 0 : -1;
+}
+
+Dataset *dataset_cache_open(const char *filename)
+{
+    if (filename == NULL) {
+        return NULL;
+    }
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    CacheHeader header;
+    if (!read_header(fd, &header)) {
+        close(fd);
+        return NULL;
+    }
+
+    // the mapping is kept after closing the descriptor
+    void *map = mmap(NULL, header.file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    const bool class_labels = (header.t_type == IDX_TYPE_UBYTE);
+    uint8_t *bytes = (uint8_t*)map;
+
+    // class indices are expanded without bounds checks when they are gathered
+    if (class_labels) {
+        for (int i = 0; i < header.size; i++) {
+            if (bytes[header.t_offset + i] >= header.t_size) {
+                munmap(map, header.file_size);
+                return NULL;
+            }
+        }
+    }
+
+    Dataset *dataset = malloc(sizeof(Dataset));
+    if (dataset == NULL) {
+        munmap(map, header.file_size);
+        return NULL;
+    }
+
+    *dataset = (Dataset){
+        .size     = header.size,
+        .x_size   = header.x_size,
+        .t_size   = header.t_size,
+        .x        = (float*)(bytes + header.x_offset),
+        .t        = class_labels ? NULL : (float*)(bytes + header.t_offset),
+        .xs       = malloc(sizeof(float*) * header.size),
+        .ts       = class_labels ? NULL : malloc(sizeof(float*) * header.size),
+        .x_u8     = NULL,
+        .t_u8     = class_labels ? (bytes + header.t_offset) : NULL,
+        .x_scale  = 1.0f,
+        .x_offset = 0.0f,
+        .owner    = false,
+        .map      = map,
+        .map_size = header.file_size
+    };
+    if ((dataset->xs == NULL) || (!class_labels && (dataset->ts == NULL))) {
+        dataset_free(&dataset);
+        return NULL;
+    }
+
+    for (int i = 0; i < header.size; i++) {
+        dataset->xs[i] = dataset->x + (size_t)i * header.x_size;
+        if (!class_labels) {
+            dataset->ts[i] = dataset->t + (size_t)i * header.t_size;
+        }
+    }
+
+    return dataset;
+}
+
+/**
+ * @brief check that cache file is not older than a source file
+ * @note a cache of a removed source is kept
+ * 
+ * @param[in] cache status of cache file
+ * @param[in] source path to source file
+ * @return true if the cache is modified after the source, or the source does not exist
+ */
+static bool newer_than(const struct stat *cache, const char *source)
+{
+    struct stat st;
+    if (stat(source, &st) != 0) {
+        return true;
+    }
+
+    if (cache->st_mtim.tv_sec != st.st_mtim.tv_sec) {
+        return cache->st_mtim.tv_sec > st.st_mtim.tv_sec;
+    }
+
+    return cache->st_mtim.tv_nsec >= st.st_mtim.tv_nsec;
+}
+
+/**
+ * @brief build cache of IDX files of byte images and labels
+ * 
+ * @param[in] filename path to cache file
+ * @param[in] images path to IDX file of images
+ * @param[in] labels path to IDX file of labels
+ * @param[in] n_classes num of classes
+ * @return int 0 if succeeded, -1 if failed
+ */
+static int build_from_idx(const char *filename, const char *images, const char *labels, const int n_classes)
+{
+    int result = -1;
+
+    IdxFile *image_file = idx_open(images);
+    IdxFile *label_file = idx_open(labels);
+    if ((image_file == NULL) || (label_file == NULL)) {
+        goto BUILD_FREE;
+    }
+
+    Dataset *dataset = dataset_from_idx(image_file, label_file, n_classes);
+    if (dataset == NULL) {
+        goto BUILD_FREE;
+    }
+
+    // the first dimension of images is num of items
+    result = dataset_cache_build(dataset, (image_file->n_dims - 1), (image_file->dims + 1), filename);
+
+    dataset_free(&dataset);
+
+BUILD_FREE:
+    idx_close(&image_file);
+    idx_close(&label_file);
+
+    return result;
+}
+
+Dataset *dataset_cache_load(const char *filename, const char *images, const char *labels, const int n_classes)
+{
+    if ((filename == NULL) || (images == NULL) || (labels == NULL) || (n_classes < 1)) {
+        return NULL;
+    }
+
+    struct stat st;
+    CacheHeader header;
+    const bool fresh = (stat(filename, &st) == 0) &&
+                       newer_than(&st, images) && newer_than(&st, labels) &&
+                       (dataset_cache_read_header(filename, &header) == 0) &&
+                       (header.t_type == IDX_TYPE_UBYTE) && (header.t_size == n_classes);
+
+    if (!fresh && (build_from_idx(filename, images, labels, n_classes) != 0)) {
+        return NULL;
+    }
+
+    return dataset_cache_open(filename);
+}
@@ -0,0 +1,738 @@
+/**
+ * @file checkpoint.c
+ * @brief binary checkpoint of network topology and parameters
+ * 
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "checkpoint.h"
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "data.h"
+#include "trace.h"
+#include "util.h"
+
+// suffix of temporary file written before it replaces the checkpoint
+#define CHECKPOINT_TMP_SUFFIX ".tmp"
+
+/**
+ * @brief round up offset to a multiple of CHECKPOINT_ALIGN
+ * 
+ * @param[in] offset offset [byte]
+ * @return uint64_t aligned offset [byte]
+ */
+static uint64_t align_offset(const uint64_t offset)
+{
+    return (offset + CHECKPOINT_ALIGN - 1) / CHECKPOINT_ALIGN * CHECKPOINT_ALIGN;
+}
+
+/**
+ * @brief write zeros to fill the gap up to an offset
+ * 
+ * @param[in,out] fp target file
+ * @param[in] offset offset to be reached [byte]
+ * @return true if succeeded
+ */
+static bool write_padding(FILE *fp, const uint64_t offset)
+{
+    static const uint8_t zeros[CHECKPOINT_ALIGN] = { 0 };
+
+    const long pos = ftell(fp);
+    if ((pos < 0) || ((uint64_t)pos > offset) || ((offset - pos) > CHECKPOINT_ALIGN)) {
+        return false;
+    }
+
+    const size_t n = (size_t)(offset - pos);
+
+    return fwrite(zeros, 1, n, fp) == n;
+}
+
+/**
+ * @brief get num of elements of a blob
+ * 
+ * @param[in] record record of layer
+ * @param[in] blob blob of layer
+ * @return int num of elements, w_size for weights and their moments, b_size otherwise
+ */
+static int blob_size(const CheckpointLayer *record, const int blob)
+{
+    switch (blob) {
+    case CHECKPOINT_BLOB_W:
+    case CHECKPOINT_BLOB_MW:
+    case CHECKPOINT_BLOB_VW:
+        return record->w_size;
+    default:
+        return record->b_size;
+    }
+}
+
+/**
+ * @brief make records of layers and lay out their blobs
+ * 
+ * @param[in] net target network
+ * @param[in] optimizer optimizer of the network, NULL if its state is not written
+ * @param[out] header header of checkpoint
+ * @param[out] records records of layers, net->size elements
+ * @param[out] blobs sources of blobs of layers, net->size x CHECKPOINT_N_BLOBS elements, NULL if absent
+ * @return true if every layer can be written
+ */
+static bool make_records(
+    const Net *net, const Optimizer *optimizer, CheckpointHeader *header, CheckpointLayer *records, const float **blobs)
+{
+    if ((optimizer != NULL) && (optimizer->size != net->size)) {
+        return false;
+    }
+
+    // padding is written as zeros
+    memset(header, 0, sizeof(CheckpointHeader));
+    memcpy(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic));
+    header->version    = CHECKPOINT_VERSION;
+    header->byte_order = CHECKPOINT_BYTE_ORDER;
+    header->n_layers   = net->size;
+    header->layer_size = sizeof(CheckpointLayer);
+    if (optimizer != NULL) {
+        header->has_optimizer = 1;
+        header->optimizer     = optimizer->param;
+        header->step          = optimizer->step;
+    }
+
+    uint64_t offset = sizeof(CheckpointHeader) + (uint64_t)net->size * sizeof(CheckpointLayer);
+
+    for (int i = 0; i < net->size; i++) {
+        const Layer *layer = net->layers[i];
+        if (layer->type == LAYER_TYPE_NONE) {
+            return false;
+        }
+
+        CheckpointLayer *record = &records[i];
+        memset(record, 0, sizeof(CheckpointLayer));
+
+        record->type  = layer->type;
+        record->n_in  = layer->n_in;
+        record->param = layer->param;
+        for (int j = 0; j < LAYER_IN_MAX; j++) {
+            record->in_ids[j]   = layer->in_ids[j];
+            record->in_ports[j] = layer->in_ports[j];
+        }
+
+        record->w_size = (layer->w != NULL) ? layer->w_size : 0;
+        record->b_size = (layer->b != NULL) ? layer->b_size : 0;
+
+        const OptimizerState *state = (optimizer != NULL) ? &optimizer->states[layer->id] : NULL;
+        const float *sources[CHECKPOINT_N_BLOBS] = {
+            layer->w,
+            layer->b,
+            (state != NULL) ? state->mw : NULL,
+            (state != NULL) ? state->vw : NULL,
+            (state != NULL) ? state->mb : NULL,
+            (state != NULL) ? state->vb : NULL
+        };
+
+        for (int k = 0; k < CHECKPOINT_N_BLOBS; k++) {
+            const int size = blob_size(record, k);
+            const float **blob = &blobs[i * CHECKPOINT_N_BLOBS + k];
+
+            *blob = (size > 0) ? sources[k] : NULL;
+            if (*blob != NULL) {
+                record->offsets[k] = align_offset(offset);
+                offset = record->offsets[k] + (uint64_t)size * sizeof(float);
+            }
+        }
+    }
+
+    header->file_size = offset;
+
+    return true;
+}
+
+/**
+ * @brief write checkpoint
+ * 
+ * @param[in,out] fp target file at its beginning
+ * @param[in] header header of checkpoint
+ * @param[in] records records of layers
+ * @param[in] blobs sources of blobs of layers
+ * @return true if succeeded
+ */
+static bool write_checkpoint(
+    FILE *fp, const CheckpointHeader *header, const CheckpointLayer *records, const float *const *blobs)
+{
+    const int n_layers = header->n_layers;
+
+    if ((fwrite(header, sizeof(CheckpointHeader), 1, fp) != 1) ||
+        (fwrite(records, sizeof(CheckpointLayer), n_layers, fp) != (size_t)n_layers)) {
+        return false;
+    }
+
+    for (int i = 0; i < n_layers; i++) {
+        const CheckpointLayer *record = &records[i];
+
+        for (int k = 0; k < CHECKPOINT_N_BLOBS; k++) {
+            const float *blob = blobs[i * CHECKPOINT_N_BLOBS + k];
+            if (blob == NULL) {
+                continue;
+            }
+
+            const size_t size = (size_t)blob_size(record, k);
+            if (!write_padding(fp, record->offsets[k]) || (fwrite(blob, sizeof(float), size, fp) != size)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief write checkpoint into file atomically
+ * 
+ * @param[in] filename path to checkpoint file
+ * @param[in] header header of checkpoint
+ * @param[in] records records of layers
+ * @param[in] blobs sources of blobs of layers
+ * @return true if succeeded
+ */
+static bool write_file(
+    const char *filename, const CheckpointHeader *header, const CheckpointLayer *records, const float *const *blobs)
+{
+    char *tmp_filename = malloc(strlen(filename) + sizeof(CHECKPOINT_TMP_SUFFIX));
+    if (tmp_filename == NULL) {
+        return false;
+    }
+    strcpy(tmp_filename, filename);
+    strcat(tmp_filename, CHECKPOINT_TMP_SUFFIX);
+
+    bool written = false;
+
+    FILE *fp = fopen(tmp_filename, "wb");
+    if (fp != NULL) {
+        // the checkpoint is complete on disk before it replaces the old one
+        written = write_checkpoint(fp, header, records, blobs) && (fflush(fp) == 0) && (fsync(fileno(fp)) == 0);
+        written = (fclose(fp) == 0) && written;
+        if (written) {
+            written = (rename(tmp_filename, filename) == 0);
+        }
+        if (!written) {
+            remove(tmp_filename);
+        }
+    }
+
+    FREE_WITH_NULL(&tmp_filename);
+
+    return written;
+}
+
+int net_save(const Net *net, const char *filename)
+{
+    return net_save_with_optimizer(net, NULL, filename);
+}
+
+int net_save_with_optimizer(const Net *net, const Optimizer *optimizer, const char *filename)
+{
+    if ((net == NULL) || (net->size < 1) || (filename == NULL)) {
+        return -1;
+    }
+
+    CheckpointHeader header;
+    CheckpointLayer *records = malloc(sizeof(CheckpointLayer) * net->size);
+    const float **blobs = malloc(sizeof(float*) * net->size * CHECKPOINT_N_BLOBS);
+
+    const bool written = (records != NULL) && (blobs != NULL) &&
+                         make_records(net, optimizer, &header, records, blobs) &&
+                         write_file(filename, &header, records, blobs);
+
+    FREE_WITH_NULL(&records);
+    FREE_WITH_NULL(&blobs);
+
+    return written ? 0 : -1;
+}
+
+/**
+ * @brief check that a blob of parameters is in the checkpoint
+ * 
+ * @param[in] offset offset of blob [byte]
+ * @param[in] size num of elements of blob
+ * @param[in] file_size size of checkpoint [byte]
+ * @return true if the blob is aligned and in the checkpoint, or empty
+ */
+static bool check_blob(const uint64_t offset, const int size, const uint64_t file_size)
+{
+    if (size == 0) {
+        return (offset == 0);
+    }
+
+    return (size > 0) &&
+           ((offset % CHECKPOINT_ALIGN) == 0) &&
+           (offset <= file_size) &&
+           (((uint64_t)size * sizeof(float)) <= (file_size - offset));
+}
+
+/**
+ * @brief check header of checkpoint mapped into memory
+ * 
+ * @param[in] map mapped checkpoint
+ * @param[in] map_size size of mapped checkpoint [byte]
+ * @return const CheckpointLayer* records of layers, NULL if the header is invalid
+ */
+static const CheckpointLayer *check_header(const uint8_t *map, const size_t map_size)
+{
+    const CheckpointHeader *header = (const CheckpointHeader*)map;
+
+    if ((memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) != 0) ||
+        (header->version != CHECKPOINT_VERSION) || (header->byte_order != CHECKPOINT_BYTE_ORDER) ||
+        (header->layer_size != sizeof(CheckpointLayer)) || (header->file_size != map_size) ||
+        (header->n_layers < 1) ||
+        ((uint64_t)header->n_layers > ((map_size - sizeof(CheckpointHeader)) / sizeof(CheckpointLayer)))) {
+        return NULL;
+    }
+
+    return (const CheckpointLayer*)(map + sizeof(CheckpointHeader));
+}
+
+/**
+ * @brief create network from checkpoint mapped into memory
+ * 
+ * @param[in] map mapped checkpoint
+ * @param[in] map_size size of mapped checkpoint [byte]
+ * @param[in] share parameters point into the mapping if true, copied otherwise
+ * @return Net* pointer to network, NULL if the checkpoint is invalid
+ */
+static Net *build_net(const uint8_t *map, const size_t map_size, const bool share)
+{
+    const CheckpointLayer *records = check_header(map, map_size);
+    if (records == NULL) {
+        return NULL;
+    }
+
+    Net *net = net_alloc();
+    if (net == NULL) {
+        return NULL;
+    }
+
+    // layers are connected only to the preceding layers, so they can be appended in ID order
+    const int n_layers = ((const CheckpointHeader*)map)->n_layers;
+    for (int i = 0; i < n_layers; i++) {
+        const CheckpointLayer *record = &records[i];
+
+        Layer *layer = (record->type != LAYER_TYPE_NONE) ? layer_create(record->type, record->param) : NULL;
+        if (layer == NULL) {
+            goto NET_FREE;
+        }
+
+        // parameters must match the sizes derived from the layer parameter
+        const int w_size = (layer->w != NULL) ? layer->w_size : 0;
+        const int b_size = (layer->b != NULL) ? layer->b_size : 0;
+        const uint64_t w_offset = record->offsets[CHECKPOINT_BLOB_W];
+        const uint64_t b_offset = record->offsets[CHECKPOINT_BLOB_B];
+        if ((record->w_size != w_size) || (record->b_size != b_size) ||
+            !check_blob(w_offset, w_size, map_size) || !check_blob(b_offset, b_size, map_size)) {
+            layer_free(&layer);
+            goto NET_FREE;
+        }
+
+        if (share) {
+            if (w_size > 0) {
+                FREE_WITH_NULL(&layer->w);
+                layer->w = (float*)(map + w_offset);
+            }
+            if (b_size > 0) {
+                FREE_WITH_NULL(&layer->b);
+                layer->b = (float*)(map + b_offset);
+            }
+            layer->shared_params = true;
+        } else {
+            fdata_copy((const float*)(map + w_offset), w_size, layer->w);
+            fdata_copy((const float*)(map + b_offset), b_size, layer->b);
+        }
+
+        if (net_connect(net, layer, record->n_in, record->in_ids, record->in_ports) == NULL) {
+            layer_free(&layer);
+            goto NET_FREE;
+        }
+    }
+
+    return net;
+
+NET_FREE:
+    net_free(&net);
+
+    return NULL;
+}
+
+/**
+ * @brief map checkpoint file into memory
+ * 
+ * @param[in] filename path to checkpoint file
+ * @param[out] map_size size of mapped checkpoint [byte]
+ * @return uint8_t* mapped checkpoint, NULL if failed
+ */
+static uint8_t *map_file(const char *filename, size_t *map_size)
+{
+    if (filename == NULL) {
+        return NULL;
+    }
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (st.st_size < (off_t)sizeof(CheckpointHeader))) {
+        close(fd);
+        return NULL;
+    }
+
+    // the mapping is kept after closing the descriptor
+    *map_size = (size_t)st.st_size;
+    void *map = mmap(NULL, *map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    return (map != MAP_FAILED) ? map : NULL;
+}
+
+/**
+ * @brief create network from checkpoint file
+ * 
+ * @param[in] filename path to checkpoint file
+ * @param[in] share parameters point into the mapped file if true, copied otherwise
+ * @return Net* pointer to network, NULL if failed
+ */
+static Net *load(const char *filename, const bool share)
+{
+    size_t map_size;
+    uint8_t *map = map_file(filename, &map_size);
+    if (map == NULL) {
+        return NULL;
+    }
+
+    Net *net = build_net(map, map_size, share);
+    if ((net == NULL) || !share) {
+        munmap(map, map_size);
+        return net;
+    }
+
+    net->map      = map;
+    net->map_size = map_size;
+
+    return net;
+}
+
+Net *net_load(const char *filename)
+{
+    return load(filename, false);
+}
+
+Net *net_load_mmap(const char *filename)
+{
+    return load(filename, true);
+}
+
+/**
+ * @brief restore state of optimizer from checkpoint mapped into memory
+ * 
+ * @param[in,out] optimizer optimizer created with the parameter of the checkpoint
+ * @param[in] net target network
+ * @param[in] map mapped checkpoint
+ * @param[in] map_size size of mapped checkpoint [byte]
+ * @return true if the state of every layer is restored
+ */
+static bool restore_optimizer(Optimizer *optimizer, const Net *net, const uint8_t *map, const size_t map_size)
+{
+    const CheckpointLayer *records = (const CheckpointLayer*)(map + sizeof(CheckpointHeader));
+
+    for (int i = 0; i < net->size; i++) {
+        const Layer *layer = net->layers[i];
+        const CheckpointLayer *record = &records[i];
+
+        // the network must have the topology of the checkpoint
+        const int w_size = (layer->w != NULL) ? layer->w_size : 0;
+        const int b_size = (layer->b != NULL) ? layer->b_size : 0;
+        if ((record->type != (int32_t)layer->type) || (record->w_size != w_size) || (record->b_size != b_size)) {
+            return false;
+        }
+
+        // moments allocated by the optimizer must be in the checkpoint, and others must not
+        OptimizerState *state = &optimizer->states[layer->id];
+        float *moments[] = { state->mw, state->vw, state->mb, state->vb };
+        for (int k = CHECKPOINT_BLOB_MW; k < CHECKPOINT_N_BLOBS; k++) {
+            float *moment = moments[k - CHECKPOINT_BLOB_MW];
+            const int size = (moment != NULL) ? blob_size(record, k) : 0;
+            if (!check_blob(record->offsets[k], size, map_size)) {
+                return false;
+            }
+            fdata_copy((const float*)(map + record->offsets[k]), size, moment);
+        }
+    }
+
+    return true;
+}
+
+Optimizer *optimizer_load(const Net *net, const char *filename)
+{
+    if (net == NULL) {
+        return NULL;
+    }
+
+    size_t map_size;
+    uint8_t *map = map_file(filename, &map_size);
+    if (map == NULL) {
+        return NULL;
+    }
+
+    Optimizer *optimizer = NULL;
+
+    const CheckpointHeader *header = (const CheckpointHeader*)map;
+    if ((check_header(map, map_size) != NULL) && (header->has_optimizer == 1) &&
+        (header->n_layers == net->size) && (header->step >= 0)) {
+        optimizer = optimizer_create(net, header->optimizer);
+    }
+
+    if (optimizer != NULL) {
+        optimizer->step = header->step;
+        if (!restore_optimizer(optimizer, net, map, map_size)) {
+            optimizer_free(&optimizer);
+        }
+    }
+
+    munmap(map, map_size);
+
+    return optimizer;
+}
+
+/**
+ * @brief main loop of writer thread
+ * 
+ * @param[in,out] arg checkpointer
+ * @return void* always NULL
+ */
+static void *writer(void *arg)
+{
+    Checkpointer *checkpointer = (Checkpointer*)arg;
+
+    pthread_mutex_lock(&checkpointer->lock);
+
+    while (true) {
+        // a pending snapshot is written before the thread stops
+        while (!checkpointer->pending && !checkpointer->stop) {
+            pthread_cond_wait(&checkpointer->cond, &checkpointer->lock);
+        }
+        if (!checkpointer->pending) {
+            break;
+        }
+
+        pthread_mutex_unlock(&checkpointer->lock);
+
+        // the snapshot is not modified until it is written
+        TRACE_BEGIN(write_start);
+        const bool written = write_file(
+            checkpointer->filename, &checkpointer->header, checkpointer->records, checkpointer->blobs
+        );
+        TRACE_END(TRACE_CATEGORY_TRAIN, "write checkpoint", checkpointer->written, write_start);
+
+        pthread_mutex_lock(&checkpointer->lock);
+
+        if (written) {
+            checkpointer->written++;
+        } else {
+            checkpointer->failed = true;
+        }
+        checkpointer->pending = false;
+        pthread_cond_broadcast(&checkpointer->cond);
+    }
+
+    pthread_mutex_unlock(&checkpointer->lock);
+
+    return NULL;
+}
+
+Checkpointer *checkpointer_create(const char *filename)
+{
+    if (filename == NULL) {
+        return NULL;
+    }
+
+    Checkpointer *checkpointer = malloc(sizeof(Checkpointer));
+    if (checkpointer == NULL) {
+        return NULL;
+    }
+
+    checkpointer->filename = malloc(strlen(filename) + 1);
+    if (checkpointer->filename == NULL) {
+        FREE_WITH_NULL(&checkpointer);
+        return NULL;
+    }
+    strcpy(checkpointer->filename, filename);
+
+    checkpointer->records    = NULL;
+    checkpointer->blobs      = NULL;
+    checkpointer->capacity   = 0;
+    checkpointer->arena      = NULL;
+    checkpointer->arena_size = 0;
+
+    checkpointer->pending = false;
+    checkpointer->failed  = false;
+    checkpointer->stop    = false;
+    checkpointer->written = 0;
+
+    pthread_mutex_init(&checkpointer->lock, NULL);
+    pthread_cond_init(&checkpointer->cond, NULL);
+
+    if (pthread_create(&checkpointer->thread, NULL, writer, checkpointer) != 0) {
+        pthread_mutex_destroy(&checkpointer->lock);
+        pthread_cond_destroy(&checkpointer->cond);
+        FREE_WITH_NULL(&checkpointer->filename);
+        FREE_WITH_NULL(&checkpointer);
+        return NULL;
+    }
+
+    return checkpointer;
+}
+
+/**
+ * @brief wait until the pending snapshot is written
+ * 
+ * @param[in,out] checkpointer target checkpointer
+ */
+static void wait_written(Checkpointer *checkpointer)
+{
+    pthread_mutex_lock(&checkpointer->lock);
+    while (checkpointer->pending) {
+        pthread_cond_wait(&checkpointer->cond, &checkpointer->lock);
+    }
+    pthread_mutex_unlock(&checkpointer->lock);
+}
+
+/**
+ * @brief allocate records and sources of blobs of a snapshot
+ * 
+ * @param[in,out] checkpointer target checkpointer, whose writer thread is idle
+ * @param[in] n_layers num of layers of the snapshot
+ * @return true if succeeded
+ */
+static bool reserve_records(Checkpointer *checkpointer, const int n_layers)
+{
+    if (n_layers <= checkpointer->capacity) {
+        return true;
+    }
+
+    FREE_WITH_NULL(&checkpointer->records);
+    FREE_WITH_NULL(&checkpointer->blobs);
+    checkpointer->capacity = 0;
+
+    checkpointer->records = malloc(sizeof(CheckpointLayer) * n_layers);
+    checkpointer->blobs   = malloc(sizeof(float*) * n_layers * CHECKPOINT_N_BLOBS);
+    if ((checkpointer->records == NULL) || (checkpointer->blobs == NULL)) {
+        FREE_WITH_NULL(&checkpointer->records);
+        FREE_WITH_NULL(&checkpointer->blobs);
+        return false;
+    }
+
+    checkpointer->capacity = n_layers;
+
+    return true;
+}
+
+int checkpointer_snapshot(Checkpointer *checkpointer, const Net *net, const Optimizer *optimizer)
+{
+    if ((checkpointer == NULL) || (net == NULL) || (net->size < 1)) {
+        return -1;
+    }
+
+    // the writer thread does not read the snapshot after it is written
+    wait_written(checkpointer);
+
+    if (!reserve_records(checkpointer, net->size) ||
+        !make_records(net, optimizer, &checkpointer->header, checkpointer->records, checkpointer->blobs)) {
+        return -1;
+    }
+
+    const int n_blobs = net->size * CHECKPOINT_N_BLOBS;
+
+    size_t size = 0;
+    for (int i = 0; i < n_blobs; i++) {
+        if (checkpointer->blobs[i] != NULL) {
+            size += blob_size(&checkpointer->records[i / CHECKPOINT_N_BLOBS], (i % CHECKPOINT_N_BLOBS));
+        }
+    }
+
+    if (size > checkpointer->arena_size) {
+        FREE_WITH_NULL(&checkpointer->arena);
+        checkpointer->arena_size = 0;
+
+        checkpointer->arena = fdata_alloc_aligned(size);
+        if (checkpointer->arena == NULL) {
+            return -1;
+        }
+        checkpointer->arena_size = size;
+    }
+
+    // blobs are copied into the arena and the snapshot refers to the copies
+    float *dest = checkpointer->arena;
+    for (int i = 0; i < n_blobs; i++) {
+        const float *blob = checkpointer->blobs[i];
+        if (blob == NULL) {
+            continue;
+        }
+
+        const int blob_elems = blob_size(&checkpointer->records[i / CHECKPOINT_N_BLOBS], (i % CHECKPOINT_N_BLOBS));
+        fdata_copy(blob, blob_elems, dest);
+        checkpointer->blobs[i] = dest;
+        dest += blob_elems;
+    }
+
+    pthread_mutex_lock(&checkpointer->lock);
+    checkpointer->pending = true;
+    pthread_cond_broadcast(&checkpointer->cond);
+    pthread_mutex_unlock(&checkpointer->lock);
+
+    return 0;
+}
+
+int checkpointer_wait(Checkpointer *checkpointer)
+{
+    if (checkpointer == NULL) {
+        return -1;
+    }
+
+    wait_written(checkpointer);
+
+    pthread_mutex_lock(&checkpointer->lock);
+    const bool failed = checkpointer->failed;
+    checkpointer->failed = false;
+    pthread_mutex_unlock(&checkpointer->lock);
+
+    return failed ? -1 : 0;
+}
+
+void checkpointer_free(Checkpointer **checkpointer)
+{
+    if (*checkpointer == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&(*checkpointer)->lock);
+    (*checkpointer)->stop = true;
+    pthread_cond_broadcast(&(*checkpointer)->cond);
+    pthread_mutex_unlock(&(*checkpointer)->lock);
+
+    pthread_join((*checkpointer)->thread, NULL);
+
+    pthread_mutex_destroy(&(*checkpointer)->lock);
+    pthread_cond_destroy(&(*checkpointer)->cond);
+
+    FREE_WITH_NULL(&(*checkpointer)->filename);
+    FREE_WITH_NULL(&(*checkpointer)->records);
+    FREE_WITH_NULL(&(*checkpointer)->blobs);
+    FREE_WITH_NULL(&(*checkpointer)->arena);
+
+    FREE_WITH_NULL(checkpointer);
+}
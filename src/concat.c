@@ -0,0 +1,98 @@
+/**
+ * @file concat.c
+ * @brief Concat layer
+ * 
+ */
+#include "concat.h"
+
+#include "data.h"
+
+/**
+ * @brief forward propagation of Concat layer
+ * 
+ * @param self target layer
+ * @param x first layer input, the others are taken from self->xs
+ */
+static void forward(Layer *self, const float *x)
+{
+    self->x = x;
+
+    // y = [x0, x1, ...]
+    float *y = self->y;
+    for (int i = 0; i < self->n_in; i++) {
+        fdata_copy(self->xs[i], self->xs_size[i], y);
+        y += self->xs_size[i];
+    }
+}
+
+/**
+ * @brief backward propagation of Concat layer
+ * 
+ * @param self target layer
+ * @param dy diff of next layer
+ */
+static void backward(Layer *self, const float *dy)
+{
+    // dxs[i] point to the slices of dx
+    fdata_copy(dy, self->y_size, self->dx);
+}
+
+Layer *concat_layer(const LayerParameter layer_param)
+{
+    if ((layer_param.n_in < 1) || (layer_param.n_in > LAYER_IN_MAX)) {
+        return NULL;
+    }
+
+    int in = 0;
+    for (int i = 0; i < layer_param.n_in; i++) {
+        if (layer_param.ins[i] < 1) {
+            return NULL;
+        }
+        in += layer_param.ins[i];
+    }
+
+    Layer *layer = layer_alloc();
+    if (layer == NULL) {
+        return NULL;
+    }
+
+    int x_size = 1 * in * 1 * 1;
+    SET_DIM(layer->x_dim, 1, in, 1, 1);
+    layer->x_size = x_size;
+
+    int y_size = 1 * in * 1 * 1;
+    SET_DIM(layer->y_dim, 1, in, 1, 1);
+    layer->y_size = y_size;
+
+    layer->y = fdata_alloc(y_size);
+    if (layer->y == NULL) {
+        goto LAYER_FREE;
+    }
+
+    layer->dx = fdata_alloc(x_size);
+    if (layer->dx == NULL) {
+        goto LAYER_FREE;
+    }
+
+    layer->n_in = layer_param.n_in;
+    int offset = 0;
+    for (int i = 0; i < layer->n_in; i++) {
+        layer->xs_size[i] = layer_param.ins[i];
+        layer->dxs[i]     = layer->dx + offset;
+        offset += layer_param.ins[i];
+    }
+    layer->ys_size[0] = y_size;
+
+    layer->type  = LAYER_TYPE_CONCAT;
+    layer->param = layer_param;
+
+    layer->forward  = forward;
+    layer->backward = backward;
+
+    return layer;
+
+LAYER_FREE:
+    layer_free(&layer);
+
+    return NULL;
+}
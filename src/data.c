@@ -8,6 +8,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "random.h"
 
 float* fdata_alloc(const size_t size)
@@ -15,6 +19,15 @@ float* fdata_alloc(const size_t size)
     return (float*)malloc(sizeof(float) * size);
 }
 
+float* fdata_alloc_aligned(const size_t size)
+{
+    // size must be a multiple of alignment
+    size_t bytes = sizeof(float) * ((size > 0) ? size : 1);
+    bytes = (bytes + DATA_ALIGN - 1) / DATA_ALIGN * DATA_ALIGN;
+
+    return (float*)aligned_alloc(DATA_ALIGN, bytes);
+}
+
 void fdata_copy(const float *src, const size_t size, float *dest)
 {
     if ((src == NULL) || (dest == NULL)) {
@@ -23,6 +36,42 @@ void fdata_copy(const float *src, const size_t size, float *dest)
     memcpy(dest, src, (sizeof(float) * size));
 }
 
+void fdata_from_bytes(const uint8_t *src, const size_t size, const float scale, const float offset, float *dest)
+{
+    if ((src == NULL) || (dest == NULL)) {
+        return;
+    }
+
+    size_t i = 0;
+
+#ifdef __SSE2__
+    const __m128i zero    = _mm_setzero_si128();
+    const __m128  scale4  = _mm_set1_ps(scale);
+    const __m128  offset4 = _mm_set1_ps(offset);
+    for (; (i + 16) <= size; i += 16) {
+        // widen 16 bytes to 4 vectors of 32-bit integers
+        __m128i b16 = _mm_loadu_si128((const __m128i*)&src[i]);
+        __m128i lo8 = _mm_unpacklo_epi8(b16, zero);
+        __m128i hi8 = _mm_unpackhi_epi8(b16, zero);
+        __m128i w[4] = {
+            _mm_unpacklo_epi16(lo8, zero),
+            _mm_unpackhi_epi16(lo8, zero),
+            _mm_unpacklo_epi16(hi8, zero),
+            _mm_unpackhi_epi16(hi8, zero)
+        };
+
+        for (int k = 0; k < 4; k++) {
+            __m128 f4 = _mm_cvtepi32_ps(w[k]);
+            _mm_storeu_ps(&dest[i + 4 * k], _mm_add_ps(_mm_mul_ps(f4, scale4), offset4));
+        }
+    }
+#endif
+
+    for (; i < size; i++) {
+        dest[i] = src[i] * scale + offset;
+    }
+}
+
 void fdata_rand_uniform(float *array, const size_t size)
 {
     if ((array == NULL) || (size < 1)) {
@@ -0,0 +1,319 @@
+/**
+ * @file dataset.c
+ * @brief dataset of samples and labels in contiguous matrices
+ * 
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "dataset.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "data.h"
+#include "util.h"
+
+/**
+ * @brief allocate bytes aligned to DATA_ALIGN
+ * 
+ * @param[in] size num of bytes
+ * @return uint8_t* pointer to bytes, deallocated with free()
+ */
+static uint8_t *aligned_bytes(const size_t size)
+{
+    // size must be a multiple of alignment
+    size_t bytes = (size > 0) ? size : 1;
+    bytes = (bytes + DATA_ALIGN - 1) / DATA_ALIGN * DATA_ALIGN;
+
+    return (uint8_t*)aligned_alloc(DATA_ALIGN, bytes);
+}
+
+Dataset *dataset_create(const int size, const int x_size, const int t_size)
+{
+    if ((size < 1) || (x_size < 1) || (t_size < 1)) {
+        return NULL;
+    }
+
+    Dataset *dataset = malloc(sizeof(Dataset));
+    if (dataset == NULL) {
+        return NULL;
+    }
+
+    *dataset = (Dataset){
+        .size     = size,
+        .x_size   = x_size,
+        .t_size   = t_size,
+        .x        = fdata_alloc_aligned((size_t)size * x_size),
+        .t        = fdata_alloc_aligned((size_t)size * t_size),
+        .xs       = malloc(sizeof(float*) * size),
+        .ts       = malloc(sizeof(float*) * size),
+        .x_u8     = NULL,
+        .t_u8     = NULL,
+        .x_scale  = 1.0f,
+        .x_offset = 0.0f,
+        .owner    = true,
+        .map      = NULL,
+        .map_size = 0
+    };
+    if ((dataset->x == NULL) || (dataset->t == NULL) || (dataset->xs == NULL) || (dataset->ts == NULL)) {
+        dataset_free(&dataset);
+        return NULL;
+    }
+
+    for (int i = 0; i < size; i++) {
+        dataset->xs[i] = dataset->x + (size_t)i * x_size;
+        dataset->ts[i] = dataset->t + (size_t)i * t_size;
+    }
+
+    return dataset;
+}
+
+Dataset *dataset_create_bytes(const int size, const int x_size, const int n_classes, const float scale, const float offset)
+{
+    if ((size < 1) || (x_size < 1) || (n_classes < 1) || (n_classes > (UINT8_MAX + 1))) {
+        return NULL;
+    }
+
+    Dataset *dataset = malloc(sizeof(Dataset));
+    if (dataset == NULL) {
+        return NULL;
+    }
+
+    *dataset = (Dataset){
+        .size     = size,
+        .x_size   = x_size,
+        .t_size   = n_classes,
+        .x        = NULL,
+        .t        = NULL,
+        .xs       = NULL,
+        .ts       = NULL,
+        .x_u8     = aligned_bytes((size_t)size * x_size),
+        .t_u8     = aligned_bytes(size),
+        .x_scale  = scale,
+        .x_offset = offset,
+        .owner    = true,
+        .map      = NULL,
+        .map_size = 0
+    };
+    if ((dataset->x_u8 == NULL) || (dataset->t_u8 == NULL)) {
+        dataset_free(&dataset);
+        return NULL;
+    }
+
+    return dataset;
+}
+
+Dataset *dataset_from_arrays(float **x, float **t, const int size, const int x_size, const int t_size)
+{
+    if ((x == NULL) || (t == NULL)) {
+        return NULL;
+    }
+
+    Dataset *dataset = dataset_create(size, x_size, t_size);
+    if (dataset == NULL) {
+        return NULL;
+    }
+
+    for (int i = 0; i < size; i++) {
+        fdata_copy(x[i], x_size, dataset->xs[i]);
+        fdata_copy(t[i], t_size, dataset->ts[i]);
+    }
+
+    return dataset;
+}
+
+Dataset dataset_wrap(float **x, float **t, const int size, const int x_size, const int t_size)
+{
+    return (Dataset){
+        .size     = size,
+        .x_size   = x_size,
+        .t_size   = t_size,
+        .x        = NULL,
+        .t        = NULL,
+        .xs       = x,
+        .ts       = t,
+        .x_u8     = NULL,
+        .t_u8     = NULL,
+        .x_scale  = 1.0f,
+        .x_offset = 0.0f,
+        .owner    = false,
+        .map      = NULL,
+        .map_size = 0
+    };
+}
+
+Dataset *dataset_from_idx(const IdxFile *images, const IdxFile *labels, const int n_classes)
+{
+    if ((images == NULL) || (labels == NULL) || (n_classes < 1)) {
+        return NULL;
+    }
+    if ((images->type != IDX_TYPE_UBYTE) || (labels->type != IDX_TYPE_UBYTE) ||
+        (labels->n_dims != 1) || (images->size != labels->size)) {
+        return NULL;
+    }
+
+    // labels are checked here not to be skipped silently when they are expanded
+    for (int i = 0; i < labels->size; i++) {
+        if (labels->data[i] >= n_classes) {
+            return NULL;
+        }
+    }
+
+    Dataset *dataset = malloc(sizeof(Dataset));
+    if (dataset == NULL) {
+        return NULL;
+    }
+
+    *dataset = (Dataset){
+        .size     = images->size,
+        .x_size   = images->item_size,
+        .t_size   = n_classes,
+        .x        = NULL,
+        .t        = NULL,
+        .xs       = NULL,
+        .ts       = NULL,
+        .x_u8     = (uint8_t*)images->data,
+        .t_u8     = (uint8_t*)labels->data,
+        .x_scale  = 1.0f / 255,
+        .x_offset = 0.0f,
+        .owner    = false,
+        .map      = NULL,
+        .map_size = 0
+    };
+
+    return dataset;
+}
+
+bool dataset_in_memory(const Dataset *dataset)
+{
+    return (dataset->xs != NULL) && (dataset->ts != NULL);
+}
+
+bool dataset_has_class_labels(const Dataset *dataset)
+{
+    return (dataset->t_u8 != NULL);
+}
+
+bool dataset_check_labels(const Dataset *dataset)
+{
+    if (dataset->t_u8 == NULL) {
+        return true;
+    }
+
+    for (int i = 0; i < dataset->size; i++) {
+        if (dataset->t_u8[i] >= dataset->t_size) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void dataset_gather(const Dataset *dataset, const int *indices, const int count, float *x, float *t)
+{
+    const int x_size = dataset->x_size;
+    const int t_size = dataset->t_size;
+
+    for (int i = 0; i < count; i++) {
+        const int k = indices[i];
+        float *xi = x + (size_t)i * x_size;
+
+        if (dataset->xs != NULL) {
+            memcpy(xi, dataset->xs[k], (sizeof(float) * x_size));
+        } else {
+            fdata_from_bytes(
+                (dataset->x_u8 + (size_t)k * x_size), x_size, dataset->x_scale, dataset->x_offset, xi
+            );
+        }
+
+        if (t == NULL) {
+            continue;
+        }
+
+        float *ti = t + (size_t)i * t_size;
+        if (dataset->ts != NULL) {
+            memcpy(ti, dataset->ts[k], (sizeof(float) * t_size));
+        } else {
+            memset(ti, 0, (sizeof(float) * t_size));
+            ti[dataset->t_u8[k]] = 1.0f;
+        }
+    }
+}
+
+void dataset_gather_labels(const Dataset *dataset, const int *indices, const int count, int *labels)
+{
+    for (int i = 0; i < count; i++) {
+        labels[i] = dataset->t_u8[indices[i]];
+    }
+}
+
+Dataset dataset_view(const Dataset *dataset, const int begin, const int size)
+{
+    Dataset view = {
+        .size     = 0,
+        .x_size   = dataset->x_size,
+        .t_size   = dataset->t_size,
+        .x        = NULL,
+        .t        = NULL,
+        .xs       = NULL,
+        .ts       = NULL,
+        .x_u8     = NULL,
+        .t_u8     = NULL,
+        .x_scale  = dataset->x_scale,
+        .x_offset = dataset->x_offset,
+        .owner    = false,
+        .map      = NULL,
+        .map_size = 0
+    };
+
+    if ((begin < 0) || (begin >= dataset->size) || (size < 1)) {
+        return view;
+    }
+
+    view.size = ((begin + size) <= dataset->size) ? size : (dataset->size - begin);
+
+    if (dataset->x != NULL) {
+        view.x = dataset->x + (size_t)begin * dataset->x_size;
+    }
+    if (dataset->t != NULL) {
+        view.t = dataset->t + (size_t)begin * dataset->t_size;
+    }
+    if (dataset->xs != NULL) {
+        view.xs = dataset->xs + begin;
+    }
+    if (dataset->ts != NULL) {
+        view.ts = dataset->ts + begin;
+    }
+    if (dataset->x_u8 != NULL) {
+        view.x_u8 = dataset->x_u8 + (size_t)begin * dataset->x_size;
+    }
+    if (dataset->t_u8 != NULL) {
+        view.t_u8 = dataset->t_u8 + begin;
+    }
+
+    return view;
+}
+
+void dataset_free(Dataset **dataset)
+{
+    if (*dataset == NULL) {
+        return;
+    }
+
+    if ((*dataset)->map != NULL) {
+        // matrices and labels are in the mapped file
+        FREE_WITH_NULL(&(*dataset)->xs);
+        FREE_WITH_NULL(&(*dataset)->ts);
+        munmap((*dataset)->map, (*dataset)->map_size);
+    } else if ((*dataset)->owner) {
+        FREE_WITH_NULL(&(*dataset)->x);
+        FREE_WITH_NULL(&(*dataset)->t);
+        FREE_WITH_NULL(&(*dataset)->xs);
+        FREE_WITH_NULL(&(*dataset)->ts);
+        FREE_WITH_NULL(&(*dataset)->x_u8);
+        FREE_WITH_NULL(&(*dataset)->t_u8);
+    }
+
+    FREE_WITH_NULL(dataset);
+}
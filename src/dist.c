@@ -0,0 +1,757 @@
+/**
+ * @file dist.c
+ * @brief multi-process communication for data-parallel training
+ * 
+ */
+// sched_setaffinity() and CPU_SET() are GNU extensions
+#define _GNU_SOURCE
+
+#include "dist.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "data.h"
+#include "util.h"
+
+// max num of elements in a message
+#define DIST_PIECE_SIZE 16384
+
+// timeout of joining process group [s]
+#define DIST_JOIN_TIMEOUT 60
+
+// interval of retrying to join process group [ns]
+#define DIST_JOIN_INTERVAL 1000000
+
+// num of polls of a mailbox between checks of the deadline
+#define DIST_POLL_CHECK 1024
+
+/**
+ * @brief header of shared memory
+ * 
+ */
+typedef struct ShmHeader {
+    atomic_int attached;    //!< num of processes attached
+} ShmHeader;
+
+/**
+ * @brief mailbox of a rank in shared memory, written by the previous rank
+ * 
+ */
+typedef struct ShmSlot {
+    _Alignas(64) atomic_ulong seq;  //!< num of messages written
+    _Alignas(64) atomic_ulong ack;  //!< num of messages read
+    _Alignas(64) float data[DIST_PIECE_SIZE];   //!< message
+} ShmSlot;
+
+/**
+ * @brief get mailbox of a rank
+ * 
+ * @param[in] self process group
+ * @param[in] rank rank
+ * @return ShmSlot* mailbox
+ */
+static ShmSlot *shm_slot(const Dist *self, const int rank)
+{
+    char *base = (char*)self->shm + sizeof(ShmSlot);
+
+    return (ShmSlot*)(base + sizeof(ShmSlot) * rank);
+}
+
+/**
+ * @brief sleep for interval of retrying to join or polling children
+ * 
+ */
+static void join_wait(void)
+{
+    struct timespec ts = { .tv_sec = 0, .tv_nsec = DIST_JOIN_INTERVAL };
+    nanosleep(&ts, NULL);
+}
+
+/**
+ * @brief poll counter of mailbox until it reaches or leaves a value
+ * @note a peer which crashed or stopped communicating is detected by the timeout
+ * 
+ * @param[in] self process group
+ * @param[in] counter counter of mailbox
+ * @param[in] value value of counter
+ * @param[in] until_equal wait until the counter is the value if true, until it is not otherwise
+ * @return true if succeeded, false if timed out
+ */
+static bool shm_wait(const Dist *self, atomic_ulong *counter, const unsigned long value, const bool until_equal)
+{
+    const time_t deadline = time(NULL) + self->timeout;
+
+    for (unsigned long n = 1;
+         (atomic_load_explicit(counter, memory_order_acquire) == value) != until_equal; n++) {
+        if (((n % DIST_POLL_CHECK) == 0) && (time(NULL) > deadline)) {
+            return false;
+        }
+        sched_yield();
+    }
+
+    return true;
+}
+
+/**
+ * @brief send message to the next rank with shared memory
+ * 
+ * @param[in,out] self process group
+ * @param[in] data message
+ * @param[in] size num of elements, up to DIST_PIECE_SIZE
+ * @return true if succeeded, false if the next rank does not read the previous message in time
+ */
+static bool shm_send(Dist *self, const float *data, const int size)
+{
+    ShmSlot *slot = shm_slot(self, ((self->rank + 1) % self->world_size));
+
+    // wait until the previous message is read
+    if (!shm_wait(self, &slot->ack, self->n_sent, true)) {
+        return false;
+    }
+
+    memcpy(slot->data, data, (sizeof(float) * size));
+
+    self->n_sent++;
+    atomic_store_explicit(&slot->seq, self->n_sent, memory_order_release);
+
+    return true;
+}
+
+/**
+ * @brief receive message from the previous rank with shared memory
+ * 
+ * @param[in,out] self process group
+ * @param[out] data message
+ * @param[in] size num of elements, up to DIST_PIECE_SIZE
+ * @return true if succeeded, false if the previous rank does not write the next message in time
+ */
+static bool shm_recv(Dist *self, float *data, const int size)
+{
+    ShmSlot *slot = shm_slot(self, self->rank);
+
+    // wait until the next message is written
+    if (!shm_wait(self, &slot->seq, self->n_received, false)) {
+        return false;
+    }
+
+    memcpy(data, slot->data, (sizeof(float) * size));
+
+    self->n_received++;
+    atomic_store_explicit(&slot->ack, self->n_received, memory_order_release);
+
+    return true;
+}
+
+/**
+ * @brief attach shared memory of process group
+ * 
+ * @param[in,out] self process group
+ * @param[in] name name of process group
+ * @return true if succeeded
+ */
+static bool shm_join(Dist *self, const char *name)
+{
+    char shm_name[256];
+    if (snprintf(shm_name, sizeof(shm_name), "/nnc-%s", name) >= (int)sizeof(shm_name)) {
+        return false;
+    }
+
+    // header is padded to a slot to keep alignment
+    self->shm_size = sizeof(ShmSlot) * (self->world_size + 1);
+
+    int fd = -1;
+    const time_t deadline = time(NULL) + DIST_JOIN_TIMEOUT;
+
+    if (self->rank == 0) {
+        // the segment is zero-filled by ftruncate()
+        shm_unlink(shm_name);
+        fd = shm_open(shm_name, (O_CREAT | O_EXCL | O_RDWR), 0600);
+        if ((fd < 0) || (ftruncate(fd, (off_t)self->shm_size) != 0)) {
+            goto SHM_FAIL;
+        }
+    } else {
+        // wait for rank 0 to create the segment
+        while (true) {
+            fd = shm_open(shm_name, O_RDWR, 0600);
+            if (fd >= 0) {
+                struct stat st;
+                if ((fstat(fd, &st) == 0) && ((unsigned long)st.st_size == self->shm_size)) {
+                    break;
+                }
+                close(fd);
+                fd = -1;
+            }
+            if (time(NULL) > deadline) {
+                goto SHM_FAIL;
+            }
+            join_wait();
+        }
+    }
+
+    self->shm = mmap(NULL, self->shm_size, (PROT_READ | PROT_WRITE), MAP_SHARED, fd, 0);
+    close(fd);
+    fd = -1;
+    if (self->shm == MAP_FAILED) {
+        self->shm = NULL;
+        goto SHM_FAIL;
+    }
+
+    ShmHeader *header = (ShmHeader*)self->shm;
+    atomic_fetch_add(&header->attached, 1);
+    while (atomic_load(&header->attached) < self->world_size) {
+        if (time(NULL) > deadline) {
+            goto SHM_FAIL;
+        }
+        join_wait();
+    }
+
+    // the segment is kept mapped until all processes leave
+    if (self->rank == 0) {
+        shm_unlink(shm_name);
+    }
+
+    return true;
+
+SHM_FAIL:
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (self->rank == 0) {
+        shm_unlink(shm_name);
+    }
+
+    return false;
+}
+
+/**
+ * @brief send message to the next rank with socket
+ * 
+ * @param[in,out] self process group
+ * @param[in] data message
+ * @param[in] size num of elements
+ * @return true if succeeded
+ */
+static bool socket_send(Dist *self, const float *data, const int size)
+{
+    const char *p = (const char*)data;
+    size_t rest = sizeof(float) * size;
+
+    while (rest > 0) {
+        // a closed peer is an error, not SIGPIPE
+        ssize_t n = send(self->next_fd, p, rest, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p    += n;
+        rest -= n;
+    }
+
+    return true;
+}
+
+/**
+ * @brief receive message from the previous rank with socket
+ * 
+ * @param[in,out] self process group
+ * @param[out] data message
+ * @param[in] size num of elements
+ * @return true if succeeded
+ */
+static bool socket_recv(Dist *self, float *data, const int size)
+{
+    char *p = (char*)data;
+    size_t rest = sizeof(float) * size;
+
+    while (rest > 0) {
+        ssize_t n = read(self->prev_fd, p, rest);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (n == 0) {
+            // closed by peer
+            return false;
+        }
+        p    += n;
+        rest -= n;
+    }
+
+    return true;
+}
+
+/**
+ * @brief set path of socket of a rank
+ * 
+ * @param[out] addr socket address
+ * @param[in] name name of process group
+ * @param[in] rank rank
+ * @return true if succeeded
+ */
+static bool socket_addr(struct sockaddr_un *addr, const char *name, const int rank)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+
+    int n = snprintf(addr->sun_path, sizeof(addr->sun_path), "/tmp/nnc-%s-%d.sock", name, rank);
+
+    return (n > 0) && (n < (int)sizeof(addr->sun_path));
+}
+
+/**
+ * @brief connect sockets of process group in a ring
+ * 
+ * @param[in,out] self process group
+ * @param[in] name name of process group
+ * @return true if succeeded
+ */
+static bool socket_join(Dist *self, const char *name)
+{
+    struct sockaddr_un own, next;
+    if (!socket_addr(&own, name, self->rank) ||
+        !socket_addr(&next, name, ((self->rank + 1) % self->world_size))) {
+        return false;
+    }
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        return false;
+    }
+
+    unlink(own.sun_path);
+    if ((bind(listen_fd, (struct sockaddr*)&own, sizeof(own)) != 0) || (listen(listen_fd, 1) != 0)) {
+        goto SOCKET_FAIL;
+    }
+
+    // the next rank may not listen yet
+    const time_t deadline = time(NULL) + DIST_JOIN_TIMEOUT;
+    while (true) {
+        self->next_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (self->next_fd < 0) {
+            goto SOCKET_FAIL;
+        }
+        if (connect(self->next_fd, (struct sockaddr*)&next, sizeof(next)) == 0) {
+            break;
+        }
+        close(self->next_fd);
+        self->next_fd = -1;
+
+        if (time(NULL) > deadline) {
+            goto SOCKET_FAIL;
+        }
+        join_wait();
+    }
+
+    self->prev_fd = accept(listen_fd, NULL, NULL);
+    if (self->prev_fd < 0) {
+        goto SOCKET_FAIL;
+    }
+
+    // a peer which stops communicating is detected by the timeout
+    const struct timeval timeout = { .tv_sec = self->timeout, .tv_usec = 0 };
+    if ((setsockopt(self->prev_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0) ||
+        (setsockopt(self->next_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) != 0)) {
+        goto SOCKET_FAIL;
+    }
+
+    close(listen_fd);
+    unlink(own.sun_path);
+
+    return true;
+
+SOCKET_FAIL:
+    close(listen_fd);
+    unlink(own.sun_path);
+
+    return false;
+}
+
+Dist *dist_create(const DistParameter param)
+{
+    if ((param.world_size < 1) || (param.rank < 0) || (param.rank >= param.world_size)) {
+        return NULL;
+    }
+    if (param.name == NULL) {
+        return NULL;
+    }
+
+    Dist *dist = malloc(sizeof(Dist));
+    if (dist == NULL) {
+        return NULL;
+    }
+
+    dist->rank       = param.rank;
+    dist->world_size = param.world_size;
+    dist->transport  = param.transport;
+    dist->timeout    = (param.timeout > 0) ? param.timeout : DIST_TIMEOUT;
+
+    dist->shm        = NULL;
+    dist->shm_size   = 0;
+    dist->n_sent     = 0;
+    dist->n_received = 0;
+
+    dist->next_fd = -1;
+    dist->prev_fd = -1;
+
+    dist->buffer      = NULL;
+    dist->buffer_size = 0;
+
+    if (dist->transport == DIST_TRANSPORT_AUTO) {
+        // same result on all processes of the host
+        dist->transport = (access("/dev/shm", W_OK) == 0) ? DIST_TRANSPORT_SHM : DIST_TRANSPORT_SOCKET;
+    }
+
+    if (dist->transport == DIST_TRANSPORT_SHM) {
+        dist->send = shm_send;
+        dist->recv = shm_recv;
+    } else {
+        dist->send = socket_send;
+        dist->recv = socket_recv;
+    }
+
+    // single process needs no communication
+    if (dist->world_size == 1) {
+        return dist;
+    }
+
+    bool joined = (dist->transport == DIST_TRANSPORT_SHM) ?
+        shm_join(dist, param.name) : socket_join(dist, param.name);
+    if (!joined) {
+        dist_free(&dist);
+        return NULL;
+    }
+
+    return dist;
+}
+
+int dist_param_from_env(DistParameter *param)
+{
+    const char *rank       = getenv("NNC_RANK");
+    const char *world_size = getenv("NNC_WORLD_SIZE");
+    const char *name       = getenv("NNC_DIST_NAME");
+    const char *transport  = getenv("NNC_DIST_TRANSPORT");
+
+    if ((param == NULL) || (rank == NULL) || (world_size == NULL) || (name == NULL)) {
+        return -1;
+    }
+
+    param->rank       = atoi(rank);
+    param->world_size = atoi(world_size);
+    param->name       = name;
+    param->timeout    = 0;
+    param->transport  = DIST_TRANSPORT_AUTO;
+    if (transport != NULL) {
+        if (strcmp(transport, "shm") == 0) {
+            param->transport = DIST_TRANSPORT_SHM;
+        } else if (strcmp(transport, "socket") == 0) {
+            param->transport = DIST_TRANSPORT_SOCKET;
+        }
+    }
+
+    if ((param->world_size < 1) || (param->rank < 0) || (param->rank >= param->world_size)) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief send array to the next rank and receive array from the previous rank
+ * @note messages are interleaved in pieces, so no process is blocked by full mailbox
+ * 
+ * @param[in,out] dist process group
+ * @param[in] send_data array to be sent
+ * @param[in] send_size num of elements to be sent
+ * @param[out] recv_data array to be received
+ * @param[in] recv_size num of elements to be received
+ * @return true if succeeded
+ */
+static bool exchange(Dist *dist, const float *send_data, const int send_size, float *recv_data, const int recv_size)
+{
+    for (int i = 0; (i < send_size) || (i < recv_size); i += DIST_PIECE_SIZE) {
+        if (i < send_size) {
+            int n = ((send_size - i) < DIST_PIECE_SIZE) ? (send_size - i) : DIST_PIECE_SIZE;
+            if (!dist->send(dist, (send_data + i), n)) {
+                return false;
+            }
+        }
+        if (i < recv_size) {
+            int n = ((recv_size - i) < DIST_PIECE_SIZE) ? (recv_size - i) : DIST_PIECE_SIZE;
+            if (!dist->recv(dist, (recv_data + i), n)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+int dist_allreduce(Dist *dist, float *data, const int size)
+{
+    if ((dist == NULL) || (data == NULL) || (size < 0)) {
+        return -1;
+    }
+
+    const int n = dist->world_size;
+    const int r = dist->rank;
+    if (n == 1) {
+        return 0;
+    }
+
+    // chunk k is [offset(k), offset(k + 1))
+#define CHUNK_OFFSET(k) ((int)((long)size * (k) / n))
+#define CHUNK_SIZE(k) (CHUNK_OFFSET((k) + 1) - CHUNK_OFFSET(k))
+
+    const int max_chunk = (size + n - 1) / n;
+    if (dist->buffer_size < max_chunk) {
+        FREE_WITH_NULL(&dist->buffer);
+        dist->buffer = fdata_alloc(max_chunk);
+        if (dist->buffer == NULL) {
+            dist->buffer_size = 0;
+            return -1;
+        }
+        dist->buffer_size = max_chunk;
+    }
+
+    // reduce-scatter: rank r has the sum of chunk (r + 1) at the end
+    for (int s = 0; s < (n - 1); s++) {
+        int send_k = (r - s + n) % n;
+        int recv_k = (r - s - 1 + n) % n;
+
+        if (!exchange(dist, (data + CHUNK_OFFSET(send_k)), CHUNK_SIZE(send_k), dist->buffer, CHUNK_SIZE(recv_k))) {
+            return -1;
+        }
+
+        float *dst = data + CHUNK_OFFSET(recv_k);
+        for (int i = 0; i < CHUNK_SIZE(recv_k); i++) {
+            dst[i] += dist->buffer[i];
+        }
+    }
+
+    // all-gather: pass the summed chunks around the ring
+    for (int s = 0; s < (n - 1); s++) {
+        int send_k = (r + 1 - s + n) % n;
+        int recv_k = (r - s + n) % n;
+
+        if (!exchange(dist, (data + CHUNK_OFFSET(send_k)), CHUNK_SIZE(send_k),
+                (data + CHUNK_OFFSET(recv_k)), CHUNK_SIZE(recv_k))) {
+            return -1;
+        }
+    }
+
+#undef CHUNK_OFFSET
+#undef CHUNK_SIZE
+
+    return 0;
+}
+
+int dist_broadcast(Dist *dist, float *data, const int size)
+{
+    if ((dist == NULL) || (data == NULL) || (size < 0)) {
+        return -1;
+    }
+
+    // each piece is received from the previous rank and forwarded to the next one,
+    // the last rank does not send back to rank 0
+    const int last = dist->world_size - 1;
+    for (int i = 0; i < size; i += DIST_PIECE_SIZE) {
+        int n = ((size - i) < DIST_PIECE_SIZE) ? (size - i) : DIST_PIECE_SIZE;
+        if ((dist->rank > 0) && !dist->recv(dist, (data + i), n)) {
+            return -1;
+        }
+        if ((dist->rank < last) && !dist->send(dist, (data + i), n)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int dist_barrier(Dist *dist)
+{
+    float token = 0;
+
+    return dist_allreduce(dist, &token, 1);
+}
+
+void dist_free(Dist **dist)
+{
+    if (*dist == NULL) {
+        return;
+    }
+
+    if ((*dist)->shm != NULL) {
+        munmap((*dist)->shm, (*dist)->shm_size);
+    }
+    if ((*dist)->next_fd >= 0) {
+        close((*dist)->next_fd);
+    }
+    if ((*dist)->prev_fd >= 0) {
+        close((*dist)->prev_fd);
+    }
+
+    FREE_WITH_NULL(&(*dist)->buffer);
+
+    FREE_WITH_NULL(dist);
+}
+
+/**
+ * @brief pin the calling process to CPUs of a rank
+ * 
+ * @param[in] rank rank of the process
+ * @param[in] n_cpus num of CPUs of a rank
+ * @return true if succeeded
+ */
+static bool pin_cpus(const int rank, const int n_cpus)
+{
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return false;
+    }
+
+    // IDs of CPUs allowed to the process in ascending order
+    int ids[CPU_SETSIZE];
+    int n_allowed = 0;
+    for (int i = 0; i < CPU_SETSIZE; i++) {
+        if (CPU_ISSET(i, &allowed)) {
+            ids[n_allowed++] = i;
+        }
+    }
+    if (n_allowed == 0) {
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int i = 0; i < n_cpus; i++) {
+        CPU_SET(ids[((long)rank * n_cpus + i) % n_allowed], &set);
+    }
+
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+int dist_launch(const DistParameter param, int (*func)(const DistParameter param, void *arg), void *arg)
+{
+    if ((param.world_size < 1) || (param.cpus_per_rank < 0) || (func == NULL)) {
+        return -1;
+    }
+
+    char name[64];
+    if (param.name == NULL) {
+        snprintf(name, sizeof(name), "%ld", (long)getpid());
+    }
+
+    pid_t *pids = malloc(sizeof(pid_t) * param.world_size);
+    if (pids == NULL) {
+        return -1;
+    }
+
+    // avoid output buffered before fork from being written by children
+    fflush(NULL);
+
+    int n_children = 0;
+    bool failed = false;
+    for (; n_children < param.world_size; n_children++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            failed = true;
+            break;
+        }
+
+        if (pid == 0) {
+            DistParameter child = param;
+            child.rank = n_children;
+            if (child.name == NULL) {
+                child.name = name;
+            }
+
+            char value[32];
+            snprintf(value, sizeof(value), "%d", child.rank);
+            setenv("NNC_RANK", value, 1);
+            snprintf(value, sizeof(value), "%d", child.world_size);
+            setenv("NNC_WORLD_SIZE", value, 1);
+            setenv("NNC_DIST_NAME", child.name, 1);
+            if (child.transport != DIST_TRANSPORT_AUTO) {
+                setenv("NNC_DIST_TRANSPORT", ((child.transport == DIST_TRANSPORT_SHM) ? "shm" : "socket"), 1);
+            }
+
+            // pinned before func allocates anything, so memory is placed near the CPUs
+            if ((child.cpus_per_rank > 0) && !pin_cpus(child.rank, child.cpus_per_rank)) {
+                _exit(1);
+            }
+
+            int ret = func(child, arg);
+
+            fflush(NULL);
+            _exit((ret == 0) ? 0 : 1);
+        }
+
+        pids[n_children] = pid;
+    }
+
+    if (failed) {
+        for (int i = 0; i < n_children; i++) {
+            kill(pids[i], SIGTERM);
+        }
+    }
+
+    // only the recorded children are reaped, not the other children of the caller,
+    // and they are polled so that a failed one is found whichever rank it is
+    int n_running = n_children;
+    while (n_running > 0) {
+        bool reaped = false;
+        for (int i = 0; i < n_children; i++) {
+            if (pids[i] == 0) {
+                continue;
+            }
+
+            int status = 0;
+            pid_t pid = waitpid(pids[i], &status, WNOHANG);
+            if (pid == 0) {
+                continue;
+            }
+
+            // the child is not waited again even if waitpid failed
+            pids[i] = 0;
+            n_running--;
+            reaped = true;
+
+            if (!failed && ((pid < 0) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0))) {
+                // stop the others waiting for the failed one
+                failed = true;
+                for (int j = 0; j < n_children; j++) {
+                    if (pids[j] != 0) {
+                        kill(pids[j], SIGTERM);
+                    }
+                }
+            }
+        }
+
+        if (!reaped && (n_running > 0)) {
+            join_wait();
+        }
+    }
+
+    FREE_WITH_NULL(&pids);
+
+    return failed ? -1 : 0;
+}
@@ -0,0 +1,304 @@
+/**
+ * @file export.c
+ * @brief export of trained network into C source
+ * 
+ */
+#include "export.h"
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <ctype.h>
+
+// alignment of arrays in generated code, in bytes
+#define EXPORT_ALIGN 64
+
+/**
+ * @brief check if a string is a valid C identifier
+ * 
+ * @param[in] name target string
+ * @return true if valid
+ */
+static bool is_identifier(const char *name)
+{
+    if ((name == NULL) || !(isalpha((unsigned char)name[0]) || (name[0] == '_'))) {
+        return false;
+    }
+    for (const char *c = name; *c != '\0'; c++) {
+        if (!(isalnum((unsigned char)*c) || (*c == '_'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief write array as static const definition
+ * @note values are written as hexadecimal floating literals to keep them bit-exact
+ * 
+ * @param[in] fp output file
+ * @param[in] name prefix of array name
+ * @param[in] id layer ID, suffix of array name
+ * @param[in] array array to be written
+ * @param[in] size num of elements
+ */
+static void write_array(FILE *fp, const char *name, const int id, const float *array, const int size)
+{
+    fprintf(fp, "static const _Alignas(%d) float %s%d[%d] = {", EXPORT_ALIGN, name, id, size);
+    for (int i = 0; i < size; i++) {
+        fprintf(fp, "%s%af,", ((i % 8) == 0) ? "\n    " : " ", (double)array[i]);
+    }
+    fprintf(fp, "\n};\n\n");
+}
+
+/**
+ * @brief write name of output array of layer
+ * 
+ * @param[in] net target network
+ * @param[in] id layer ID
+ * @param[out] buf buffer of name
+ * @param[in] size size of buffer
+ */
+static void output_name(const Net *net, const int id, char *buf, const size_t size)
+{
+    if (id == net->output_layer->id) {
+        snprintf(buf, size, "y");
+    } else {
+        snprintf(buf, size, "y%d", id);
+    }
+}
+
+/**
+ * @brief write Fully connected part: y = Wx + b followed by activation
+ * 
+ * @param[in] fp output file
+ * @param[in] layer target layer
+ * @param[in] y name of output array
+ * @param[in] activation expression of activation on v, NULL if nothing
+ */
+static void write_fc(FILE *fp, const Layer *layer, const char *y, const char *activation)
+{
+    const int in  = layer->x_dim[1];
+    const int out = layer->y_dim[1];
+
+    fprintf(fp, "        for (int j = 0; j < %d; j++) {\n", out);
+    fprintf(fp, "            %s[j] = 0.0f;\n", y);
+    fprintf(fp, "        }\n");
+    fprintf(fp, "        for (int k = 0; k < %d; k++) {\n", in);
+    fprintf(fp, "            const float xk = x0[k];\n");
+    fprintf(fp, "            for (int j = 0; j < %d; j++) {\n", out);
+    fprintf(fp, "                %s[j] += xk * w%d[(k * %d) + j];\n", y, layer->id, out);
+    fprintf(fp, "            }\n");
+    fprintf(fp, "        }\n");
+    fprintf(fp, "        for (int j = 0; j < %d; j++) {\n", out);
+    fprintf(fp, "            const float v = %s[j] + b%d[j];\n", y, layer->id);
+    fprintf(fp, "            %s[j] = %s;\n", y, (activation == NULL) ? "v" : activation);
+    fprintf(fp, "        }\n");
+}
+
+/**
+ * @brief write Softmax applied to y in place
+ * 
+ * @param[in] fp output file
+ * @param[in] y name of output array
+ * @param[in] size num of elements
+ */
+static void write_softmax(FILE *fp, const char *y, const int size)
+{
+    fprintf(fp, "        float max = %s[0];\n", y);
+    fprintf(fp, "        for (int i = 1; i < %d; i++) {\n", size);
+    fprintf(fp, "            max = (%s[i] > max) ? %s[i] : max;\n", y, y);
+    fprintf(fp, "        }\n");
+    fprintf(fp, "        float sum = 0.0f;\n");
+    fprintf(fp, "        for (int i = 0; i < %d; i++) {\n", size);
+    fprintf(fp, "            %s[i] = expf(%s[i] - max);\n", y, y);
+    fprintf(fp, "            sum += %s[i];\n", y);
+    fprintf(fp, "        }\n");
+    fprintf(fp, "        for (int i = 0; i < %d; i++) {\n", size);
+    fprintf(fp, "            %s[i] /= sum;\n", y);
+    fprintf(fp, "        }\n");
+}
+
+/**
+ * @brief write elementwise operation y[i] = f(x0[i])
+ * 
+ * @param[in] fp output file
+ * @param[in] y name of output array
+ * @param[in] size num of elements
+ * @param[in] expression expression of f on v
+ */
+static void write_elementwise(FILE *fp, const char *y, const int size, const char *expression)
+{
+    fprintf(fp, "        for (int i = 0; i < %d; i++) {\n", size);
+    fprintf(fp, "            const float v = x0[i];\n");
+    fprintf(fp, "            %s[i] = %s;\n", y, expression);
+    fprintf(fp, "        }\n");
+}
+
+// activations on v in generated code
+static const char *SIGMOID = "1.0f / (1.0f + expf(-v))";
+static const char *RELU    = "(v > 0.0f) ? v : 0.0f";
+
+/**
+ * @brief write forward propagation of a layer
+ * 
+ * @param[in] fp output file
+ * @param[in] net target network
+ * @param[in] layer target layer
+ * @return true if succeeded, false if layer type is not supported
+ */
+static bool write_layer(FILE *fp, const Net *net, const Layer *layer)
+{
+    char y[32];
+    output_name(net, layer->id, y, sizeof(y));
+
+    fprintf(fp, "    // layer %d\n", layer->id);
+    fprintf(fp, "    {\n");
+
+    for (int i = 0; i < layer->n_in; i++) {
+        int in_id = layer->in_ids[i];
+        if (in_id < 0) {
+            fprintf(fp, "        const float *x%d = x;\n", i);
+        } else {
+            const Layer *in_layer = net->layers[in_id];
+            fprintf(fp, "        const float *x%d = y%d + %d;\n", i, in_id, in_layer->ys_offset[layer->in_ports[i]]);
+        }
+    }
+
+    switch (layer->type) {
+    case LAYER_TYPE_FC:
+        write_fc(fp, layer, y, NULL);
+        break;
+    case LAYER_TYPE_FC_SIGMOID:
+        write_fc(fp, layer, y, SIGMOID);
+        break;
+    case LAYER_TYPE_FC_RELU:
+        write_fc(fp, layer, y, RELU);
+        break;
+    case LAYER_TYPE_FC_SOFTMAX:
+        write_fc(fp, layer, y, NULL);
+        write_softmax(fp, y, layer->y_size);
+        break;
+    case LAYER_TYPE_SIGMOID:
+        write_elementwise(fp, y, layer->y_size, SIGMOID);
+        break;
+    case LAYER_TYPE_RELU:
+        write_elementwise(fp, y, layer->y_size, RELU);
+        break;
+    case LAYER_TYPE_SOFTMAX:
+        write_elementwise(fp, y, layer->y_size, "v");
+        write_softmax(fp, y, layer->y_size);
+        break;
+    case LAYER_TYPE_SIGMOID_SOFTMAX:
+        write_elementwise(fp, y, layer->y_size, SIGMOID);
+        write_softmax(fp, y, layer->y_size);
+        break;
+    case LAYER_TYPE_SPLIT:
+        write_elementwise(fp, y, layer->y_size, "v");
+        break;
+    case LAYER_TYPE_ADD:
+        fprintf(fp, "        for (int i = 0; i < %d; i++) {\n", layer->y_size);
+        fprintf(fp, "            %s[i] = x0[i]", y);
+        for (int i = 1; i < layer->n_in; i++) {
+            fprintf(fp, " + x%d[i]", i);
+        }
+        fprintf(fp, ";\n");
+        fprintf(fp, "        }\n");
+        break;
+    case LAYER_TYPE_CONCAT:
+        for (int i = 0, offset = 0; i < layer->n_in; i++) {
+            fprintf(fp, "        for (int i = 0; i < %d; i++) {\n", layer->xs_size[i]);
+            fprintf(fp, "            %s[%d + i] = x%d[i];\n", y, offset, i);
+            fprintf(fp, "        }\n");
+            offset += layer->xs_size[i];
+        }
+        break;
+    default:
+        return false;
+    }
+
+    fprintf(fp, "    }\n");
+
+    return true;
+}
+
+int net_export_c(Net *net, const char *filename, const char *func_name)
+{
+    if ((net == NULL) || (net->size < 1) || (filename == NULL) || !is_identifier(func_name)) {
+        return -1;
+    }
+
+    // the network input is shared by all source layers
+    int in_size = 0;
+    for (int i = 0; i < net->size; i++) {
+        const Layer *layer = net->layers[i];
+        for (int j = 0; j < layer->n_in; j++) {
+            if (layer->in_ids[j] >= 0) {
+                continue;
+            }
+            if ((in_size != 0) && (in_size != layer->xs_size[j])) {
+                return -1;
+            }
+            in_size = layer->xs_size[j];
+        }
+    }
+
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL) {
+        return -1;
+    }
+
+    fprintf(fp, "/**\n");
+    fprintf(fp, " * @file %s\n", filename);
+    fprintf(fp, " * @brief inference function generated by net_export_c()\n");
+    fprintf(fp, " * \n");
+    fprintf(fp, " * void %s(const float *x, float *y);\n", func_name);
+    fprintf(fp, " *   x: network input, %d elements\n", in_size);
+    fprintf(fp, " *   y: network output, %d elements\n", net->output_layer->y_size);
+    fprintf(fp, " */\n");
+    fprintf(fp, "#include <math.h>\n\n");
+
+    for (int i = 0; i < net->size; i++) {
+        const Layer *layer = net->layers[i];
+        if (layer->w != NULL) {
+            write_array(fp, "w", layer->id, layer->w, layer->w_size);
+        }
+        if (layer->b != NULL) {
+            write_array(fp, "b", layer->id, layer->b, layer->b_size);
+        }
+    }
+
+    fprintf(fp, "void %s(const float *x, float *y);\n\n", func_name);
+    fprintf(fp, "void %s(const float *x, float *y)\n", func_name);
+    fprintf(fp, "{\n");
+
+    // intermediate outputs on stack
+    for (int i = 0; i < net->size; i++) {
+        const Layer *layer = net->layers[i];
+        if (layer != net->output_layer) {
+            fprintf(fp, "    _Alignas(%d) float y%d[%d];\n", EXPORT_ALIGN, layer->id, layer->y_size);
+        }
+    }
+    fprintf(fp, "\n");
+
+    // layer IDs are in topological order
+    bool succeeded = true;
+    for (int i = 0; i < net->size; i++) {
+        if (!write_layer(fp, net, net->layers[i])) {
+            succeeded = false;
+            break;
+        }
+    }
+
+    fprintf(fp, "}\n");
+
+    if (fclose(fp) != 0) {
+        succeeded = false;
+    }
+
+    if (!succeeded) {
+        remove(filename);
+        return -1;
+    }
+
+    return 0;
+}
@@ -7,6 +7,7 @@
 
 #include "data.h"
 #include "mat.h"
+#include "sparse.h"
 
 /**
  * @brief forward propagation of Fully connected layer
@@ -18,8 +19,12 @@ static void forward(Layer *self, const float *x)
 {
     self->x = x;
 
-    // y = Wx + b
-    mat_mul(self->x, self->w, self->y, 1, self->x_dim[1], self->y_dim[1]);
+    // y = Wx + b, only rows of W at nonzeros of sparse input are read
+    if (self->sx != NULL) {
+        sparse_mat_mul(self->sx, self->w, self->y, self->y_dim[1]);
+    } else {
+        mat_mul(self->x, self->w, self->y, 1, self->x_dim[1], self->y_dim[1]);
+    }
     mat_add(self->y, self->b, self->y, 1, self->y_dim[1]);
 }
 
@@ -31,8 +36,30 @@ static void forward(Layer *self, const float *x)
  */
 static void backward(Layer *self, const float *dy)
 {
+    if (self->sx != NULL) {
+        // network input has no diff, only rows of dW at nonzeros of input are written
+        layer_sparse_grad(self, dy);
+
+        if (self->accumulate) {
+            mat_add(self->db, dy, self->db, 1, self->b_size);
+        } else {
+            fdata_copy(dy, self->b_size, self->db);
+        }
+        return;
+    }
+
     // dy = Wx^T
     mat_mul_trans_b(dy, self->w, self->dx, 1, self->y_dim[1], self->x_dim[1]);
+
+    // every row of dW is written
+    self->rows.sparse = false;
+    if (self->accumulate) {
+        // dW += x^T dy, db += dy
+        mat_mul_trans_a_acc(self->x, dy, self->dw, 1, self->x_dim[1], self->y_dim[1]);
+        mat_add(self->db, dy, self->db, 1, self->b_size);
+        return;
+    }
+
     // dW = x^T dy
     mat_mul_trans_a(self->x, dy, self->dw, 1, self->x_dim[1], self->y_dim[1]);
 
@@ -87,6 +114,10 @@ Layer *fc_layer(const LayerParameter layer_param)
         goto LAYER_FREE;
     }
 
+    layer->xs_size[0] = x_size;
+    layer->dxs[0]     = layer->dx;
+    layer->ys_size[0] = y_size;
+
     layer->dw = fdata_alloc(w_size);
     if (layer->dw == NULL) {
         goto LAYER_FREE;
@@ -97,6 +128,9 @@ Layer *fc_layer(const LayerParameter layer_param)
         goto LAYER_FREE;
     }
 
+    layer->type  = LAYER_TYPE_FC;
+    layer->param = layer_param;
+
     layer->forward  = forward;
     layer->backward = backward;
 
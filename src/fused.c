@@ -0,0 +1,331 @@
+/**
+ * @file fused.c
+ * @brief fused layers, which compute two successive layers in one pass
+ * 
+ */
+#include "fused.h"
+
+#include <stddef.h>
+#include <math.h>
+
+#include "data.h"
+#include "fc.h"
+#include "sigmoid.h"
+#include "mat.h"
+#include "sparse.h"
+
+/**
+ * @brief compute y = Wx + b without bias/activation passes over y
+ * @note W is streamed row by row, y stays in cache while accumulating
+ * 
+ * @param self target layer
+ */
+static void fc_kernel(Layer *self)
+{
+    const int in  = self->x_dim[1];
+    const int out = self->y_dim[1];
+
+    if (self->sx != NULL) {
+        sparse_mat_mul(self->sx, self->w, self->y, out);
+        mat_add(self->y, self->b, self->y, 1, out);
+        return;
+    }
+
+    for (int j = 0; j < out; j++) {
+        self->y[j] = 0;
+    }
+    for (int k = 0; k < in; k++) {
+        const float xk = self->x[k];
+        const float *w = &self->w[k * out];
+        for (int j = 0; j < out; j++) {
+            self->y[j] += xk * w[j];
+        }
+    }
+    for (int j = 0; j < out; j++) {
+        self->y[j] += self->b[j];
+    }
+}
+
+/**
+ * @brief get buffer to write diff of Fully connected part
+ * @note it is db itself unless gradients are accumulated
+ * 
+ * @param self target layer
+ * @return float* buffer of dz
+ */
+static float *dz_buffer(Layer *self)
+{
+    return self->accumulate ? self->dz : self->db;
+}
+
+/**
+ * @brief backward propagation of Fully connected part with diff of its output in dz_buffer()
+ * 
+ * @param self target layer
+ */
+static void fc_backward_kernel(Layer *self)
+{
+    const float *dz = dz_buffer(self);
+
+    if (self->sx != NULL) {
+        // network input has no diff, only rows of dW at nonzeros of input are written
+        if (self->accumulate) {
+            mat_add(self->db, dz, self->db, 1, self->b_size);
+        }
+        layer_sparse_grad(self, dz);
+        return;
+    }
+
+    // dx = dz W^T
+    mat_mul_trans_b(dz, self->w, self->dx, 1, self->y_dim[1], self->x_dim[1]);
+
+    // every row of dW is written
+    self->rows.sparse = false;
+
+    if (self->accumulate) {
+        // dW += x^T dz, db += dz
+        mat_mul_trans_a_acc(self->x, dz, self->dw, 1, self->x_dim[1], self->y_dim[1]);
+        mat_add(self->db, dz, self->db, 1, self->b_size);
+        return;
+    }
+
+    // dW = x^T dz
+    mat_mul_trans_a(self->x, dz, self->dw, 1, self->x_dim[1], self->y_dim[1]);
+}
+
+/**
+ * @brief apply Softmax to y in place
+ * 
+ * @param self target layer
+ */
+static void softmax_kernel(Layer *self)
+{
+    // the max is subtracted not to overflow exp
+    float max = self->y[0];
+    for (int i = 1; i < self->y_size; i++) {
+        if (self->y[i] > max) {
+            max = self->y[i];
+        }
+    }
+
+    float sum = 0;
+    for (int i = 0; i < self->y_size; i++) {
+        self->y[i] = exp(self->y[i] - max);
+        sum += self->y[i];
+    }
+
+    for (int i = 0; i < self->y_size; i++) {
+        self->y[i] /= sum;
+    }
+}
+
+/**
+ * @brief forward propagation of fused Fully connected and Sigmoid layer
+ * 
+ * @param self target layer
+ * @param x layer input
+ */
+static void fc_sigmoid_forward(Layer *self, const float *x)
+{
+    self->x = x;
+
+    fc_kernel(self);
+
+    for (int i = 0; i < self->y_size; i++) {
+        self->y[i] = 1.0f / (1 + exp(-self->y[i]));
+    }
+}
+
+/**
+ * @brief backward propagation of fused Fully connected and Sigmoid layer
+ * 
+ * @param self target layer
+ * @param dy diff of next layer
+ */
+static void fc_sigmoid_backward(Layer *self, const float *dy)
+{
+    // dz = dy * (1 - y) * y
+    float *dz = dz_buffer(self);
+    for (int i = 0; i < self->y_size; i++) {
+        dz[i] = dy[i] * (1.0f - self->y[i]) * self->y[i];
+    }
+
+    fc_backward_kernel(self);
+}
+
+/**
+ * @brief forward propagation of fused Fully connected and ReLU layer
+ * 
+ * @param self target layer
+ * @param x layer input
+ */
+static void fc_relu_forward(Layer *self, const float *x)
+{
+    self->x = x;
+
+    fc_kernel(self);
+
+    for (int i = 0; i < self->y_size; i++) {
+        self->y[i] = (self->y[i] > 0) ? self->y[i] : 0;
+    }
+}
+
+/**
+ * @brief backward propagation of fused Fully connected and ReLU layer
+ * 
+ * @param self target layer
+ * @param dy diff of next layer
+ */
+static void fc_relu_backward(Layer *self, const float *dy)
+{
+    // y > 0 iff Wx + b > 0
+    float *dz = dz_buffer(self);
+    for (int i = 0; i < self->y_size; i++) {
+        dz[i] = (self->y[i] > 0) ? dy[i] : 0;
+    }
+
+    fc_backward_kernel(self);
+}
+
+/**
+ * @brief forward propagation of fused Fully connected and Softmax layer
+ * 
+ * @param self target layer
+ * @param x layer input
+ */
+static void fc_softmax_forward(Layer *self, const float *x)
+{
+    self->x = x;
+
+    fc_kernel(self);
+
+    softmax_kernel(self);
+}
+
+/**
+ * @brief backward propagation of fused Fully connected and Softmax layer
+ * 
+ * @param self target layer
+ * @param dy diff of next layer
+ */
+static void fc_softmax_backward(Layer *self, const float *dy)
+{
+    // backward with cross entropy loss, diff passes through Softmax
+    float *dz = dz_buffer(self);
+    for (int i = 0; i < self->y_size; i++) {
+        dz[i] = dy[i];
+    }
+
+    fc_backward_kernel(self);
+}
+
+/**
+ * @brief forward propagation of fused Sigmoid and Softmax layer
+ * @note output of Sigmoid is kept in dx until backward propagation
+ * 
+ * @param self target layer
+ * @param x layer input
+ */
+static void sigmoid_softmax_forward(Layer *self, const float *x)
+{
+    self->x = x;
+
+    for (int i = 0; i < self->x_size; i++) {
+        self->dx[i] = 1.0f / (1 + exp(-self->x[i]));
+        self->y[i]  = self->dx[i];
+    }
+
+    softmax_kernel(self);
+}
+
+/**
+ * @brief backward propagation of fused Sigmoid and Softmax layer
+ * 
+ * @param self target layer
+ * @param dy diff of next layer
+ */
+static void sigmoid_softmax_backward(Layer *self, const float *dy)
+{
+    // backward with cross entropy loss, diff passes through Softmax
+    for (int i = 0; i < self->x_size; i++) {
+        self->dx[i] = dy[i] * (1.0f - self->dx[i]) * self->dx[i];
+    }
+}
+
+Layer *fc_sigmoid_layer(const LayerParameter layer_param)
+{
+    Layer *layer = fc_layer(layer_param);
+    if (layer == NULL) {
+        return NULL;
+    }
+
+    layer->type = LAYER_TYPE_FC_SIGMOID;
+
+    layer->forward  = fc_sigmoid_forward;
+    layer->backward = fc_sigmoid_backward;
+
+    layer->dz = fdata_alloc(layer->y_size);
+    if (layer->dz == NULL) {
+        layer_free(&layer);
+        return NULL;
+    }
+
+    return layer;
+}
+
+Layer *fc_relu_layer(const LayerParameter layer_param)
+{
+    Layer *layer = fc_layer(layer_param);
+    if (layer == NULL) {
+        return NULL;
+    }
+
+    layer->type = LAYER_TYPE_FC_RELU;
+
+    layer->forward  = fc_relu_forward;
+    layer->backward = fc_relu_backward;
+
+    layer->dz = fdata_alloc(layer->y_size);
+    if (layer->dz == NULL) {
+        layer_free(&layer);
+        return NULL;
+    }
+
+    return layer;
+}
+
+Layer *fc_softmax_layer(const LayerParameter layer_param)
+{
+    Layer *layer = fc_layer(layer_param);
+    if (layer == NULL) {
+        return NULL;
+    }
+
+    layer->type = LAYER_TYPE_FC_SOFTMAX;
+
+    layer->forward  = fc_softmax_forward;
+    layer->backward = fc_softmax_backward;
+
+    layer->dz = fdata_alloc(layer->y_size);
+    if (layer->dz == NULL) {
+        layer_free(&layer);
+        return NULL;
+    }
+
+    return layer;
+}
+
+Layer *sigmoid_softmax_layer(const LayerParameter layer_param)
+{
+    Layer *layer = sigmoid_layer(layer_param);
+    if (layer == NULL) {
+        return NULL;
+    }
+
+    layer->type = LAYER_TYPE_SIGMOID_SOFTMAX;
+
+    layer->forward  = sigmoid_softmax_forward;
+    layer->backward = sigmoid_softmax_backward;
+
+    return layer;
+}
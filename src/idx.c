@@ -0,0 +1,355 @@
+/**
+ * @file idx.c
+ * @brief memory-mapped reader of IDX files, optionally compressed with gzip
+ * 
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "idx.h"
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "inflate.h"
+#include "util.h"
+
+// size of magic number and each dimension [byte]
+#define IDX_WORD_SIZE 4
+
+/**
+ * @brief read 32-bit big endian integer
+ * 
+ * @param[in] p pointer to the first byte
+ * @return uint32_t value
+ */
+static uint32_t read_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+int idx_type_size(const IdxType type)
+{
+    switch (type) {
+    case IDX_TYPE_UBYTE:
+    case IDX_TYPE_BYTE:
+        return 1;
+    case IDX_TYPE_SHORT:
+        return 2;
+    case IDX_TYPE_INT:
+    case IDX_TYPE_FLOAT:
+        return 4;
+    case IDX_TYPE_DOUBLE:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief parse header of IDX file
+ * @note data of file is set to the elements following the header in bytes
+ * 
+ * @param[in] bytes bytes from the beginning of the file, the header at least
+ * @param[in] n_bytes num of bytes available in bytes
+ * @param[in] file_size size of the file [byte]
+ * @param[in,out] file IDX file
+ * @return true if the header is valid
+ */
+static bool parse_header(const uint8_t *bytes, const size_t n_bytes, const size_t file_size, IdxFile *file)
+{
+    if (n_bytes < IDX_WORD_SIZE) {
+        return false;
+    }
+
+    // magic number: 0x00, 0x00, element type, num of dimensions
+    if ((bytes[0] != 0) || (bytes[1] != 0)) {
+        return false;
+    }
+
+    file->type = (IdxType)bytes[2];
+    const int type_size = idx_type_size(file->type);
+    if (type_size == 0) {
+        return false;
+    }
+
+    file->n_dims = bytes[3];
+    if ((file->n_dims < 1) || (file->n_dims > IDX_MAX_DIMS)) {
+        return false;
+    }
+
+    const size_t header_size = idx_header_size(file);
+    if ((n_bytes < header_size) || (file_size < header_size)) {
+        return false;
+    }
+
+    size_t n_elements = 1;
+    for (int i = 0; i < file->n_dims; i++) {
+        uint32_t dim = read_be32(bytes + IDX_WORD_SIZE * (1 + i));
+        if ((dim < 1) || (dim > INT32_MAX)) {
+            return false;
+        }
+        file->dims[i] = (int)dim;
+
+        if (n_elements > (SIZE_MAX / dim)) {
+            return false;
+        }
+        n_elements *= dim;
+    }
+
+    // elements must be in the file
+    if (n_elements > ((file_size - header_size) / type_size)) {
+        return false;
+    }
+
+    size_t item_size = n_elements / file->dims[0];
+    if (item_size > INT32_MAX) {
+        return false;
+    }
+
+    file->size      = file->dims[0];
+    file->item_size = (int)item_size;
+    file->data      = bytes + header_size;
+
+    return true;
+}
+
+size_t idx_header_size(const IdxFile *file)
+{
+    return (size_t)IDX_WORD_SIZE * (1 + file->n_dims);
+}
+
+/**
+ * @brief get IDX file with no elements
+ * 
+ * @return IdxFile empty IDX file
+ */
+static IdxFile empty_file(void)
+{
+    return (IdxFile){
+        .type      = IDX_TYPE_UBYTE,
+        .n_dims    = 0,
+        .dims      = { 0 },
+        .size      = 0,
+        .item_size = 0,
+        .data      = NULL,
+        .map       = NULL,
+        .map_size  = 0,
+        .buffer    = NULL
+    };
+}
+
+/**
+ * @brief decode header of gzip-compressed IDX file
+ * @note size of decoded file is unknown until the end,
+ *       so elements the header describes are not checked
+ * 
+ * @param[in,out] inflater inflater at the beginning of the file
+ * @param[out] file IDX file, its data is invalid
+ * @return true if the header is valid
+ */
+static bool inflate_header(Inflater *inflater, IdxFile *file)
+{
+    uint8_t header[IDX_WORD_SIZE * (1 + IDX_MAX_DIMS)];
+    size_t n_read;
+
+    // num of dimensions in magic number determines size of header
+    if ((inflater_read(inflater, header, IDX_WORD_SIZE, &n_read) != 0) || (n_read != IDX_WORD_SIZE)) {
+        return false;
+    }
+
+    const size_t header_size = (size_t)IDX_WORD_SIZE * (1 + header[3]);
+    if (header_size > sizeof(header)) {
+        return false;
+    }
+
+    const size_t n_dims_size = header_size - IDX_WORD_SIZE;
+    if ((inflater_read(inflater, (header + IDX_WORD_SIZE), n_dims_size, &n_read) != 0) || (n_read != n_dims_size)) {
+        return false;
+    }
+
+    return parse_header(header, header_size, SIZE_MAX, file);
+}
+
+/**
+ * @brief decode elements of gzip-compressed IDX file mapped into memory
+ * @note elements are decoded into an allocated buffer, and the compressed file is unmapped
+ * 
+ * @param[in,out] file IDX file
+ * @return true if the file is decoded
+ */
+static bool inflate_file(IdxFile *file)
+{
+    Inflater *inflater = inflater_create(file->map, file->map_size);
+    if (inflater == NULL) {
+        return false;
+    }
+
+    bool decoded = false;
+
+    if (!inflate_header(inflater, file)) {
+        goto INFLATE_FREE;
+    }
+
+    const size_t data_size = (size_t)file->size * file->item_size * idx_type_size(file->type);
+    file->buffer = malloc(data_size);
+    if (file->buffer == NULL) {
+        goto INFLATE_FREE;
+    }
+
+    size_t n_read;
+    if ((inflater_read(inflater, file->buffer, data_size, &n_read) != 0) || (n_read != data_size)) {
+        goto INFLATE_FREE;
+    }
+
+    // bytes following the elements are decoded to verify CRC
+    uint8_t rest[IDX_WORD_SIZE * 256];
+    do {
+        if (inflater_read(inflater, rest, sizeof(rest), &n_read) != 0) {
+            goto INFLATE_FREE;
+        }
+    } while (n_read == sizeof(rest));
+
+    munmap(file->map, file->map_size);
+    file->map      = NULL;
+    file->map_size = 0;
+    file->data     = file->buffer;
+
+    decoded = true;
+
+INFLATE_FREE:
+    inflater_free(&inflater);
+
+    return decoded;
+}
+
+IdxFile *idx_open(const char *filename)
+{
+    if (filename == NULL) {
+        return NULL;
+    }
+
+    IdxFile *file = malloc(sizeof(IdxFile));
+    if (file == NULL) {
+        return NULL;
+    }
+
+    *file = empty_file();
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        FREE_WITH_NULL(&file);
+        return NULL;
+    }
+
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (st.st_size < IDX_WORD_SIZE)) {
+        goto IDX_FREE;
+    }
+
+    file->map_size = (size_t)st.st_size;
+    file->map = mmap(NULL, file->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (file->map == MAP_FAILED) {
+        file->map = NULL;
+        goto IDX_FREE;
+    }
+
+    // the mapping is kept after closing the descriptor
+    close(fd);
+    fd = -1;
+
+    if (gzip_check(file->map, file->map_size)) {
+        // sequential access to compressed file
+        posix_madvise(file->map, file->map_size, POSIX_MADV_SEQUENTIAL);
+        if (!inflate_file(file)) {
+            goto IDX_FREE;
+        }
+    } else if (!parse_header(file->map, file->map_size, file->map_size, file)) {
+        goto IDX_FREE;
+    }
+
+    return file;
+
+IDX_FREE:
+    if (fd >= 0) {
+        close(fd);
+    }
+    idx_close(&file);
+
+    return NULL;
+}
+
+int idx_read_header(const char *filename, IdxFile *file)
+{
+    if ((filename == NULL) || (file == NULL)) {
+        return -1;
+    }
+
+    *file = empty_file();
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    // the longest header is read at most
+    uint8_t header[IDX_WORD_SIZE * (1 + IDX_MAX_DIMS)];
+
+    struct stat st;
+    ssize_t n_read = -1;
+    if (fstat(fd, &st) == 0) {
+        n_read = pread(fd, header, sizeof(header), 0);
+    }
+
+    bool valid = false;
+    if ((n_read >= 0) && gzip_check(header, (size_t)n_read)) {
+        // only the beginning of compressed file is decoded
+        void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            Inflater *inflater = inflater_create(map, (size_t)st.st_size);
+            valid = (inflater != NULL) && inflate_header(inflater, file);
+
+            inflater_free(&inflater);
+            munmap(map, (size_t)st.st_size);
+        }
+    } else if (n_read >= 0) {
+        valid = parse_header(header, (size_t)n_read, (size_t)st.st_size, file);
+    }
+    close(fd);
+
+    if (!valid) {
+        *file = empty_file();
+        return -1;
+    }
+
+    // elements are not read
+    file->data = NULL;
+
+    return 0;
+}
+
+const uint8_t *idx_item(const IdxFile *file, const int index)
+{
+    if ((file == NULL) || (index < 0) || (index >= file->size)) {
+        return NULL;
+    }
+
+    return file->data + (size_t)index * file->item_size * idx_type_size(file->type);
+}
+
+void idx_close(IdxFile **file)
+{
+    if (*file == NULL) {
+        return;
+    }
+
+    if ((*file)->map != NULL) {
+        munmap((*file)->map, (*file)->map_size);
+    }
+    FREE_WITH_NULL(&(*file)->buffer);
+
+    FREE_WITH_NULL(file);
+}
@@ -0,0 +1,645 @@
+/**
+ * @file inflate.c
+ * @brief decoder of gzip files compressed with DEFLATE
+ * 
+ */
+#include "inflate.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "util.h"
+
+// flags of gzip header
+#define GZIP_FLAG_HCRC      0x02
+#define GZIP_FLAG_EXTRA     0x04
+#define GZIP_FLAG_NAME      0x08
+#define GZIP_FLAG_COMMENT   0x10
+#define GZIP_FLAG_RESERVED  0xE0
+
+// compression method of gzip, DEFLATE
+#define GZIP_METHOD_DEFLATE 8
+
+// size of gzip header without optional fields [byte]
+#define GZIP_HEADER_SIZE 10
+
+// end of block code
+#define INFLATE_END_OF_BLOCK 256
+
+// base lengths and num of extra bits of length codes 257-285
+static const uint16_t LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+// base distances and num of extra bits of distance codes 0-29
+static const uint16_t DISTANCE_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t DISTANCE_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// order of lengths of code length code
+static const uint8_t CODE_LENGTH_ORDER[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+bool gzip_check(const uint8_t *src, const size_t size)
+{
+    return (src != NULL) && (size >= 2) && (src[0] == 0x1F) && (src[1] == 0x8B);
+}
+
+/**
+ * @brief reverse order of bits
+ * 
+ * @param[in] code bits to be reversed
+ * @param[in] n_bits num of bits of code
+ * @return uint32_t reversed bits
+ */
+static uint32_t reverse_bits(uint32_t code, const int n_bits)
+{
+    uint32_t reversed = 0;
+    for (int i = 0; i < n_bits; i++) {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+
+    return reversed;
+}
+
+/**
+ * @brief build canonical Huffman code from lengths of codes
+ * @note incomplete codes are accepted, unused codes are rejected when they are decoded
+ * 
+ * @param[out] huffman target code
+ * @param[in] lengths length of code of each symbol, 0 if unused
+ * @param[in] n_symbols num of symbols
+ * @return true if lengths are valid
+ */
+static bool build_huffman(InflateHuffman *huffman, const uint8_t *lengths, const int n_symbols)
+{
+    int count[16] = { 0 };
+    for (int i = 0; i < n_symbols; i++) {
+        count[lengths[i]]++;
+    }
+
+    uint32_t next_code[16];
+    uint32_t code   = 0;
+    uint32_t symbol = 0;
+    for (int n = 1; n < 16; n++) {
+        next_code[n]               = code;
+        huffman->first_code[n]     = (uint16_t)code;
+        huffman->first_symbol[n]   = (uint16_t)symbol;
+
+        code += count[n];
+        // over-subscribed
+        if (code > (1U << n)) {
+            return false;
+        }
+        huffman->max_code[n] = code << (16 - n);
+
+        code <<= 1;
+        symbol += count[n];
+    }
+    huffman->max_code[16] = 1U << 16;
+
+    memset(huffman->fast, 0, sizeof(huffman->fast));
+
+    for (int i = 0; i < n_symbols; i++) {
+        const int n = lengths[i];
+        if (n == 0) {
+            continue;
+        }
+
+        huffman->symbols[huffman->first_symbol[n] + (next_code[n] - huffman->first_code[n])] = (uint16_t)i;
+
+        // codes are read from LSB, every entry starting with a short code points to it
+        if (n <= INFLATE_FAST_BITS) {
+            for (uint32_t j = reverse_bits(next_code[n], n); j < (1U << INFLATE_FAST_BITS); j += (1U << n)) {
+                huffman->fast[j] = (uint16_t)((n << 9) | i);
+            }
+        }
+        next_code[n]++;
+    }
+
+    return true;
+}
+
+/**
+ * @brief load bytes of file into bit buffer, zeros are padded after the end of file
+ * 
+ * @param[in,out] inflater target inflater
+ */
+static void refill(Inflater *inflater)
+{
+    while (inflater->n_bits <= 56) {
+        uint64_t byte = 0;
+        if (inflater->pos < inflater->src_size) {
+            byte = inflater->src[inflater->pos++];
+        } else {
+            inflater->n_padding += 8;
+        }
+        inflater->bits |= byte << inflater->n_bits;
+        inflater->n_bits += 8;
+    }
+}
+
+/**
+ * @brief check if bits after the end of file have been consumed
+ * 
+ * @param[in] inflater target inflater
+ * @return true if the file is truncated
+ */
+static bool overrun(const Inflater *inflater)
+{
+    return inflater->n_bits < inflater->n_padding;
+}
+
+/**
+ * @brief consume bits
+ * 
+ * @param[in,out] inflater target inflater
+ * @param[in] n_bits num of bits, 32 at most
+ * @return uint32_t value of bits, the first bit is LSB
+ */
+static uint32_t get_bits(Inflater *inflater, const int n_bits)
+{
+    if (inflater->n_bits < n_bits) {
+        refill(inflater);
+    }
+
+    const uint32_t value = (uint32_t)(inflater->bits & ((1ULL << n_bits) - 1));
+    inflater->bits >>= n_bits;
+    inflater->n_bits -= n_bits;
+
+    return value;
+}
+
+/**
+ * @brief discard bits to the next byte boundary
+ * 
+ * @param[in,out] inflater target inflater
+ */
+static void align_to_byte(Inflater *inflater)
+{
+    get_bits(inflater, (inflater->n_bits % 8));
+}
+
+/**
+ * @brief decode a symbol
+ * 
+ * @param[in,out] inflater target inflater
+ * @param[in] huffman code of symbols
+ * @return int symbol, -1 if the code is unused
+ */
+static int decode(Inflater *inflater, const InflateHuffman *huffman)
+{
+    if (inflater->n_bits < 16) {
+        refill(inflater);
+    }
+
+    const int entry = huffman->fast[inflater->bits & ((1U << INFLATE_FAST_BITS) - 1)];
+    if (entry != 0) {
+        get_bits(inflater, (entry >> 9));
+        return entry & 0x1FF;
+    }
+
+    // long codes are compared in order of MSB first
+    const uint32_t code = reverse_bits((uint32_t)(inflater->bits & 0xFFFF), 16);
+
+    int n = INFLATE_FAST_BITS + 1;
+    for (; n < 16; n++) {
+        if (code < huffman->max_code[n]) {
+            break;
+        }
+    }
+    if (n >= 16) {
+        return -1;
+    }
+
+    const int index = (int)(code >> (16 - n)) - huffman->first_code[n] + huffman->first_symbol[n];
+    if ((index < 0) || (index >= 288)) {
+        return -1;
+    }
+    get_bits(inflater, n);
+
+    return huffman->symbols[index];
+}
+
+/**
+ * @brief build codes of a block compressed with fixed Huffman codes
+ * 
+ * @param[in,out] inflater target inflater
+ */
+static void build_fixed(Inflater *inflater)
+{
+    uint8_t lengths[288];
+    memset(lengths, 8, 144);
+    memset((lengths + 144), 9, (256 - 144));
+    memset((lengths + 256), 7, (280 - 256));
+    memset((lengths + 280), 8, (288 - 280));
+    build_huffman(&inflater->literals, lengths, 288);
+
+    memset(lengths, 5, 30);
+    build_huffman(&inflater->distances, lengths, 30);
+}
+
+/**
+ * @brief read codes of a block compressed with dynamic Huffman codes
+ * 
+ * @param[in,out] inflater target inflater
+ * @return true if the codes are valid
+ */
+static bool read_dynamic(Inflater *inflater)
+{
+    const int n_literals  = get_bits(inflater, 5) + 257;
+    const int n_distances = get_bits(inflater, 5) + 1;
+    const int n_lengths   = get_bits(inflater, 4) + 4;
+    if ((n_literals > 286) || (n_distances > 30)) {
+        return false;
+    }
+
+    uint8_t lengths[286 + 30] = { 0 };
+    for (int i = 0; i < n_lengths; i++) {
+        lengths[CODE_LENGTH_ORDER[i]] = (uint8_t)get_bits(inflater, 3);
+    }
+
+    // code of lengths is kept in the table of distances until they are read
+    if (!build_huffman(&inflater->distances, lengths, 19)) {
+        return false;
+    }
+
+    const int n_codes = n_literals + n_distances;
+    memset(lengths, 0, sizeof(lengths));
+
+    int n = 0;
+    while (n < n_codes) {
+        const int symbol = decode(inflater, &inflater->distances);
+        if (symbol < 0) {
+            return false;
+        }
+        if (symbol < 16) {
+            lengths[n++] = (uint8_t)symbol;
+            continue;
+        }
+
+        // repeat the previous length or zeros
+        uint8_t length = 0;
+        int repeat;
+        if (symbol == 16) {
+            if (n == 0) {
+                return false;
+            }
+            length = lengths[n - 1];
+            repeat = 3 + get_bits(inflater, 2);
+        } else if (symbol == 17) {
+            repeat = 3 + get_bits(inflater, 3);
+        } else {
+            repeat = 11 + get_bits(inflater, 7);
+        }
+        if (repeat > (n_codes - n)) {
+            return false;
+        }
+        memset((lengths + n), length, repeat);
+        n += repeat;
+    }
+
+    // end of block must be coded
+    if (lengths[INFLATE_END_OF_BLOCK] == 0) {
+        return false;
+    }
+
+    return build_huffman(&inflater->literals, lengths, n_literals) &&
+           build_huffman(&inflater->distances, (lengths + n_literals), n_distances) &&
+           !overrun(inflater);
+}
+
+/**
+ * @brief read header of a gzip member, bit buffer must be empty
+ * 
+ * @param[in,out] inflater target inflater
+ * @return true if the header is valid
+ */
+static bool read_member(Inflater *inflater)
+{
+    const uint8_t *header = inflater->src + inflater->pos;
+    const size_t available = inflater->src_size - inflater->pos;
+
+    if ((available < GZIP_HEADER_SIZE) || !gzip_check(header, available) ||
+        (header[2] != GZIP_METHOD_DEFLATE) || ((header[3] & GZIP_FLAG_RESERVED) != 0)) {
+        return false;
+    }
+
+    const int flags = header[3];
+    size_t size = GZIP_HEADER_SIZE;
+
+    if ((flags & GZIP_FLAG_EXTRA) != 0) {
+        if ((size + 2) > available) {
+            return false;
+        }
+        size += 2 + (header[size] | (header[size + 1] << 8));
+    }
+    // zero-terminated file name and comment
+    if ((flags & GZIP_FLAG_NAME) != 0) {
+        while ((size < available) && (header[size] != 0)) {
+            size++;
+        }
+        size++;
+    }
+    if ((flags & GZIP_FLAG_COMMENT) != 0) {
+        while ((size < available) && (header[size] != 0)) {
+            size++;
+        }
+        size++;
+    }
+    if ((flags & GZIP_FLAG_HCRC) != 0) {
+        size += 2;
+    }
+    if (size > available) {
+        return false;
+    }
+
+    inflater->pos       += size;
+    inflater->last_block = false;
+    inflater->window_pos = 0;
+    inflater->crc        = 0xFFFFFFFF;
+
+    return true;
+}
+
+/**
+ * @brief read header of a DEFLATE block
+ * 
+ * @param[in,out] inflater target inflater
+ * @return true if the header is valid
+ */
+static bool read_block(Inflater *inflater)
+{
+    inflater->last_block = get_bits(inflater, 1);
+
+    switch (get_bits(inflater, 2)) {
+    case 0:
+        align_to_byte(inflater);
+        inflater->stored = get_bits(inflater, 16);
+        if ((inflater->stored ^ get_bits(inflater, 16)) != 0xFFFF) {
+            return false;
+        }
+        inflater->state = INFLATE_STATE_STORED;
+        break;
+    case 1:
+        build_fixed(inflater);
+        inflater->state = INFLATE_STATE_CODES;
+        break;
+    case 2:
+        if (!read_dynamic(inflater)) {
+            return false;
+        }
+        inflater->state = INFLATE_STATE_CODES;
+        break;
+    default:
+        return false;
+    }
+
+    return !overrun(inflater);
+}
+
+/**
+ * @brief output a decoded byte
+ * 
+ * @param[in,out] inflater target inflater
+ * @param[out] dest destination of decoded bytes
+ * @param[in,out] n num of bytes in dest
+ * @param[in] byte decoded byte
+ */
+static inline void put_byte(Inflater *inflater, uint8_t *dest, size_t *n, const uint8_t byte)
+{
+    inflater->window[inflater->window_pos & (INFLATE_WINDOW_SIZE - 1)] = byte;
+    inflater->window_pos++;
+    dest[(*n)++] = byte;
+}
+
+/**
+ * @brief decode codes of a Huffman block until dest is full or the block ends
+ * 
+ * @param[in,out] inflater target inflater
+ * @param[out] dest destination of decoded bytes
+ * @param[in] size num of bytes of dest
+ * @param[in,out] n num of bytes in dest
+ * @return true if codes are valid
+ */
+static bool read_codes(Inflater *inflater, uint8_t *dest, const size_t size, size_t *n)
+{
+    while (*n < size) {
+        // copy the current match first
+        if (inflater->length > 0) {
+            const uint8_t byte =
+                inflater->window[(inflater->window_pos - inflater->distance) & (INFLATE_WINDOW_SIZE - 1)];
+            put_byte(inflater, dest, n, byte);
+            inflater->length--;
+            continue;
+        }
+
+        int symbol = decode(inflater, &inflater->literals);
+        if (symbol < 0) {
+            return false;
+        }
+        if (symbol < INFLATE_END_OF_BLOCK) {
+            put_byte(inflater, dest, n, (uint8_t)symbol);
+            continue;
+        }
+        if (symbol == INFLATE_END_OF_BLOCK) {
+            inflater->state = INFLATE_STATE_BLOCK;
+            break;
+        }
+
+        symbol -= INFLATE_END_OF_BLOCK + 1;
+        if (symbol >= 29) {
+            return false;
+        }
+        inflater->length = LENGTH_BASE[symbol] + get_bits(inflater, LENGTH_EXTRA[symbol]);
+
+        symbol = decode(inflater, &inflater->distances);
+        if ((symbol < 0) || (symbol >= 30)) {
+            return false;
+        }
+        inflater->distance = DISTANCE_BASE[symbol] + get_bits(inflater, DISTANCE_EXTRA[symbol]);
+
+        // a match can not refer before the beginning of the member
+        if ((size_t)inflater->distance > inflater->window_pos) {
+            return false;
+        }
+    }
+
+    return !overrun(inflater);
+}
+
+/**
+ * @brief update CRC-32
+ * 
+ * @param[in,out] inflater target inflater
+ * @param[in] bytes bytes following the previous ones
+ * @param[in] size num of bytes
+ */
+static void update_crc(Inflater *inflater, const uint8_t *bytes, const size_t size)
+{
+    uint32_t crc = inflater->crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = inflater->crc_table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    inflater->crc = crc;
+}
+
+/**
+ * @brief read and verify trailer of a gzip member, and start the next member if exists
+ * 
+ * @param[in,out] inflater target inflater
+ * @return true if the trailer is valid
+ */
+static bool read_trailer(Inflater *inflater)
+{
+    align_to_byte(inflater);
+
+    const uint32_t crc  = get_bits(inflater, 32);
+    const uint32_t size = get_bits(inflater, 32);
+    if (overrun(inflater) || (crc != ~inflater->crc) || (size != (uint32_t)inflater->window_pos)) {
+        return false;
+    }
+
+    // return bytes left in bit buffer
+    inflater->pos      -= (inflater->n_bits - inflater->n_padding) / 8;
+    inflater->bits      = 0;
+    inflater->n_bits    = 0;
+    inflater->n_padding = 0;
+
+    // bytes following the last member are ignored
+    if (gzip_check((inflater->src + inflater->pos), (inflater->src_size - inflater->pos))) {
+        inflater->state = INFLATE_STATE_MEMBER;
+    } else {
+        inflater->state = INFLATE_STATE_DONE;
+    }
+
+    return true;
+}
+
+Inflater *inflater_create(const uint8_t *src, const size_t size)
+{
+    if (!gzip_check(src, size)) {
+        return NULL;
+    }
+
+    Inflater *inflater = malloc(sizeof(Inflater));
+    if (inflater == NULL) {
+        return NULL;
+    }
+
+    inflater->src        = src;
+    inflater->src_size   = size;
+    inflater->pos        = 0;
+    inflater->bits       = 0;
+    inflater->n_bits     = 0;
+    inflater->n_padding  = 0;
+    inflater->state      = INFLATE_STATE_MEMBER;
+    inflater->last_block = false;
+    inflater->stored     = 0;
+    inflater->length     = 0;
+    inflater->distance   = 0;
+    inflater->window_pos = 0;
+    inflater->crc        = 0xFFFFFFFF;
+
+    // reflected polynomial of CRC-32
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+        }
+        inflater->crc_table[i] = crc;
+    }
+
+    return inflater;
+}
+
+int inflater_read(Inflater *inflater, uint8_t *dest, const size_t size, size_t *n_read)
+{
+    if (n_read != NULL) {
+        *n_read = 0;
+    }
+    if ((inflater == NULL) || ((dest == NULL) && (size > 0)) || (n_read == NULL)) {
+        return -1;
+    }
+
+    size_t n = 0;
+    // bytes of dest included in CRC
+    size_t checked = 0;
+
+    // trailer after the last block is verified even if dest is full
+    while ((n < size) || (inflater->state == INFLATE_STATE_TRAILER) ||
+           ((inflater->state == INFLATE_STATE_BLOCK) && inflater->last_block)) {
+        bool valid = true;
+
+        switch (inflater->state) {
+        case INFLATE_STATE_MEMBER:
+            valid = read_member(inflater);
+            inflater->state = INFLATE_STATE_BLOCK;
+            break;
+        case INFLATE_STATE_BLOCK:
+            if (inflater->last_block) {
+                inflater->state = INFLATE_STATE_TRAILER;
+            } else {
+                valid = read_block(inflater);
+            }
+            break;
+        case INFLATE_STATE_STORED:
+            while ((inflater->stored > 0) && (n < size)) {
+                put_byte(inflater, dest, &n, (uint8_t)get_bits(inflater, 8));
+                inflater->stored--;
+            }
+            valid = !overrun(inflater);
+            if (inflater->stored == 0) {
+                inflater->state = INFLATE_STATE_BLOCK;
+            }
+            break;
+        case INFLATE_STATE_CODES:
+            valid = read_codes(inflater, dest, size, &n);
+            break;
+        case INFLATE_STATE_TRAILER:
+            if (n > checked) {
+                update_crc(inflater, (dest + checked), (n - checked));
+                checked = n;
+            }
+            valid = read_trailer(inflater);
+            break;
+        default:
+            break;
+        }
+
+        if (!valid) {
+            inflater->state = INFLATE_STATE_ERROR;
+        }
+        if ((inflater->state == INFLATE_STATE_DONE) || (inflater->state == INFLATE_STATE_ERROR)) {
+            break;
+        }
+    }
+
+    if (inflater->state == INFLATE_STATE_ERROR) {
+        return -1;
+    }
+
+    if (n > checked) {
+        update_crc(inflater, (dest + checked), (n - checked));
+    }
+    *n_read = n;
+
+    return 0;
+}
+
+void inflater_free(Inflater **inflater)
+{
+    FREE_WITH_NULL(inflater);
+}
@@ -7,9 +7,11 @@
 #include "layer.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #include "data.h"
+#include "layers.h"
 #include "random.h"
 #include "util.h"
 #include "mat.h"
@@ -68,7 +70,11 @@ Layer *layer_alloc(void)
     // initialize basic members
     layer->id = -1;
 
+    layer->type  = LAYER_TYPE_NONE;
+    layer->param = (LayerParameter){ 0 };
+
     layer->x = NULL;
+    layer->sx = NULL;
     layer->x_size = 0;
 
     layer->y = NULL;
@@ -90,9 +96,33 @@ Layer *layer_alloc(void)
     layer->dx = NULL;
     layer->dw = NULL;
     layer->db = NULL;
+    layer->dz = NULL;
+
+    layer->accumulate = false;
+    layer->rows = (LayerRows){ .ids = NULL, .marked = NULL, .size = 0, .sparse = false };
+
+    layer->shared_params = false;
+
+    layer->n_in = 1;
+    for (int i = 0; i < LAYER_IN_MAX; i++) {
+        layer->in_ids[i]   = -1;
+        layer->in_ports[i] = 0;
+        layer->xs[i]       = NULL;
+        layer->xs_size[i]  = 0;
+        layer->dxs[i]      = NULL;
+    }
 
-    layer->prev_id = -1;
-    layer->next_id = -1;
+    layer->n_ys = 1;
+    layer->n_out = 0;
+    for (int i = 0; i < LAYER_OUT_MAX; i++) {
+        layer->ys_offset[i] = 0;
+        layer->ys_size[i]   = 0;
+        layer->out_ids[i]   = -1;
+    }
+    layer->dy = NULL;
+
+    profile_stat_reset(&layer->profile.forward);
+    profile_stat_reset(&layer->profile.backward);
 
     layer->forward = NULL;
     layer->backward = NULL;
@@ -104,16 +134,260 @@ Layer *layer_alloc(void)
     return layer;
 }
 
+Layer *layer_create(const LayerType type, const LayerParameter layer_param)
+{
+    switch (type) {
+    case LAYER_TYPE_FC:
+        return fc_layer(layer_param);
+    case LAYER_TYPE_SIGMOID:
+        return sigmoid_layer(layer_param);
+    case LAYER_TYPE_SOFTMAX:
+        return softmax_layer(layer_param);
+    case LAYER_TYPE_RELU:
+        return relu_layer(layer_param);
+    case LAYER_TYPE_ADD:
+        return add_layer(layer_param);
+    case LAYER_TYPE_CONCAT:
+        return concat_layer(layer_param);
+    case LAYER_TYPE_SPLIT:
+        return split_layer(layer_param);
+    case LAYER_TYPE_FC_SIGMOID:
+        return fc_sigmoid_layer(layer_param);
+    case LAYER_TYPE_FC_RELU:
+        return fc_relu_layer(layer_param);
+    case LAYER_TYPE_FC_SOFTMAX:
+        return fc_softmax_layer(layer_param);
+    case LAYER_TYPE_SIGMOID_SOFTMAX:
+        return sigmoid_softmax_layer(layer_param);
+    default:
+        return NULL;
+    }
+}
+
+const char *layer_type_name(const LayerType type)
+{
+    switch (type) {
+    case LAYER_TYPE_FC:
+        return "fc";
+    case LAYER_TYPE_SIGMOID:
+        return "sigmoid";
+    case LAYER_TYPE_SOFTMAX:
+        return "softmax";
+    case LAYER_TYPE_RELU:
+        return "relu";
+    case LAYER_TYPE_ADD:
+        return "add";
+    case LAYER_TYPE_CONCAT:
+        return "concat";
+    case LAYER_TYPE_SPLIT:
+        return "split";
+    case LAYER_TYPE_FC_SIGMOID:
+        return "fc_sigmoid";
+    case LAYER_TYPE_FC_RELU:
+        return "fc_relu";
+    case LAYER_TYPE_FC_SOFTMAX:
+        return "fc_softmax";
+    case LAYER_TYPE_SIGMOID_SOFTMAX:
+        return "sigmoid_softmax";
+    default:
+        return "none";
+    }
+}
+
+void layer_cost(const Layer *layer, const bool backward, double *flops, double *bytes)
+{
+    // total num of elements of inputs and output
+    double n_x = 0;
+    for (int k = 0; k < layer->n_in; k++) {
+        n_x += layer->xs_size[k];
+    }
+    const double n_y = layer->y_size;
+
+    // cost of matrix-vector products and bias of FC
+    const double n_w      = n_x * n_y;
+    const double fc_flops = backward ? (4 * n_w) : (2 * n_w + n_y);
+    const double fc_elems = backward ? (2 * n_w + 2 * n_x + 2 * n_y) : (n_w + n_x + 2 * n_y);
+
+    double f = 0;
+    double e = 0;
+
+    switch (layer->type) {
+    case LAYER_TYPE_FC:
+        f = fc_flops;
+        e = fc_elems;
+        break;
+    case LAYER_TYPE_FC_SIGMOID:
+        // exp, add, div / sub, mul, mul
+        f = fc_flops + 3 * n_y;
+        e = fc_elems + (backward ? n_y : 0);
+        break;
+    case LAYER_TYPE_FC_RELU:
+        f = fc_flops + n_y;
+        e = fc_elems + (backward ? n_y : 0);
+        break;
+    case LAYER_TYPE_FC_SOFTMAX:
+        // max, sub, exp, sum, div / diff is passed through
+        f = fc_flops + (backward ? 0 : 5) * n_y;
+        e = fc_elems;
+        break;
+    case LAYER_TYPE_SIGMOID:
+        f = 3 * n_y;
+        e = (backward ? 3 : 2) * n_y;
+        break;
+    case LAYER_TYPE_RELU:
+        f = n_y;
+        e = (backward ? 3 : 2) * n_y;
+        break;
+    case LAYER_TYPE_SOFTMAX:
+        f = backward ? 0 : (5 * n_y);
+        e = 2 * n_y;
+        break;
+    case LAYER_TYPE_SIGMOID_SOFTMAX:
+        f = backward ? (3 * n_y) : (8 * n_y);
+        e = 3 * n_y;
+        break;
+    case LAYER_TYPE_ADD:
+        f = backward ? 0 : (n_x - n_y);
+        e = backward ? (2 * n_y) : (n_x + n_y);
+        break;
+    case LAYER_TYPE_CONCAT:
+    case LAYER_TYPE_SPLIT:
+        f = 0;
+        e = n_x + n_y;
+        break;
+    default:
+        break;
+    }
+
+    *flops = f;
+    *bytes = e * sizeof(float);
+}
+
+/**
+ * @brief forget rows of dw written by sparse input
+ * 
+ * @param[in,out] layer target layer
+ */
+static void unmark_rows(Layer *layer)
+{
+    for (int i = 0; i < layer->rows.size; i++) {
+        layer->rows.marked[layer->rows.ids[i]] = false;
+    }
+    layer->rows.size = 0;
+}
+
+/**
+ * @brief clear dw, only the rows written by sparse input if they are tracked
+ * 
+ * @param[in,out] layer target layer
+ */
+static void zero_dw(Layer *layer)
+{
+    if (layer->rows.sparse) {
+        const int width = layer->w_size / layer->x_size;
+        for (int i = 0; i < layer->rows.size; i++) {
+            memset((layer->dw + (size_t)layer->rows.ids[i] * width), 0, (sizeof(float) * width));
+        }
+    } else {
+        memset(layer->dw, 0, (sizeof(float) * layer->w_size));
+    }
+
+    // dw is zero, rows written next are tracked if they can be
+    unmark_rows(layer);
+    layer->rows.sparse = (layer->rows.ids != NULL);
+}
+
+int layer_alloc_rows(Layer *layer)
+{
+    if (layer->rows.ids != NULL) {
+        return 0;
+    }
+
+    layer->rows.ids    = malloc(sizeof(int) * layer->x_size);
+    layer->rows.marked = calloc(layer->x_size, sizeof(bool));
+    if ((layer->rows.ids == NULL) || (layer->rows.marked == NULL)) {
+        FREE_WITH_NULL(&layer->rows.ids);
+        FREE_WITH_NULL(&layer->rows.marked);
+        return -1;
+    }
+
+    // rows are tracked from the next clear of dw
+    layer->rows.size   = 0;
+    layer->rows.sparse = false;
+
+    return 0;
+}
+
+void layer_sparse_grad(Layer *layer, const float *dy)
+{
+    const int width = layer->w_size / layer->x_size;
+
+    if (!layer->accumulate) {
+        zero_dw(layer);
+    }
+
+    sparse_mat_mul_trans_a_acc(layer->sx, dy, layer->dw, width);
+
+    if (layer->rows.sparse) {
+        const SparseMatrix *x = layer->sx;
+        for (int k = x->row_ptr[0]; k < x->row_ptr[x->n_rows]; k++) {
+            const int row = x->col_idx[k];
+            if (!layer->rows.marked[row]) {
+                layer->rows.marked[row] = true;
+                layer->rows.ids[layer->rows.size++] = row;
+            }
+        }
+    }
+}
+
+void layer_zero_grad(Layer *layer)
+{
+    if (layer->dw != NULL) {
+        zero_dw(layer);
+    }
+
+    if (layer->db != NULL) {
+        memset(layer->db, 0, (sizeof(float) * layer->b_size));
+    }
+}
+
+void layer_scale_grad(Layer *layer, const float k)
+{
+    if (layer->dw != NULL) {
+        if (layer->rows.sparse) {
+            const int width = layer->w_size / layer->x_size;
+            for (int i = 0; i < layer->rows.size; i++) {
+                float *row = layer->dw + (size_t)layer->rows.ids[i] * width;
+                mat_mul_scalar(row, row, 1, width, k);
+            }
+        } else {
+            mat_mul_scalar(layer->dw, layer->dw, 1, layer->w_size, k);
+        }
+    }
+
+    if (layer->db != NULL) {
+        mat_mul_scalar(layer->db, layer->db, 1, layer->b_size, k);
+    }
+}
+
 void layer_free(Layer **layer)
 {
     FREE_WITH_NULL(&(*layer)->y);
 
-    FREE_WITH_NULL(&(*layer)->w);
-    FREE_WITH_NULL(&(*layer)->b);
+    if (!(*layer)->shared_params) {
+        FREE_WITH_NULL(&(*layer)->w);
+        FREE_WITH_NULL(&(*layer)->b);
+    }
 
     FREE_WITH_NULL(&(*layer)->dx);
     FREE_WITH_NULL(&(*layer)->dw);
     FREE_WITH_NULL(&(*layer)->db);
+    FREE_WITH_NULL(&(*layer)->dz);
+
+    FREE_WITH_NULL(&(*layer)->dy);
+
+    FREE_WITH_NULL(&(*layer)->rows.ids);
+    FREE_WITH_NULL(&(*layer)->rows.marked);
 
     FREE_WITH_NULL(layer);
 }
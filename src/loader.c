@@ -0,0 +1,317 @@
+/**
+ * @file loader.c
+ * @brief background loader gathering shuffled batches into staging buffers
+ * 
+ */
+#include "loader.h"
+
+#include <stdlib.h>
+
+#include "data.h"
+#include "trace.h"
+#include "util.h"
+
+/**
+ * @brief gather samples of a batch into its staging buffers
+ * 
+ * @param[in] loader target loader
+ * @param[in] index index of batch in epoch
+ */
+static void gather(const Loader *loader, const int index)
+{
+    LoaderBatch *batch = &loader->batches[index % (loader->depth + 1)];
+
+    const int begin = index * loader->batch_size;
+    const int rest  = loader->data_size - begin;
+
+    batch->size  = (rest < loader->batch_size) ? rest : loader->batch_size;
+    batch->index = index;
+
+    if (loader->stream != NULL) {
+        batch->size = stream_read(
+            loader->stream, batch->size, batch->x,
+            (loader->class_labels ? NULL : batch->t), (loader->class_labels ? batch->labels : NULL)
+        );
+    } else if (loader->class_labels) {
+        dataset_gather(loader->dataset, (loader->indices + begin), batch->size, batch->x, NULL);
+        dataset_gather_labels(loader->dataset, (loader->indices + begin), batch->size, batch->labels);
+    } else {
+        dataset_gather(loader->dataset, (loader->indices + begin), batch->size, batch->x, batch->t);
+    }
+
+    if (loader->augmenter != NULL) {
+        TRACE_BEGIN(augment_start);
+        augment_batch(loader->augmenter, batch->x, batch->size, loader->epoch, begin);
+        TRACE_END(TRACE_CATEGORY_DATA, "augment", index, augment_start);
+    }
+}
+
+/**
+ * @brief main loop of loader thread
+ * 
+ * @param[in,out] arg loader
+ * @return void* always NULL
+ */
+static void *worker(void *arg)
+{
+    Loader *loader = (Loader*)arg;
+
+    pthread_mutex_lock(&loader->lock);
+
+    while (true) {
+        // gather up to depth batches ahead of the batch in use
+        while (!loader->stop &&
+               ((loader->produced >= loader->n_batches) ||
+                ((loader->produced - loader->consumed) >= loader->depth))) {
+            pthread_cond_wait(&loader->cond, &loader->lock);
+        }
+        if (loader->stop) {
+            break;
+        }
+
+        int index = loader->produced;
+        loader->busy = true;
+
+        pthread_mutex_unlock(&loader->lock);
+
+        TRACE_BEGIN(gather_start);
+        gather(loader, index);
+        TRACE_END(TRACE_CATEGORY_DATA, "gather", index, gather_start);
+
+        pthread_mutex_lock(&loader->lock);
+
+        loader->busy = false;
+        loader->produced++;
+        pthread_cond_broadcast(&loader->cond);
+    }
+
+    pthread_mutex_unlock(&loader->lock);
+
+    return NULL;
+}
+
+/**
+ * @brief create loader of a source and start its thread
+ * 
+ * @param[in] dataset source dataset, NULL if stream is given
+ * @param[in,out] stream source stream, NULL if dataset is given
+ * @param[in] data_size num of data
+ * @param[in] x_size num of elements of a data
+ * @param[in] t_size num of elements of a label
+ * @param[in] batch_size num of samples of a batch
+ * @param[in] depth num of batches gathered ahead of the batch in use
+ * @param[in] class_labels gather class indices of labels instead of one-hot vectors
+ * @return Loader* pointer to loader
+ */
+static Loader *create(
+    const Dataset *dataset,
+    Stream *stream,
+    const int data_size,
+    const int x_size,
+    const int t_size,
+    const int batch_size,
+    const int depth,
+    const bool class_labels)
+{
+    if ((data_size < 1) || (x_size < 1) || (t_size < 1) || (batch_size < 1) || (depth < 1)) {
+        return NULL;
+    }
+
+    Loader *loader = malloc(sizeof(Loader));
+    if (loader == NULL) {
+        return NULL;
+    }
+
+    loader->dataset    = dataset;
+    loader->stream     = stream;
+    loader->data_size  = data_size;
+    loader->x_size     = x_size;
+    loader->t_size     = t_size;
+    loader->batch_size = batch_size;
+    loader->depth      = depth;
+
+    loader->class_labels = class_labels;
+    loader->augmenter    = NULL;
+
+    loader->indices   = NULL;
+    loader->n_batches = 0;
+    loader->epoch     = -1;
+    loader->produced  = 0;
+    loader->consumed  = 0;
+    loader->busy      = false;
+    loader->stop      = false;
+
+    loader->batches = malloc(sizeof(LoaderBatch) * (depth + 1));
+    if (loader->batches == NULL) {
+        FREE_WITH_NULL(&loader);
+        return NULL;
+    }
+    for (int i = 0; i < (depth + 1); i++) {
+        loader->batches[i] = (LoaderBatch){
+            .x      = fdata_alloc_aligned(batch_size * x_size),
+            .t      = class_labels ? NULL : fdata_alloc_aligned(batch_size * t_size),
+            .labels = class_labels ? malloc(sizeof(int) * batch_size) : NULL,
+            .size   = 0,
+            .index  = -1
+        };
+    }
+
+    pthread_mutex_init(&loader->lock, NULL);
+    pthread_cond_init(&loader->cond, NULL);
+
+    for (int i = 0; i < (depth + 1); i++) {
+        if ((loader->batches[i].x == NULL) ||
+            ((loader->batches[i].t == NULL) && (loader->batches[i].labels == NULL))) {
+            goto LOADER_FREE;
+        }
+    }
+
+    if (pthread_create(&loader->thread, NULL, worker, loader) != 0) {
+        goto LOADER_FREE;
+    }
+
+    return loader;
+
+LOADER_FREE:
+    for (int i = 0; i < (depth + 1); i++) {
+        FREE_WITH_NULL(&loader->batches[i].x);
+        FREE_WITH_NULL(&loader->batches[i].t);
+        FREE_WITH_NULL(&loader->batches[i].labels);
+    }
+    FREE_WITH_NULL(&loader->batches);
+
+    pthread_mutex_destroy(&loader->lock);
+    pthread_cond_destroy(&loader->cond);
+
+    FREE_WITH_NULL(&loader);
+
+    return NULL;
+}
+
+Loader *loader_create(const Dataset *dataset, const int batch_size, const int depth, const bool class_labels)
+{
+    if ((dataset == NULL) || (class_labels && !dataset_has_class_labels(dataset)) ||
+        !dataset_check_labels(dataset)) {
+        return NULL;
+    }
+
+    return create(
+        dataset, NULL, dataset->size, dataset->x_size, dataset->t_size, batch_size, depth, class_labels
+    );
+}
+
+Loader *loader_create_stream(Stream *stream, const int batch_size, const int depth, const bool class_labels)
+{
+    if (stream == NULL) {
+        return NULL;
+    }
+
+    return create(
+        NULL, stream, stream->size, stream->x_size, stream->n_classes, batch_size, depth, class_labels
+    );
+}
+
+void loader_set_augmenter(Loader *loader, Augmenter *augmenter)
+{
+    if ((loader == NULL) || ((augmenter != NULL) && (augmenter->x_size != loader->x_size))) {
+        return;
+    }
+
+    pthread_mutex_lock(&loader->lock);
+
+    // wait for a batch being gathered with the previous augmenter
+    while (loader->busy) {
+        pthread_cond_wait(&loader->cond, &loader->lock);
+    }
+    loader->augmenter = augmenter;
+
+    pthread_mutex_unlock(&loader->lock);
+}
+
+void loader_start(Loader *loader, const int *indices)
+{
+    if ((loader == NULL) || ((indices == NULL) && (loader->stream == NULL))) {
+        return;
+    }
+
+    pthread_mutex_lock(&loader->lock);
+
+    // wait for a batch of the previous epoch being gathered
+    while (loader->busy) {
+        pthread_cond_wait(&loader->cond, &loader->lock);
+    }
+
+    // the loader thread does not touch the stream while it is idle
+    if (loader->stream != NULL) {
+        stream_rewind(loader->stream);
+    }
+
+    loader->indices   = indices;
+    loader->epoch++;
+    loader->n_batches = (loader->data_size + loader->batch_size - 1) / loader->batch_size;
+    loader->produced  = 0;
+    loader->consumed  = 0;
+
+    pthread_cond_broadcast(&loader->cond);
+
+    pthread_mutex_unlock(&loader->lock);
+}
+
+const LoaderBatch *loader_next(Loader *loader)
+{
+    if (loader == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&loader->lock);
+
+    if (loader->consumed >= loader->n_batches) {
+        pthread_mutex_unlock(&loader->lock);
+        return NULL;
+    }
+
+    if (loader->produced <= loader->consumed) {
+        // stalled by loading
+        TRACE_BEGIN(wait_start);
+        while (loader->produced <= loader->consumed) {
+            pthread_cond_wait(&loader->cond, &loader->lock);
+        }
+        TRACE_END(TRACE_CATEGORY_DATA, "wait", loader->consumed, wait_start);
+    }
+
+    const LoaderBatch *batch = &loader->batches[loader->consumed % (loader->depth + 1)];
+
+    // the previous batch is released, and the loader can gather into its buffer
+    loader->consumed++;
+    pthread_cond_broadcast(&loader->cond);
+
+    pthread_mutex_unlock(&loader->lock);
+
+    return batch;
+}
+
+void loader_free(Loader **loader)
+{
+    if (*loader == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&(*loader)->lock);
+    (*loader)->stop = true;
+    pthread_cond_broadcast(&(*loader)->cond);
+    pthread_mutex_unlock(&(*loader)->lock);
+
+    pthread_join((*loader)->thread, NULL);
+
+    pthread_mutex_destroy(&(*loader)->lock);
+    pthread_cond_destroy(&(*loader)->cond);
+
+    for (int i = 0; i < ((*loader)->depth + 1); i++) {
+        FREE_WITH_NULL(&(*loader)->batches[i].x);
+        FREE_WITH_NULL(&(*loader)->batches[i].t);
+        FREE_WITH_NULL(&(*loader)->batches[i].labels);
+    }
+    FREE_WITH_NULL(&(*loader)->batches);
+
+    FREE_WITH_NULL(loader);
+}
@@ -6,6 +6,7 @@
 #include "loss.h"
 
 #include <math.h>
+#include <stddef.h>
 
 float mean_squared_loss(const float *y, const float *t, const int size)
 {
@@ -31,3 +32,40 @@ float cross_entropy_loss(const float *y, const float *t, const int size)
 
     return -err;
 }
+
+float mean_squared_loss_label(const float *y, const int label, const int size)
+{
+    float sq_err = 0;
+
+    for (int i = 0; i < size; i++) {
+        float t = (i == label) ? 1.0f : 0.0f;
+        sq_err += (t - y[i]) * (t - y[i]);
+    }
+
+    return 0.5 * sq_err;
+}
+
+float cross_entropy_loss_label(const float *y, const int label, const int size)
+{
+    // small value to avoid log(0)
+    const float epsilon = 1e-7;
+
+    if ((label < 0) || (label >= size)) {
+        return 0;
+    }
+
+    // terms of other classes are zero
+    return -log(y[label] + epsilon);
+}
+
+LabelLossFunc loss_label_func(const LossFunc loss_func)
+{
+    if (loss_func == mean_squared_loss) {
+        return mean_squared_loss_label;
+    }
+    if (loss_func == cross_entropy_loss) {
+        return cross_entropy_loss_label;
+    }
+
+    return NULL;
+}
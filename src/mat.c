@@ -89,6 +89,29 @@ float *mat_mul_trans_a(const float *a, const float *b, float *c, const int m, co
     return c;
 }
 
+float *mat_mul_trans_a_acc(const float *a, const float *b, float *c, const int m, const int n, const int p)
+{
+    if ((a == NULL) || (b == NULL) | (c == NULL)) {
+        return NULL;
+    }
+
+    if ((m < 1) || (n < 1) || (p < 1)) {
+        return NULL;
+    }
+
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < p; j++) {
+            float y = c[i * p + j];
+            for (int k = 0; k < m; k++) {
+                y += a[k * n + i] * b[k * p + j];
+            }
+            c[i * p + j] = y;
+        }
+    }
+
+    return c;
+}
+
 float *mat_mul_trans_b(const float *a, const float *b, float *c, const int m, const int n, const int p)
 {
     if ((a == NULL) || (b == NULL) | (c == NULL)) {
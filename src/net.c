@@ -3,14 +3,32 @@
  * @brief network structure
  * 
  */
+#define _POSIX_C_SOURCE 200809L
+
 #include "net.h"
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <sys/mman.h>
 
 #include "data.h"
+#include "layers.h"
 #include "util.h"
 #include "mat.h"
+#include "trace.h"
+
+// initial capacity of layer list
+#define NET_INIT_CAPACITY 8
+
+/**
+ * @brief argument of a layer task run on thread pool
+ * 
+ */
+typedef struct NetTask {
+    Net   *net;         //!< network
+    Layer *layer;       //!< target layer
+    const float *dy;    //!< diff of layer output, given only to the output layer
+} NetTask;
 
 Net *net_alloc(void)
 {
@@ -20,21 +38,29 @@ Net *net_alloc(void)
     }
 
     // initialize member
-    net->size = 0;
-
-    for (int i = 0; i < NET_LAYER_MAX_SIZE; i++) {
-        net->layers[i] = NULL;
-    }
+    net->size     = 0;
+    net->capacity = 0;
+    net->layers   = NULL;
 
     net->input_layer  = NULL;
     net->output_layer = NULL;
 
+    net->order       = NULL;
+    net->level_start = NULL;
+    net->n_levels    = 0;
+    net->tasks       = NULL;
+
+    net->pool = NULL;
+
+    net->map      = NULL;
+    net->map_size = 0;
+
     return net;
 }
 
 Net *net_create(const int size, Layer *layers[])
 {
-    if ((size < 1) || (size > NET_LAYER_MAX_SIZE) || (layers == NULL)) {
+    if ((size < 1) || (layers == NULL)) {
         return NULL;
     }
 
@@ -59,30 +85,237 @@ NET_FREE:
     return NULL;
 }
 
+/**
+ * @brief discard execution order of network
+ * 
+ * @param[in,out] net target network
+ */
+static void unschedule(Net *net)
+{
+    FREE_WITH_NULL(&net->order);
+    FREE_WITH_NULL(&net->level_start);
+    FREE_WITH_NULL(&net->tasks);
+    net->n_levels = 0;
+}
+
+/**
+ * @brief find input of the consumer whose diff is the diff of layer output
+ * @note the diff is used directly if the layer has a single consumer
+ *       which takes the whole output as one of its inputs
+ * 
+ * @param[in] net target network
+ * @param[in] layer target layer
+ * @return int index of input of the consumer, -1 if diffs are gathered into dy of the layer
+ */
+static int direct_slot(const Net *net, const Layer *layer)
+{
+    if ((layer->n_out != 1) || (layer->n_ys != 1)) {
+        return -1;
+    }
+
+    const Layer *out_layer = net->layers[layer->out_ids[0]];
+    int slot  = -1;
+    int count = 0;
+    for (int i = 0; i < out_layer->n_in; i++) {
+        if (out_layer->in_ids[i] == layer->id) {
+            slot = i;
+            count++;
+        }
+    }
+
+    return (count == 1) ? slot : -1;
+}
+
+/**
+ * @brief compute execution order of network, grouped by topological level
+ * @note layers in the same level have no dependency on each other
+ * 
+ * @param[in,out] net target network
+ * @return true if succeeded
+ */
+static bool schedule(Net *net)
+{
+    int *level  = malloc(sizeof(int) * net->size);
+    net->order  = malloc(sizeof(int) * net->size);
+    net->tasks  = malloc(sizeof(NetTask) * net->size);
+    if ((level == NULL) || (net->order == NULL) || (net->tasks == NULL)) {
+        goto SCHEDULE_FAILED;
+    }
+
+    // IDs are already topologically sorted since inputs precede a layer,
+    // the level of a layer is the longest path from the network input
+    net->n_levels = 0;
+    for (int i = 0; i < net->size; i++) {
+        Layer *layer = net->layers[i];
+        level[i] = 0;
+        for (int j = 0; j < layer->n_in; j++) {
+            int in_id = layer->in_ids[j];
+            if ((in_id >= 0) && (level[in_id] + 1 > level[i])) {
+                level[i] = level[in_id] + 1;
+            }
+        }
+        if (level[i] + 1 > net->n_levels) {
+            net->n_levels = level[i] + 1;
+        }
+
+        net->tasks[i] = (NetTask){ .net = net, .layer = layer, .dy = NULL };
+
+        // layers whose diff is not an input diff of a consumer gather diffs into their own buffer
+        if ((layer != net->output_layer) && (direct_slot(net, layer) < 0) && (layer->dy == NULL)) {
+            layer->dy = fdata_alloc(layer->y_size);
+            if (layer->dy == NULL) {
+                goto SCHEDULE_FAILED;
+            }
+        }
+    }
+
+    // counting sort by level, stable in IDs
+    net->level_start = malloc(sizeof(int) * (net->n_levels + 1));
+    if (net->level_start == NULL) {
+        goto SCHEDULE_FAILED;
+    }
+    for (int i = 0; i <= net->n_levels; i++) {
+        net->level_start[i] = 0;
+    }
+    for (int i = 0; i < net->size; i++) {
+        net->level_start[level[i] + 1]++;
+    }
+    for (int i = 0; i < net->n_levels; i++) {
+        net->level_start[i + 1] += net->level_start[i];
+    }
+    for (int l = 0, n = 0; l < net->n_levels; l++) {
+        for (int i = 0; i < net->size; i++) {
+            if (level[i] == l) {
+                net->order[n++] = i;
+            }
+        }
+    }
+
+    FREE_WITH_NULL(&level);
+
+    return true;
+
+SCHEDULE_FAILED:
+    FREE_WITH_NULL(&level);
+    unschedule(net);
+
+    return false;
+}
+
+/**
+ * @brief make room for one more layer
+ * 
+ * @param[in,out] net target network
+ * @return true if succeeded
+ */
+static bool reserve(Net *net)
+{
+    if (net->size < net->capacity) {
+        return true;
+    }
+
+    int capacity = (net->capacity == 0) ? NET_INIT_CAPACITY : (net->capacity * 2);
+
+    Layer **layers = realloc(net->layers, sizeof(Layer*) * capacity);
+    if (layers == NULL) {
+        return false;
+    }
+
+    for (int i = net->capacity; i < capacity; i++) {
+        layers[i] = NULL;
+    }
+
+    net->layers   = layers;
+    net->capacity = capacity;
+
+    return true;
+}
+
 Net *net_append(Net *net, Layer *layer)
 {
     if ((net == NULL) || (layer == NULL)) {
         return NULL;
     }
 
+    // first layer takes the network input
+    int in_id = (net->output_layer == NULL) ? -1 : net->output_layer->id;
+
+    return net_connect(net, layer, 1, (int[]){ in_id }, NULL);
+}
+
+Net *net_connect(Net *net, Layer *layer, const int n_in, const int in_ids[], const int in_ports[])
+{
+    if ((net == NULL) || (layer == NULL) || (in_ids == NULL)) {
+        return NULL;
+    }
+
+    if (n_in != layer->n_in) {
+        return NULL;
+    }
+
+    // validate connections before modifying any of layers
+    for (int i = 0; i < n_in; i++) {
+        int in_id   = in_ids[i];
+        int in_port = (in_ports == NULL) ? 0 : in_ports[i];
+        if ((in_id < -1) || (in_id >= net->size)) {
+            return NULL;
+        }
+        if (in_id < 0) {
+            continue;
+        }
+
+        Layer *in_layer = net->layers[in_id];
+        if ((in_port < 0) || (in_port >= in_layer->n_ys)) {
+            return NULL;
+        }
+        if (in_layer->ys_size[in_port] != layer->xs_size[i]) {
+            return NULL;
+        }
+        // count connections to the same layer once
+        bool connected = false;
+        for (int j = 0; j < i; j++) {
+            connected |= (in_ids[j] == in_id);
+        }
+        if (!connected && (in_layer->n_out >= LAYER_OUT_MAX)) {
+            return NULL;
+        }
+    }
+
+    if (!reserve(net)) {
+        return NULL;
+    }
+
     int id = net->size;
 
-    layer->id      = id;
-    layer->next_id = -1;
+    layer->id = id;
 
-    // append layer to tail of the network layers
-    if (id == 0) {
-        // first layer
-        layer->x       = NULL;
-        layer->prev_id = -1;
-    } else {
-        Layer *prev_layer = net->layers[id - 1];
+    for (int i = 0; i < n_in; i++) {
+        int in_id   = in_ids[i];
+        int in_port = (in_ports == NULL) ? 0 : in_ports[i];
 
-        layer->x       = prev_layer->y;
-        layer->prev_id = prev_layer->id;
+        layer->in_ids[i]   = in_id;
+        layer->in_ports[i] = in_port;
 
-        prev_layer->next_id = id;
+        if (in_id < 0) {
+            // bound at forward propagation
+            layer->xs[i] = NULL;
+            continue;
+        }
+
+        Layer *in_layer = net->layers[in_id];
+        layer->xs[i] = in_layer->y + in_layer->ys_offset[in_port];
+
+        bool connected = false;
+        for (int j = 0; j < in_layer->n_out; j++) {
+            connected |= (in_layer->out_ids[j] == id);
+        }
+        if (!connected) {
+            in_layer->out_ids[in_layer->n_out] = id;
+            in_layer->n_out++;
+        }
     }
+    layer->x = layer->xs[0];
+
     net->layers[id] = layer;
 
     net->input_layer  = net->layers[0];
@@ -90,9 +323,194 @@ Net *net_append(Net *net, Layer *layer)
 
     net->size++;
 
+    unschedule(net);
+
     return net;
 }
 
+void net_set_thread_pool(Net *net, ThreadPool *pool)
+{
+    net->pool = pool;
+}
+
+/**
+ * @brief allocate fused layer of two successive layers
+ * 
+ * @param[in] first first layer
+ * @param[in] second second layer which takes the output of first layer
+ * @return Layer* fused layer, NULL if not fusable
+ */
+static Layer *fuse(const Layer *first, const Layer *second)
+{
+    if (first->type == LAYER_TYPE_FC) {
+        switch (second->type) {
+        case LAYER_TYPE_SIGMOID:
+            return fc_sigmoid_layer(first->param);
+        case LAYER_TYPE_RELU:
+            return fc_relu_layer(first->param);
+        case LAYER_TYPE_SOFTMAX:
+            return fc_softmax_layer(first->param);
+        default:
+            return NULL;
+        }
+    }
+
+    if ((first->type == LAYER_TYPE_SIGMOID) && (second->type == LAYER_TYPE_SOFTMAX)) {
+        return sigmoid_softmax_layer(first->param);
+    }
+
+    return NULL;
+}
+
+int net_optimize(Net *net)
+{
+    if (net == NULL) {
+        return -1;
+    }
+
+    // new ID of each layer, a fused pair is mapped to the same ID
+    int *new_ids = malloc(sizeof(int) * net->size);
+    if (new_ids == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < net->size; i++) {
+        new_ids[i] = i;
+    }
+
+    // find pairs from the output side
+    int n_fused = 0;
+    for (int id = net->size - 1; id > 0; id--) {
+        Layer *second = net->layers[id];
+        if ((second == NULL) || (second->n_in != 1) || (second->in_ids[0] < 0)) {
+            continue;
+        }
+
+        Layer *first = net->layers[second->in_ids[0]];
+        if ((first->n_out != 1) || (first->n_ys != 1)) {
+            continue;
+        }
+
+        Layer *fused = fuse(first, second);
+        if (fused == NULL) {
+            continue;
+        }
+
+        fdata_copy(first->w, first->w_size, fused->w);
+        fdata_copy(first->b, first->b_size, fused->b);
+
+        // fused layer takes inputs of the first and consumers of the second
+        fused->id = id;
+        for (int i = 0; i < first->n_in; i++) {
+            fused->in_ids[i]   = first->in_ids[i];
+            fused->in_ports[i] = first->in_ports[i];
+        }
+
+        new_ids[first->id] = -1;
+        layer_free(&net->layers[first->id]);
+        layer_free(&net->layers[id]);
+        net->layers[id] = fused;
+
+        n_fused++;
+    }
+
+    // compact the layer list and renumber IDs
+    int size = 0;
+    for (int i = 0; i < net->size; i++) {
+        if (net->layers[i] == NULL) {
+            continue;
+        }
+        new_ids[i] = size;
+        net->layers[size] = net->layers[i];
+        net->layers[size]->id = size;
+        size++;
+    }
+    for (int i = size; i < net->size; i++) {
+        net->layers[i] = NULL;
+    }
+    net->size = size;
+
+    // reconnect layers
+    for (int i = 0; i < net->size; i++) {
+        net->layers[i]->n_out = 0;
+    }
+    for (int i = 0; i < net->size; i++) {
+        Layer *layer = net->layers[i];
+        for (int j = 0; j < layer->n_in; j++) {
+            if (layer->in_ids[j] < 0) {
+                continue;
+            }
+            // in_ids still hold the IDs before compaction
+            Layer *in_layer = net->layers[new_ids[layer->in_ids[j]]];
+            layer->in_ids[j] = in_layer->id;
+            layer->xs[j] = in_layer->y + in_layer->ys_offset[layer->in_ports[j]];
+
+            bool connected = false;
+            for (int k = 0; k < in_layer->n_out; k++) {
+                connected |= (in_layer->out_ids[k] == i);
+            }
+            if (!connected) {
+                in_layer->out_ids[in_layer->n_out] = i;
+                in_layer->n_out++;
+            }
+        }
+        layer->x = layer->xs[0];
+    }
+
+    net->input_layer  = (net->size > 0) ? net->layers[0] : NULL;
+    net->output_layer = (net->size > 0) ? net->layers[net->size - 1] : NULL;
+
+    FREE_WITH_NULL(&new_ids);
+
+    unschedule(net);
+
+    return n_fused;
+}
+
+Net *net_replicate(const Net *net)
+{
+    if ((net == NULL) || (net->size < 1)) {
+        return NULL;
+    }
+
+    Net *replica = net_alloc();
+    if (replica == NULL) {
+        return NULL;
+    }
+
+    // layers are connected only to the preceding layers, so they can be appended in ID order
+    for (int i = 0; i < net->size; i++) {
+        const Layer *src = net->layers[i];
+
+        Layer *layer = layer_create(src->type, src->param);
+        if (layer == NULL) {
+            goto REPLICA_FREE;
+        }
+
+        // take over the callbacks which can be customized
+        layer->init_params = src->init_params;
+        layer->update      = src->update;
+
+        // share parameters
+        FREE_WITH_NULL(&layer->w);
+        FREE_WITH_NULL(&layer->b);
+        layer->w = src->w;
+        layer->b = src->b;
+        layer->shared_params = true;
+
+        if (net_connect(replica, layer, src->n_in, src->in_ids, src->in_ports) == NULL) {
+            layer_free(&layer);
+            goto REPLICA_FREE;
+        }
+    }
+
+    return replica;
+
+REPLICA_FREE:
+    net_free(&replica);
+
+    return NULL;
+}
+
 void net_init_layer_params(Net *net)
 {
     for (int i = 0; i < net->size; i++) {
@@ -100,68 +518,719 @@ void net_init_layer_params(Net *net)
     }
 }
 
+void net_set_accumulate(Net *net, const bool accumulate)
+{
+    for (int i = 0; i < net->size; i++) {
+        net->layers[i]->accumulate = accumulate;
+    }
+}
+
+void net_zero_grad(Net *net)
+{
+    for (int i = 0; i < net->size; i++) {
+        layer_zero_grad(net->layers[i]);
+    }
+}
+
+void net_scale_grad(Net *net, const float k)
+{
+    for (int i = 0; i < net->size; i++) {
+        layer_scale_grad(net->layers[i], k);
+    }
+}
+
+/**
+ * @brief run layer tasks level by level, in parallel within a level if thread pool is set
+ * 
+ * @param[in,out] net target network
+ * @param[in] func task function
+ * @param[in] reverse run levels in reverse order if true
+ */
+static void run_levels(Net *net, void (*func)(void *arg), const bool reverse)
+{
+    for (int l = 0; l < net->n_levels; l++) {
+        int level = reverse ? (net->n_levels - 1 - l) : l;
+        int start = net->level_start[level];
+        int end   = net->level_start[level + 1];
+
+        if ((net->pool == NULL) || ((end - start) < 2)) {
+            for (int i = start; i < end; i++) {
+                func(&net->tasks[net->order[i]]);
+            }
+            continue;
+        }
+
+        for (int i = start; i < end; i++) {
+            NetTask *task = &net->tasks[net->order[i]];
+            if (thread_pool_submit(net->pool, func, task) == NULL) {
+                // run on the caller if failed to queue
+                func(task);
+            }
+        }
+        thread_pool_wait(net->pool);
+    }
+}
+
+/**
+ * @brief task of forward propagation of a layer
+ * 
+ * @param[in,out] arg NetTask of the layer
+ */
+static void forward_task(void *arg)
+{
+    Layer *layer = ((NetTask*)arg)->layer;
+
+    TRACE_BEGIN(traced);
+    PROFILE_BEGIN(start);
+    layer->forward(layer, layer->xs[0]);
+    PROFILE_END(layer->profile.forward, start);
+    TRACE_END(TRACE_CATEGORY_FORWARD, layer_type_name(layer->type), layer->id, traced);
+}
+
+/**
+ * @brief gather diffs of layer output from consumer layers
+ * 
+ * @param[in] net target network
+ * @param[in,out] layer target layer
+ * @return const float* diff of layer output
+ */
+static const float *gather_dy(const Net *net, Layer *layer)
+{
+    const int slot = direct_slot(net, layer);
+    if (slot >= 0) {
+        return net->layers[layer->out_ids[0]]->dxs[slot];
+    }
+
+    for (int i = 0; i < layer->y_size; i++) {
+        layer->dy[i] = 0;
+    }
+
+    for (int i = 0; i < layer->n_out; i++) {
+        Layer *out_layer = net->layers[layer->out_ids[i]];
+        for (int j = 0; j < out_layer->n_in; j++) {
+            if (out_layer->in_ids[j] != layer->id) {
+                continue;
+            }
+            float *dy = layer->dy + layer->ys_offset[out_layer->in_ports[j]];
+            mat_add(dy, out_layer->dxs[j], dy, 1, out_layer->xs_size[j]);
+        }
+    }
+
+    return layer->dy;
+}
+
+/**
+ * @brief task of backward propagation of a layer
+ * 
+ * @param[in,out] arg NetTask of the layer
+ */
+static void backward_task(void *arg)
+{
+    NetTask *task = (NetTask*)arg;
+    Layer *layer  = task->layer;
+
+    const float *dy = task->dy;
+    if (layer != task->net->output_layer) {
+        dy = gather_dy(task->net, layer);
+    }
+
+    TRACE_BEGIN(traced);
+    PROFILE_BEGIN(start);
+    layer->backward(layer, dy);
+    PROFILE_END(layer->profile.backward, start);
+    TRACE_END(TRACE_CATEGORY_BACKWARD, layer_type_name(layer->type), layer->id, traced);
+}
+
 void net_forward(Net *net, const float *x)
 {
-    Layer *layer = net->layers[0];
+    if ((net->order == NULL) && !schedule(net)) {
+        return;
+    }
+
+    // bind network input
+    for (int i = 0; i < net->size; i++) {
+        Layer *layer = net->layers[i];
+        for (int j = 0; j < layer->n_in; j++) {
+            if (layer->in_ids[j] < 0) {
+                layer->xs[j] = x;
+            }
+        }
+        layer->x  = layer->xs[0];
+        layer->sx = NULL;
+    }
 
-    layer->x = x;
+    run_levels(net, forward_task, false);
+}
+
+/**
+ * @brief check that layer takes sparse input
+ * 
+ * @param[in] layer target layer
+ * @return true if layer is Fully connected or fused with it
+ */
+static bool accepts_sparse(const Layer *layer)
+{
+    switch (layer->type) {
+    case LAYER_TYPE_FC:
+    case LAYER_TYPE_FC_SIGMOID:
+    case LAYER_TYPE_FC_RELU:
+    case LAYER_TYPE_FC_SOFTMAX:
+        return true;
+    default:
+        return false;
+    }
+}
 
-    while (true) {
-        layer->forward(layer, layer->x);
-        int next_id = layer->next_id;
-        if (next_id < 0) {
-            break;
+int net_forward_sparse(Net *net, const SparseMatrix *x)
+{
+    if ((net == NULL) || (x == NULL) || (x->n_rows != 1)) {
+        return -1;
+    }
+    if ((net->order == NULL) && !schedule(net)) {
+        return -1;
+    }
+
+    for (int i = 0; i < net->size; i++) {
+        const Layer *layer = net->layers[i];
+        for (int j = 0; j < layer->n_in; j++) {
+            if ((layer->in_ids[j] < 0) &&
+                ((j > 0) || (layer->n_in > 1) || !accepts_sparse(layer) || (layer->x_size != x->n_cols))) {
+                return -1;
+            }
+        }
+    }
+
+    // bind network input to layers taking it, whose rows of dw written by it are tracked
+    for (int i = 0; i < net->size; i++) {
+        Layer *layer = net->layers[i];
+        if ((layer->in_ids[0] < 0) && (layer_alloc_rows(layer) != 0)) {
+            return -1;
         }
-        layer = net->layers[next_id];
     }
+    for (int i = 0; i < net->size; i++) {
+        Layer *layer = net->layers[i];
+        layer->sx = (layer->in_ids[0] < 0) ? x : NULL;
+        if (layer->sx != NULL) {
+            layer->xs[0] = NULL;
+        }
+        layer->x = layer->xs[0];
+    }
+
+    run_levels(net, forward_task, false);
+
+    return 0;
+}
+
+/**
+ * @brief run backward propagation from diff of network output
+ * 
+ * @param[in,out] net network structure
+ * @param[in] dy diff of network output
+ */
+static void backward_from(Net *net, const float *dy)
+{
+    net->tasks[net->output_layer->id].dy = dy;
+
+    // backwarding
+    run_levels(net, backward_task, true);
+
+    net->tasks[net->output_layer->id].dy = NULL;
 }
 
 void net_backward(Net *net, const float *t)
 {
+    if ((net->order == NULL) && !schedule(net)) {
+        return;
+    }
+
     // calculate diff at the last layer
     float *dy = malloc(sizeof(float) * net->output_layer->y_size);
 
     mat_sub(net->output_layer->y, t, dy, 1, net->output_layer->y_size);
 
-    net->output_layer->backward(net->output_layer, dy);
+    backward_from(net, dy);
 
-    Layer *next_layer = net->output_layer;
-    Layer *layer = net->layers[next_layer->prev_id];
+    FREE_WITH_NULL(&dy);
+}
 
-    // backwarding
-    while (true) {
-        layer->backward(layer, next_layer->dx);
-        int prev_id = layer->prev_id;
-        if (prev_id < 0) {
-            break;
-        }
-        next_layer = layer;
-        layer = net->layers[prev_id];
+void net_backward_label(Net *net, const int label)
+{
+    if ((net->order == NULL) && !schedule(net)) {
+        return;
     }
 
+    // diff at the last layer from one-hot vector, y - t
+    const int size = net->output_layer->y_size;
+    float *dy = malloc(sizeof(float) * size);
+
+    fdata_copy(net->output_layer->y, size, dy);
+    if ((label >= 0) && (label < size)) {
+        dy[label] -= 1.0f;
+    }
+
+    backward_from(net, dy);
+
     FREE_WITH_NULL(&dy);
 }
 
+/**
+ * @brief context of a thread evaluating a range of samples
+ * 
+ */
+typedef struct EvalWorker {
+    Net *replica;           //!< replica of network sharing parameters
+    float **x;              //!< array of data
+    float **t;              //!< array of labels
+    int begin;              //!< start of the range of samples
+    int end;                //!< end of the range of samples
+    EvalParameter param;    //!< evaluation parameter
+    float loss;             //!< sum of losses
+    int correct;            //!< num of samples correct at top-1
+    int correct_k;          //!< num of samples correct at top-k
+    int *confusion;         //!< partial confusion matrix
+} EvalWorker;
+
+/**
+ * @brief get class of a label or an output
+ * 
+ * @param[in] y label or output
+ * @param[in] size num of elements
+ * @return int index of class
+ */
+static int class_of(const float *y, const int size)
+{
+    if (size == 1) {
+        return (y[0] > 0.5f) ? 1 : 0;
+    }
+
+    int max = 0;
+    for (int i = 1; i < size; i++) {
+        if (y[i] > y[max]) {
+            max = i;
+        }
+    }
+
+    return max;
+}
+
+/**
+ * @brief get rank of a class in an output
+ * 
+ * @param[in] y output
+ * @param[in] size num of elements
+ * @param[in] label index of class
+ * @return int num of classes with larger scores
+ */
+static int rank_of(const float *y, const int size, const int label)
+{
+    if (size == 1) {
+        return (class_of(y, size) == label) ? 0 : 1;
+    }
+
+    int rank = 0;
+    for (int i = 0; i < size; i++) {
+        if (y[i] > y[label]) {
+            rank++;
+        }
+    }
+
+    return rank;
+}
+
+/**
+ * @brief evaluate a range of samples
+ * 
+ * @param[in,out] arg evaluation worker
+ */
+static void eval_task(void *arg)
+{
+    EvalWorker *worker = (EvalWorker*)arg;
+    Net *replica = worker->replica;
+    const Layer *output = replica->output_layer;
+    const int n_classes = (output->y_size == 1) ? 2 : output->y_size;
+
+    for (int j = worker->begin; j < worker->end; j++) {
+        net_forward(replica, worker->x[j]);
+
+        if (worker->param.loss_func != NULL) {
+            worker->loss += worker->param.loss_func(output->y, worker->t[j], output->y_size);
+        }
+
+        const int label = class_of(worker->t[j], output->y_size);
+        const int pred  = class_of(output->y, output->y_size);
+        const int rank  = rank_of(output->y, output->y_size, label);
+
+        worker->correct   += (pred == label);
+        worker->correct_k += (rank < worker->param.top_k);
+        worker->confusion[label * n_classes + pred]++;
+    }
+}
+
+EvalResult *net_evaluate(const Net *net, float **x, float **t, const int data_size, const EvalParameter eval_param)
+{
+    if ((net == NULL) || (x == NULL) || (t == NULL) || (data_size < 1) ||
+        (eval_param.top_k < 0) || (eval_param.n_threads < 0)) {
+        return NULL;
+    }
+
+    Evaluator *evaluator = evaluator_create(net, eval_param.n_threads);
+    EvalResult *result = evaluator_run(evaluator, x, t, data_size, eval_param);
+    evaluator_free(&evaluator);
+
+    return result;
+}
+
+Evaluator *evaluator_create(const Net *net, const int n_threads)
+{
+    if ((net == NULL) || (net->output_layer == NULL) || (n_threads < 0)) {
+        return NULL;
+    }
+
+    Evaluator *evaluator = malloc(sizeof(Evaluator));
+    if (evaluator == NULL) {
+        return NULL;
+    }
+
+    *evaluator = (Evaluator){
+        .net        = net,
+        .pool       = net->pool,
+        .own_pool   = NULL,
+        .n_replicas = 0,
+        .replicas   = NULL
+    };
+
+    // run on the thread pool of the network, or an own one
+    if ((evaluator->pool == NULL) && (n_threads > 1)) {
+        evaluator->own_pool = thread_pool_create(n_threads);
+        if (evaluator->own_pool == NULL) {
+            goto EVALUATOR_FREE;
+        }
+        evaluator->pool = evaluator->own_pool;
+    }
+    const int n_replicas = (evaluator->pool != NULL) ? evaluator->pool->size : 1;
+
+    evaluator->replicas = calloc(n_replicas, sizeof(Net*));
+    if (evaluator->replicas == NULL) {
+        goto EVALUATOR_FREE;
+    }
+    for (; evaluator->n_replicas < n_replicas; evaluator->n_replicas++) {
+        evaluator->replicas[evaluator->n_replicas] = net_replicate(net);
+        if (evaluator->replicas[evaluator->n_replicas] == NULL) {
+            goto EVALUATOR_FREE;
+        }
+    }
+
+    return evaluator;
+
+EVALUATOR_FREE:
+    evaluator_free(&evaluator);
+
+    return NULL;
+}
+
+EvalResult *evaluator_run(
+    Evaluator *evaluator, float **x, float **t, const int data_size, const EvalParameter eval_param)
+{
+    if ((evaluator == NULL) || (x == NULL) || (t == NULL) || (data_size < 1) || (eval_param.top_k < 0)) {
+        return NULL;
+    }
+
+    EvalParameter param = eval_param;
+    if (param.top_k == 0) {
+        param.top_k = 1;
+    }
+
+    const int y_size    = evaluator->net->output_layer->y_size;
+    const int n_classes = (y_size == 1) ? 2 : y_size;
+    const int n_threads = evaluator->n_replicas;
+
+    bool succeeded = false;
+    int n_workers  = 0;
+
+    EvalResult *result = malloc(sizeof(EvalResult));
+    EvalWorker *workers = malloc(sizeof(EvalWorker) * n_threads);
+    if ((result == NULL) || (workers == NULL)) {
+        FREE_WITH_NULL(&result);
+        FREE_WITH_NULL(&workers);
+        return NULL;
+    }
+
+    *result = (EvalResult){
+        .count          = data_size,
+        .loss           = 0,
+        .accuracy       = 0,
+        .top_k_accuracy = 0,
+        .top_k          = param.top_k,
+        .n_classes      = n_classes,
+        .confusion      = calloc((n_classes * n_classes), sizeof(int))
+    };
+    if (result->confusion == NULL) {
+        goto WORKERS_FREE;
+    }
+
+    for (; n_workers < n_threads; n_workers++) {
+        EvalWorker *worker = &workers[n_workers];
+
+        *worker = (EvalWorker){
+            .replica   = evaluator->replicas[n_workers],
+            .x         = x,
+            .t         = t,
+            .begin     = (int)((long)data_size * n_workers / n_threads),
+            .end       = (int)((long)data_size * (n_workers + 1) / n_threads),
+            .param     = param,
+            .loss      = 0,
+            .correct   = 0,
+            .correct_k = 0,
+            .confusion = calloc((n_classes * n_classes), sizeof(int))
+        };
+        if (worker->confusion == NULL) {
+            goto WORKERS_FREE;
+        }
+    }
+
+    if (evaluator->pool != NULL) {
+        for (int k = 0; k < n_workers; k++) {
+            if (thread_pool_submit(evaluator->pool, eval_task, &workers[k]) == NULL) {
+                // run by the caller if the queue cannot grow
+                eval_task(&workers[k]);
+            }
+        }
+        thread_pool_wait(evaluator->pool);
+    } else {
+        eval_task(&workers[0]);
+    }
+
+    // sum in the order of ranges
+    int correct   = 0;
+    int correct_k = 0;
+    for (int k = 0; k < n_workers; k++) {
+        result->loss += workers[k].loss;
+        correct      += workers[k].correct;
+        correct_k    += workers[k].correct_k;
+        for (int m = 0; m < (n_classes * n_classes); m++) {
+            result->confusion[m] += workers[k].confusion[m];
+        }
+    }
+    result->loss           /= data_size;
+    result->accuracy       = (float)correct / data_size;
+    result->top_k_accuracy = (float)correct_k / data_size;
+
+    succeeded = true;
+
+WORKERS_FREE:
+    for (int k = 0; k < n_workers; k++) {
+        FREE_WITH_NULL(&workers[k].confusion);
+    }
+    FREE_WITH_NULL(&workers);
+
+    if (!succeeded) {
+        net_eval_result_free(&result);
+    }
+
+    return result;
+}
+
+void evaluator_free(Evaluator **evaluator)
+{
+    if (*evaluator == NULL) {
+        return;
+    }
+
+    if ((*evaluator)->replicas != NULL) {
+        for (int i = 0; i < (*evaluator)->n_replicas; i++) {
+            net_free(&(*evaluator)->replicas[i]);
+        }
+    }
+    FREE_WITH_NULL(&(*evaluator)->replicas);
+    thread_pool_free(&(*evaluator)->own_pool);
+
+    FREE_WITH_NULL(evaluator);
+}
+
+void net_eval_result_free(EvalResult **result)
+{
+    if (*result == NULL) {
+        return;
+    }
+
+    FREE_WITH_NULL(&(*result)->confusion);
+
+    FREE_WITH_NULL(result);
+}
+
+void net_profile_reset(Net *net)
+{
+    for (int i = 0; i < net->size; i++) {
+        profile_stat_reset(&net->layers[i]->profile.forward);
+        profile_stat_reset(&net->layers[i]->profile.backward);
+    }
+}
+
+#ifdef NNC_PROFILE
+
+/**
+ * @brief write statistics as columns of table
+ * 
+ * @param[in] fp output stream
+ * @param[in] stat target statistics
+ */
+static void write_stat_columns(FILE *fp, const ProfileStat *stat)
+{
+    double mean = (stat->count > 0) ? (stat->total / stat->count) : 0;
+
+    fprintf(fp, " %12ld %12.3f %12.3f %12.3f %12.3f",
+        stat->count, (stat->total * 1e3), (mean * 1e6), (stat->min * 1e6), (stat->max * 1e6));
+}
+
+/**
+ * @brief write achieved throughput and counters as a row of table
+ * 
+ * @param[in] fp output stream
+ * @param[in] layer target layer
+ * @param[in] backward write statistics of backward propagation if true
+ */
+static void write_roofline_row(FILE *fp, const Layer *layer, const bool backward)
+{
+    const ProfileStat *stat = backward ? &layer->profile.backward : &layer->profile.forward;
+
+    double flops, bytes;
+    layer_cost(layer, backward, &flops, &bytes);
+
+    fprintf(fp, "%4d %-16s %-4s %12.0f %12.0f %12.3f",
+        layer->id, layer_type_name(layer->type), (backward ? "bwd" : "fwd"), flops, bytes, ((bytes > 0) ? (flops / bytes) : 0));
+
+    if ((stat->count > 0) && (stat->total > 0)) {
+        fprintf(fp, " %12.3f %12.3f",
+            (flops * stat->count / stat->total * 1e-9), (bytes * stat->count / stat->total * 1e-9));
+    } else {
+        fprintf(fp, " %12s %12s", "n/a", "n/a");
+    }
+
+    if ((stat->counted > 0) && (stat->counters[PROFILE_COUNTER_CYCLES] > 0)) {
+        const double n = stat->counted;
+        fprintf(fp, " %12.3f %12.1f %12.1f",
+            ((double)stat->counters[PROFILE_COUNTER_INSTRUCTIONS] / stat->counters[PROFILE_COUNTER_CYCLES]),
+            (stat->counters[PROFILE_COUNTER_LLC_MISSES] / n),
+            (stat->counters[PROFILE_COUNTER_BRANCH_MISSES] / n));
+    } else {
+        fprintf(fp, " %12s %12s %12s", "n/a", "n/a", "n/a");
+    }
+
+    fprintf(fp, "\n");
+}
+
+/**
+ * @brief write statistics as JSON object
+ * 
+ * @param[in] fp output stream
+ * @param[in] layer target layer
+ * @param[in] backward write statistics of backward propagation if true
+ */
+static void write_stat_json(FILE *fp, const Layer *layer, const bool backward)
+{
+    const ProfileStat *stat = backward ? &layer->profile.backward : &layer->profile.forward;
+
+    double mean = (stat->count > 0) ? (stat->total / stat->count) : 0;
+
+    fprintf(fp, "{\"count\": %ld, \"total_ms\": %.6f, \"mean_us\": %.6f, \"min_us\": %.6f, \"max_us\": %.6f",
+        stat->count, (stat->total * 1e3), (mean * 1e6), (stat->min * 1e6), (stat->max * 1e6));
+
+    double flops, bytes;
+    layer_cost(layer, backward, &flops, &bytes);
+
+    fprintf(fp, ", \"flops\": %.0f, \"bytes\": %.0f", flops, bytes);
+    if ((stat->count > 0) && (stat->total > 0)) {
+        fprintf(fp, ", \"gflops_per_s\": %.6f, \"gbytes_per_s\": %.6f",
+            (flops * stat->count / stat->total * 1e-9), (bytes * stat->count / stat->total * 1e-9));
+    } else {
+        fprintf(fp, ", \"gflops_per_s\": null, \"gbytes_per_s\": null");
+    }
+
+    // counters are averaged per call
+    for (int i = 0; i < PROFILE_COUNTER_NUM; i++) {
+        if (stat->counted > 0) {
+            fprintf(fp, ", \"%s\": %.3f", profile_counter_name(i), ((double)stat->counters[i] / stat->counted));
+        } else {
+            fprintf(fp, ", \"%s\": null", profile_counter_name(i));
+        }
+    }
+
+    fprintf(fp, "}");
+}
+
+#endif // NNC_PROFILE
+
+int net_profile_report(const Net *net, FILE *fp, const ProfileFormat format)
+{
+#ifndef NNC_PROFILE
+    (void)net;
+    (void)fp;
+    (void)format;
+
+    return -1;
+#else
+    if ((net == NULL) || (fp == NULL)) {
+        return -1;
+    }
+
+    if (format == PROFILE_FORMAT_JSON) {
+        fprintf(fp, "[\n");
+        for (int i = 0; i < net->size; i++) {
+            const Layer *layer = net->layers[i];
+            fprintf(fp, "  {\"id\": %d, \"type\": \"%s\", \"forward\": ", layer->id, layer_type_name(layer->type));
+            write_stat_json(fp, layer, false);
+            fprintf(fp, ", \"backward\": ");
+            write_stat_json(fp, layer, true);
+            fprintf(fp, "}%s\n", (i < (net->size - 1)) ? "," : "");
+        }
+        fprintf(fp, "]\n");
+
+        return 0;
+    }
+
+    fprintf(fp, "%4s %-16s %12s %12s %12s %12s %12s %12s %12s %12s %12s %12s\n",
+        "id", "type",
+        "fwd calls", "fwd tot[ms]", "fwd avg[us]", "fwd min[us]", "fwd max[us]",
+        "bwd calls", "bwd tot[ms]", "bwd avg[us]", "bwd min[us]", "bwd max[us]");
+    for (int i = 0; i < net->size; i++) {
+        const Layer *layer = net->layers[i];
+        fprintf(fp, "%4d %-16s", layer->id, layer_type_name(layer->type));
+        write_stat_columns(fp, &layer->profile.forward);
+        write_stat_columns(fp, &layer->profile.backward);
+        fprintf(fp, "\n");
+    }
+
+    // achieved throughput against theoretical cost per call
+    fprintf(fp, "\n%4s %-16s %-4s %12s %12s %12s %12s %12s %12s %12s %12s\n",
+        "id", "type", "dir", "FLOP/call", "byte/call", "FLOP/byte", "GFLOP/s", "GB/s",
+        "IPC", "LLC miss", "br miss");
+    for (int i = 0; i < net->size; i++) {
+        write_roofline_row(fp, net->layers[i], false);
+        write_roofline_row(fp, net->layers[i], true);
+    }
+
+    return 0;
+#endif // NNC_PROFILE
+}
+
 void net_free(Net **net)
 {
     if (*net == NULL) {
         return;
     }
 
-    Layer *layer = (*net)->layers[0];
-    if (layer == NULL) {
-        goto NET_FREE;
+    for (int i = 0; i < (*net)->size; i++) {
+        layer_free(&(*net)->layers[i]);
     }
 
-    while (true) {
-        int next_id = layer->next_id;
-        layer_free(&layer);
-        if (next_id < 0) {
-            break;
-        }
-        layer = (*net)->layers[next_id];
+    unschedule(*net);
+
+    FREE_WITH_NULL(&(*net)->layers);
+
+    // parameters of layers are in the mapped checkpoint
+    if ((*net)->map != NULL) {
+        munmap((*net)->map, (*net)->map_size);
     }
 
-NET_FREE:
     FREE_WITH_NULL(net);
 }
@@ -0,0 +1,338 @@
+/**
+ * @file optimizer.c
+ * @brief optimizers to update network parameters
+ * 
+ */
+#include "optimizer.h"
+
+#include <stdlib.h>
+#include <math.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "data.h"
+#include "util.h"
+
+/**
+ * @brief update with SGD with momentum in a single pass
+ * @note v = mu * v + g, p -= lr * v, or p -= lr * (g + mu * v) with Nesterov momentum
+ * 
+ * @param[in,out] p parameters
+ * @param[in] g diffs of parameters
+ * @param[in,out] v velocity
+ * @param[in] size num of parameters
+ * @param[in] lr learning rate
+ * @param[in] mu coefficient of momentum
+ * @param[in] nesterov use Nesterov momentum if true
+ */
+static void momentum_kernel(
+    float *p, const float *g, float *v, const int size,
+    const float lr, const float mu, const bool nesterov)
+{
+    int i = 0;
+
+#ifdef __SSE2__
+    const __m128 lr4 = _mm_set1_ps(lr);
+    const __m128 mu4 = _mm_set1_ps(mu);
+    for (; i <= (size - 4); i += 4) {
+        __m128 g4 = _mm_loadu_ps(&g[i]);
+        __m128 v4 = _mm_add_ps(_mm_mul_ps(mu4, _mm_loadu_ps(&v[i])), g4);
+        __m128 d4 = nesterov ? _mm_add_ps(g4, _mm_mul_ps(mu4, v4)) : v4;
+
+        _mm_storeu_ps(&v[i], v4);
+        _mm_storeu_ps(&p[i], _mm_sub_ps(_mm_loadu_ps(&p[i]), _mm_mul_ps(lr4, d4)));
+    }
+#endif
+
+    for (; i < size; i++) {
+        v[i] = mu * v[i] + g[i];
+        p[i] -= lr * (nesterov ? (g[i] + mu * v[i]) : v[i]);
+    }
+}
+
+/**
+ * @brief update with SGD
+ * @note p -= lr * g
+ * 
+ * @param[in,out] p parameters
+ * @param[in] g diffs of parameters
+ * @param[in] size num of parameters
+ * @param[in] lr learning rate
+ */
+static void sgd_kernel(float *p, const float *g, const int size, const float lr)
+{
+    for (int i = 0; i < size; i++) {
+        p[i] -= lr * g[i];
+    }
+}
+
+/**
+ * @brief update with Adam in a single pass
+ * @note m = b1 * m + (1 - b1) * g, v = b2 * v + (1 - b2) * g^2,
+ *       p = p * decay - lr * (m * c1) / (sqrt(v * c2) + eps)
+ * 
+ * @param[in,out] p parameters
+ * @param[in] g diffs of parameters
+ * @param[in,out] m 1st moment
+ * @param[in,out] v 2nd moment
+ * @param[in] size num of parameters
+ * @param[in] lr learning rate
+ * @param[in] b1 decay rate of 1st moment
+ * @param[in] b2 decay rate of 2nd moment
+ * @param[in] eps term to avoid division by zero
+ * @param[in] c1 bias correction of 1st moment
+ * @param[in] c2 bias correction of 2nd moment
+ * @param[in] decay multiplier of parameters for decoupled weight decay, 1 for no decay
+ */
+static void adam_kernel(
+    float *p, const float *g, float *m, float *v, const int size,
+    const float lr, const float b1, const float b2, const float eps,
+    const float c1, const float c2, const float decay)
+{
+    int i = 0;
+
+#ifdef __SSE2__
+    const __m128 lr4    = _mm_set1_ps(lr);
+    const __m128 b14    = _mm_set1_ps(b1);
+    const __m128 b24    = _mm_set1_ps(b2);
+    const __m128 nb14   = _mm_set1_ps(1 - b1);
+    const __m128 nb24   = _mm_set1_ps(1 - b2);
+    const __m128 eps4   = _mm_set1_ps(eps);
+    const __m128 c14    = _mm_set1_ps(c1);
+    const __m128 c24    = _mm_set1_ps(c2);
+    const __m128 decay4 = _mm_set1_ps(decay);
+    for (; i <= (size - 4); i += 4) {
+        __m128 g4 = _mm_loadu_ps(&g[i]);
+        __m128 m4 = _mm_add_ps(_mm_mul_ps(b14, _mm_loadu_ps(&m[i])), _mm_mul_ps(nb14, g4));
+        __m128 v4 = _mm_add_ps(_mm_mul_ps(b24, _mm_loadu_ps(&v[i])), _mm_mul_ps(nb24, _mm_mul_ps(g4, g4)));
+
+        __m128 num = _mm_mul_ps(lr4, _mm_mul_ps(m4, c14));
+        __m128 den = _mm_add_ps(_mm_sqrt_ps(_mm_mul_ps(v4, c24)), eps4);
+        __m128 p4  = _mm_mul_ps(_mm_loadu_ps(&p[i]), decay4);
+
+        _mm_storeu_ps(&m[i], m4);
+        _mm_storeu_ps(&v[i], v4);
+        _mm_storeu_ps(&p[i], _mm_sub_ps(p4, _mm_div_ps(num, den)));
+    }
+#endif
+
+    for (; i < size; i++) {
+        m[i] = b1 * m[i] + (1 - b1) * g[i];
+        v[i] = b2 * v[i] + (1 - b2) * g[i] * g[i];
+        p[i] = p[i] * decay - lr * (m[i] * c1) / (sqrtf(v[i] * c2) + eps);
+    }
+}
+
+/**
+ * @brief allocate array of moment initialized with 0
+ * 
+ * @param[in] size num of elements
+ * @return float* pointer to array, NULL if failed
+ */
+static float *moment_alloc(const int size)
+{
+    float *moment = fdata_alloc(size);
+    if (moment != NULL) {
+        for (int i = 0; i < size; i++) {
+            moment[i] = 0;
+        }
+    }
+
+    return moment;
+}
+
+Optimizer *optimizer_create(const Net *net, const OptimizerParameter param)
+{
+    if ((net == NULL) || (param.learning_rate <= 0)) {
+        return NULL;
+    }
+    if ((param.type < OPTIMIZER_TYPE_SGD) || (param.type > OPTIMIZER_TYPE_ADAMW)) {
+        return NULL;
+    }
+
+    Optimizer *optimizer = malloc(sizeof(Optimizer));
+    if (optimizer == NULL) {
+        return NULL;
+    }
+
+    optimizer->param = param;
+    optimizer->step  = 0;
+    optimizer->size  = net->size;
+
+    // set defaults, except for zeros given explicitly
+    const int zeros = param.zeros;
+    if ((optimizer->param.momentum == 0) && !(zeros & OPTIMIZER_ZERO_MOMENTUM)) {
+        optimizer->param.momentum = 0.9f;
+    }
+    if ((optimizer->param.beta1 == 0) && !(zeros & OPTIMIZER_ZERO_BETA1)) {
+        optimizer->param.beta1 = 0.9f;
+    }
+    if ((optimizer->param.beta2 == 0) && !(zeros & OPTIMIZER_ZERO_BETA2)) {
+        optimizer->param.beta2 = 0.999f;
+    }
+    if ((optimizer->param.epsilon == 0) && !(zeros & OPTIMIZER_ZERO_EPSILON)) {
+        optimizer->param.epsilon = 1e-8f;
+    }
+    if ((optimizer->param.weight_decay == 0) && !(zeros & OPTIMIZER_ZERO_WEIGHT_DECAY)) {
+        optimizer->param.weight_decay = 0.01f;
+    }
+
+    optimizer->states = malloc(sizeof(OptimizerState) * net->size);
+    if (optimizer->states == NULL) {
+        FREE_WITH_NULL(&optimizer);
+        return NULL;
+    }
+    for (int i = 0; i < net->size; i++) {
+        optimizer->states[i] = (OptimizerState){ NULL, NULL, NULL, NULL };
+    }
+
+    // SGD has no state
+    if (param.type == OPTIMIZER_TYPE_SGD) {
+        return optimizer;
+    }
+
+    const bool has_2nd = (param.type == OPTIMIZER_TYPE_ADAM) || (param.type == OPTIMIZER_TYPE_ADAMW);
+
+    for (int i = 0; i < net->size; i++) {
+        const Layer *layer = net->layers[i];
+        OptimizerState *state = &optimizer->states[layer->id];
+
+        if (layer->w != NULL) {
+            state->mw = moment_alloc(layer->w_size);
+            if ((state->mw == NULL) ||
+                (has_2nd && ((state->vw = moment_alloc(layer->w_size)) == NULL))) {
+                goto OPTIMIZER_FREE;
+            }
+        }
+        if (layer->b != NULL) {
+            state->mb = moment_alloc(layer->b_size);
+            if ((state->mb == NULL) ||
+                (has_2nd && ((state->vb = moment_alloc(layer->b_size)) == NULL))) {
+                goto OPTIMIZER_FREE;
+            }
+        }
+    }
+
+    return optimizer;
+
+OPTIMIZER_FREE:
+    optimizer_free(&optimizer);
+
+    return NULL;
+}
+
+const char *optimizer_type_name(const OptimizerType type)
+{
+    switch (type) {
+    case OPTIMIZER_TYPE_SGD:
+        return "sgd";
+    case OPTIMIZER_TYPE_MOMENTUM:
+        return "momentum";
+    case OPTIMIZER_TYPE_NESTEROV:
+        return "nesterov";
+    case OPTIMIZER_TYPE_ADAM:
+        return "adam";
+    case OPTIMIZER_TYPE_ADAMW:
+        return "adamw";
+    default:
+        return "none";
+    }
+}
+
+void optimizer_step(Optimizer *optimizer, Net *net)
+{
+    if ((optimizer == NULL) || (net == NULL) || (optimizer->size != net->size)) {
+        return;
+    }
+
+    const OptimizerParameter *param = &optimizer->param;
+    const float lr = param->learning_rate;
+
+    optimizer->step++;
+
+    // bias corrections of Adam
+    const float c1 = 1.0f / (1.0f - powf(param->beta1, (float)optimizer->step));
+    const float c2 = 1.0f / (1.0f - powf(param->beta2, (float)optimizer->step));
+
+    for (int i = 0; i < net->size; i++) {
+        Layer *layer = net->layers[i];
+        OptimizerState *state = &optimizer->states[layer->id];
+
+        // weights are a single row unless rows written by sparse input are tracked
+        const bool sparse = layer->rows.sparse && (layer->w != NULL);
+        const int n_rows  = sparse ? layer->rows.size : 1;
+        const int width   = sparse ? (layer->w_size / layer->x_size) : layer->w_size;
+
+        switch (param->type) {
+        case OPTIMIZER_TYPE_SGD:
+            if (!sparse) {
+                layer->update(layer, lr);
+                break;
+            }
+            for (int r = 0; r < n_rows; r++) {
+                const size_t offset = (size_t)layer->rows.ids[r] * width;
+                sgd_kernel((layer->w + offset), (layer->dw + offset), width, lr);
+            }
+            if (layer->b != NULL) {
+                sgd_kernel(layer->b, layer->db, layer->b_size, lr);
+            }
+            break;
+        case OPTIMIZER_TYPE_MOMENTUM:
+        case OPTIMIZER_TYPE_NESTEROV:
+        {
+            const bool nesterov = (param->type == OPTIMIZER_TYPE_NESTEROV);
+            for (int r = 0; (layer->w != NULL) && (r < n_rows); r++) {
+                const size_t offset = sparse ? ((size_t)layer->rows.ids[r] * width) : 0;
+                momentum_kernel(
+                    (layer->w + offset), (layer->dw + offset), (state->mw + offset), width,
+                    lr, param->momentum, nesterov
+                );
+            }
+            if (layer->b != NULL) {
+                momentum_kernel(layer->b, layer->db, state->mb, layer->b_size, lr, param->momentum, nesterov);
+            }
+            break;
+        }
+        case OPTIMIZER_TYPE_ADAM:
+        case OPTIMIZER_TYPE_ADAMW:
+        {
+            // weight decay is applied only to weights
+            const float decay = (param->type == OPTIMIZER_TYPE_ADAMW) ? (1 - lr * param->weight_decay) : 1;
+            for (int r = 0; (layer->w != NULL) && (r < n_rows); r++) {
+                const size_t offset = sparse ? ((size_t)layer->rows.ids[r] * width) : 0;
+                adam_kernel((layer->w + offset), (layer->dw + offset), (state->mw + offset), (state->vw + offset),
+                    width, lr, param->beta1, param->beta2, param->epsilon, c1, c2, decay);
+            }
+            if (layer->b != NULL) {
+                adam_kernel(layer->b, layer->db, state->mb, state->vb, layer->b_size,
+                    lr, param->beta1, param->beta2, param->epsilon, c1, c2, 1);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+void optimizer_free(Optimizer **optimizer)
+{
+    if (*optimizer == NULL) {
+        return;
+    }
+
+    if ((*optimizer)->states != NULL) {
+        for (int i = 0; i < (*optimizer)->size; i++) {
+            OptimizerState *state = &(*optimizer)->states[i];
+            FREE_WITH_NULL(&state->mw);
+            FREE_WITH_NULL(&state->vw);
+            FREE_WITH_NULL(&state->mb);
+            FREE_WITH_NULL(&state->vb);
+        }
+        FREE_WITH_NULL(&(*optimizer)->states);
+    }
+
+    FREE_WITH_NULL(optimizer);
+}
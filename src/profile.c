@@ -0,0 +1,222 @@
+/**
+ * @file profile.c
+ * @brief per-layer profiling
+ * 
+ */
+#include "profile.h"
+
+#include <time.h>
+
+#ifdef NNC_PROFILE_PERF
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+// file descriptors of counter group of each thread,
+// the first one is the group leader, -1 if not available
+static _Thread_local int perf_fds[PROFILE_COUNTER_NUM];
+
+// state of counter group of each thread: 0: not opened, 1: opened, -1: failed
+static _Thread_local int perf_state = 0;
+
+// key whose destructor closes counter group at exit of each thread
+static pthread_key_t perf_key;
+static pthread_once_t perf_key_once = PTHREAD_ONCE_INIT;
+
+// event config of each counter
+static const uint64_t PERF_CONFIGS[PROFILE_COUNTER_NUM] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+
+/**
+ * @brief close counter group of an exiting thread
+ * 
+ * @param[in,out] fds file descriptors of counter group
+ */
+static void perf_close(void *fds)
+{
+    int *group = fds;
+    for (int i = 0; i < PROFILE_COUNTER_NUM; i++) {
+        if (group[i] >= 0) {
+            close(group[i]);
+        }
+        group[i] = -1;
+    }
+}
+
+/**
+ * @brief create key closing counter groups of threads
+ * 
+ */
+static void perf_create_key(void)
+{
+    pthread_key_create(&perf_key, perf_close);
+}
+
+/**
+ * @brief open counter group for the calling thread
+ * @note the group is closed when the thread exits,
+ *       and when the process exits for the main thread
+ * 
+ * @return true if succeeded
+ */
+static bool perf_open(void)
+{
+    for (int i = 0; i < PROFILE_COUNTER_NUM; i++) {
+        perf_fds[i] = -1;
+    }
+
+    for (int i = 0; i < PROFILE_COUNTER_NUM; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type           = PERF_TYPE_HARDWARE;
+        attr.size           = sizeof(attr);
+        attr.config         = PERF_CONFIGS[i];
+        attr.read_format    = PERF_FORMAT_GROUP;
+        attr.disabled       = (i == 0);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+
+        // count the calling thread on any CPU
+        perf_fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, ((i == 0) ? -1 : perf_fds[0]), 0);
+        if (perf_fds[i] < 0) {
+            goto PERF_CLOSE;
+        }
+    }
+
+    // the destructor of the key is called with non-NULL value only
+    pthread_once(&perf_key_once, perf_create_key);
+    if (pthread_setspecific(perf_key, perf_fds) != 0) {
+        goto PERF_CLOSE;
+    }
+
+    ioctl(perf_fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(perf_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+    return true;
+
+PERF_CLOSE:
+    perf_close(perf_fds);
+
+    return false;
+}
+
+/**
+ * @brief read counter group of the calling thread
+ * 
+ * @param[out] counters values of counters
+ * @return true if succeeded
+ */
+static bool perf_read(uint64_t *counters)
+{
+    if (perf_state == 0) {
+        perf_state = perf_open() ? 1 : -1;
+    }
+    if (perf_state < 0) {
+        return false;
+    }
+
+    // layout of PERF_FORMAT_GROUP: nr, values[nr]
+    uint64_t buf[1 + PROFILE_COUNTER_NUM];
+    if (read(perf_fds[0], buf, sizeof(buf)) != (ssize_t)sizeof(buf)) {
+        return false;
+    }
+
+    for (int i = 0; i < PROFILE_COUNTER_NUM; i++) {
+        counters[i] = buf[1 + i];
+    }
+
+    return true;
+}
+#endif // NNC_PROFILE_PERF
+
+double profile_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+void profile_sample(ProfileSample *sample)
+{
+#ifdef NNC_PROFILE_PERF
+    sample->has_counters = perf_read(sample->counters);
+#else
+    sample->has_counters = false;
+#endif
+
+    // read clock last at the start of measurement
+    sample->time = profile_now();
+}
+
+const char *profile_counter_name(const ProfileCounter counter)
+{
+    switch (counter) {
+    case PROFILE_COUNTER_CYCLES:
+        return "cycles";
+    case PROFILE_COUNTER_INSTRUCTIONS:
+        return "instructions";
+    case PROFILE_COUNTER_LLC_MISSES:
+        return "llc_misses";
+    case PROFILE_COUNTER_BRANCH_MISSES:
+        return "branch_misses";
+    default:
+        return "unknown";
+    }
+}
+
+void profile_stat_reset(ProfileStat *stat)
+{
+    stat->count = 0;
+    stat->total = 0;
+    stat->min   = 0;
+    stat->max   = 0;
+
+    stat->counted = 0;
+    for (int i = 0; i < PROFILE_COUNTER_NUM; i++) {
+        stat->counters[i] = 0;
+    }
+}
+
+void profile_stat_add(ProfileStat *stat, const double elapsed)
+{
+    if ((stat->count == 0) || (elapsed < stat->min)) {
+        stat->min = elapsed;
+    }
+    if ((stat->count == 0) || (elapsed > stat->max)) {
+        stat->max = elapsed;
+    }
+
+    stat->total += elapsed;
+    stat->count++;
+}
+
+void profile_stat_add_since(ProfileStat *stat, const ProfileSample *start)
+{
+    // read clock first at the end of measurement
+    double elapsed = profile_now() - start->time;
+
+    profile_stat_add(stat, elapsed);
+
+    if (!start->has_counters) {
+        return;
+    }
+
+    ProfileSample end;
+    profile_sample(&end);
+    if (!end.has_counters) {
+        return;
+    }
+
+    for (int i = 0; i < PROFILE_COUNTER_NUM; i++) {
+        stat->counters[i] += end.counters[i] - start->counters[i];
+    }
+    stat->counted++;
+}
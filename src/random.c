@@ -6,6 +6,9 @@
 #include "random.h"
 
 #include <math.h>
+#include <stdlib.h>
+
+#include "util.h"
 
 // pi constant
 static const float PI = 3.141592;
@@ -36,6 +39,68 @@ uint32_t rand_xorshift(void)
     return w;
 }
 
+uint32_t rand_range(const uint32_t n)
+{
+    // multiply and shift, with rejection of the biased part (Lemire's method)
+    uint64_t m = (uint64_t)rand_xorshift() * n;
+    uint32_t low = (uint32_t)m;
+    if (low < n) {
+        const uint32_t threshold = (uint32_t)(-n) % n;
+        while (low < threshold) {
+            m = (uint64_t)rand_xorshift() * n;
+            low = (uint32_t)m;
+        }
+    }
+
+    return (uint32_t)(m >> 32);
+}
+
+void rand_shuffle(int *array, const int size)
+{
+    for (int i = size - 1; i > 0; i--) {
+        int j = (int)rand_range((uint32_t)(i + 1));
+
+        int tmp = array[i];
+        array[i] = array[j];
+        array[j] = tmp;
+    }
+}
+
+int rand_block_shuffle(int *array, const int size, const int block_size)
+{
+    if ((size < 1) || (block_size < 1)) {
+        return -1;
+    }
+
+    const int n_blocks = (size + block_size - 1) / block_size;
+
+    int *order = malloc(sizeof(int) * n_blocks);
+    if (order == NULL) {
+        return -1;
+    }
+    for (int k = 0; k < n_blocks; k++) {
+        order[k] = k;
+    }
+    rand_shuffle(order, n_blocks);
+
+    int *p = array;
+    for (int k = 0; k < n_blocks; k++) {
+        const int begin = order[k] * block_size;
+        const int end   = ((begin + block_size) < size) ? (begin + block_size) : size;
+
+        for (int i = begin; i < end; i++) {
+            p[i - begin] = i;
+        }
+        rand_shuffle(p, (end - begin));
+
+        p += end - begin;
+    }
+
+    FREE_WITH_NULL(&order);
+
+    return 0;
+}
+
 float rand_uniform(void)
 {
     return (rand_xorshift() + 1.0f) / (UINT32_MAX + 2.0f);
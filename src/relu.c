@@ -0,0 +1,83 @@
+/**
+ * @file relu.c
+ * @brief ReLU layer
+ * 
+ */
+#include "relu.h"
+
+#include "data.h"
+
+/**
+ * @brief forward propagation of ReLU layer
+ * 
+ * @param self target layer
+ * @param x layer input
+ */
+static void forward(Layer *self, const float *x)
+{
+    self->x = x;
+
+    for (int i = 0; i < self->x_size; i++) {
+        self->y[i] = (self->x[i] > 0) ? self->x[i] : 0;
+    }
+}
+
+/**
+ * @brief backward propagation of ReLU layer
+ * 
+ * @param self target layer
+ * @param dy diff of next layer
+ */
+static void backward(Layer *self, const float *dy)
+{
+    for (int i = 0; i < self->y_size; i++) {
+        self->dx[i] = (self->x[i] > 0) ? dy[i] : 0;
+    }
+}
+
+Layer *relu_layer(const LayerParameter layer_param)
+{
+    if (layer_param.in < 1) {
+        return NULL;
+    }
+
+    Layer *layer = layer_alloc();
+    if (layer == NULL) {
+        return NULL;
+    }
+
+    int x_size = 1 * layer_param.in * 1 * 1;
+    SET_DIM(layer->x_dim, 1, layer_param.in, 1, 1);
+    layer->x_size = x_size;
+
+    int y_size = 1 * layer_param.in * 1 * 1;
+    SET_DIM(layer->y_dim, 1, layer_param.in, 1, 1);
+    layer->y_size = y_size;
+
+    layer->y = fdata_alloc(y_size);
+    if (layer->y == NULL) {
+        goto LAYER_FREE;
+    }
+
+    layer->dx = fdata_alloc(x_size);
+    if (layer->dx == NULL) {
+        goto LAYER_FREE;
+    }
+
+    layer->xs_size[0] = x_size;
+    layer->dxs[0]     = layer->dx;
+    layer->ys_size[0] = y_size;
+
+    layer->type  = LAYER_TYPE_RELU;
+    layer->param = layer_param;
+
+    layer->forward  = forward;
+    layer->backward = backward;
+
+    return layer;
+
+LAYER_FREE:
+    layer_free(&layer);
+
+    return NULL;
+}
@@ -67,6 +67,13 @@ Layer *sigmoid_layer(const LayerParameter layer_param)
         goto LAYER_FREE;
     }
 
+    layer->xs_size[0] = x_size;
+    layer->dxs[0]     = layer->dx;
+    layer->ys_size[0] = y_size;
+
+    layer->type  = LAYER_TYPE_SIGMOID;
+    layer->param = layer_param;
+
     layer->forward  = forward;
     layer->backward = backward;
 
@@ -20,13 +20,22 @@ static void forward(Layer *self, const float *x)
 {
     self->x = x;
 
+    // the max is subtracted not to overflow exp
+    float max = self->x[0];
+    for (int i = 1; i < self->x_size; i++) {
+        if (self->x[i] > max) {
+            max = self->x[i];
+        }
+    }
+
     float sum = 0;
     for (int i = 0; i < self->x_size; i++) {
-        sum += exp(self->x[i]);
+        self->y[i] = exp(self->x[i] - max);
+        sum += self->y[i];
     }
 
     for (int i = 0; i < self->x_size; i++) {
-        self->y[i] = exp(self->x[i]) / sum;
+        self->y[i] /= sum;
     }
 }
 
@@ -73,6 +82,13 @@ Layer *softmax_layer(const LayerParameter layer_param)
         goto LAYER_FREE;
     }
 
+    layer->xs_size[0] = x_size;
+    layer->dxs[0]     = layer->dx;
+    layer->ys_size[0] = y_size;
+
+    layer->type  = LAYER_TYPE_SOFTMAX;
+    layer->param = layer_param;
+
     layer->forward  = forward;
     layer->backward = backward;
 
@@ -0,0 +1,329 @@
+/**
+ * @file sparse.c
+ * @brief sparse matrix in CSR format and its operations
+ * 
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "sparse.h"
+
+#include <ctype.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util.h"
+
+SparseMatrix *sparse_create(const int n_rows, const int n_cols, const int capacity)
+{
+    if ((n_rows < 0) || (n_cols < 1) || (capacity < 0)) {
+        return NULL;
+    }
+
+    SparseMatrix *matrix = malloc(sizeof(SparseMatrix));
+    if (matrix == NULL) {
+        return NULL;
+    }
+
+    // arrays are allocated even if they are empty
+    *matrix = (SparseMatrix){
+        .n_rows   = n_rows,
+        .n_cols   = n_cols,
+        .nnz      = 0,
+        .row_ptr  = calloc((n_rows + 1), sizeof(int)),
+        .col_idx  = malloc(sizeof(int) * (capacity + 1)),
+        .values   = malloc(sizeof(float) * (capacity + 1)),
+        .capacity = capacity
+    };
+    if ((matrix->row_ptr == NULL) || (matrix->col_idx == NULL) || (matrix->values == NULL)) {
+        sparse_free(&matrix);
+        return NULL;
+    }
+
+    return matrix;
+}
+
+/**
+ * @brief grow array to hold at least a num of elements
+ * 
+ * @param[in,out] array target array, reallocated
+ * @param[in,out] capacity num of allocated elements
+ * @param[in] size num of elements to be held
+ * @param[in] element_size size of an element [byte]
+ * @return true if succeeded
+ */
+static bool grow(void **array, int *capacity, const int size, const size_t element_size)
+{
+    if (size <= *capacity) {
+        return true;
+    }
+    if (*capacity > (INT_MAX / 2)) {
+        return false;
+    }
+
+    int new_capacity = (*capacity > 0) ? (*capacity * 2) : 1024;
+    if (new_capacity < size) {
+        new_capacity = size;
+    }
+
+    void *p = realloc(*array, (element_size * new_capacity));
+    if (p == NULL) {
+        return false;
+    }
+    *array    = p;
+    *capacity = new_capacity;
+
+    return true;
+}
+
+/**
+ * @brief parse class label at the beginning of a line of libsvm format
+ * 
+ * @param[in] line line of text
+ * @param[out] end end of label in line
+ * @param[out] label class index
+ * @return true if the label is an integer of 0 or more, or -1
+ */
+static bool parse_label(const char *line, char **end, int *label)
+{
+    const double value = strtod(line, end);
+    if (*end == line) {
+        return false;
+    }
+
+    // range is checked before conversion to int, and NaN fails it
+    if (!((value >= -1) && (value < INT_MAX)) || (value != (int)value)) {
+        return false;
+    }
+
+    // binary labels of -1 and +1
+    *label = (value < 0) ? 0 : (int)value;
+
+    return true;
+}
+
+SparseMatrix *sparse_load_libsvm(const char *filename, const int n_features, int **labels)
+{
+    if ((filename == NULL) || (n_features < 0) || (labels == NULL)) {
+        return NULL;
+    }
+    *labels = NULL;
+
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    SparseMatrix *matrix = malloc(sizeof(SparseMatrix));
+    if (matrix == NULL) {
+        fclose(fp);
+        return NULL;
+    }
+    *matrix = (SparseMatrix){
+        .n_rows = 0, .n_cols = 0, .nnz = 0, .row_ptr = NULL, .col_idx = NULL, .values = NULL, .capacity = 0
+    };
+
+    int rows_capacity   = 0;
+    int labels_capacity = 0;
+    int max_index       = 0;
+
+    char *line = NULL;
+    size_t line_size = 0;
+
+    // row_ptr has a sentinel
+    if (!grow((void**)&matrix->row_ptr, &rows_capacity, 1, sizeof(int))) {
+        goto LOAD_FREE;
+    }
+    matrix->row_ptr[0] = 0;
+
+    while (getline(&line, &line_size, fp) >= 0) {
+        // comment
+        char *comment = strchr(line, '#');
+        if (comment != NULL) {
+            *comment = '\0';
+        }
+
+        char *p = line;
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (*p == '\0') {
+            continue;
+        }
+
+        int label;
+        if (!parse_label(p, &p, &label) || (matrix->n_rows == INT_MAX - 1)) {
+            goto LOAD_FREE;
+        }
+
+        int prev_index = 0;
+        while (true) {
+            while (isspace((unsigned char)*p)) {
+                p++;
+            }
+            if (*p == '\0') {
+                break;
+            }
+
+            // query ID is skipped
+            if (strncmp(p, "qid:", 4) == 0) {
+                char *end;
+                strtol((p + 4), &end, 10);
+                if ((end == (p + 4)) || ((*end != '\0') && !isspace((unsigned char)*end))) {
+                    goto LOAD_FREE;
+                }
+                p = end;
+                continue;
+            }
+
+            char *end;
+            const long index = strtol(p, &end, 10);
+            if ((end == p) || (*end != ':') || (index <= prev_index) || (index > INT_MAX) ||
+                ((n_features > 0) && (index > n_features))) {
+                goto LOAD_FREE;
+            }
+            p = end + 1;
+
+            const float value = strtof(p, &end);
+            if ((end == p) || ((*end != '\0') && !isspace((unsigned char)*end))) {
+                goto LOAD_FREE;
+            }
+            p = end;
+            prev_index = (int)index;
+
+            // explicit zeros are not stored
+            if (value == 0) {
+                continue;
+            }
+
+            if (matrix->nnz == matrix->capacity) {
+                int idx_capacity   = matrix->capacity;
+                int value_capacity = matrix->capacity;
+                if ((matrix->nnz == INT_MAX) ||
+                    !grow((void**)&matrix->col_idx, &idx_capacity, (matrix->nnz + 1), sizeof(int)) ||
+                    !grow((void**)&matrix->values, &value_capacity, (matrix->nnz + 1), sizeof(float))) {
+                    goto LOAD_FREE;
+                }
+                matrix->capacity = idx_capacity;
+            }
+
+            matrix->col_idx[matrix->nnz] = (int)index - 1;
+            matrix->values[matrix->nnz]  = value;
+            matrix->nnz++;
+        }
+        if (prev_index > max_index) {
+            max_index = prev_index;
+        }
+
+        if (!grow((void**)labels, &labels_capacity, (matrix->n_rows + 1), sizeof(int)) ||
+            !grow((void**)&matrix->row_ptr, &rows_capacity, (matrix->n_rows + 2), sizeof(int))) {
+            goto LOAD_FREE;
+        }
+        (*labels)[matrix->n_rows] = label;
+        matrix->n_rows++;
+        matrix->row_ptr[matrix->n_rows] = matrix->nnz;
+    }
+
+    matrix->n_cols = (n_features > 0) ? n_features : max_index;
+    if ((matrix->n_rows < 1) || (matrix->n_cols < 1) || ferror(fp)) {
+        goto LOAD_FREE;
+    }
+
+    FREE_WITH_NULL(&line);
+    fclose(fp);
+
+    return matrix;
+
+LOAD_FREE:
+    FREE_WITH_NULL(&line);
+    fclose(fp);
+    FREE_WITH_NULL(labels);
+    sparse_free(&matrix);
+
+    return NULL;
+}
+
+SparseMatrix sparse_row(const SparseMatrix *matrix, const int row)
+{
+    const int begin = matrix->row_ptr[row];
+
+    // offsets in row_ptr are absolute, arrays are shared
+    return (SparseMatrix){
+        .n_rows   = 1,
+        .n_cols   = matrix->n_cols,
+        .nnz      = matrix->row_ptr[row + 1] - begin,
+        .row_ptr  = &matrix->row_ptr[row],
+        .col_idx  = matrix->col_idx,
+        .values   = matrix->values,
+        .capacity = 0
+    };
+}
+
+float *sparse_to_dense(const SparseMatrix *matrix, float *dense)
+{
+    for (int i = 0; i < matrix->n_rows; i++) {
+        float *row = dense + (size_t)i * matrix->n_cols;
+        for (int j = 0; j < matrix->n_cols; j++) {
+            row[j] = 0;
+        }
+        for (int k = matrix->row_ptr[i]; k < matrix->row_ptr[i + 1]; k++) {
+            row[matrix->col_idx[k]] = matrix->values[k];
+        }
+    }
+
+    return dense;
+}
+
+float *sparse_mat_mul(const SparseMatrix *a, const float *b, float *c, const int p)
+{
+    for (int i = 0; i < a->n_rows; i++) {
+        float *ci = c + (size_t)i * p;
+        for (int j = 0; j < p; j++) {
+            ci[j] = 0;
+        }
+
+        // rows of B scaled by nonzeros
+        for (int k = a->row_ptr[i]; k < a->row_ptr[i + 1]; k++) {
+            const float aik = a->values[k];
+            const float *bk = b + (size_t)a->col_idx[k] * p;
+            for (int j = 0; j < p; j++) {
+                ci[j] += aik * bk[j];
+            }
+        }
+    }
+
+    return c;
+}
+
+float *sparse_mat_mul_trans_a_acc(const SparseMatrix *a, const float *b, float *c, const int p)
+{
+    for (int i = 0; i < a->n_rows; i++) {
+        const float *bi = b + (size_t)i * p;
+
+        // outer product of nonzeros of a row of A and a row of B
+        for (int k = a->row_ptr[i]; k < a->row_ptr[i + 1]; k++) {
+            const float aik = a->values[k];
+            float *ck = c + (size_t)a->col_idx[k] * p;
+            for (int j = 0; j < p; j++) {
+                ck[j] += aik * bi[j];
+            }
+        }
+    }
+
+    return c;
+}
+
+void sparse_free(SparseMatrix **matrix)
+{
+    if (*matrix == NULL) {
+        return;
+    }
+
+    FREE_WITH_NULL(&(*matrix)->row_ptr);
+    FREE_WITH_NULL(&(*matrix)->col_idx);
+    FREE_WITH_NULL(&(*matrix)->values);
+
+    FREE_WITH_NULL(matrix);
+}
@@ -0,0 +1,98 @@
+/**
+ * @file split.c
+ * @brief Split layer
+ * 
+ */
+#include "split.h"
+
+#include "data.h"
+
+/**
+ * @brief forward propagation of Split layer
+ * 
+ * @param self target layer
+ * @param x layer input
+ */
+static void forward(Layer *self, const float *x)
+{
+    self->x = x;
+
+    // output ports are the slices of y
+    fdata_copy(self->x, self->x_size, self->y);
+}
+
+/**
+ * @brief backward propagation of Split layer
+ * 
+ * @param self target layer
+ * @param dy diff of next layer, diffs of all ports are gathered
+ */
+static void backward(Layer *self, const float *dy)
+{
+    fdata_copy(dy, self->y_size, self->dx);
+}
+
+Layer *split_layer(const LayerParameter layer_param)
+{
+    if ((layer_param.in < 1) || (layer_param.n_out < 1) || (layer_param.n_out > LAYER_OUT_MAX)) {
+        return NULL;
+    }
+
+    int out = 0;
+    for (int i = 0; i < layer_param.n_out; i++) {
+        if (layer_param.outs[i] < 1) {
+            return NULL;
+        }
+        out += layer_param.outs[i];
+    }
+    if (out != layer_param.in) {
+        return NULL;
+    }
+
+    Layer *layer = layer_alloc();
+    if (layer == NULL) {
+        return NULL;
+    }
+
+    int x_size = 1 * layer_param.in * 1 * 1;
+    SET_DIM(layer->x_dim, 1, layer_param.in, 1, 1);
+    layer->x_size = x_size;
+
+    int y_size = 1 * layer_param.in * 1 * 1;
+    SET_DIM(layer->y_dim, 1, layer_param.in, 1, 1);
+    layer->y_size = y_size;
+
+    layer->y = fdata_alloc(y_size);
+    if (layer->y == NULL) {
+        goto LAYER_FREE;
+    }
+
+    layer->dx = fdata_alloc(x_size);
+    if (layer->dx == NULL) {
+        goto LAYER_FREE;
+    }
+
+    layer->xs_size[0] = x_size;
+    layer->dxs[0]     = layer->dx;
+
+    layer->n_ys = layer_param.n_out;
+    int offset = 0;
+    for (int i = 0; i < layer->n_ys; i++) {
+        layer->ys_offset[i] = offset;
+        layer->ys_size[i]   = layer_param.outs[i];
+        offset += layer_param.outs[i];
+    }
+
+    layer->type  = LAYER_TYPE_SPLIT;
+    layer->param = layer_param;
+
+    layer->forward  = forward;
+    layer->backward = backward;
+
+    return layer;
+
+LAYER_FREE:
+    layer_free(&layer);
+
+    return NULL;
+}
@@ -0,0 +1,498 @@
+/**
+ * @file stream.c
+ * @brief streaming reader of sharded IDX files with a bounded shuffle buffer
+ * 
+ */
+#define _GNU_SOURCE
+
+#include "stream.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "data.h"
+#include "idx.h"
+#include "random.h"
+#include "util.h"
+
+/**
+ * @brief map compressed file to be decoded by reader
+ * 
+ * @param[in,out] reader target reader
+ * @param[in] fd file descriptor of compressed file
+ * @return true if succeeded
+ */
+static bool reader_map(StreamReader *reader, const int fd)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return false;
+    }
+
+    reader->map_size = (size_t)st.st_size;
+    reader->map = mmap(NULL, reader->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (reader->map == MAP_FAILED) {
+        reader->map = NULL;
+        return false;
+    }
+    madvise(reader->map, reader->map_size, MADV_SEQUENTIAL);
+
+    reader->inflater = inflater_create(reader->map, reader->map_size);
+
+    return reader->inflater != NULL;
+}
+
+/**
+ * @brief open reader of a file from an offset
+ * 
+ * @param[in,out] reader target reader, its buffer is allocated
+ * @param[in] filename path to file
+ * @param[in] offset offset of the first byte to read [byte], in decoded bytes if compressed
+ * @param[in] direct open with O_DIRECT if supported
+ * @return true if succeeded
+ */
+static bool reader_open(StreamReader *reader, const char *filename, const size_t offset, const bool direct)
+{
+    reader->fd       = -1;
+    reader->begin    = 0;
+    reader->end      = 0;
+    reader->inflater = NULL;
+    reader->map      = NULL;
+    reader->map_size = 0;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    uint8_t magic[2];
+    if ((pread(fd, magic, sizeof(magic), 0) == (ssize_t)sizeof(magic)) && gzip_check(magic, sizeof(magic))) {
+        const bool mapped = reader_map(reader, fd);
+        close(fd);
+
+        // decoded bytes are skipped at the first read
+        reader->begin = offset;
+
+        return mapped;
+    }
+
+#ifdef O_DIRECT
+    if (direct) {
+        // some file systems reject O_DIRECT
+        const int direct_fd = open(filename, (O_RDONLY | O_DIRECT));
+        if (direct_fd >= 0) {
+            close(fd);
+            fd = direct_fd;
+        }
+    }
+#else
+    (void)direct;
+#endif
+    reader->fd = fd;
+
+    // reads start at aligned offsets
+    const size_t aligned = offset / STREAM_ALIGN * STREAM_ALIGN;
+    if (lseek(reader->fd, (off_t)aligned, SEEK_SET) < 0) {
+        close(reader->fd);
+        reader->fd = -1;
+        return false;
+    }
+    reader->begin = offset - aligned;
+
+    return true;
+}
+
+/**
+ * @brief close file of reader
+ * 
+ * @param[in,out] reader target reader
+ */
+static void reader_close(StreamReader *reader)
+{
+    if (reader->fd >= 0) {
+        close(reader->fd);
+    }
+    inflater_free(&reader->inflater);
+    if (reader->map != NULL) {
+        munmap(reader->map, reader->map_size);
+    }
+    reader->fd       = -1;
+    reader->begin    = 0;
+    reader->end      = 0;
+    reader->map      = NULL;
+    reader->map_size = 0;
+}
+
+/**
+ * @brief fill buffer of reader with the next bytes of the file
+ * 
+ * @param[in,out] reader target reader
+ * @param[in] read_size size of a read [byte]
+ * @return ssize_t num of bytes read, 0 at the end of file, -1 if failed
+ */
+static ssize_t reader_fill(StreamReader *reader, const size_t read_size)
+{
+    if (reader->inflater != NULL) {
+        size_t n_read;
+        if (inflater_read(reader->inflater, reader->buffer, read_size, &n_read) != 0) {
+            return -1;
+        }
+        return (ssize_t)n_read;
+    }
+
+    while (true) {
+        ssize_t n_read = read(reader->fd, reader->buffer, read_size);
+        if (n_read >= 0) {
+            return n_read;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+#ifdef O_DIRECT
+        // fall back to buffered reads, e.g. after a short read left the offset unaligned
+        int flags = fcntl(reader->fd, F_GETFL);
+        if ((errno == EINVAL) && (flags >= 0) && ((flags & O_DIRECT) != 0) &&
+            (fcntl(reader->fd, F_SETFL, (flags & ~O_DIRECT)) == 0)) {
+            continue;
+        }
+#endif
+        return -1;
+    }
+}
+
+/**
+ * @brief take the next bytes of the file
+ * 
+ * @param[in,out] reader target reader
+ * @param[in] read_size size of a read [byte]
+ * @param[in] size num of bytes to take
+ * @param[out] dest destination of bytes
+ * @return true if all bytes are taken
+ */
+static bool reader_take(StreamReader *reader, const size_t read_size, const size_t size, uint8_t *dest)
+{
+    size_t taken = 0;
+    while (taken < size) {
+        if (reader->begin >= reader->end) {
+            // skip of the first read is kept in begin
+            const size_t skip = (reader->end == 0) ? reader->begin : 0;
+
+            ssize_t n_read = reader_fill(reader, read_size);
+            if ((n_read <= 0) || ((size_t)n_read <= skip)) {
+                return false;
+            }
+            reader->begin = skip;
+            reader->end   = (size_t)n_read;
+        }
+
+        size_t n = reader->end - reader->begin;
+        if (n > (size - taken)) {
+            n = size - taken;
+        }
+        memcpy((dest + taken), (reader->buffer + reader->begin), n);
+
+        reader->begin += n;
+        taken += n;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get next pseudorandom number of stream by Xorshift
+ * 
+ * @param[in,out] stream target stream
+ * @return uint32_t pseudorandom number
+ */
+static uint32_t next_random(Stream *stream)
+{
+    uint32_t r = stream->random;
+    r ^= r << 13;
+    r ^= r >> 17;
+    r ^= r << 5;
+    stream->random = r;
+
+    return r;
+}
+
+/**
+ * @brief read the next sample of shards into a slot of shuffle buffer
+ * 
+ * @param[in,out] stream target stream
+ * @param[in] slot index of slot
+ * @return true if a sample is read, false at the end of epoch or failure of reading
+ */
+static bool read_sample(Stream *stream, const int slot)
+{
+    const size_t read_size = (size_t)stream->param.read_size;
+
+    while (stream->remaining == 0) {
+        reader_close(&stream->images);
+        reader_close(&stream->labels);
+
+        stream->shard++;
+        if (stream->shard >= stream->n_shards) {
+            stream->shard = stream->n_shards;
+            return false;
+        }
+
+        const int k = stream->order[stream->shard];
+        if (!reader_open(&stream->images, stream->image_files[k], stream->image_offsets[k], stream->param.direct) ||
+            !reader_open(&stream->labels, stream->label_files[k], stream->label_offsets[k], stream->param.direct)) {
+            reader_close(&stream->images);
+            reader_close(&stream->labels);
+            stream->shard  = stream->n_shards;
+            stream->failed = true;
+            return false;
+        }
+        stream->remaining = stream->shard_sizes[k];
+    }
+
+    if (!reader_take(&stream->images, read_size, stream->x_size, (stream->pool_x + (size_t)slot * stream->x_size)) ||
+        !reader_take(&stream->labels, read_size, 1, (stream->pool_t + slot)) ||
+        (stream->pool_t[slot] >= stream->n_classes)) {
+        // stop the epoch on failure
+        stream->remaining = 0;
+        stream->shard     = stream->n_shards;
+        stream->failed    = true;
+        reader_close(&stream->images);
+        reader_close(&stream->labels);
+        return false;
+    }
+    stream->remaining--;
+
+    return true;
+}
+
+Stream *stream_open(
+    const char **image_files,
+    const char **label_files,
+    const int n_shards,
+    const int n_classes,
+    const StreamParameter param)
+{
+    if ((image_files == NULL) || (label_files == NULL) || (n_shards < 1) || (n_classes < 1)) {
+        return NULL;
+    }
+    if ((param.shuffle_size < 0) || (param.read_size < 0)) {
+        return NULL;
+    }
+
+    Stream *stream = malloc(sizeof(Stream));
+    if (stream == NULL) {
+        return NULL;
+    }
+
+    *stream = (Stream){
+        .n_shards      = n_shards,
+        .image_files   = calloc(n_shards, sizeof(char*)),
+        .label_files   = calloc(n_shards, sizeof(char*)),
+        .shard_sizes   = malloc(sizeof(int) * n_shards),
+        .image_offsets = malloc(sizeof(size_t) * n_shards),
+        .label_offsets = malloc(sizeof(size_t) * n_shards),
+        .size          = 0,
+        .x_size        = 0,
+        .n_classes     = n_classes,
+        .param         = param,
+        .order         = malloc(sizeof(int) * n_shards),
+        .shard         = n_shards,
+        .remaining     = 0,
+        .images        = { .fd = -1, .buffer = NULL, .inflater = NULL, .map = NULL },
+        .labels        = { .fd = -1, .buffer = NULL, .inflater = NULL, .map = NULL },
+        .pool_x        = NULL,
+        .pool_t        = NULL,
+        .filled        = 0,
+        .random        = 1,
+        .failed        = false
+    };
+    if ((stream->image_files == NULL) || (stream->label_files == NULL) || (stream->shard_sizes == NULL) ||
+        (stream->image_offsets == NULL) || (stream->label_offsets == NULL) || (stream->order == NULL)) {
+        goto STREAM_FREE;
+    }
+
+    // defaults of parameters
+    if (stream->param.shuffle_size == 0) {
+        stream->param.shuffle_size = STREAM_SHUFFLE_SIZE;
+    }
+    if (stream->param.read_size == 0) {
+        stream->param.read_size = STREAM_READ_SIZE;
+    }
+    stream->param.read_size = (stream->param.read_size + STREAM_ALIGN - 1) / STREAM_ALIGN * STREAM_ALIGN;
+    if (stream->param.scale == 0) {
+        stream->param.scale = 1.0f / 255;
+    }
+
+    // validate headers of shards
+    for (int i = 0; i < n_shards; i++) {
+        IdxFile images, labels;
+        if ((idx_read_header(image_files[i], &images) != 0) || (idx_read_header(label_files[i], &labels) != 0)) {
+            goto STREAM_FREE;
+        }
+        if ((images.type != IDX_TYPE_UBYTE) || (labels.type != IDX_TYPE_UBYTE) ||
+            (labels.n_dims != 1) || (images.size != labels.size)) {
+            goto STREAM_FREE;
+        }
+        if ((i > 0) && (images.item_size != stream->x_size)) {
+            goto STREAM_FREE;
+        }
+        if (images.size > (INT32_MAX - stream->size)) {
+            goto STREAM_FREE;
+        }
+
+        stream->image_files[i] = strdup(image_files[i]);
+        stream->label_files[i] = strdup(label_files[i]);
+        if ((stream->image_files[i] == NULL) || (stream->label_files[i] == NULL)) {
+            goto STREAM_FREE;
+        }
+
+        stream->shard_sizes[i]   = images.size;
+        stream->image_offsets[i] = idx_header_size(&images);
+        stream->label_offsets[i] = idx_header_size(&labels);
+        stream->x_size           = images.item_size;
+        stream->size            += images.size;
+        stream->order[i]         = i;
+    }
+
+    // shuffle buffer is not larger than the dataset
+    if (stream->param.shuffle_size > stream->size) {
+        stream->param.shuffle_size = stream->size;
+    }
+
+    stream->images.buffer = aligned_alloc(STREAM_ALIGN, stream->param.read_size);
+    stream->labels.buffer = aligned_alloc(STREAM_ALIGN, stream->param.read_size);
+    stream->pool_x        = malloc((size_t)stream->param.shuffle_size * stream->x_size);
+    stream->pool_t        = malloc(stream->param.shuffle_size);
+    if ((stream->images.buffer == NULL) || (stream->labels.buffer == NULL) ||
+        (stream->pool_x == NULL) || (stream->pool_t == NULL)) {
+        goto STREAM_FREE;
+    }
+
+    return stream;
+
+STREAM_FREE:
+    stream_close(&stream);
+
+    return NULL;
+}
+
+void stream_rewind(Stream *stream)
+{
+    if (stream == NULL) {
+        return;
+    }
+
+    reader_close(&stream->images);
+    reader_close(&stream->labels);
+
+    for (int i = 0; i < stream->n_shards; i++) {
+        stream->order[i] = i;
+    }
+    if (stream->param.shuffle_size > 1) {
+        rand_shuffle(stream->order, stream->n_shards);
+    }
+
+    // samples are picked with a private PRNG in the loader thread, seeded here
+    stream->random = rand_xorshift() | 1;
+
+    // the first shard is opened at the first read
+    stream->shard     = -1;
+    stream->remaining = 0;
+    stream->filled    = 0;
+    stream->failed    = false;
+}
+
+int stream_read(Stream *stream, const int count, float *x, float *t, int *labels)
+{
+    if ((stream == NULL) || (x == NULL)) {
+        return 0;
+    }
+
+    const int x_size = stream->x_size;
+
+    int n = 0;
+    for (; n < count; n++) {
+        // fill shuffle buffer
+        while ((stream->filled < stream->param.shuffle_size) && read_sample(stream, stream->filled)) {
+            stream->filled++;
+        }
+        if (stream->filled == 0) {
+            break;
+        }
+
+        const int slot = (stream->filled > 1) ? (int)(next_random(stream) % stream->filled) : 0;
+
+        fdata_from_bytes(
+            (stream->pool_x + (size_t)slot * x_size), x_size, stream->param.scale, stream->param.offset,
+            (x + (size_t)n * x_size)
+        );
+
+        const int label = stream->pool_t[slot];
+        if (t != NULL) {
+            float *tn = t + (size_t)n * stream->n_classes;
+            memset(tn, 0, (sizeof(float) * stream->n_classes));
+            tn[label] = 1.0f;
+        }
+        if (labels != NULL) {
+            labels[n] = label;
+        }
+
+        // replace the taken sample with the next one, or with the last one at the end of epoch
+        if (!read_sample(stream, slot)) {
+            stream->filled--;
+            if (slot != stream->filled) {
+                memcpy(
+                    (stream->pool_x + (size_t)slot * x_size),
+                    (stream->pool_x + (size_t)stream->filled * x_size),
+                    x_size
+                );
+                stream->pool_t[slot] = stream->pool_t[stream->filled];
+            }
+        }
+    }
+
+    return n;
+}
+
+bool stream_failed(const Stream *stream)
+{
+    return (stream != NULL) && stream->failed;
+}
+
+void stream_close(Stream **stream)
+{
+    if (*stream == NULL) {
+        return;
+    }
+
+    reader_close(&(*stream)->images);
+    reader_close(&(*stream)->labels);
+
+    if ((*stream)->image_files != NULL) {
+        for (int i = 0; i < (*stream)->n_shards; i++) {
+            FREE_WITH_NULL(&(*stream)->image_files[i]);
+        }
+    }
+    if ((*stream)->label_files != NULL) {
+        for (int i = 0; i < (*stream)->n_shards; i++) {
+            FREE_WITH_NULL(&(*stream)->label_files[i]);
+        }
+    }
+    FREE_WITH_NULL(&(*stream)->image_files);
+    FREE_WITH_NULL(&(*stream)->label_files);
+    FREE_WITH_NULL(&(*stream)->shard_sizes);
+    FREE_WITH_NULL(&(*stream)->image_offsets);
+    FREE_WITH_NULL(&(*stream)->label_offsets);
+    FREE_WITH_NULL(&(*stream)->order);
+
+    FREE_WITH_NULL(&(*stream)->images.buffer);
+    FREE_WITH_NULL(&(*stream)->labels.buffer);
+    FREE_WITH_NULL(&(*stream)->pool_x);
+    FREE_WITH_NULL(&(*stream)->pool_t);
+
+    FREE_WITH_NULL(stream);
+}
@@ -0,0 +1,196 @@
+/**
+ * @file thread_pool.c
+ * @brief fixed-size pool of worker threads
+ * 
+ */
+#include "thread_pool.h"
+
+#include <stdlib.h>
+
+#include "trace.h"
+#include "util.h"
+
+// initial capacity of task queue
+#define QUEUE_INIT_CAPACITY 16
+
+/**
+ * @brief main loop of worker thread
+ * 
+ * @param[in,out] arg thread pool
+ * @return void* always NULL
+ */
+static void *worker(void *arg)
+{
+    ThreadPool *pool = (ThreadPool*)arg;
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (true) {
+        while ((pool->count == 0) && !pool->stop) {
+            pthread_cond_wait(&pool->ready, &pool->lock);
+        }
+        if (pool->count == 0) {
+            // stopped and no task left
+            break;
+        }
+
+        ThreadPoolTask task = pool->queue[pool->head];
+        pool->head = (pool->head + 1) % pool->capacity;
+        pool->count--;
+
+        pthread_mutex_unlock(&pool->lock);
+
+        TRACE_BEGIN(traced);
+        task.func(task.arg);
+        TRACE_END(TRACE_CATEGORY_TASK, "task", -1, traced);
+
+        pthread_mutex_lock(&pool->lock);
+
+        pool->pending--;
+        if (pool->pending == 0) {
+            pthread_cond_broadcast(&pool->done);
+        }
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+/**
+ * @brief double capacity of task queue
+ * @note need to be called with the lock held
+ * 
+ * @param[in,out] pool target thread pool
+ * @return true if succeeded
+ */
+static bool grow_queue(ThreadPool *pool)
+{
+    int capacity = pool->capacity * 2;
+
+    ThreadPoolTask *queue = malloc(sizeof(ThreadPoolTask) * capacity);
+    if (queue == NULL) {
+        return false;
+    }
+
+    // unwrap the ring buffer
+    for (int i = 0; i < pool->count; i++) {
+        queue[i] = pool->queue[(pool->head + i) % pool->capacity];
+    }
+
+    FREE_WITH_NULL(&pool->queue);
+
+    pool->queue    = queue;
+    pool->capacity = capacity;
+    pool->head     = 0;
+
+    return true;
+}
+
+ThreadPool *thread_pool_create(const int size)
+{
+    if (size < 1) {
+        return NULL;
+    }
+
+    ThreadPool *pool = malloc(sizeof(ThreadPool));
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    pool->size     = 0;
+    pool->capacity = QUEUE_INIT_CAPACITY;
+    pool->head     = 0;
+    pool->count    = 0;
+    pool->pending  = 0;
+    pool->stop     = false;
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->ready, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    pool->queue   = malloc(sizeof(ThreadPoolTask) * pool->capacity);
+    pool->threads = malloc(sizeof(pthread_t) * size);
+    if ((pool->queue == NULL) || (pool->threads == NULL)) {
+        goto POOL_FREE;
+    }
+
+    for (int i = 0; i < size; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker, pool) != 0) {
+            goto POOL_FREE;
+        }
+        pool->size++;
+    }
+
+    return pool;
+
+POOL_FREE:
+    thread_pool_free(&pool);
+
+    return NULL;
+}
+
+ThreadPool *thread_pool_submit(ThreadPool *pool, void (*func)(void *arg), void *arg)
+{
+    if ((pool == NULL) || (func == NULL)) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+
+    if ((pool->count == pool->capacity) && !grow_queue(pool)) {
+        pthread_mutex_unlock(&pool->lock);
+        return NULL;
+    }
+
+    int tail = (pool->head + pool->count) % pool->capacity;
+    pool->queue[tail] = (ThreadPoolTask){ .func = func, .arg = arg };
+    pool->count++;
+    pool->pending++;
+
+    pthread_cond_signal(&pool->ready);
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return pool;
+}
+
+void thread_pool_wait(ThreadPool *pool)
+{
+    if (pool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void thread_pool_free(ThreadPool **pool)
+{
+    if (*pool == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&(*pool)->lock);
+    (*pool)->stop = true;
+    pthread_cond_broadcast(&(*pool)->ready);
+    pthread_mutex_unlock(&(*pool)->lock);
+
+    for (int i = 0; i < (*pool)->size; i++) {
+        pthread_join((*pool)->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&(*pool)->lock);
+    pthread_cond_destroy(&(*pool)->ready);
+    pthread_cond_destroy(&(*pool)->done);
+
+    FREE_WITH_NULL(&(*pool)->queue);
+    FREE_WITH_NULL(&(*pool)->threads);
+
+    FREE_WITH_NULL(pool);
+}
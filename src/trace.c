@@ -0,0 +1,278 @@
+/**
+ * @file trace.c
+ * @brief event tracing in Chrome Trace Event format
+ * 
+ */
+#include "trace.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "profile.h"
+#include "util.h"
+
+/**
+ * @brief trace event
+ * 
+ */
+typedef struct TraceEvent {
+    const char *name;           //!< name of event
+    TraceCategory category;     //!< category of event
+    int    arg;                 //!< integer argument
+    double start;               //!< start time [s]
+    double end;                 //!< end time [s]
+} TraceEvent;
+
+/**
+ * @brief ring buffer of events owned by a thread
+ * @note only the owner thread writes events, so the buffer needs no lock
+ * 
+ */
+typedef struct TraceBuffer {
+    int tid;                        //!< thread id in the trace
+    int capacity;                   //!< num of event slots
+    TraceEvent *events;             //!< event slots
+    atomic_ulong head;              //!< num of events recorded so far
+    struct TraceBuffer *next;       //!< next buffer in the list
+} TraceBuffer;
+
+// list of buffers of all threads, pushed without lock
+static _Atomic(TraceBuffer*) buffers = NULL;
+
+// tracing is enabled
+static atomic_bool enabled = false;
+
+// generation of buffers, incremented when buffers are discarded
+static atomic_int generation = 0;
+
+// num of threads which have buffers in the current generation
+static atomic_int n_threads = 0;
+
+// event slots per thread
+static int buffer_capacity = 0;
+
+// origin of timestamps
+static double origin = 0;
+
+// output file of trace_dump()
+static char *output = NULL;
+
+// buffer of the calling thread and its generation
+static _Thread_local TraceBuffer *local_buffer = NULL;
+static _Thread_local int local_generation = -1;
+
+/**
+ * @brief get buffer of the calling thread, allocate and register it at the first call
+ * 
+ * @return TraceBuffer* buffer, NULL if failed
+ */
+static TraceBuffer *get_buffer(void)
+{
+    int gen = atomic_load_explicit(&generation, memory_order_acquire);
+    if ((local_buffer != NULL) && (local_generation == gen)) {
+        return local_buffer;
+    }
+
+    TraceBuffer *buffer = malloc(sizeof(TraceBuffer));
+    if (buffer == NULL) {
+        return NULL;
+    }
+    buffer->events = malloc(sizeof(TraceEvent) * buffer_capacity);
+    if (buffer->events == NULL) {
+        FREE_WITH_NULL(&buffer);
+        return NULL;
+    }
+
+    buffer->tid      = atomic_fetch_add(&n_threads, 1);
+    buffer->capacity = buffer_capacity;
+    atomic_init(&buffer->head, 0);
+
+    // push to the list
+    buffer->next = atomic_load(&buffers);
+    while (!atomic_compare_exchange_weak(&buffers, &buffer->next, buffer)) {
+        ;
+    }
+
+    local_buffer     = buffer;
+    local_generation = gen;
+
+    return buffer;
+}
+
+/**
+ * @brief deallocate all buffers
+ * 
+ */
+static void free_buffers(void)
+{
+    TraceBuffer *buffer = atomic_exchange(&buffers, NULL);
+    while (buffer != NULL) {
+        TraceBuffer *next = buffer->next;
+        FREE_WITH_NULL(&buffer->events);
+        FREE_WITH_NULL(&buffer);
+        buffer = next;
+    }
+
+    // invalidate buffers cached by threads
+    atomic_fetch_add_explicit(&generation, 1, memory_order_release);
+    atomic_store(&n_threads, 0);
+}
+
+int trace_enable(const char *filename, const int capacity)
+{
+    if (capacity < 1) {
+        return -1;
+    }
+
+    atomic_store(&enabled, false);
+
+    free_buffers();
+    FREE_WITH_NULL(&output);
+
+    if (filename != NULL) {
+        output = malloc(strlen(filename) + 1);
+        if (output == NULL) {
+            return -1;
+        }
+        strcpy(output, filename);
+    }
+
+    buffer_capacity = capacity;
+    origin          = profile_now();
+
+    atomic_store(&enabled, true);
+
+    return 0;
+}
+
+void trace_disable(void)
+{
+    atomic_store(&enabled, false);
+}
+
+double trace_now(void)
+{
+    if (!atomic_load_explicit(&enabled, memory_order_relaxed)) {
+        return 0;
+    }
+
+    return profile_now();
+}
+
+void trace_record(const TraceCategory category, const char *name, const int arg, const double start)
+{
+    if (!atomic_load_explicit(&enabled, memory_order_relaxed) || (start <= 0)) {
+        return;
+    }
+
+    double end = profile_now();
+
+    TraceBuffer *buffer = get_buffer();
+    if (buffer == NULL) {
+        return;
+    }
+
+    unsigned long head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+
+    buffer->events[head % buffer->capacity] = (TraceEvent){
+        .name     = name,
+        .category = category,
+        .arg      = arg,
+        .start    = start,
+        .end      = end
+    };
+
+    // publish the event to the writer
+    atomic_store_explicit(&buffer->head, (head + 1), memory_order_release);
+}
+
+const char *trace_category_name(const TraceCategory category)
+{
+    switch (category) {
+    case TRACE_CATEGORY_FORWARD:
+        return "forward";
+    case TRACE_CATEGORY_BACKWARD:
+        return "backward";
+    case TRACE_CATEGORY_OPTIMIZER:
+        return "optimizer";
+    case TRACE_CATEGORY_DATA:
+        return "data";
+    case TRACE_CATEGORY_TASK:
+        return "task";
+    case TRACE_CATEGORY_TRAIN:
+        return "train";
+    default:
+        return "unknown";
+    }
+}
+
+int trace_write(FILE *fp)
+{
+    if (fp == NULL) {
+        return -1;
+    }
+
+    int count = 0;
+
+    fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+
+    bool first = true;
+    for (TraceBuffer *buffer = atomic_load(&buffers); buffer != NULL; buffer = buffer->next) {
+        unsigned long head = atomic_load_explicit(&buffer->head, memory_order_acquire);
+
+        // the oldest events are overwritten if the buffer is wrapped around
+        unsigned long begin = (head > (unsigned long)buffer->capacity) ? (head - buffer->capacity) : 0;
+
+        fprintf(fp, "%s  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"thread %d\"}}",
+            (first ? "" : ",\n"), buffer->tid, buffer->tid);
+        first = false;
+
+        for (unsigned long i = begin; i < head; i++) {
+            const TraceEvent *event = &buffer->events[i % buffer->capacity];
+
+            fprintf(fp, ",\n  {\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %d",
+                event->name, trace_category_name(event->category),
+                ((event->start - origin) * 1e6), ((event->end - event->start) * 1e6), buffer->tid);
+            if (event->arg >= 0) {
+                fprintf(fp, ", \"args\": {\"id\": %d}", event->arg);
+            }
+            fprintf(fp, "}");
+
+            count++;
+        }
+    }
+
+    fprintf(fp, "\n]}\n");
+
+    return ferror(fp) ? -1 : count;
+}
+
+int trace_dump(void)
+{
+    if (output == NULL) {
+        return -1;
+    }
+
+    FILE *fp = fopen(output, "w");
+    if (fp == NULL) {
+        return -1;
+    }
+
+    int count = trace_write(fp);
+
+    if (fclose(fp) != 0) {
+        return -1;
+    }
+
+    return count;
+}
+
+void trace_free(void)
+{
+    atomic_store(&enabled, false);
+
+    free_buffers();
+    FREE_WITH_NULL(&output);
+}
@@ -5,96 +5,1510 @@
  */
 #include "trainer.h"
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "data.h"
+#include "loader.h"
+#include "loss.h"
 #include "util.h"
 #include "mat.h"
+#include "profile.h"
 #include "random.h"
+#include "trace.h"
 
 /**
- * @brief shuffle data indices with specified batch size for training
+ * @brief shuffle data indices for an epoch
+ * @note indices are shuffled block by block if block_size is set, uniformly otherwise
  * 
- * @param[in] indices array of indices
- * @param[out] shuffled array of shuffled indices
+ * @param[in,out] indices array of indices
  * @param[in] data_size num of training data
- * @param[in] batch_size training batch size
+ * @param[in] block_size num of successive data shuffled as a block, 0 to shuffle all uniformly
  */
-static void shuffle_indices(int *indices, const int data_size)
+static void shuffle_indices(int *indices, const int data_size, const int block_size)
 {
-    // swap randomly specified indices
-    // iterate with data size
-    for (int i = 0; i < data_size; i++) {
-        int idx0 = rand_xorshift() % data_size;
-        int idx1 = rand_xorshift() % data_size;
+    if ((block_size > 0) && (rand_block_shuffle(indices, data_size, block_size) == 0)) {
+        return;
+    }
+
+    rand_shuffle(indices, data_size);
+}
+
+/**
+ * @brief evaluate evenly spaced samples of dataset
+ * @note samples of a dataset backed by bytes are converted by TRAIN_EVAL_CHUNK samples
+ * 
+ * @param[in,out] evaluator evaluator of the target network
+ * @param[in] dataset dataset
+ * @param[in] n_samples num of samples to evaluate, not larger than size of dataset
+ * @param[in] offset offset of evaluated samples, less than size of dataset / n_samples
+ * @param[in] loss_func loss function
+ * @param[out] loss mean loss
+ * @param[out] accuracy ratio of samples whose top-1 class matches the label
+ * @return true if succeeded
+ */
+static bool evaluate(
+    Evaluator *evaluator,
+    const Dataset *dataset,
+    const int n_samples,
+    const int offset,
+    float (*loss_func)(const float*, const float*, const int),
+    float *loss,
+    float *accuracy)
+{
+    const bool in_memory = dataset_in_memory(dataset);
+    const int chunk = (in_memory || (n_samples < TRAIN_EVAL_CHUNK)) ? n_samples : TRAIN_EVAL_CHUNK;
+
+    bool succeeded = false;
+
+    int *indices = malloc(sizeof(int) * n_samples);
+    float **sample_x = malloc(sizeof(float*) * chunk);
+    float **sample_t = malloc(sizeof(float*) * chunk);
+    Dataset *staging = in_memory ? NULL : dataset_create(chunk, dataset->x_size, dataset->t_size);
+    if ((indices == NULL) || (sample_x == NULL) || (sample_t == NULL) || (!in_memory && (staging == NULL))) {
+        goto EVALUATE_FREE;
+    }
+
+    for (int j = 0; j < n_samples; j++) {
+        indices[j] = (int)((long)dataset->size * j / n_samples) + offset;
+    }
+
+    double sum_loss    = 0;
+    double sum_correct = 0;
+
+    for (int begin = 0; begin < n_samples; begin += chunk) {
+        const int count = ((n_samples - begin) < chunk) ? (n_samples - begin) : chunk;
+
+        if (in_memory) {
+            for (int j = 0; j < count; j++) {
+                sample_x[j] = dataset->xs[indices[begin + j]];
+                sample_t[j] = dataset->ts[indices[begin + j]];
+            }
+        } else {
+            dataset_gather(dataset, (indices + begin), count, staging->x, staging->t);
+        }
+
+        EvalResult *result = evaluator_run(
+            evaluator, (in_memory ? sample_x : staging->xs), (in_memory ? sample_t : staging->ts), count,
+            SET_EVAL_PARAM(.loss_func=loss_func)
+        );
+        if (result == NULL) {
+            goto EVALUATE_FREE;
+        }
+        sum_loss    += (double)result->loss * count;
+        sum_correct += (double)result->accuracy * count;
+        net_eval_result_free(&result);
+    }
+
+    *loss     = (float)(sum_loss / n_samples);
+    *accuracy = (float)(sum_correct / n_samples);
+
+    succeeded = true;
+
+EVALUATE_FREE:
+    FREE_WITH_NULL(&indices);
+    FREE_WITH_NULL(&sample_x);
+    FREE_WITH_NULL(&sample_t);
+    dataset_free(&staging);
+
+    return succeeded;
+}
+
+/**
+ * @brief print losses of an epoch
+ * @note replicas of the network are created at the first evaluation and kept in evaluator
+ * 
+ * @param[in] net target network
+ * @param[in,out] evaluator evaluator of the network, created if NULL and evaluation is needed
+ * @param[in] epoch index of epoch
+ * @param[in] running_loss sum of losses of forward outputs during the epoch
+ * @param[in] train_data_size num of training data
+ * @param[in] train_data training dataset, NULL to print running loss regardless of loss mode
+ * @param[in] test_data test dataset, not evaluated if it is empty
+ * @param[in] train_param training parameter
+ */
+static void print_loss(
+    const Net *net,
+    Evaluator **evaluator,
+    const int epoch,
+    const float running_loss,
+    const int train_data_size,
+    const Dataset *train_data,
+    const Dataset *test_data,
+    const TrainParameter *train_param)
+{
+    printf("epoch %d: ", (epoch + 1));
+
+    const TrainLossMode loss_mode = (train_data != NULL) ? train_param->loss_mode : TRAIN_LOSS_RUNNING;
+    const bool has_test = (test_data != NULL) && (test_data->size > 0);
+    if (((loss_mode != TRAIN_LOSS_RUNNING) || has_test) && (*evaluator == NULL)) {
+        const int n_threads = (train_param->eval_threads > 0) ? train_param->eval_threads : 1;
+        *evaluator = evaluator_create(net, n_threads);
+    }
+
+    // calculate training loss
+    float train_loss = NAN;
+    float accuracy   = NAN;
+    switch (loss_mode) {
+    case TRAIN_LOSS_SAMPLED: {
+        int n_samples = (train_param->loss_samples > 0) ? train_param->loss_samples : TRAIN_LOSS_SAMPLES;
+        if (n_samples > train_data_size) {
+            n_samples = train_data_size;
+        }
+        // shift samples in each epoch
+        const int offset = epoch % (train_data_size / n_samples);
+
+        evaluate(*evaluator, train_data, n_samples, offset, train_param->loss_func, &train_loss, &accuracy);
+        break;
+    }
+    case TRAIN_LOSS_FULL:
+        evaluate(*evaluator, train_data, train_data_size, 0, train_param->loss_func, &train_loss, &accuracy);
+        break;
+    default:
+        train_loss = running_loss / train_data_size;
+        break;
+    }
+
+    printf("training loss=%f", train_loss);
+
+    // evaluate test data
+    if (has_test) {
+        float test_loss;
+        if (evaluate(*evaluator, test_data, test_data->size, 0, train_param->loss_func, &test_loss, &accuracy)) {
+            printf(", test loss=%f, test accuracy=%f", test_loss, accuracy);
+        }
+    }
+}
+
+/**
+ * @brief get num of elements of network input
+ * 
+ * @param[in] net target network
+ * @return int num of elements
+ */
+static int input_size(const Net *net)
+{
+    int size = 0;
+    for (int i = 0; i < net->size; i++) {
+        const Layer *layer = net->layers[i];
+        for (int j = 0; j < layer->n_in; j++) {
+            if ((layer->in_ids[j] < 0) && (layer->xs_size[j] > size)) {
+                size = layer->xs_size[j];
+            }
+        }
+    }
+
+    return size;
+}
+
+/**
+ * @brief wrap arrays of samples and labels fitting network without copy
+ * 
+ * @param[in] net target network
+ * @param[in] x array of data, NULL if not given
+ * @param[in] t array of labels, NULL if not given
+ * @param[in] data_size num of data
+ * @return Dataset dataset referring to the arrays, empty if they are not given
+ */
+static Dataset wrap_data(const Net *net, float **x, float **t, const int data_size)
+{
+    const bool given = (x != NULL) && (t != NULL);
+
+    return dataset_wrap(x, t, (given ? data_size : 0), input_size(net), net->output_layer->y_size);
+}
+
+/**
+ * @brief get num of accumulated samples to update parameters after a sample
+ * 
+ * @param[in] j index of sample in epoch
+ * @param[in] data_size num of training data
+ * @param[in] accumulation num of samples accumulated per update
+ * @return int num of accumulated samples, 0 not to update
+ */
+static int update_count(const int j, const int data_size, const int accumulation)
+{
+    if ((((j + 1) % accumulation) == 0) || ((j + 1) == data_size)) {
+        return (j % accumulation) + 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief update parameters at the end of accumulation
+ * @note accumulated gradients are averaged and cleared at the update if count is larger than 1
+ * 
+ * @param[in,out] net target network
+ * @param[in,out] optimizer optimizer
+ * @param[in] count num of accumulated samples to update parameters, 0 not to update
+ * @param[in] j index of sample in epoch
+ */
+static void update_params(Net *net, Optimizer *optimizer, const int count, const int j)
+{
+    (void)j;    // used only for tracing
+
+    if (count < 1) {
+        return;
+    }
+
+    TRACE_BEGIN(update_start);
+    if (count > 1) {
+        net_scale_grad(net, (1.0f / count));
+    }
+    optimizer_step(optimizer, net);
+    if (net->layers[0]->accumulate) {
+        net_zero_grad(net);
+    }
+    TRACE_END(TRACE_CATEGORY_OPTIMIZER, optimizer_type_name(optimizer->param.type), j, update_start);
+}
+
+/**
+ * @brief train network with a sample, and update parameters at the end of accumulation
+ * 
+ * @param[in,out] net target network
+ * @param[in] x data
+ * @param[in] t label
+ * @param[in,out] optimizer optimizer
+ * @param[in] loss_func loss function
+ * @param[in] count num of accumulated samples to update parameters after the sample, 0 not to update
+ * @param[in] j index of sample in epoch
+ * @return float loss of forward output
+ */
+static float train_sample(
+    Net *net,
+    const float *x,
+    const float *t,
+    Optimizer *optimizer,
+    float (*loss_func)(const float*, const float*, const int),
+    const int count,
+    const int j)
+{
+    net_forward(net, x);
+    float loss = loss_func(net->output_layer->y, t, net->output_layer->y_size);
+
+    net_backward(net, t);
+
+    update_params(net, optimizer, count, j);
+
+    return loss;
+}
+
+/**
+ * @brief train network with a sample of class label, and update parameters at the end of accumulation
+ * 
+ * @param[in,out] net target network
+ * @param[in] x data
+ * @param[in] label class index of label
+ * @param[in,out] optimizer optimizer
+ * @param[in] loss_func loss function of class indices
+ * @param[in] count num of accumulated samples to update parameters after the sample, 0 not to update
+ * @param[in] j index of sample in epoch
+ * @return float loss of forward output
+ */
+static float train_label_sample(
+    Net *net,
+    const float *x,
+    const int label,
+    Optimizer *optimizer,
+    const LabelLossFunc loss_func,
+    const int count,
+    const int j)
+{
+    net_forward(net, x);
+    float loss = loss_func(net->output_layer->y, label, net->output_layer->y_size);
+
+    net_backward_label(net, label);
+
+    update_params(net, optimizer, count, j);
+
+    return loss;
+}
+
+int train(
+    Net *net,
+    float **train_x,
+    float **train_t,
+    float **test_x,
+    float **test_t,
+    const int train_data_size,
+    const int test_data_size,
+    const TrainParameter train_param)
+{
+    if ((net == NULL) || (train_x == NULL) || (train_t == NULL) || (train_data_size < 1)) {
+        return -1;
+    }
+
+    Dataset train_data = wrap_data(net, train_x, train_t, train_data_size);
+    Dataset test_data  = wrap_data(net, test_x, test_t, test_data_size);
+
+    return train_dataset(net, &train_data, ((test_data.size > 0) ? &test_data : NULL), train_param);
+}
+
+/**
+ * @brief context of a Hogwild worker
+ * 
+ */
+typedef struct HogwildWorker {
+    Net *replica;           //!< replica of network sharing parameters
+    Optimizer *optimizer;   //!< optimizer with private state
+    float **train_x;        //!< array of training data
+    float **train_t;        //!< array of training labels
+    const int *indices;     //!< shuffled indices of training data
+    int begin;              //!< start of the range of indices
+    int end;                //!< end of the range of indices
+    int accumulation;       //!< num of samples accumulated per update
+    float (*loss_func)(const float*, const float*, const int);  //!< loss function
+    float loss;             //!< sum of losses of forward outputs in current epoch
+} HogwildWorker;
+
+/**
+ * @brief train replica with a range of shuffled data, updating shared parameters without lock
+ * 
+ * @param[in,out] arg Hogwild worker
+ */
+static void hogwild_task(void *arg)
+{
+    HogwildWorker *worker = (HogwildWorker*)arg;
+    const int size = worker->end - worker->begin;
+
+    worker->loss = 0;
+    for (int j = worker->begin; j < worker->end; j++) {
+        int index = worker->indices[j];
+
+        worker->loss += train_sample(
+            worker->replica, worker->train_x[index], worker->train_t[index],
+            worker->optimizer, worker->loss_func,
+            update_count((j - worker->begin), size, worker->accumulation), j
+        );
+    }
+}
+
+int train_hogwild(
+    Net *net,
+    float **train_x,
+    float **train_t,
+    float **test_x,
+    float **test_t,
+    const int train_data_size,
+    const int test_data_size,
+    const TrainParameter train_param,
+    const int n_threads)
+{
+    if ((net == NULL) || (train_x == NULL) || (train_t == NULL) || (train_data_size < 1)) {
+        return -1;
+    }
+    if ((train_param.optimizer == NULL) || (train_param.loss_func == NULL) || (n_threads < 1)) {
+        return -1;
+    }
+
+    // datasets referring to the arrays for evaluation
+    Dataset train_data = wrap_data(net, train_x, train_t, train_data_size);
+    Dataset test_data  = wrap_data(net, test_x, test_t, test_data_size);
+
+    int ret = -1;
+
+    // replicas for evaluation are kept across epochs
+    Evaluator *evaluator = NULL;
+
+    int *indices = malloc(sizeof(int) * train_data_size);
+    HogwildWorker *workers = malloc(sizeof(HogwildWorker) * n_threads);
+    ThreadPool *pool = thread_pool_create(n_threads);
+    if ((indices == NULL) || (workers == NULL) || (pool == NULL)) {
+        FREE_WITH_NULL(&indices);
+        FREE_WITH_NULL(&workers);
+        thread_pool_free(&pool);
+        return -1;
+    }
+
+    for (int i = 0; i < train_data_size; i++) {
+        indices[i] = i;
+    }
+
+    int n_workers = 0;
+    for (; n_workers < n_threads; n_workers++) {
+        HogwildWorker *worker = &workers[n_workers];
+
+        worker->replica = net_replicate(net);
+        if (worker->replica == NULL) {
+            goto WORKERS_FREE;
+        }
+        worker->optimizer = optimizer_create(worker->replica, train_param.optimizer->param);
+        if (worker->optimizer == NULL) {
+            net_free(&worker->replica);
+            goto WORKERS_FREE;
+        }
+
+        // gradients of samples are accumulated in the replica
+        worker->accumulation = (train_param.accumulation > 0) ? train_param.accumulation : 1;
+        if (worker->accumulation > 1) {
+            net_set_accumulate(worker->replica, true);
+            net_zero_grad(worker->replica);
+        }
+
+        worker->train_x = train_x;
+        worker->train_t = train_t;
+        worker->indices = indices;
+        worker->begin   = (int)((long)train_data_size * n_workers / n_threads);
+        worker->end     = (int)((long)train_data_size * (n_workers + 1) / n_threads);
+
+        worker->loss_func = train_param.loss_func;
+        worker->loss      = 0;
+    }
+
+    for (int i = 0; i < train_param.epoch; i++) {
+        TRACE_BEGIN(epoch_start);
+
+        TRACE_BEGIN(shuffle_start);
+        shuffle_indices(indices, train_data_size, train_param.shuffle_block);
+        TRACE_END(TRACE_CATEGORY_DATA, "shuffle", i, shuffle_start);
+
+        const double start = profile_now();
+
+        for (int k = 0; k < n_workers; k++) {
+            if (thread_pool_submit(pool, hogwild_task, &workers[k]) == NULL) {
+                // run by the caller if the queue cannot grow
+                hogwild_task(&workers[k]);
+            }
+        }
+        thread_pool_wait(pool);
+
+        const double elapsed = profile_now() - start;
+
+        float running_loss = 0;
+        for (int k = 0; k < n_workers; k++) {
+            running_loss += workers[k].loss;
+        }
+
+        TRACE_END(TRACE_CATEGORY_TRAIN, "epoch", i, epoch_start);
+
+        TRACE_BEGIN(eval_start);
+        print_loss(net, &evaluator, i, running_loss, train_data.size, &train_data, &test_data, &train_param);
+        TRACE_END(TRACE_CATEGORY_TRAIN, "evaluate", i, eval_start);
+
+        printf(", %.1f samples/sec with %d threads\n", (train_data_size / elapsed), n_threads);
+    }
+
+    ret = 0;
+
+WORKERS_FREE:
+    for (int k = 0; k < n_workers; k++) {
+        optimizer_free(&workers[k].optimizer);
+        net_free(&workers[k].replica);
+    }
+    evaluator_free(&evaluator);
+
+    thread_pool_free(&pool);
+    FREE_WITH_NULL(&workers);
+    FREE_WITH_NULL(&indices);
+
+#ifdef NNC_TRACE
+    // write timeline of the training if a trace file is given
+    if (ret == 0) {
+        trace_dump();
+    }
+#endif
+
+    return ret;
+}
+
+// num of floats in a cache line, boundary of ranges reduced by threads
+#define REDUCE_ALIGN 16
+
+/**
+ * @brief context of a synchronous data-parallel worker
+ * 
+ */
+typedef struct SyncWorker {
+    Net *replica;           //!< replica of network sharing parameters
+    float *grad;            //!< private sum of gradients, weights and biases of each layer in ID order
+    int grad_size;          //!< num of elements of grad
+    float **train_x;        //!< array of training data
+    float **train_t;        //!< array of training labels
+    const int *indices;     //!< shuffled indices of training data
+    int begin;              //!< start of the range of indices in current micro-batch
+    int end;                //!< end of the range of indices in current micro-batch
+    bool first;             //!< current micro-batch is the first one of an update
+    bool last;              //!< current micro-batch is the last one of an update
+    float (*loss_func)(const float*, const float*, const int);  //!< loss function
+    float loss;             //!< sum of losses of forward outputs in current epoch
+} SyncWorker;
+
+/**
+ * @brief range of gradient elements reduced by a thread
+ * 
+ */
+typedef struct ReduceRange {
+    SyncWorker *workers;    //!< workers
+    int n_workers;          //!< num of workers
+    int begin;              //!< start of the range of elements
+    int end;                //!< end of the range of elements
+} ReduceRange;
+
+/**
+ * @brief get num of elements of parameters of network
+ * 
+ * @param[in] net target network
+ * @return int num of elements of weights and biases of all layers
+ */
+static int params_size(const Net *net)
+{
+    int size = 0;
+    for (int n = 0; n < net->size; n++) {
+        const Layer *layer = net->layers[n];
+        size += ((layer->w != NULL) ? layer->w_size : 0) + ((layer->b != NULL) ? layer->b_size : 0);
+    }
+
+    return size;
+}
+
+/**
+ * @brief set mean of summed gradients to diffs of parameters
+ * 
+ * @param[in,out] net target network
+ * @param[in] grad sum of gradients, weights and biases of each layer in ID order
+ * @param[in] count num of summed samples
+ */
+static void set_mean_gradient(Net *net, const float *grad, const int count)
+{
+    for (int n = 0; n < net->size; n++) {
+        Layer *layer = net->layers[n];
+        if (layer->w != NULL) {
+            for (int m = 0; m < layer->w_size; m++) {
+                layer->dw[m] = grad[m] / count;
+            }
+            layer->rows.sparse = false;
+            grad += layer->w_size;
+        }
+        if (layer->b != NULL) {
+            for (int m = 0; m < layer->b_size; m++) {
+                layer->db[m] = grad[m] / count;
+            }
+            grad += layer->b_size;
+        }
+    }
+}
+
+/**
+ * @brief accumulate gradients of a range of a micro-batch in replica,
+ *        and collect them into private buffer at the last micro-batch of an update
+ * @note the replica must accumulate gradients (see net_set_accumulate())
+ * 
+ * @param[in,out] arg synchronous data-parallel worker
+ */
+static void sync_gradient_task(void *arg)
+{
+    SyncWorker *worker = (SyncWorker*)arg;
+    Net *replica = worker->replica;
+
+    if (worker->first) {
+        net_zero_grad(replica);
+    }
+
+    for (int j = worker->begin; j < worker->end; j++) {
+        int index = worker->indices[j];
+
+        net_forward(replica, worker->train_x[index]);
+        worker->loss += worker->loss_func(replica->output_layer->y, worker->train_t[index], replica->output_layer->y_size);
+
+        net_backward(replica, worker->train_t[index]);
+    }
+
+    if (!worker->last) {
+        return;
+    }
+
+    float *grad = worker->grad;
+    for (int n = 0; n < replica->size; n++) {
+        const Layer *layer = replica->layers[n];
+        if (layer->w != NULL) {
+            fdata_copy(layer->dw, layer->w_size, grad);
+            grad += layer->w_size;
+        }
+        if (layer->b != NULL) {
+            fdata_copy(layer->db, layer->b_size, grad);
+            grad += layer->b_size;
+        }
+    }
+}
+
+/**
+ * @brief sum a range of private buffers into the buffer of the 1st worker with a binary tree
+ * @note the order of additions of each element depends only on the num of workers
+ * 
+ * @param[in,out] arg range of gradient elements
+ */
+static void reduce_task(void *arg)
+{
+    ReduceRange *range = (ReduceRange*)arg;
+    SyncWorker *workers = range->workers;
+    const int size = range->end - range->begin;
+
+    for (int stride = 1; stride < range->n_workers; stride *= 2) {
+        for (int k = 0; (k + stride) < range->n_workers; k += (2 * stride)) {
+            float *dst = workers[k].grad + range->begin;
+            const float *src = workers[k + stride].grad + range->begin;
+            mat_add(dst, src, dst, 1, size);
+        }
+    }
+}
+
+int train_data_parallel(
+    Net *net,
+    float **train_x,
+    float **train_t,
+    float **test_x,
+    float **test_t,
+    const int train_data_size,
+    const int test_data_size,
+    const TrainParameter train_param,
+    const int n_threads)
+{
+    if ((net == NULL) || (train_x == NULL) || (train_t == NULL) || (train_data_size < 1)) {
+        return -1;
+    }
+    if ((train_param.optimizer == NULL) || (train_param.loss_func == NULL) || (n_threads < 1)) {
+        return -1;
+    }
+    if (train_param.batch_size < 0) {
+        return -1;
+    }
+
+    const int batch_size   = (train_param.batch_size == 0) ? 1 : train_param.batch_size;
+    const int accumulation = (train_param.accumulation > 0) ? train_param.accumulation : 1;
+
+    // num of elements of gradients
+    const int grad_size = params_size(net);
+
+    // datasets referring to the arrays for evaluation
+    Dataset train_data = wrap_data(net, train_x, train_t, train_data_size);
+    Dataset test_data  = wrap_data(net, test_x, test_t, test_data_size);
+
+    int ret = -1;
+
+    // replicas for evaluation are kept across epochs
+    Evaluator *evaluator = NULL;
+
+    int *indices = malloc(sizeof(int) * train_data_size);
+    SyncWorker *workers = malloc(sizeof(SyncWorker) * n_threads);
+    ReduceRange *ranges = malloc(sizeof(ReduceRange) * n_threads);
+    ThreadPool *pool = thread_pool_create(n_threads);
+    if ((indices == NULL) || (workers == NULL) || (ranges == NULL) || (pool == NULL)) {
+        FREE_WITH_NULL(&indices);
+        FREE_WITH_NULL(&workers);
+        FREE_WITH_NULL(&ranges);
+        thread_pool_free(&pool);
+        return -1;
+    }
+
+    for (int i = 0; i < train_data_size; i++) {
+        indices[i] = i;
+    }
+
+    int n_workers = 0;
+    for (; n_workers < n_threads; n_workers++) {
+        SyncWorker *worker = &workers[n_workers];
+
+        worker->replica = net_replicate(net);
+        if (worker->replica == NULL) {
+            goto WORKERS_FREE;
+        }
+        net_set_accumulate(worker->replica, true);
+
+        worker->grad = fdata_alloc((grad_size > 0) ? grad_size : 1);
+        if (worker->grad == NULL) {
+            net_free(&worker->replica);
+            goto WORKERS_FREE;
+        }
+
+        worker->grad_size = grad_size;
+        worker->train_x   = train_x;
+        worker->train_t   = train_t;
+        worker->indices   = indices;
+        worker->loss_func = train_param.loss_func;
+        worker->loss      = 0;
+    }
+
+    // ranges of elements reduced by each thread, aligned to cache lines
+    const int chunk = ((grad_size / n_threads) + REDUCE_ALIGN - 1) / REDUCE_ALIGN * REDUCE_ALIGN;
+    for (int k = 0; k < n_threads; k++) {
+        int begin = k * chunk;
+        int end   = begin + chunk;
+        ranges[k] = (ReduceRange){
+            .workers   = workers,
+            .n_workers = n_workers,
+            .begin     = (begin < grad_size) ? begin : grad_size,
+            .end       = ((end < grad_size) && (k < (n_threads - 1))) ? end : grad_size
+        };
+    }
+
+    for (int i = 0; i < train_param.epoch; i++) {
+        TRACE_BEGIN(epoch_start);
+
+        TRACE_BEGIN(shuffle_start);
+        shuffle_indices(indices, train_data_size, train_param.shuffle_block);
+        TRACE_END(TRACE_CATEGORY_DATA, "shuffle", i, shuffle_start);
+
+        for (int k = 0; k < n_workers; k++) {
+            workers[k].loss = 0;
+        }
+
+        for (int j = 0; j < train_data_size;) {
+            const int start = j;
+
+            // gradients of each range of micro-batches are accumulated in replicas
+            for (int m = 0; (m < accumulation) && (j < train_data_size); m++) {
+                const int size = ((j + batch_size) <= train_data_size) ? batch_size : (train_data_size - j);
+
+                for (int k = 0; k < n_workers; k++) {
+                    workers[k].begin = j + (int)((long)size * k / n_workers);
+                    workers[k].end   = j + (int)((long)size * (k + 1) / n_workers);
+                    workers[k].first = (m == 0);
+                    workers[k].last  = ((m + 1) == accumulation) || ((j + size) == train_data_size);
+                    if (thread_pool_submit(pool, sync_gradient_task, &workers[k]) == NULL) {
+                        // run by the caller if the queue cannot grow
+                        sync_gradient_task(&workers[k]);
+                    }
+                }
+                thread_pool_wait(pool);
 
-        int tmp = indices[idx1];
-        indices[idx1] = indices[idx0];
-        indices[idx0] = tmp;
+                j += size;
+            }
+
+            for (int k = 0; k < n_threads; k++) {
+                if (thread_pool_submit(pool, reduce_task, &ranges[k]) == NULL) {
+                    // run by the caller if the queue cannot grow
+                    reduce_task(&ranges[k]);
+                }
+            }
+            thread_pool_wait(pool);
+
+            // mean gradient of the micro-batches
+            TRACE_BEGIN(update_start);
+            set_mean_gradient(net, workers[0].grad, (j - start));
+
+            optimizer_step(train_param.optimizer, net);
+            TRACE_END(TRACE_CATEGORY_OPTIMIZER, optimizer_type_name(train_param.optimizer->param.type), start, update_start);
+        }
+
+        // sum in the order of workers
+        float running_loss = 0;
+        for (int k = 0; k < n_workers; k++) {
+            running_loss += workers[k].loss;
+        }
+
+        TRACE_END(TRACE_CATEGORY_TRAIN, "epoch", i, epoch_start);
+
+        TRACE_BEGIN(eval_start);
+        print_loss(net, &evaluator, i, running_loss, train_data.size, &train_data, &test_data, &train_param);
+        TRACE_END(TRACE_CATEGORY_TRAIN, "evaluate", i, eval_start);
+
+        printf("\n");
+    }
+
+    ret = 0;
+
+WORKERS_FREE:
+    for (int k = 0; k < n_workers; k++) {
+        FREE_WITH_NULL(&workers[k].grad);
+        net_free(&workers[k].replica);
+    }
+    evaluator_free(&evaluator);
+
+    thread_pool_free(&pool);
+    FREE_WITH_NULL(&ranges);
+    FREE_WITH_NULL(&workers);
+    FREE_WITH_NULL(&indices);
+
+#ifdef NNC_TRACE
+    // write timeline of the training if a trace file is given
+    if (ret == 0) {
+        trace_dump();
     }
+#endif
+
+    return ret;
 }
 
-void train_sgd(
+/**
+ * @brief copy parameters of rank 0 to all processes so that all replicas start from the same values
+ * 
+ * @param[in,out] net target network
+ * @param[in,out] dist process group
+ * @param[out] buffer buffer of params_size() elements
+ * @return true if succeeded
+ */
+static bool broadcast_params(Net *net, Dist *dist, float *buffer)
+{
+    float *p = buffer;
+    for (int n = 0; n < net->size; n++) {
+        const Layer *layer = net->layers[n];
+        if (layer->w != NULL) {
+            fdata_copy(layer->w, layer->w_size, p);
+            p += layer->w_size;
+        }
+        if (layer->b != NULL) {
+            fdata_copy(layer->b, layer->b_size, p);
+            p += layer->b_size;
+        }
+    }
+
+    if (dist_broadcast(dist, buffer, params_size(net)) != 0) {
+        return false;
+    }
+
+    p = buffer;
+    for (int n = 0; n < net->size; n++) {
+        Layer *layer = net->layers[n];
+        if (layer->w != NULL) {
+            fdata_copy(p, layer->w_size, layer->w);
+            p += layer->w_size;
+        }
+        if (layer->b != NULL) {
+            fdata_copy(p, layer->b_size, layer->b);
+            p += layer->b_size;
+        }
+    }
+
+    return true;
+}
+
+int train_distributed(
     Net *net,
     float **train_x,
     float **train_t,
     float **test_x,
     float **test_t,
-    const float learning_rate,
-    const int epoch,
     const int train_data_size,
     const int test_data_size,
-    float (*loss_func)(const float*, const float*, const int))
+    const TrainParameter train_param,
+    Dist *dist)
 {
-    // indices of learning data
+    if ((net == NULL) || (train_x == NULL) || (train_t == NULL) || (train_data_size < 1)) {
+        return -1;
+    }
+    if ((train_param.optimizer == NULL) || (train_param.loss_func == NULL) || (dist == NULL)) {
+        return -1;
+    }
+    if (train_param.batch_size < 0) {
+        return -1;
+    }
+
+    const int batch_size   = (train_param.batch_size == 0) ? 1 : train_param.batch_size;
+    const int accumulation = (train_param.accumulation > 0) ? train_param.accumulation : 1;
+    const int grad_size    = params_size(net);
+
+    // datasets referring to the arrays for evaluation
+    Dataset train_data = wrap_data(net, train_x, train_t, train_data_size);
+    Dataset test_data  = wrap_data(net, test_x, test_t, test_data_size);
+
+    int ret = -1;
+
+    // replicas for evaluation are kept across epochs
+    Evaluator *evaluator = NULL;
+
     int *indices = malloc(sizeof(int) * train_data_size);
+    float *grad  = fdata_alloc((grad_size > 0) ? grad_size : 1);
+    if ((indices == NULL) || (grad == NULL)) {
+        goto TRAIN_FREE;
+    }
+
     for (int i = 0; i < train_data_size; i++) {
         indices[i] = i;
     }
 
+    if (!broadcast_params(net, dist, grad)) {
+        goto TRAIN_FREE;
+    }
+
+    // gradients of this process are computed with the network itself
+    SyncWorker worker = {
+        .replica   = net,
+        .grad      = grad,
+        .grad_size = grad_size,
+        .train_x   = train_x,
+        .train_t   = train_t,
+        .indices   = indices,
+        .loss_func = train_param.loss_func,
+        .loss      = 0
+    };
+
+    net_set_accumulate(net, true);
+
+    for (int i = 0; i < train_param.epoch; i++) {
+        TRACE_BEGIN(epoch_start);
+
+        // all processes shuffle in the same order with the same random state
+        TRACE_BEGIN(shuffle_start);
+        shuffle_indices(indices, train_data_size, train_param.shuffle_block);
+        TRACE_END(TRACE_CATEGORY_DATA, "shuffle", i, shuffle_start);
+
+        worker.loss = 0;
+
+        for (int j = 0; j < train_data_size;) {
+            const int start = j;
+
+            // gradients of the ranges of micro-batches of this process are accumulated in the network
+            for (int m = 0; (m < accumulation) && (j < train_data_size); m++) {
+                const int size = ((j + batch_size) <= train_data_size) ? batch_size : (train_data_size - j);
+
+                worker.begin = j + (int)((long)size * dist->rank / dist->world_size);
+                worker.end   = j + (int)((long)size * (dist->rank + 1) / dist->world_size);
+                worker.first = (m == 0);
+                worker.last  = ((m + 1) == accumulation) || ((j + size) == train_data_size);
+                sync_gradient_task(&worker);
+
+                j += size;
+            }
+
+            TRACE_BEGIN(reduce_start);
+            if (dist_allreduce(dist, grad, grad_size) != 0) {
+                goto TRAIN_FREE;
+            }
+            TRACE_END(TRACE_CATEGORY_OPTIMIZER, "allreduce", start, reduce_start);
+
+            TRACE_BEGIN(update_start);
+            set_mean_gradient(net, grad, (j - start));
+
+            optimizer_step(train_param.optimizer, net);
+            TRACE_END(TRACE_CATEGORY_OPTIMIZER, optimizer_type_name(train_param.optimizer->param.type), start, update_start);
+        }
+
+        TRACE_END(TRACE_CATEGORY_TRAIN, "epoch", i, epoch_start);
+
+        // losses of ranges of all processes
+        float running_loss = worker.loss;
+        if ((train_param.loss_mode == TRAIN_LOSS_RUNNING) && (dist_allreduce(dist, &running_loss, 1) != 0)) {
+            goto TRAIN_FREE;
+        }
+
+        if (dist->rank == 0) {
+            TRACE_BEGIN(eval_start);
+            print_loss(net, &evaluator, i, running_loss, train_data.size, &train_data, &test_data, &train_param);
+            TRACE_END(TRACE_CATEGORY_TRAIN, "evaluate", i, eval_start);
+
+            printf(" (%d processes)\n", dist->world_size);
+        }
+    }
+
+    ret = 0;
+
+TRAIN_FREE:
+    net_set_accumulate(net, false);
+
+    evaluator_free(&evaluator);
+    FREE_WITH_NULL(&grad);
+    FREE_WITH_NULL(&indices);
+
+#ifdef NNC_TRACE
+    // write timeline of the training if a trace file is given
+    if (ret == 0) {
+        trace_dump();
+    }
+#endif
+
+    return ret;
+}
+
+/**
+ * @brief take snapshot of the network and the optimizer after an epoch if it is due
+ * 
+ * @param[in] net target network
+ * @param[in] train_param training parameter
+ * @param[in] epoch index of epoch
+ * @return true if the snapshot is taken or not due
+ */
+static bool take_snapshot(const Net *net, const TrainParameter *train_param, const int epoch)
+{
+    if (train_param->checkpointer == NULL) {
+        return true;
+    }
+
+    const int interval = (train_param->checkpoint_interval > 0) ? train_param->checkpoint_interval : 1;
+    if ((((epoch + 1) % interval) != 0) && ((epoch + 1) != train_param->epoch)) {
+        return true;
+    }
+
+    TRACE_BEGIN(snapshot_start);
+    const int result = checkpointer_snapshot(train_param->checkpointer, net, train_param->optimizer);
+    TRACE_END(TRACE_CATEGORY_TRAIN, "snapshot", epoch, snapshot_start);
+
+    return (result == 0);
+}
+
+/**
+ * @brief check that dataset fits network
+ * @note class indices are checked here not to be expanded out of bounds when they are gathered
+ * 
+ * @param[in] net target network
+ * @param[in] dataset dataset, NULL is allowed if optional is true
+ * @param[in] optional dataset can be NULL
+ * @return true if fits
+ */
+static bool fits(const Net *net, const Dataset *dataset, const bool optional)
+{
+    if (dataset == NULL) {
+        return optional;
+    }
+
+    return (dataset->size > 0) &&
+           (dataset->x_size == input_size(net)) &&
+           (dataset->t_size == net->output_layer->y_size) &&
+           dataset_check_labels(dataset);
+}
+
+/**
+ * @brief train network with optimizer on training dataset or stream
+ * 
+ * @param[in,out] net target network
+ * @param[in] train_data training dataset, NULL if stream is given
+ * @param[in,out] stream training stream, NULL if train_data is given
+ * @param[in] test_data test dataset, NULL if not evaluated
+ * @param[in] train_param training parameter
+ * @return int 0 if succeeded, -1 if failed
+ */
+static int train_source(
+    Net *net,
+    const Dataset *train_data,
+    Stream *stream,
+    const Dataset *test_data,
+    const TrainParameter train_param)
+{
+    if ((train_param.optimizer == NULL) || (train_param.loss_func == NULL)) {
+        return -1;
+    }
+
+    if ((train_param.augmenter != NULL) && (train_param.augmenter->x_size != input_size(net))) {
+        return -1;
+    }
+
+    Optimizer *optimizer = train_param.optimizer;
+    const int train_data_size = (stream != NULL) ? stream->size : train_data->size;
+
+    // gradients of samples are accumulated in the network
+    const int accumulation = (train_param.accumulation > 0) ? train_param.accumulation : 1;
+    if (accumulation > 1) {
+        net_set_accumulate(net, true);
+        net_zero_grad(net);
+    }
+
+    // indices of learning data, a stream is shuffled by itself
+    int *indices = NULL;
+    if (stream == NULL) {
+        indices = malloc(sizeof(int) * train_data_size);
+        if (indices == NULL) {
+            net_set_accumulate(net, false);
+            return -1;
+        }
+        for (int i = 0; i < train_data_size; i++) {
+            indices[i] = i;
+        }
+    }
+
+    // loader gathering shuffled data into staging buffers,
+    // bytes and streams are always converted by the loader
+    const int x_size = input_size(net);
+    const int t_size = net->output_layer->y_size;
+
+    // class indices are given to the loss and the output layer without one-hot vectors
+    const bool class_labels = (stream != NULL) || dataset_has_class_labels(train_data);
+    const LabelLossFunc label_loss_func = class_labels ? loss_label_func(train_param.loss_func) : NULL;
+
+    int prefetch = train_param.prefetch;
+    if ((prefetch < 1) &&
+        ((stream != NULL) || !dataset_in_memory(train_data) || (label_loss_func != NULL) ||
+         (train_param.augmenter != NULL))) {
+        prefetch = 1;
+    }
+
+    Loader *loader = NULL;
+    if (prefetch > 0) {
+        const int batch_size = (train_param.batch_size > 0) ? train_param.batch_size : TRAIN_STAGING_SIZE;
+        if (stream != NULL) {
+            loader = loader_create_stream(stream, batch_size, prefetch, (label_loss_func != NULL));
+        } else {
+            loader = loader_create(train_data, batch_size, prefetch, (label_loss_func != NULL));
+        }
+        if (loader == NULL) {
+            FREE_WITH_NULL(&indices);
+            net_set_accumulate(net, false);
+            return -1;
+        }
+        loader_set_augmenter(loader, train_param.augmenter);
+    }
+
+    // snapshots are written while training continues
+    bool checkpointed = true;
+
+    // a stream stopped by a failure of reading is not trained further
+    bool read_failed = false;
+
+    // replicas for evaluation are kept across epochs
+    Evaluator *evaluator = NULL;
+
     // epoch
-    for (int i = 0; i < epoch; i++) {
-        shuffle_indices(indices, train_data_size);
+    for (int i = 0; i < train_param.epoch; i++) {
+        TRACE_BEGIN(epoch_start);
+
+        if (indices != NULL) {
+            TRACE_BEGIN(shuffle_start);
+            shuffle_indices(indices, train_data_size, train_param.shuffle_block);
+            TRACE_END(TRACE_CATEGORY_DATA, "shuffle", i, shuffle_start);
+        }
+
+        // losses of forward outputs during the epoch
+        float running_loss = 0;
 
         // training iteration
-        for (int j = 0; j < train_data_size; j++) {
-            int index = indices[j];
+        if (loader != NULL) {
+            loader_start(loader, indices);
 
-            net_forward(net, train_x[index]);
+            const LoaderBatch *batch;
+            int j = 0;
+            while ((batch = loader_next(loader)) != NULL) {
+                for (int k = 0; k < batch->size; k++, j++) {
+                    const int count = update_count(j, train_data_size, accumulation);
+                    if (batch->labels != NULL) {
+                        running_loss += train_label_sample(
+                            net, (batch->x + k * x_size), batch->labels[k], optimizer, label_loss_func, count, j
+                        );
+                    } else {
+                        running_loss += train_sample(
+                            net, (batch->x + k * x_size), (batch->t + k * t_size),
+                            optimizer, train_param.loss_func, count, j
+                        );
+                    }
+                }
+            }
 
-            net_backward(net, train_t[index]);
+            if (stream_failed(stream)) {
+                read_failed = true;
+                break;
+            }
+        } else {
+            for (int j = 0; j < train_data_size; j++) {
+                int index = indices[j];
 
-            // update network parameters
-            for (int n = 0; n < net->size; n++) {
-                Layer *layer = net->layers[n];
-                layer->update(layer, learning_rate);
+                running_loss += train_sample(
+                    net, train_data->xs[index], train_data->ts[index],
+                    optimizer, train_param.loss_func, update_count(j, train_data_size, accumulation), j
+                );
             }
         }
 
-        printf("epoch %d: ", (i + 1));
+        TRACE_END(TRACE_CATEGORY_TRAIN, "epoch", i, epoch_start);
 
-        // calculate training loss
-        float train_loss = 0;
-        for (int j = 0; j < train_data_size; j++) {
-            net_forward(net, train_x[j]);
-            train_loss += loss_func(net->output_layer->y, train_t[j], net->output_layer->y_size);
+        TRACE_BEGIN(eval_start);
+        print_loss(net, &evaluator, i, running_loss, train_data_size, train_data, test_data, &train_param);
+        TRACE_END(TRACE_CATEGORY_TRAIN, "evaluate", i, eval_start);
+
+        printf("\n");
+
+        checkpointed = take_snapshot(net, &train_param, i) && checkpointed;
+    }
+
+    evaluator_free(&evaluator);
+    loader_free(&loader);
+    FREE_WITH_NULL(&indices);
+
+    net_set_accumulate(net, false);
+
+    // the last checkpoint is on disk when training returns
+    if (train_param.checkpointer != NULL) {
+        checkpointed = (checkpointer_wait(train_param.checkpointer) == 0) && checkpointed;
+    }
+
+#ifdef NNC_TRACE
+    // write timeline of the training if a trace file is given
+    trace_dump();
+#endif
+
+    return (checkpointed && !read_failed) ? 0 : -1;
+}
+
+int train_dataset(Net *net, const Dataset *train_data, const Dataset *test_data, const TrainParameter train_param)
+{
+    if ((net == NULL) || !fits(net, train_data, false) || !fits(net, test_data, true)) {
+        return -1;
+    }
+
+    return train_source(net, train_data, NULL, test_data, train_param);
+}
+
+int train_stream(Net *net, Stream *stream, const Dataset *test_data, const TrainParameter train_param)
+{
+    if ((net == NULL) || (stream == NULL) || !fits(net, test_data, true)) {
+        return -1;
+    }
+    if ((stream->size < 1) || (stream->x_size != input_size(net)) ||
+        (stream->n_classes != net->output_layer->y_size)) {
+        return -1;
+    }
+
+    return train_source(net, NULL, stream, test_data, train_param);
+}
+
+/**
+ * @brief check that class labels of sparse samples match the network
+ * 
+ * @param[in] net target network
+ * @param[in] x sparse samples
+ * @param[in] labels class index of each sample
+ * @return true if num of columns and labels match the input and output of the network
+ */
+static bool fits_sparse(const Net *net, const SparseMatrix *x, const int *labels)
+{
+    if ((x == NULL) || (labels == NULL) || (x->n_rows < 1) || (x->n_cols != input_size(net))) {
+        return false;
+    }
+
+    for (int i = 0; i < x->n_rows; i++) {
+        if ((labels[i] < 0) || (labels[i] >= net->output_layer->y_size)) {
+            return false;
         }
-        train_loss /= train_data_size;
+    }
+
+    return true;
+}
 
-        printf("training loss=%f", train_loss);
+/**
+ * @brief evaluate network on sparse samples of class labels
+ * 
+ * @param[in,out] net target network
+ * @param[in] x sparse samples
+ * @param[in] labels class index of each sample
+ * @param[in] loss_func loss function of class indices
+ * @param[out] loss mean loss
+ * @param[out] accuracy ratio of samples whose top-1 class matches the label
+ */
+static void evaluate_sparse(
+    Net *net,
+    const SparseMatrix *x,
+    const int *labels,
+    const LabelLossFunc loss_func,
+    float *loss,
+    float *accuracy)
+{
+    const float *y = net->output_layer->y;
+    const int size = net->output_layer->y_size;
+
+    double sum_loss = 0;
+    int correct     = 0;
+    for (int i = 0; i < x->n_rows; i++) {
+        const SparseMatrix row = sparse_row(x, i);
+        net_forward_sparse(net, &row);
 
-        // calculate test loss
-        if ((test_x != NULL) && (test_t != NULL)) {
-            float test_loss = 0;
-            for (int j = 0; j < test_data_size; j++) {
-                net_forward(net, test_x[j]);
-                test_loss += loss_func(net->output_layer->y, test_t[j], net->output_layer->y_size);
+        sum_loss += loss_func(y, labels[i], size);
+
+        int predicted = 0;
+        for (int k = 1; k < size; k++) {
+            if (y[k] > y[predicted]) {
+                predicted = k;
             }
-            test_loss /= test_data_size;
+        }
+        if (predicted == labels[i]) {
+            correct++;
+        }
+    }
+
+    *loss     = (float)(sum_loss / x->n_rows);
+    *accuracy = (float)correct / x->n_rows;
+}
+
+int train_sparse(
+    Net *net,
+    const SparseMatrix *train_x,
+    const int *train_labels,
+    const SparseMatrix *test_x,
+    const int *test_labels,
+    const TrainParameter train_param)
+{
+    if ((net == NULL) || (train_param.optimizer == NULL) || (train_param.loss_func == NULL)) {
+        return -1;
+    }
+    if (!fits_sparse(net, train_x, train_labels) || ((test_x != NULL) && !fits_sparse(net, test_x, test_labels))) {
+        return -1;
+    }
+
+    const LabelLossFunc loss_func = loss_label_func(train_param.loss_func);
+    if (loss_func == NULL) {
+        return -1;
+    }
+
+    // layers taking input must accept sparse input
+    const SparseMatrix first = sparse_row(train_x, 0);
+    if (net_forward_sparse(net, &first) != 0) {
+        return -1;
+    }
+
+    const int train_data_size = train_x->n_rows;
+
+    int *indices = malloc(sizeof(int) * train_data_size);
+    if (indices == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < train_data_size; i++) {
+        indices[i] = i;
+    }
+
+    // gradients of samples are accumulated in the network
+    const int accumulation = (train_param.accumulation > 0) ? train_param.accumulation : 1;
+    if (accumulation > 1) {
+        net_set_accumulate(net, true);
+        net_zero_grad(net);
+    }
+
+    // snapshots are written while training continues
+    bool checkpointed = true;
+
+    // epoch
+    for (int i = 0; i < train_param.epoch; i++) {
+        TRACE_BEGIN(epoch_start);
+
+        shuffle_indices(indices, train_data_size, train_param.shuffle_block);
+
+        // losses of forward outputs during the epoch
+        float running_loss = 0;
+
+        for (int j = 0; j < train_data_size; j++) {
+            const int index = indices[j];
+            const SparseMatrix row = sparse_row(train_x, index);
+
+            net_forward_sparse(net, &row);
+            running_loss += loss_func(net->output_layer->y, train_labels[index], net->output_layer->y_size);
+
+            net_backward_label(net, train_labels[index]);
+
+            update_params(net, train_param.optimizer, update_count(j, train_data_size, accumulation), j);
+        }
+
+        TRACE_END(TRACE_CATEGORY_TRAIN, "epoch", i, epoch_start);
+
+        printf("epoch %d: training loss=%f", (i + 1), (running_loss / train_data_size));
+
+        if (test_x != NULL) {
+            float test_loss, accuracy;
+            evaluate_sparse(net, test_x, test_labels, loss_func, &test_loss, &accuracy);
+            printf(", test loss=%f, test accuracy=%f", test_loss, accuracy);
         }
 
         printf("\n");
+
+        checkpointed = take_snapshot(net, &train_param, i) && checkpointed;
     }
 
     FREE_WITH_NULL(&indices);
+
+    net_set_accumulate(net, false);
+
+    // the last checkpoint is on disk when training returns
+    if (train_param.checkpointer != NULL) {
+        checkpointed = (checkpointer_wait(train_param.checkpointer) == 0) && checkpointed;
+    }
+
+#ifdef NNC_TRACE
+    // write timeline of the training if a trace file is given
+    trace_dump();
+#endif
+
+    return checkpointed ? 0 : -1;
+}
+
+int train_hogwild_dataset(
+    Net *net,
+    const Dataset *train_data,
+    const Dataset *test_data,
+    const TrainParameter train_param,
+    const int n_threads)
+{
+    if ((net == NULL) || !fits(net, train_data, false) || !fits(net, test_data, true)) {
+        return -1;
+    }
+    if (!dataset_in_memory(train_data) || ((test_data != NULL) && !dataset_in_memory(test_data))) {
+        return -1;
+    }
+
+    return train_hogwild(
+        net,
+        train_data->xs, train_data->ts,
+        ((test_data != NULL) ? test_data->xs : NULL), ((test_data != NULL) ? test_data->ts : NULL),
+        train_data->size, ((test_data != NULL) ? test_data->size : 0),
+        train_param, n_threads
+    );
+}
+
+int train_data_parallel_dataset(
+    Net *net,
+    const Dataset *train_data,
+    const Dataset *test_data,
+    const TrainParameter train_param,
+    const int n_threads)
+{
+    if ((net == NULL) || !fits(net, train_data, false) || !fits(net, test_data, true)) {
+        return -1;
+    }
+    if (!dataset_in_memory(train_data) || ((test_data != NULL) && !dataset_in_memory(test_data))) {
+        return -1;
+    }
+
+    return train_data_parallel(
+        net,
+        train_data->xs, train_data->ts,
+        ((test_data != NULL) ? test_data->xs : NULL), ((test_data != NULL) ? test_data->ts : NULL),
+        train_data->size, ((test_data != NULL) ? test_data->size : 0),
+        train_param, n_threads
+    );
+}
+
+int train_distributed_dataset(
+    Net *net,
+    const Dataset *train_data,
+    const Dataset *test_data,
+    const TrainParameter train_param,
+    Dist *dist)
+{
+    if ((net == NULL) || !fits(net, train_data, false) || !fits(net, test_data, true)) {
+        return -1;
+    }
+    if (!dataset_in_memory(train_data) || ((test_data != NULL) && !dataset_in_memory(test_data))) {
+        return -1;
+    }
+
+    return train_distributed(
+        net,
+        train_data->xs, train_data->ts,
+        ((test_data != NULL) ? test_data->xs : NULL), ((test_data != NULL) ? test_data->ts : NULL),
+        train_data->size, ((test_data != NULL) ? test_data->size : 0),
+        train_param, dist
+    );
+}
+
+void train_sgd(
+    Net *net,
+    float **train_x,
+    float **train_t,
+    float **test_x,
+    float **test_t,
+    const float learning_rate,
+    const int epoch,
+    const int train_data_size,
+    const int test_data_size,
+    float (*loss_func)(const float*, const float*, const int))
+{
+    Optimizer *optimizer = optimizer_create(
+        net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_SGD, .learning_rate=learning_rate)
+    );
+    if (optimizer == NULL) {
+        return;
+    }
+
+    train(
+        net,
+        train_x, train_t,
+        test_x, test_t,
+        train_data_size, test_data_size,
+        SET_TRAIN_PARAM(.epoch=epoch, .optimizer=optimizer, .loss_func=loss_func, .prefetch=2)
+    );
+
+    optimizer_free(&optimizer);
 }
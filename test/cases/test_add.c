@@ -0,0 +1,86 @@
+/**
+ * @file test_add.c
+ * @brief unit tests of add.c
+ * 
+ */
+#include "add.h"
+
+#include "unity_fixture.h"
+
+TEST_GROUP(add);
+
+TEST_SETUP(add)
+{}
+
+TEST_TEAR_DOWN(add)
+{}
+
+TEST(add, add_layer_and_free)
+{
+    LayerParameter param = { .in = 10, .n_in = 3 };
+    Layer *add = add_layer(param);
+
+    TEST_ASSERT_NOT_NULL(add);
+
+    TEST_ASSERT_EQUAL_INT(param.in, add->x_size);
+    TEST_ASSERT_EQUAL_INT(param.in, add->y_size);
+    TEST_ASSERT_NOT_NULL(add->y);
+
+    TEST_ASSERT_NULL(add->w);
+    TEST_ASSERT_NULL(add->b);
+
+    TEST_ASSERT_NOT_NULL(add->dx);
+
+    TEST_ASSERT_EQUAL_INT(3, add->n_in);
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_INT(param.in, add->xs_size[i]);
+        TEST_ASSERT_EQUAL_PTR(add->dx, add->dxs[i]);
+    }
+
+    TEST_ASSERT_NOT_NULL(add->forward);
+    TEST_ASSERT_NOT_NULL(add->backward);
+
+    layer_free(&add);
+
+    TEST_ASSERT_NULL(add);
+}
+
+TEST(add, add_layer_invalid_param)
+{
+    TEST_ASSERT_NULL(add_layer((LayerParameter){ .in = 0, .n_in = 2 }));
+    TEST_ASSERT_NULL(add_layer((LayerParameter){ .in = 10, .n_in = 1 }));
+    TEST_ASSERT_NULL(add_layer((LayerParameter){ .in = 10, .n_in = (LAYER_IN_MAX + 1) }));
+}
+
+TEST(add, add_forward)
+{
+    Layer *add = add_layer((LayerParameter){ .in = 3, .n_in = 3 });
+
+    float x0[] = { 1, 2, 3 };
+    float x1[] = { 10, 20, 30 };
+    float x2[] = { -1, 0.5, 0 };
+    add->xs[0] = x0;
+    add->xs[1] = x1;
+    add->xs[2] = x2;
+
+    add->forward(add, x0);
+
+    float ans[] = { 10, 22.5, 33 };
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(ans, add->y, 3);
+
+    layer_free(&add);
+}
+
+TEST(add, add_backward)
+{
+    Layer *add = add_layer((LayerParameter){ .in = 3, .n_in = 2 });
+
+    float dy[] = { 0.1, -0.2, 0.3 };
+
+    add->backward(add, dy);
+
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(dy, add->dxs[0], 3);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(dy, add->dxs[1], 3);
+
+    layer_free(&add);
+}
@@ -0,0 +1,260 @@
+/**
+ * @file test_augment.c
+ * @brief unit tests of augment.c
+ * 
+ */
+#include "augment.h"
+
+#include <string.h>
+
+#include "unity_fixture.h"
+
+TEST_GROUP(augment);
+
+TEST_SETUP(augment)
+{}
+
+TEST_TEAR_DOWN(augment)
+{}
+
+// shape of samples used in tests, wider than a vector of 4 pixels with a tail
+#define N_CHANNELS 2
+#define HEIGHT 5
+#define WIDTH 7
+#define X_SIZE (N_CHANNELS * HEIGHT * WIDTH)
+#define N_DATA 8
+
+/**
+ * @brief fill samples with distinct pixels: 1000 * n + 100 * c + 10 * y + x
+ * 
+ * @param[out] x samples
+ */
+static void init_samples(float *x)
+{
+    for (int n = 0; n < N_DATA; n++) {
+        for (int c = 0; c < N_CHANNELS; c++) {
+            for (int y = 0; y < HEIGHT; y++) {
+                for (int x_ = 0; x_ < WIDTH; x_++) {
+                    x[((n * N_CHANNELS + c) * HEIGHT + y) * WIDTH + x_] = 1000 * n + 100 * c + 10 * y + x_;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief check if a sample is its source translated by a shift
+ * 
+ * @param[in] src source sample
+ * @param[in] dest augmented sample
+ * @param[in] dx shift along x
+ * @param[in] dy shift along y
+ * @param[in] fill value outside of source
+ * @return true if dest is translated src
+ */
+static bool is_shifted(const float *src, const float *dest, const int dx, const int dy, const float fill)
+{
+    for (int c = 0; c < N_CHANNELS; c++) {
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                const int sx = x - dx;
+                const int sy = y - dy;
+                const float expected = ((sx < 0) || (sx >= WIDTH) || (sy < 0) || (sy >= HEIGHT)) ?
+                    fill : src[(c * HEIGHT + sy) * WIDTH + sx];
+                if (dest[(c * HEIGHT + y) * WIDTH + x] != expected) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+TEST(augment, augmenter_create_and_free)
+{
+    Augmenter *augmenter = augmenter_create(
+        SET_AUGMENT_PARAM(.channels=N_CHANNELS, .height=HEIGHT, .width=WIDTH, .max_shift=2, .n_threads=3)
+    );
+
+    TEST_ASSERT_NOT_NULL(augmenter);
+    TEST_ASSERT_EQUAL_INT(X_SIZE, augmenter->x_size);
+    TEST_ASSERT_EQUAL_INT(3, augmenter->n_tasks);
+    TEST_ASSERT_NOT_NULL(augmenter->pool);
+
+    augmenter_free(&augmenter);
+
+    TEST_ASSERT_NULL(augmenter);
+
+    // a channel by default, augmented by the caller
+    augmenter = augmenter_create(SET_AUGMENT_PARAM(.height=HEIGHT, .width=WIDTH));
+
+    TEST_ASSERT_NOT_NULL(augmenter);
+    TEST_ASSERT_EQUAL_INT(HEIGHT * WIDTH, augmenter->x_size);
+    TEST_ASSERT_NULL(augmenter->pool);
+
+    augmenter_free(&augmenter);
+}
+
+TEST(augment, augmenter_create_invalid)
+{
+    TEST_ASSERT_NULL(augmenter_create(SET_AUGMENT_PARAM(.height=0, .width=WIDTH)));
+    TEST_ASSERT_NULL(augmenter_create(SET_AUGMENT_PARAM(.height=HEIGHT, .width=0)));
+    TEST_ASSERT_NULL(augmenter_create(SET_AUGMENT_PARAM(.channels=-1, .height=HEIGHT, .width=WIDTH)));
+    TEST_ASSERT_NULL(augmenter_create(SET_AUGMENT_PARAM(.height=HEIGHT, .width=WIDTH, .max_shift=-1)));
+    TEST_ASSERT_NULL(augmenter_create(SET_AUGMENT_PARAM(.height=HEIGHT, .width=WIDTH, .min_crop=1.5f)));
+    TEST_ASSERT_NULL(augmenter_create(SET_AUGMENT_PARAM(.height=HEIGHT, .width=WIDTH, .max_rotation=-1)));
+    TEST_ASSERT_NULL(augmenter_create(SET_AUGMENT_PARAM(.height=HEIGHT, .width=WIDTH, .n_threads=-1)));
+}
+
+TEST(augment, augment_identity)
+{
+    float src[N_DATA * X_SIZE];
+    float x[N_DATA * X_SIZE];
+    init_samples(src);
+    memcpy(x, src, sizeof(x));
+
+    Augmenter *augmenter = augmenter_create(
+        SET_AUGMENT_PARAM(.channels=N_CHANNELS, .height=HEIGHT, .width=WIDTH, .n_threads=2)
+    );
+    TEST_ASSERT_NOT_NULL(augmenter);
+
+    augment_batch(augmenter, x, N_DATA, 0, 0);
+
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(src, x, (N_DATA * X_SIZE));
+
+    augmenter_free(&augmenter);
+}
+
+TEST(augment, augment_shift)
+{
+    float src[N_DATA * X_SIZE];
+    float x[N_DATA * X_SIZE];
+    init_samples(src);
+    memcpy(x, src, sizeof(x));
+
+    Augmenter *augmenter = augmenter_create(
+        SET_AUGMENT_PARAM(.channels=N_CHANNELS, .height=HEIGHT, .width=WIDTH, .max_shift=2, .fill=-1, .seed=1)
+    );
+    TEST_ASSERT_NOT_NULL(augmenter);
+
+    augment_batch(augmenter, x, N_DATA, 0, 0);
+
+    // each sample is translated by integers within the range, exactly
+    int n_shifted = 0;
+    for (int n = 0; n < N_DATA; n++) {
+        bool found = false;
+        for (int dy = -2; (dy <= 2) && !found; dy++) {
+            for (int dx = -2; (dx <= 2) && !found; dx++) {
+                if (is_shifted(&src[n * X_SIZE], &x[n * X_SIZE], dx, dy, -1)) {
+                    found = true;
+                    n_shifted += ((dx != 0) || (dy != 0));
+                }
+            }
+        }
+        TEST_ASSERT_TRUE(found);
+    }
+    TEST_ASSERT_TRUE(n_shifted > 0);
+
+    augmenter_free(&augmenter);
+}
+
+TEST(augment, augment_flip)
+{
+    float src[N_DATA * X_SIZE];
+    float x[N_DATA * X_SIZE];
+    init_samples(src);
+    memcpy(x, src, sizeof(x));
+
+    Augmenter *augmenter = augmenter_create(
+        SET_AUGMENT_PARAM(.channels=N_CHANNELS, .height=HEIGHT, .width=WIDTH, .flip=true, .seed=1)
+    );
+    TEST_ASSERT_NOT_NULL(augmenter);
+
+    augment_batch(augmenter, x, N_DATA, 0, 0);
+
+    // each sample is kept or mirrored
+    int n_flipped = 0;
+    for (int n = 0; n < N_DATA; n++) {
+        const float *s = &src[n * X_SIZE];
+        const float *d = &x[n * X_SIZE];
+
+        bool kept    = true;
+        bool flipped = true;
+        for (int row = 0; row < (N_CHANNELS * HEIGHT); row++) {
+            for (int col = 0; col < WIDTH; col++) {
+                kept    &= (d[row * WIDTH + col] == s[row * WIDTH + col]);
+                flipped &= (d[row * WIDTH + col] == s[row * WIDTH + (WIDTH - 1 - col)]);
+            }
+        }
+        TEST_ASSERT_TRUE(kept || flipped);
+        n_flipped += flipped;
+    }
+    TEST_ASSERT_TRUE((n_flipped > 0) && (n_flipped < N_DATA));
+
+    augmenter_free(&augmenter);
+}
+
+TEST(augment, augment_rotation_and_crop)
+{
+    float src[N_DATA * X_SIZE];
+    float x[N_DATA * X_SIZE];
+    init_samples(src);
+    memcpy(x, src, sizeof(x));
+
+    Augmenter *augmenter = augmenter_create(
+        SET_AUGMENT_PARAM(
+            .channels=N_CHANNELS, .height=HEIGHT, .width=WIDTH, .min_crop=0.8f, .max_rotation=30, .seed=1
+        )
+    );
+    TEST_ASSERT_NOT_NULL(augmenter);
+
+    augment_batch(augmenter, x, N_DATA, 0, 0);
+
+    const int center = (HEIGHT / 2) * WIDTH + (WIDTH / 2);
+    for (int n = 0; n < N_DATA; n++) {
+        for (int c = 0; c < N_CHANNELS; c++) {
+            const float *s = &src[n * X_SIZE + c * HEIGHT * WIDTH];
+            const float *d = &x[n * X_SIZE + c * HEIGHT * WIDTH];
+
+            // rotated and scaled around the center
+            TEST_ASSERT_FLOAT_WITHIN(1e-3f, s[center], d[center]);
+        }
+    }
+    TEST_ASSERT_FALSE(memcmp(src, x, sizeof(x)) == 0);
+
+    augmenter_free(&augmenter);
+}
+
+TEST(augment, augment_reproducible)
+{
+    float x[3][N_DATA * X_SIZE];
+
+    AugmentParameter param = SET_AUGMENT_PARAM(
+        .channels=N_CHANNELS, .height=HEIGHT, .width=WIDTH,
+        .max_shift=1, .min_crop=0.9f, .max_rotation=10, .flip=true, .seed=42
+    );
+
+    // whole batch by the caller
+    Augmenter *augmenter = augmenter_create(param);
+    TEST_ASSERT_NOT_NULL(augmenter);
+    init_samples(x[0]);
+    augment_batch(augmenter, x[0], N_DATA, 3, 16);
+    augmenter_free(&augmenter);
+
+    // split into smaller batches by threads
+    param.n_threads = 3;
+    augmenter = augmenter_create(param);
+    TEST_ASSERT_NOT_NULL(augmenter);
+    init_samples(x[1]);
+    augment_batch(augmenter, x[1], 5, 3, 16);
+    augment_batch(augmenter, &x[1][5 * X_SIZE], (N_DATA - 5), 3, 21);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(x[0], x[1], (N_DATA * X_SIZE));
+
+    // another epoch differs
+    init_samples(x[2]);
+    augment_batch(augmenter, x[2], N_DATA, 4, 16);
+    TEST_ASSERT_FALSE(memcmp(x[0], x[2], sizeof(x[0])) == 0);
+
+    augmenter_free(&augmenter);
+}
@@ -0,0 +1,265 @@
+/**
+ * @file test_cache.c
+ * @brief unit tests of cache.c
+ * 
+ */
+#include "cache.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fixture.h"
+
+#include "unity_fixture.h"
+
+TEST_GROUP(cache);
+
+TEST_SETUP(cache)
+{}
+
+TEST_TEAR_DOWN(cache)
+{}
+
+#define CACHE_FILE "test_cache.bin"
+#define IMAGE_FILE "test_cache_images.idx"
+#define LABEL_FILE "test_cache_labels.idx"
+
+// 3 images of 2x2 pixels
+static const uint8_t IMAGES[] = {
+    0x00, 0x00, 0x08, 0x03,
+    0x00, 0x00, 0x00, 0x03,
+    0x00, 0x00, 0x00, 0x02,
+    0x00, 0x00, 0x00, 0x02,
+    0, 1, 2, 3,
+    4, 5, 6, 7,
+    8, 9, 10, 255
+};
+
+// 3 labels
+static const uint8_t LABELS[] = {
+    0x00, 0x00, 0x08, 0x01,
+    0x00, 0x00, 0x00, 0x03,
+    2, 0, 1
+};
+
+TEST(cache, cache_build_and_open)
+{
+    float *x[] = {
+        (float[4]){ 0.5f, 1, 2, 3 },
+        (float[4]){ 4, 5, 6, 7 },
+        (float[4]){ -8, 9, 10, 11 }
+    };
+    float *t[] = {
+        (float[2]){ 1, 0 },
+        (float[2]){ 0.25f, 0.75f },
+        (float[2]){ 0, 1 }
+    };
+
+    Dataset *src = dataset_from_arrays(x, t, 3, 4, 2);
+    TEST_ASSERT_NOT_NULL(src);
+
+    TEST_ASSERT_EQUAL_INT(0, dataset_cache_build(src, 2, (int[]){ 2, 2 }, CACHE_FILE));
+
+    CacheHeader header;
+    TEST_ASSERT_EQUAL_INT(0, dataset_cache_read_header(CACHE_FILE, &header));
+    TEST_ASSERT_EQUAL_INT(CACHE_VERSION, header.version);
+    TEST_ASSERT_EQUAL_INT(IDX_TYPE_FLOAT, header.x_type);
+    TEST_ASSERT_EQUAL_INT(IDX_TYPE_FLOAT, header.t_type);
+    TEST_ASSERT_EQUAL_INT(3, header.size);
+    TEST_ASSERT_EQUAL_INT(4, header.x_size);
+    TEST_ASSERT_EQUAL_INT(2, header.t_size);
+    TEST_ASSERT_EQUAL_INT(2, header.n_dims);
+    TEST_ASSERT_EQUAL_INT(2, header.dims[0]);
+    TEST_ASSERT_EQUAL_INT(2, header.dims[1]);
+    TEST_ASSERT_EQUAL_INT(0, (header.x_offset % 64));
+    TEST_ASSERT_EQUAL_INT(0, (header.t_offset % 64));
+
+    Dataset *dataset = dataset_cache_open(CACHE_FILE);
+    TEST_ASSERT_NOT_NULL(dataset);
+
+    TEST_ASSERT_EQUAL_INT(3, dataset->size);
+    TEST_ASSERT_EQUAL_INT(4, dataset->x_size);
+    TEST_ASSERT_EQUAL_INT(2, dataset->t_size);
+    TEST_ASSERT_TRUE(dataset_in_memory(dataset));
+    TEST_ASSERT_FALSE(dataset_has_class_labels(dataset));
+    TEST_ASSERT_EQUAL_INT(0, ((uintptr_t)dataset->x % 64));
+    TEST_ASSERT_EQUAL_INT(0, ((uintptr_t)dataset->t % 64));
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_FLOAT_ARRAY(x[i], dataset->xs[i], 4);
+        TEST_ASSERT_EQUAL_FLOAT_ARRAY(t[i], dataset->ts[i], 2);
+    }
+
+    dataset_free(&dataset);
+    TEST_ASSERT_NULL(dataset);
+
+    dataset_free(&src);
+
+    remove(CACHE_FILE);
+}
+
+TEST(cache, cache_class_labels)
+{
+    Dataset *src = dataset_create_bytes(3, 4, 3, 0.5f, -1.0f);
+    TEST_ASSERT_NOT_NULL(src);
+
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 4; j++) {
+            src->x_u8[i * 4 + j] = (uint8_t)(i * 4 + j);
+        }
+        src->t_u8[i] = (uint8_t)(2 - i);
+    }
+
+    // a sample of 1 dimension
+    TEST_ASSERT_EQUAL_INT(0, dataset_cache_build(src, 0, NULL, CACHE_FILE));
+
+    CacheHeader header;
+    TEST_ASSERT_EQUAL_INT(0, dataset_cache_read_header(CACHE_FILE, &header));
+    TEST_ASSERT_EQUAL_INT(IDX_TYPE_UBYTE, header.t_type);
+    TEST_ASSERT_EQUAL_INT(1, header.n_dims);
+    TEST_ASSERT_EQUAL_INT(4, header.dims[0]);
+
+    Dataset *dataset = dataset_cache_open(CACHE_FILE);
+    TEST_ASSERT_NOT_NULL(dataset);
+
+    // samples are normalized floats, labels stay class indices
+    TEST_ASSERT_TRUE(dataset_has_class_labels(dataset));
+    TEST_ASSERT_NULL(dataset->x_u8);
+    TEST_ASSERT_NOT_NULL(dataset->xs);
+    TEST_ASSERT_EQUAL_INT(3, dataset->t_size);
+
+    int indices[3] = { 2, 0, 1 };
+    float gathered_x[3 * 4];
+    float gathered_t[3 * 3];
+    float expected_x[3 * 4];
+    float expected_t[3 * 3];
+    dataset_gather(dataset, indices, 3, gathered_x, gathered_t);
+    dataset_gather(src, indices, 3, expected_x, expected_t);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(expected_x, gathered_x, (3 * 4));
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(expected_t, gathered_t, (3 * 3));
+
+    int labels[3];
+    dataset_gather_labels(dataset, indices, 3, labels);
+    TEST_ASSERT_EQUAL_INT_ARRAY(((int[]){ 0, 2, 1 }), labels, 3);
+
+    dataset_free(&dataset);
+    dataset_free(&src);
+
+    remove(CACHE_FILE);
+}
+
+TEST(cache, cache_build_invalid)
+{
+    Dataset *src = dataset_create(3, 4, 2);
+    TEST_ASSERT_NOT_NULL(src);
+
+    TEST_ASSERT_EQUAL_INT(-1, dataset_cache_build(NULL, 0, NULL, CACHE_FILE));
+    TEST_ASSERT_EQUAL_INT(-1, dataset_cache_build(src, 0, NULL, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, dataset_cache_build(src, 1, NULL, CACHE_FILE));
+
+    // shape mismatches to the size of a sample
+    TEST_ASSERT_EQUAL_INT(-1, dataset_cache_build(src, 2, (int[]){ 3, 2 }, CACHE_FILE));
+
+    // directory does not exist
+    TEST_ASSERT_EQUAL_INT(-1, dataset_cache_build(src, 0, NULL, "no_such_dir/test_cache.bin"));
+
+    dataset_free(&src);
+
+    FILE *fp = fopen(CACHE_FILE, "rb");
+    TEST_ASSERT_NULL(fp);
+}
+
+TEST(cache, cache_open_invalid)
+{
+    CacheHeader header;
+
+    TEST_ASSERT_NULL(dataset_cache_open(NULL));
+    TEST_ASSERT_NULL(dataset_cache_open("no_such_file.bin"));
+    TEST_ASSERT_EQUAL_INT(-1, dataset_cache_read_header("no_such_file.bin", &header));
+
+    // IDX file is not a cache
+    write_file(CACHE_FILE, IMAGES, sizeof(IMAGES));
+    TEST_ASSERT_NULL(dataset_cache_open(CACHE_FILE));
+
+    Dataset *src = dataset_create(3, 4, 2);
+    TEST_ASSERT_NOT_NULL(src);
+    TEST_ASSERT_EQUAL_INT(0, dataset_cache_build(src, 0, NULL, CACHE_FILE));
+    dataset_free(&src);
+
+    TEST_ASSERT_EQUAL_INT(0, dataset_cache_read_header(CACHE_FILE, &header));
+
+    // file with trailing bytes
+    FILE *fp = fopen(CACHE_FILE, "r+b");
+    TEST_ASSERT_NOT_NULL(fp);
+    const uint8_t trailing[] = { 0 };
+    fseek(fp, 0, SEEK_END);
+    fwrite(trailing, 1, 1, fp);
+    fclose(fp);
+    TEST_ASSERT_EQUAL_INT(-1, dataset_cache_read_header(CACHE_FILE, &header));
+
+    // label out of range of classes
+    src = dataset_create_bytes(3, 4, 3, 1.0f, 0.0f);
+    TEST_ASSERT_NOT_NULL(src);
+    memset(src->x_u8, 0, (3 * 4));
+    memset(src->t_u8, 0, 3);
+    TEST_ASSERT_EQUAL_INT(0, dataset_cache_build(src, 0, NULL, CACHE_FILE));
+    dataset_free(&src);
+    TEST_ASSERT_EQUAL_INT(0, dataset_cache_read_header(CACHE_FILE, &header));
+
+    fp = fopen(CACHE_FILE, "r+b");
+    TEST_ASSERT_NOT_NULL(fp);
+    const uint8_t label = 200;
+    fseek(fp, (long)(header.t_offset + 1), SEEK_SET);
+    fwrite(&label, 1, 1, fp);
+    fclose(fp);
+    TEST_ASSERT_EQUAL_INT(0, dataset_cache_read_header(CACHE_FILE, &header));
+    TEST_ASSERT_NULL(dataset_cache_open(CACHE_FILE));
+
+    // another version
+    header.version = CACHE_VERSION + 1;
+    write_file(CACHE_FILE, (const uint8_t*)&header, sizeof(header));
+    TEST_ASSERT_NULL(dataset_cache_open(CACHE_FILE));
+
+    remove(CACHE_FILE);
+}
+
+TEST(cache, cache_load)
+{
+    write_file(IMAGE_FILE, IMAGES, sizeof(IMAGES));
+    write_file(LABEL_FILE, LABELS, sizeof(LABELS));
+    remove(CACHE_FILE);
+
+    // built from IDX files at first
+    Dataset *dataset = dataset_cache_load(CACHE_FILE, IMAGE_FILE, LABEL_FILE, 3);
+    TEST_ASSERT_NOT_NULL(dataset);
+
+    CacheHeader header;
+    TEST_ASSERT_EQUAL_INT(0, dataset_cache_read_header(CACHE_FILE, &header));
+    TEST_ASSERT_EQUAL_INT(2, header.n_dims);
+    TEST_ASSERT_EQUAL_INT(2, header.dims[0]);
+    TEST_ASSERT_EQUAL_INT(2, header.dims[1]);
+
+    TEST_ASSERT_EQUAL_INT(3, dataset->size);
+    TEST_ASSERT_EQUAL_INT(4, dataset->x_size);
+    TEST_ASSERT_EQUAL_INT(3, dataset->t_size);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f / 255, dataset->xs[0][1]);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, dataset->xs[2][3]);
+    TEST_ASSERT_EQUAL_INT(2, dataset->t_u8[0]);
+
+    dataset_free(&dataset);
+
+    // the cache is used alone without IDX files
+    remove(IMAGE_FILE);
+    remove(LABEL_FILE);
+
+    dataset = dataset_cache_load(CACHE_FILE, IMAGE_FILE, LABEL_FILE, 3);
+    TEST_ASSERT_NOT_NULL(dataset);
+    TEST_ASSERT_EQUAL_FLOAT((10.0f / 255), dataset->xs[2][2]);
+    dataset_free(&dataset);
+
+    // a cache of another num of classes is rebuilt from the missing files
+    TEST_ASSERT_NULL(dataset_cache_load(CACHE_FILE, IMAGE_FILE, LABEL_FILE, 4));
+
+    remove(CACHE_FILE);
+}
@@ -0,0 +1,384 @@
+/**
+ * @file test_checkpoint.c
+ * @brief unit tests of checkpoint.c
+ * 
+ */
+#include "checkpoint.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "layers.h"
+#include "loss.h"
+#include "random.h"
+
+#include "unity_fixture.h"
+
+TEST_GROUP(checkpoint);
+
+TEST_SETUP(checkpoint)
+{}
+
+TEST_TEAR_DOWN(checkpoint)
+{}
+
+#define CHECKPOINT_FILE "test_checkpoint.bin"
+
+/**
+ * @brief create network with a skip connection and random parameters
+ * 
+ * @return Net* pointer to network
+ */
+static Net *create_net(void)
+{
+    Net *net = net_alloc();
+    net_append(net, fc_layer((LayerParameter){ .in=3, .out=5 }));         // 0
+    net_append(net, relu_layer((LayerParameter){ .in=5 }));               // 1
+    net_append(net, fc_layer((LayerParameter){ .in=5, .out=5 }));         // 2
+    net_connect(net, add_layer((LayerParameter){ .in=5, .n_in=2 }), 2, (int[]){ 2, 0 }, NULL); // 3
+    net_append(net, fc_layer((LayerParameter){ .in=5, .out=2 }));         // 4
+    net_append(net, softmax_layer((LayerParameter){ .in=2 }));            // 5
+
+    rand_seed(1);
+    net_init_layer_params(net);
+    for (int i = 0; i < net->size; i++) {
+        for (int j = 0; j < net->layers[i]->b_size; j++) {
+            net->layers[i]->b[j] = 0.1f * (j + 1);
+        }
+    }
+
+    return net;
+}
+
+/**
+ * @brief check that two networks have the same topology, parameters and outputs
+ * 
+ * @param[in] expected expected network
+ * @param[in,out] actual actual network
+ */
+static void check_same_net(Net *expected, Net *actual)
+{
+    TEST_ASSERT_EQUAL_INT(expected->size, actual->size);
+
+    for (int i = 0; i < expected->size; i++) {
+        const Layer *e = expected->layers[i];
+        const Layer *a = actual->layers[i];
+
+        TEST_ASSERT_EQUAL_INT(e->type, a->type);
+        TEST_ASSERT_EQUAL_INT(e->n_in, a->n_in);
+        TEST_ASSERT_EQUAL_INT_ARRAY(e->in_ids, a->in_ids, e->n_in);
+        TEST_ASSERT_EQUAL_INT(e->w_size, a->w_size);
+        TEST_ASSERT_EQUAL_INT(e->b_size, a->b_size);
+        if (e->w != NULL) {
+            TEST_ASSERT_EQUAL_MEMORY(e->w, a->w, (sizeof(float) * e->w_size));
+            TEST_ASSERT_EQUAL_MEMORY(e->b, a->b, (sizeof(float) * e->b_size));
+        }
+    }
+
+    const float x[] = { 0.5f, -1.0f, 2.0f };
+    net_forward(expected, x);
+    net_forward(actual, x);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(expected->output_layer->y, actual->output_layer->y, 2);
+}
+
+TEST(checkpoint, net_save_and_load)
+{
+    Net *net = create_net();
+
+    TEST_ASSERT_EQUAL_INT(0, net_save(net, CHECKPOINT_FILE));
+
+    Net *loaded = net_load(CHECKPOINT_FILE);
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT_NULL(loaded->map);
+    check_same_net(net, loaded);
+
+    // parameters are copied and trainable
+    loaded->layers[0]->w[0] += 1.0f;
+    TEST_ASSERT_FALSE(net->layers[0]->w[0] == loaded->layers[0]->w[0]);
+
+    net_free(&loaded);
+
+    // fused layers, the first FC feeds the skip connection and is not fused
+    TEST_ASSERT_EQUAL_INT(1, net_optimize(net));
+    TEST_ASSERT_EQUAL_INT(0, net_save(net, CHECKPOINT_FILE));
+
+    loaded = net_load(CHECKPOINT_FILE);
+    TEST_ASSERT_NOT_NULL(loaded);
+    TEST_ASSERT_EQUAL_INT(LAYER_TYPE_FC, loaded->layers[0]->type);
+    TEST_ASSERT_EQUAL_INT(LAYER_TYPE_FC_SOFTMAX, loaded->output_layer->type);
+    check_same_net(net, loaded);
+
+    net_free(&loaded);
+    net_free(&net);
+
+    remove(CHECKPOINT_FILE);
+}
+
+TEST(checkpoint, net_load_mmap)
+{
+    Net *net = create_net();
+
+    TEST_ASSERT_EQUAL_INT(0, net_save(net, CHECKPOINT_FILE));
+
+    Net *mapped = net_load_mmap(CHECKPOINT_FILE);
+    TEST_ASSERT_NOT_NULL(mapped);
+    TEST_ASSERT_NOT_NULL(mapped->map);
+    check_same_net(net, mapped);
+
+    // parameters point into the mapping at aligned offsets
+    const uint8_t *begin = mapped->map;
+    const uint8_t *end   = begin + mapped->map_size;
+    for (int i = 0; i < mapped->size; i++) {
+        const Layer *layer = mapped->layers[i];
+        if (layer->w == NULL) {
+            continue;
+        }
+        TEST_ASSERT_TRUE(((const uint8_t*)layer->w >= begin) && ((const uint8_t*)(layer->w + layer->w_size) <= end));
+        TEST_ASSERT_TRUE(((const uint8_t*)layer->b >= begin) && ((const uint8_t*)(layer->b + layer->b_size) <= end));
+        TEST_ASSERT_EQUAL_INT(0, ((uintptr_t)layer->w % CHECKPOINT_ALIGN));
+        TEST_ASSERT_EQUAL_INT(0, ((uintptr_t)layer->b % CHECKPOINT_ALIGN));
+    }
+
+    // the mapping is kept after the file is removed
+    remove(CHECKPOINT_FILE);
+    check_same_net(net, mapped);
+
+    net_free(&mapped);
+    TEST_ASSERT_NULL(mapped);
+
+    net_free(&net);
+}
+
+/**
+ * @brief update network with optimizer by a sample
+ * 
+ * @param[in,out] net target network
+ * @param[in,out] optimizer optimizer of the network
+ * @param[in] k index of sample
+ */
+static void train_step(Net *net, Optimizer *optimizer, const int k)
+{
+    const float x[] = { 0.1f * k, -0.5f, 1.0f };
+    net_forward(net, x);
+    net_backward_label(net, (k % 2));
+    optimizer_step(optimizer, net);
+}
+
+TEST(checkpoint, net_save_with_optimizer)
+{
+    const OptimizerType types[] = {
+        OPTIMIZER_TYPE_SGD, OPTIMIZER_TYPE_MOMENTUM, OPTIMIZER_TYPE_NESTEROV, OPTIMIZER_TYPE_ADAM, OPTIMIZER_TYPE_ADAMW
+    };
+
+    for (size_t i = 0; i < (sizeof(types) / sizeof(types[0])); i++) {
+        Net *net = create_net();
+        Optimizer *optimizer = optimizer_create(net, SET_OPTIMIZER_PARAM(.type=types[i], .learning_rate=0.01));
+        for (int k = 0; k < 3; k++) {
+            train_step(net, optimizer, k);
+        }
+
+        TEST_ASSERT_EQUAL_INT(0, net_save_with_optimizer(net, optimizer, CHECKPOINT_FILE));
+
+        Net *resumed = net_load(CHECKPOINT_FILE);
+        TEST_ASSERT_NOT_NULL(resumed);
+        Optimizer *resumed_optimizer = optimizer_load(resumed, CHECKPOINT_FILE);
+        TEST_ASSERT_NOT_NULL(resumed_optimizer);
+        TEST_ASSERT_EQUAL_INT(types[i], resumed_optimizer->param.type);
+        TEST_ASSERT_EQUAL_INT(3, resumed_optimizer->step);
+
+        // resumed training is bit-identical
+        for (int k = 3; k < 6; k++) {
+            train_step(net, optimizer, k);
+            train_step(resumed, resumed_optimizer, k);
+        }
+        check_same_net(net, resumed);
+
+        optimizer_free(&resumed_optimizer);
+        optimizer_free(&optimizer);
+        net_free(&resumed);
+        net_free(&net);
+    }
+
+    remove(CHECKPOINT_FILE);
+}
+
+TEST(checkpoint, optimizer_load_invalid)
+{
+    Net *net = create_net();
+
+    TEST_ASSERT_NULL(optimizer_load(NULL, CHECKPOINT_FILE));
+    TEST_ASSERT_NULL(optimizer_load(net, NULL));
+    TEST_ASSERT_NULL(optimizer_load(net, "no_such_file.bin"));
+
+    // written without optimizer
+    TEST_ASSERT_EQUAL_INT(0, net_save(net, CHECKPOINT_FILE));
+    TEST_ASSERT_NULL(optimizer_load(net, CHECKPOINT_FILE));
+
+    // optimizer of another network
+    Optimizer *optimizer = optimizer_create(net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_ADAM, .learning_rate=0.01));
+    Net *other = net_alloc();
+    net_append(other, fc_layer((LayerParameter){ .in=3, .out=2 }));
+    TEST_ASSERT_EQUAL_INT(-1, net_save_with_optimizer(other, optimizer, CHECKPOINT_FILE));
+
+    // network of another topology
+    TEST_ASSERT_EQUAL_INT(0, net_save_with_optimizer(net, optimizer, CHECKPOINT_FILE));
+    TEST_ASSERT_NULL(optimizer_load(other, CHECKPOINT_FILE));
+
+    Net *resized = net_alloc();
+    net_append(resized, fc_layer((LayerParameter){ .in=3, .out=4 }));
+    net_append(resized, relu_layer((LayerParameter){ .in=4 }));
+    net_append(resized, fc_layer((LayerParameter){ .in=4, .out=5 }));
+    net_connect(resized, add_layer((LayerParameter){ .in=5, .n_in=2 }), 2, (int[]){ 2, 2 }, NULL);
+    net_append(resized, fc_layer((LayerParameter){ .in=5, .out=2 }));
+    net_append(resized, softmax_layer((LayerParameter){ .in=2 }));
+    TEST_ASSERT_NULL(optimizer_load(resized, CHECKPOINT_FILE));
+
+    optimizer_free(&optimizer);
+    net_free(&resized);
+    net_free(&other);
+    net_free(&net);
+
+    remove(CHECKPOINT_FILE);
+}
+
+TEST(checkpoint, checkpointer_snapshot)
+{
+    TEST_ASSERT_NULL(checkpointer_create(NULL));
+
+    Checkpointer *checkpointer = checkpointer_create(CHECKPOINT_FILE);
+    TEST_ASSERT_NOT_NULL(checkpointer);
+
+    Net *net = create_net();
+    Optimizer *optimizer = optimizer_create(net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_ADAM, .learning_rate=0.01));
+    train_step(net, optimizer, 0);
+
+    TEST_ASSERT_EQUAL_INT(-1, checkpointer_snapshot(NULL, net, optimizer));
+    TEST_ASSERT_EQUAL_INT(-1, checkpointer_snapshot(checkpointer, NULL, optimizer));
+
+    // copy of the network at the snapshot
+    TEST_ASSERT_EQUAL_INT(0, net_save(net, "test_checkpoint_expected.bin"));
+    Net *expected = net_load("test_checkpoint_expected.bin");
+    TEST_ASSERT_NOT_NULL(expected);
+    remove("test_checkpoint_expected.bin");
+
+    // training continues while the snapshot is written
+    TEST_ASSERT_EQUAL_INT(0, checkpointer_snapshot(checkpointer, net, optimizer));
+    train_step(net, optimizer, 1);
+    TEST_ASSERT_EQUAL_INT(0, checkpointer_wait(checkpointer));
+    TEST_ASSERT_EQUAL_INT(1, checkpointer->written);
+
+    Net *loaded = net_load(CHECKPOINT_FILE);
+    TEST_ASSERT_NOT_NULL(loaded);
+    check_same_net(expected, loaded);
+    Optimizer *loaded_optimizer = optimizer_load(loaded, CHECKPOINT_FILE);
+    TEST_ASSERT_NOT_NULL(loaded_optimizer);
+    TEST_ASSERT_EQUAL_INT(1, loaded_optimizer->step);
+    optimizer_free(&loaded_optimizer);
+    net_free(&loaded);
+
+    // successive snapshots replace the checkpoint, the last one is written at deallocation
+    TEST_ASSERT_EQUAL_INT(0, checkpointer_snapshot(checkpointer, net, optimizer));
+    train_step(net, optimizer, 2);
+    TEST_ASSERT_EQUAL_INT(0, checkpointer_snapshot(checkpointer, net, optimizer));
+    checkpointer_free(&checkpointer);
+    TEST_ASSERT_NULL(checkpointer);
+
+    loaded = net_load(CHECKPOINT_FILE);
+    TEST_ASSERT_NOT_NULL(loaded);
+    check_same_net(net, loaded);
+    loaded_optimizer = optimizer_load(loaded, CHECKPOINT_FILE);
+    TEST_ASSERT_NOT_NULL(loaded_optimizer);
+    TEST_ASSERT_EQUAL_INT(3, loaded_optimizer->step);
+
+    // failed write is reported once
+    checkpointer = checkpointer_create("no_such_dir/test_checkpoint.bin");
+    TEST_ASSERT_EQUAL_INT(0, checkpointer_snapshot(checkpointer, net, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, checkpointer_wait(checkpointer));
+    TEST_ASSERT_EQUAL_INT(0, checkpointer_wait(checkpointer));
+    TEST_ASSERT_EQUAL_INT(0, checkpointer->written);
+    checkpointer_free(&checkpointer);
+
+    optimizer_free(&loaded_optimizer);
+    optimizer_free(&optimizer);
+    net_free(&loaded);
+    net_free(&expected);
+    net_free(&net);
+
+    remove(CHECKPOINT_FILE);
+}
+
+TEST(checkpoint, net_save_invalid)
+{
+    TEST_ASSERT_EQUAL_INT(-1, net_save(NULL, CHECKPOINT_FILE));
+
+    Net *net = create_net();
+    TEST_ASSERT_EQUAL_INT(-1, net_save(net, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, net_save(net, "no_such_dir/test_checkpoint.bin"));
+    net_free(&net);
+
+    // custom layer
+    net = net_alloc();
+    Layer *layer = layer_alloc();
+    layer->xs_size[0] = 0;
+    TEST_ASSERT_NOT_NULL(net_append(net, layer));
+    TEST_ASSERT_EQUAL_INT(-1, net_save(net, CHECKPOINT_FILE));
+    net_free(&net);
+
+    FILE *fp = fopen(CHECKPOINT_FILE, "rb");
+    TEST_ASSERT_NULL(fp);
+}
+
+TEST(checkpoint, net_load_invalid)
+{
+    TEST_ASSERT_NULL(net_load(NULL));
+    TEST_ASSERT_NULL(net_load("no_such_file.bin"));
+    TEST_ASSERT_NULL(net_load_mmap("no_such_file.bin"));
+
+    Net *net = create_net();
+    TEST_ASSERT_EQUAL_INT(0, net_save(net, CHECKPOINT_FILE));
+    net_free(&net);
+
+    FILE *fp = fopen(CHECKPOINT_FILE, "rb");
+    TEST_ASSERT_NOT_NULL(fp);
+    uint8_t bytes[4096];
+    const size_t size = fread(bytes, 1, sizeof(bytes), fp);
+    fclose(fp);
+    TEST_ASSERT_TRUE(size < sizeof(bytes));
+
+    const struct {
+        size_t offset;  // offset of modified value
+        uint32_t value; // value to be written
+        size_t size;    // size of file after modification
+    } corruptions[] = {
+        // another version
+        { offsetof(CheckpointHeader, version), (CHECKPOINT_VERSION + 1), size },
+        // truncated
+        { 0, 0, (size - 1) },
+        // unknown layer type
+        { (sizeof(CheckpointHeader) + offsetof(CheckpointLayer, type)), 1000, size },
+        // num of weights mismatches to the layer parameter
+        { (sizeof(CheckpointHeader) + offsetof(CheckpointLayer, w_size)), 16, size },
+        // connected to a following layer
+        { (sizeof(CheckpointHeader) + sizeof(CheckpointLayer) + offsetof(CheckpointLayer, in_ids)), 3, size }
+    };
+
+    for (size_t i = 0; i < (sizeof(corruptions) / sizeof(corruptions[0])); i++) {
+        uint8_t corrupted[sizeof(bytes)];
+        memcpy(corrupted, bytes, size);
+        if (corruptions[i].size == size) {
+            memcpy(&corrupted[corruptions[i].offset], &corruptions[i].value, sizeof(uint32_t));
+        }
+
+        fp = fopen(CHECKPOINT_FILE, "wb");
+        TEST_ASSERT_NOT_NULL(fp);
+        TEST_ASSERT_EQUAL_INT(corruptions[i].size, fwrite(corrupted, 1, corruptions[i].size, fp));
+        fclose(fp);
+
+        TEST_ASSERT_NULL(net_load(CHECKPOINT_FILE));
+        TEST_ASSERT_NULL(net_load_mmap(CHECKPOINT_FILE));
+    }
+
+    remove(CHECKPOINT_FILE);
+}
@@ -0,0 +1,82 @@
+/**
+ * @file test_concat.c
+ * @brief unit tests of concat.c
+ * 
+ */
+#include "concat.h"
+
+#include "unity_fixture.h"
+
+TEST_GROUP(concat);
+
+TEST_SETUP(concat)
+{}
+
+TEST_TEAR_DOWN(concat)
+{}
+
+TEST(concat, concat_layer_and_free)
+{
+    LayerParameter param = { .n_in = 2, .ins = { 3, 5 } };
+    Layer *concat = concat_layer(param);
+
+    TEST_ASSERT_NOT_NULL(concat);
+
+    TEST_ASSERT_EQUAL_INT(8, concat->x_size);
+    TEST_ASSERT_EQUAL_INT(8, concat->y_size);
+    TEST_ASSERT_NOT_NULL(concat->y);
+
+    TEST_ASSERT_NULL(concat->w);
+    TEST_ASSERT_NULL(concat->b);
+
+    TEST_ASSERT_NOT_NULL(concat->dx);
+
+    TEST_ASSERT_EQUAL_INT(2, concat->n_in);
+    TEST_ASSERT_EQUAL_INT(3, concat->xs_size[0]);
+    TEST_ASSERT_EQUAL_INT(5, concat->xs_size[1]);
+    TEST_ASSERT_EQUAL_PTR(concat->dx, concat->dxs[0]);
+    TEST_ASSERT_EQUAL_PTR((concat->dx + 3), concat->dxs[1]);
+
+    layer_free(&concat);
+
+    TEST_ASSERT_NULL(concat);
+}
+
+TEST(concat, concat_layer_invalid_param)
+{
+    TEST_ASSERT_NULL(concat_layer((LayerParameter){ .n_in = 0 }));
+    TEST_ASSERT_NULL(concat_layer((LayerParameter){ .n_in = 2, .ins = { 3, 0 } }));
+}
+
+TEST(concat, concat_forward)
+{
+    Layer *concat = concat_layer((LayerParameter){ .n_in = 3, .ins = { 1, 2, 3 } });
+
+    float x0[] = { 1 };
+    float x1[] = { 2, 3 };
+    float x2[] = { 4, 5, 6 };
+    concat->xs[0] = x0;
+    concat->xs[1] = x1;
+    concat->xs[2] = x2;
+
+    concat->forward(concat, x0);
+
+    float ans[] = { 1, 2, 3, 4, 5, 6 };
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(ans, concat->y, 6);
+
+    layer_free(&concat);
+}
+
+TEST(concat, concat_backward)
+{
+    Layer *concat = concat_layer((LayerParameter){ .n_in = 2, .ins = { 1, 2 } });
+
+    float dy[] = { 0.1, -0.2, 0.3 };
+
+    concat->backward(concat, dy);
+
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(&dy[0], concat->dxs[0], 1);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(&dy[1], concat->dxs[1], 2);
+
+    layer_free(&concat);
+}
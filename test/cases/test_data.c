@@ -4,6 +4,9 @@
  * 
  */
 #include "data.h"
+
+#include <stdint.h>
+
 #include "util.h"
 #include "random.h"
 
@@ -35,6 +38,24 @@ TEST(data, fdata_alloc)
     TEST_ASSERT_NULL(f);
 }
 
+TEST(data, fdata_alloc_aligned)
+{
+    // size is not a multiple of alignment
+    float *f = fdata_alloc_aligned(10);
+    TEST_ASSERT_NOT_NULL(f);
+
+    TEST_ASSERT_EQUAL_INT(0, ((uintptr_t)f % DATA_ALIGN));
+
+    for (int i = 0; i < 10; i++) {
+        f[i] = i;
+    }
+    TEST_ASSERT_EQUAL_FLOAT(9, f[9]);
+
+    FREE_WITH_NULL(&f);
+
+    TEST_ASSERT_NULL(f);
+}
+
 TEST(data, fdata_copy)
 {
     float d1[10];
@@ -49,6 +70,31 @@ TEST(data, fdata_copy)
     TEST_ASSERT_EQUAL_FLOAT_ARRAY(d2, d1, 10);
 }
 
+TEST(data, fdata_from_bytes)
+{
+    // vectorized part and the rest
+    uint8_t src[37];
+    for (int i = 0; i < 37; i++) {
+        src[i] = (uint8_t)(i * 7);
+    }
+
+    float dest[37];
+    fdata_from_bytes(src, 37, 0.5f, -1.0f, dest);
+
+    for (int i = 0; i < 37; i++) {
+        TEST_ASSERT_EQUAL_FLOAT((src[i] * 0.5f - 1.0f), dest[i]);
+    }
+
+    // full range of bytes
+    const uint8_t ends[] = { 0, 255, 128, 1 };
+    float normalized[4];
+    fdata_from_bytes(ends, 4, (1.0f / 255), 0, normalized);
+
+    TEST_ASSERT_EQUAL_FLOAT(0, normalized[0]);
+    TEST_ASSERT_EQUAL_FLOAT(1, normalized[1]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, (128.0f / 255), normalized[2]);
+}
+
 TEST(data, fdata_rand_uniform)
 {
     rand_seed(0);
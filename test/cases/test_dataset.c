@@ -0,0 +1,302 @@
+/**
+ * @file test_dataset.c
+ * @brief unit tests of dataset.c
+ * 
+ */
+#include "dataset.h"
+
+#include <stdint.h>
+
+#include "data.h"
+
+#include "unity_fixture.h"
+
+TEST_GROUP(dataset);
+
+TEST_SETUP(dataset)
+{}
+
+TEST_TEAR_DOWN(dataset)
+{}
+
+TEST(dataset, dataset_create_and_free)
+{
+    Dataset *dataset = dataset_create(5, 3, 2);
+
+    TEST_ASSERT_NOT_NULL(dataset);
+
+    TEST_ASSERT_EQUAL_INT(5, dataset->size);
+    TEST_ASSERT_EQUAL_INT(3, dataset->x_size);
+    TEST_ASSERT_EQUAL_INT(2, dataset->t_size);
+    TEST_ASSERT(dataset->owner);
+
+    // contiguous aligned matrices
+    TEST_ASSERT_EQUAL_INT(0, ((uintptr_t)dataset->x % DATA_ALIGN));
+    TEST_ASSERT_EQUAL_INT(0, ((uintptr_t)dataset->t % DATA_ALIGN));
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_PTR((dataset->x + i * 3), dataset->xs[i]);
+        TEST_ASSERT_EQUAL_PTR((dataset->t + i * 2), dataset->ts[i]);
+    }
+
+    dataset_free(&dataset);
+
+    TEST_ASSERT_NULL(dataset);
+
+    TEST_ASSERT_NULL(dataset_create(0, 3, 2));
+    TEST_ASSERT_NULL(dataset_create(5, 0, 2));
+    TEST_ASSERT_NULL(dataset_create(5, 3, 0));
+}
+
+TEST(dataset, dataset_from_arrays)
+{
+    float *x[] = {
+        (float[2]){ 0, 1 },
+        (float[2]){ 2, 3 },
+        (float[2]){ 4, 5 }
+    };
+    float *t[] = {
+        (float[1]){ -1 },
+        (float[1]){ -2 },
+        (float[1]){ -3 }
+    };
+
+    Dataset *dataset = dataset_from_arrays(x, t, 3, 2, 1);
+
+    TEST_ASSERT_NOT_NULL(dataset);
+
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(((float[]){ 0, 1, 2, 3, 4, 5 }), dataset->x, 6);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(((float[]){ -1, -2, -3 }), dataset->t, 3);
+
+    dataset_free(&dataset);
+
+    TEST_ASSERT_NULL(dataset_from_arrays(NULL, t, 3, 2, 1));
+}
+
+TEST(dataset, dataset_wrap)
+{
+    float *x[] = {
+        (float[2]){ 0, 1 },
+        (float[2]){ 2, 3 }
+    };
+    float *t[] = {
+        (float[1]){ -1 },
+        (float[1]){ -2 }
+    };
+
+    Dataset dataset = dataset_wrap(x, t, 2, 2, 1);
+
+    TEST_ASSERT_EQUAL_INT(2, dataset.size);
+    TEST_ASSERT_NULL(dataset.x);
+    TEST_ASSERT_NULL(dataset.t);
+    TEST_ASSERT_EQUAL_PTR(x, dataset.xs);
+    TEST_ASSERT_EQUAL_PTR(t, dataset.ts);
+    TEST_ASSERT_FALSE(dataset.owner);
+}
+
+TEST(dataset, dataset_view)
+{
+    Dataset *dataset = dataset_create(5, 3, 2);
+    TEST_ASSERT_NOT_NULL(dataset);
+
+    Dataset view = dataset_view(dataset, 1, 2);
+
+    TEST_ASSERT_EQUAL_INT(2, view.size);
+    TEST_ASSERT_EQUAL_INT(3, view.x_size);
+    TEST_ASSERT_EQUAL_INT(2, view.t_size);
+    TEST_ASSERT_EQUAL_PTR((dataset->x + 3), view.x);
+    TEST_ASSERT_EQUAL_PTR((dataset->t + 2), view.t);
+    TEST_ASSERT_EQUAL_PTR(dataset->xs[1], view.xs[0]);
+    TEST_ASSERT_EQUAL_PTR(dataset->ts[2], view.ts[1]);
+    TEST_ASSERT_FALSE(view.owner);
+
+    // clipped to the dataset
+    TEST_ASSERT_EQUAL_INT(1, dataset_view(dataset, 4, 3).size);
+    TEST_ASSERT_EQUAL_INT(0, dataset_view(dataset, 5, 1).size);
+    TEST_ASSERT_EQUAL_INT(0, dataset_view(dataset, -1, 1).size);
+
+    // view of wrapped arrays has no matrices
+    Dataset wrapped = dataset_wrap(dataset->xs, dataset->ts, 5, 3, 2);
+    view = dataset_view(&wrapped, 2, 2);
+    TEST_ASSERT_NULL(view.x);
+    TEST_ASSERT_EQUAL_PTR(dataset->xs[2], view.xs[0]);
+
+    dataset_free(&dataset);
+}
+
+// 3 images of 2 pixels, and their labels of 3 classes
+static const uint8_t IMAGES[] = { 0, 255, 51, 102, 153, 204 };
+static const uint8_t LABELS[] = { 2, 0, 1 };
+
+/**
+ * @brief get IDX files referring to the test images and labels
+ * 
+ * @param[out] images IDX file of images
+ * @param[out] labels IDX file of labels
+ */
+static void init_idx(IdxFile *images, IdxFile *labels)
+{
+    *images = (IdxFile){
+        .type = IDX_TYPE_UBYTE, .n_dims = 2, .dims = { 3, 2 }, .size = 3, .item_size = 2, .data = IMAGES
+    };
+    *labels = (IdxFile){
+        .type = IDX_TYPE_UBYTE, .n_dims = 1, .dims = { 3 }, .size = 3, .item_size = 1, .data = LABELS
+    };
+}
+
+TEST(dataset, dataset_from_idx)
+{
+    IdxFile images, labels;
+    init_idx(&images, &labels);
+
+    Dataset *dataset = dataset_from_idx(&images, &labels, 3);
+
+    TEST_ASSERT_NOT_NULL(dataset);
+
+    TEST_ASSERT_EQUAL_INT(3, dataset->size);
+    TEST_ASSERT_EQUAL_INT(2, dataset->x_size);
+    TEST_ASSERT_EQUAL_INT(3, dataset->t_size);
+
+    // bytes are not copied
+    TEST_ASSERT_EQUAL_PTR(IMAGES, dataset->x_u8);
+    TEST_ASSERT_EQUAL_PTR(LABELS, dataset->t_u8);
+    TEST_ASSERT_NULL(dataset->xs);
+    TEST_ASSERT_NULL(dataset->ts);
+    TEST_ASSERT_FALSE(dataset_in_memory(dataset));
+
+    // view of bytes
+    Dataset view = dataset_view(dataset, 1, 2);
+    TEST_ASSERT_EQUAL_INT(2, view.size);
+    TEST_ASSERT_EQUAL_PTR((IMAGES + 2), view.x_u8);
+    TEST_ASSERT_EQUAL_PTR((LABELS + 1), view.t_u8);
+
+    dataset_free(&dataset);
+
+    TEST_ASSERT_NULL(dataset);
+
+    // label out of classes
+    TEST_ASSERT_NULL(dataset_from_idx(&images, &labels, 2));
+
+    // mismatched num of items
+    labels.size = 2;
+    TEST_ASSERT_NULL(dataset_from_idx(&images, &labels, 3));
+
+    // not bytes
+    labels.size = 3;
+    images.type = IDX_TYPE_FLOAT;
+    TEST_ASSERT_NULL(dataset_from_idx(&images, &labels, 3));
+
+    TEST_ASSERT_NULL(dataset_from_idx(NULL, &labels, 3));
+    TEST_ASSERT_NULL(dataset_from_idx(&images, NULL, 3));
+}
+
+TEST(dataset, dataset_gather)
+{
+    IdxFile images, labels;
+    init_idx(&images, &labels);
+
+    Dataset *bytes = dataset_from_idx(&images, &labels, 3);
+    TEST_ASSERT_NOT_NULL(bytes);
+
+    float x[3 * 2];
+    float t[3 * 3];
+    const int indices[] = { 2, 0, 1 };
+
+    // normalized to [0, 1] and expanded to one-hot vectors
+    dataset_gather(bytes, indices, 3, x, t);
+
+    const float expected_x[] = { 0.6f, 0.8f, 0.0f, 1.0f, 0.2f, 0.4f };
+    const float expected_t[] = { 0, 1, 0, 0, 0, 1, 1, 0, 0 };
+    TEST_ASSERT_FLOAT_ARRAY_WITHIN(1e-6f, expected_x, x, 6);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(expected_t, t, 9);
+
+    // floats are copied
+    Dataset *floats = dataset_create(3, 2, 3);
+    TEST_ASSERT_NOT_NULL(floats);
+    for (int i = 0; i < 6; i++) {
+        floats->x[i] = i;
+    }
+    for (int i = 0; i < 9; i++) {
+        floats->t[i] = -i;
+    }
+
+    dataset_gather(floats, indices, 2, x, t);
+
+    const float copied_x[] = { 4, 5, 0, 1 };
+    const float copied_t[] = { -6, -7, -8, 0, -1, -2 };
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(copied_x, x, 4);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(copied_t, t, 6);
+
+    dataset_free(&bytes);
+    dataset_free(&floats);
+}
+
+TEST(dataset, dataset_create_bytes)
+{
+    Dataset *dataset = dataset_create_bytes(5, 3, 4, 2.0f, -1.0f);
+
+    TEST_ASSERT_NOT_NULL(dataset);
+
+    TEST_ASSERT_EQUAL_INT(5, dataset->size);
+    TEST_ASSERT_EQUAL_INT(3, dataset->x_size);
+    TEST_ASSERT_EQUAL_INT(4, dataset->t_size);
+    TEST_ASSERT_EQUAL_FLOAT(2.0f, dataset->x_scale);
+    TEST_ASSERT_EQUAL_FLOAT(-1.0f, dataset->x_offset);
+    TEST_ASSERT_NOT_NULL(dataset->x_u8);
+    TEST_ASSERT_NOT_NULL(dataset->t_u8);
+    TEST_ASSERT_EQUAL_INT(0, ((uintptr_t)dataset->x_u8 % DATA_ALIGN));
+    TEST_ASSERT_TRUE(dataset->owner);
+    TEST_ASSERT_FALSE(dataset_in_memory(dataset));
+    TEST_ASSERT_TRUE(dataset_has_class_labels(dataset));
+
+    for (int i = 0; i < 15; i++) {
+        dataset->x_u8[i] = (uint8_t)i;
+    }
+    for (int i = 0; i < 5; i++) {
+        dataset->t_u8[i] = (uint8_t)(i % 4);
+    }
+
+    // converted with scale and offset
+    const int indices[] = { 4, 1 };
+    float x[2 * 3];
+    int labels[2];
+
+    dataset_gather(dataset, indices, 2, x, NULL);
+    dataset_gather_labels(dataset, indices, 2, labels);
+
+    const float expected_x[] = { 23, 25, 27, 5, 7, 9 };
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(expected_x, x, 6);
+    TEST_ASSERT_EQUAL_INT(0, labels[0]);
+    TEST_ASSERT_EQUAL_INT(1, labels[1]);
+
+    dataset_free(&dataset);
+
+    TEST_ASSERT_NULL(dataset);
+
+    TEST_ASSERT_NULL(dataset_create_bytes(0, 3, 4, 1, 0));
+    TEST_ASSERT_NULL(dataset_create_bytes(5, 3, 257, 1, 0));
+}
+
+TEST(dataset, dataset_check_labels)
+{
+    Dataset *dataset = dataset_create_bytes(3, 2, 4, 1.0f, 0.0f);
+    TEST_ASSERT_NOT_NULL(dataset);
+
+    dataset->t_u8[0] = 0;
+    dataset->t_u8[1] = 3;
+    dataset->t_u8[2] = 2;
+    TEST_ASSERT_TRUE(dataset_check_labels(dataset));
+
+    // a label equal to num of classes would be expanded out of bounds
+    dataset->t_u8[2] = 4;
+    TEST_ASSERT_FALSE(dataset_check_labels(dataset));
+
+    dataset_free(&dataset);
+
+    // float labels are not class indices
+    float x0[] = { 0, 1 };
+    float t0[] = { 0, 5 };
+    float *x[] = { x0 };
+    float *t[] = { t0 };
+    Dataset arrays = dataset_wrap(x, t, 1, 2, 2);
+    TEST_ASSERT_TRUE(dataset_check_labels(&arrays));
+}
@@ -0,0 +1,330 @@
+/**
+ * @file test_dist.c
+ * @brief unit tests of dist.c
+ * 
+ */
+// sched_getaffinity() and CPU_COUNT() are GNU extensions
+#define _GNU_SOURCE
+
+#include "dist.h"
+
+#include <sched.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "data.h"
+#include "util.h"
+
+#include "unity_fixture.h"
+
+// num of elements, larger than a message and not divisible by num of processes
+#define REDUCE_SIZE 40001
+
+TEST_GROUP(dist);
+
+TEST_SETUP(dist)
+{}
+
+TEST_TEAR_DOWN(dist)
+{}
+
+/**
+ * @brief sum array over processes and check the result in a child process
+ * 
+ * @param[in] param configuration of the process group
+ * @param[in] arg unused
+ * @return int 0 if succeeded
+ */
+static int allreduce_func(const DistParameter param, void *arg)
+{
+    (void)arg;
+
+    Dist *dist = dist_create(param);
+    if (dist == NULL) {
+        return 1;
+    }
+
+    float *data = fdata_alloc(REDUCE_SIZE);
+
+    // repeat to reuse mailboxes
+    int ret = 0;
+    for (int n = 0; n < 2; n++) {
+        for (int i = 0; i < REDUCE_SIZE; i++) {
+            data[i] = (float)((i % 7) + param.rank);
+        }
+        if (dist_allreduce(dist, data, REDUCE_SIZE) != 0) {
+            ret = 1;
+        }
+
+        // sum of (i % 7) + rank over ranks
+        const int n_ranks = param.world_size;
+        for (int i = 0; i < REDUCE_SIZE; i++) {
+            if (data[i] != (float)(n_ranks * (i % 7) + n_ranks * (n_ranks - 1) / 2)) {
+                ret = 1;
+            }
+        }
+    }
+
+    if (dist_barrier(dist) != 0) {
+        ret = 1;
+    }
+
+    FREE_WITH_NULL(&data);
+    dist_free(&dist);
+
+    return ret;
+}
+
+/**
+ * @brief copy array of rank 0 to processes and check the result in a child process
+ * 
+ * @param[in] param configuration of the process group
+ * @param[in] arg unused
+ * @return int 0 if succeeded
+ */
+static int broadcast_func(const DistParameter param, void *arg)
+{
+    (void)arg;
+
+    Dist *dist = dist_create(param);
+    if (dist == NULL) {
+        return 1;
+    }
+
+    float *data = fdata_alloc(REDUCE_SIZE);
+
+    // repeat to reuse mailboxes
+    int ret = 0;
+    for (int n = 0; n < 2; n++) {
+        for (int i = 0; i < REDUCE_SIZE; i++) {
+            data[i] = (float)((i % 7) + param.rank + n);
+        }
+        if (dist_broadcast(dist, data, REDUCE_SIZE) != 0) {
+            ret = 1;
+        }
+
+        for (int i = 0; i < REDUCE_SIZE; i++) {
+            if (data[i] != (float)((i % 7) + n)) {
+                ret = 1;
+            }
+        }
+    }
+
+    if (dist_barrier(dist) != 0) {
+        ret = 1;
+    }
+
+    FREE_WITH_NULL(&data);
+    dist_free(&dist);
+
+    return ret;
+}
+
+/**
+ * @brief leave process group at rank 1 while rank 0 waits for it
+ * 
+ * @param[in] param configuration of the process group
+ * @param[in] arg unused
+ * @return int 0 if the communication of rank 0 fails
+ */
+static int leave_func(const DistParameter param, void *arg)
+{
+    (void)arg;
+
+    Dist *dist = dist_create(param);
+    if (dist == NULL) {
+        return 1;
+    }
+
+    int ret = 0;
+    if (param.rank == 0) {
+        float data[] = { 1, 2, 3 };
+        ret = (dist_allreduce(dist, data, 3) == -1) ? 0 : 1;
+    }
+
+    dist_free(&dist);
+
+    return ret;
+}
+
+/**
+ * @brief check CPUs the child process is pinned to
+ * 
+ * @param[in] param configuration of the process group
+ * @param[in] arg unused
+ * @return int 0 if the process is pinned to cpus_per_rank CPUs
+ */
+static int affinity_func(const DistParameter param, void *arg)
+{
+    (void)arg;
+
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return 1;
+    }
+
+    return (CPU_COUNT(&set) == param.cpus_per_rank) ? 0 : 1;
+}
+
+/**
+ * @brief fail at rank 1 without communication
+ * 
+ * @param[in] param configuration of the process group
+ * @param[in] arg unused
+ * @return int 0 if succeeded
+ */
+static int fail_func(const DistParameter param, void *arg)
+{
+    (void)arg;
+
+    return (param.rank == 1) ? 1 : 0;
+}
+
+/**
+ * @brief succeed without communication
+ * 
+ * @param[in] param configuration of the process group
+ * @param[in] arg unused
+ * @return int 0
+ */
+static int ok_func(const DistParameter param, void *arg)
+{
+    (void)param;
+    (void)arg;
+
+    return 0;
+}
+
+TEST(dist, dist_create_invalid)
+{
+    TEST_ASSERT_NULL(dist_create(SET_DIST_PARAM(.rank=0, .world_size=0, .name="invalid")));
+    TEST_ASSERT_NULL(dist_create(SET_DIST_PARAM(.rank=2, .world_size=2, .name="invalid")));
+    TEST_ASSERT_NULL(dist_create(SET_DIST_PARAM(.rank=0, .world_size=1, .name=NULL)));
+}
+
+TEST(dist, dist_single_process)
+{
+    Dist *dist = dist_create(SET_DIST_PARAM(.rank=0, .world_size=1, .name="single"));
+
+    TEST_ASSERT_NOT_NULL(dist);
+
+    float data[] = { 1, 2, 3 };
+
+    TEST_ASSERT_EQUAL_INT(0, dist_allreduce(dist, data, 3));
+    TEST_ASSERT_EQUAL_FLOAT(2, data[1]);
+
+    dist_free(&dist);
+
+    TEST_ASSERT_NULL(dist);
+}
+
+TEST(dist, dist_allreduce_shm)
+{
+    TEST_ASSERT_EQUAL_INT(
+        0, dist_launch(SET_DIST_PARAM(.world_size=3, .transport=DIST_TRANSPORT_SHM), allreduce_func, NULL)
+    );
+}
+
+TEST(dist, dist_allreduce_socket)
+{
+    TEST_ASSERT_EQUAL_INT(
+        0, dist_launch(SET_DIST_PARAM(.world_size=3, .transport=DIST_TRANSPORT_SOCKET), allreduce_func, NULL)
+    );
+}
+
+TEST(dist, dist_allreduce_two_processes)
+{
+    // the next rank is also the previous rank
+    TEST_ASSERT_EQUAL_INT(
+        0, dist_launch(SET_DIST_PARAM(.world_size=2, .transport=DIST_TRANSPORT_SOCKET), allreduce_func, NULL)
+    );
+    TEST_ASSERT_EQUAL_INT(
+        0, dist_launch(SET_DIST_PARAM(.world_size=2, .transport=DIST_TRANSPORT_AUTO), allreduce_func, NULL)
+    );
+}
+
+TEST(dist, dist_broadcast)
+{
+    TEST_ASSERT_EQUAL_INT(
+        0, dist_launch(SET_DIST_PARAM(.world_size=3, .transport=DIST_TRANSPORT_SHM), broadcast_func, NULL)
+    );
+    TEST_ASSERT_EQUAL_INT(
+        0, dist_launch(SET_DIST_PARAM(.world_size=3, .transport=DIST_TRANSPORT_SOCKET), broadcast_func, NULL)
+    );
+}
+
+TEST(dist, dist_peer_timeout)
+{
+    // rank 0 does not wait forever for a peer which left
+    TEST_ASSERT_EQUAL_INT(
+        0, dist_launch(SET_DIST_PARAM(.world_size=2, .transport=DIST_TRANSPORT_SHM, .timeout=1), leave_func, NULL)
+    );
+    TEST_ASSERT_EQUAL_INT(
+        0, dist_launch(SET_DIST_PARAM(.world_size=2, .transport=DIST_TRANSPORT_SOCKET, .timeout=1), leave_func, NULL)
+    );
+}
+
+TEST(dist, dist_launch_affinity)
+{
+    TEST_ASSERT_EQUAL_INT(0, dist_launch(SET_DIST_PARAM(.world_size=2, .cpus_per_rank=1), affinity_func, NULL));
+}
+
+TEST(dist, dist_launch_failure)
+{
+    TEST_ASSERT_EQUAL_INT(-1, dist_launch(SET_DIST_PARAM(.world_size=3), fail_func, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, dist_launch(SET_DIST_PARAM(.world_size=0), fail_func, NULL));
+    TEST_ASSERT_EQUAL_INT(-1, dist_launch(SET_DIST_PARAM(.world_size=2, .cpus_per_rank=-1), fail_func, NULL));
+}
+
+TEST(dist, dist_launch_other_child)
+{
+    // a failed child of the caller is neither reaped nor taken for a rank
+    pid_t other = fork();
+    TEST_ASSERT_TRUE(other >= 0);
+    if (other == 0) {
+        _exit(1);
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, dist_launch(SET_DIST_PARAM(.world_size=2), ok_func, NULL));
+
+    int status = 0;
+    TEST_ASSERT_EQUAL_INT(other, waitpid(other, &status, 0));
+    TEST_ASSERT_TRUE(WIFEXITED(status));
+    TEST_ASSERT_EQUAL_INT(1, WEXITSTATUS(status));
+}
+
+TEST(dist, dist_param_from_env)
+{
+    DistParameter param;
+
+    unsetenv("NNC_RANK");
+    unsetenv("NNC_WORLD_SIZE");
+
+    TEST_ASSERT_EQUAL_INT(-1, dist_param_from_env(&param));
+
+    setenv("NNC_RANK", "1", 1);
+    setenv("NNC_WORLD_SIZE", "4", 1);
+
+    // name is required
+    unsetenv("NNC_DIST_NAME");
+    TEST_ASSERT_EQUAL_INT(-1, dist_param_from_env(&param));
+
+    setenv("NNC_DIST_NAME", "job", 1);
+    setenv("NNC_DIST_TRANSPORT", "socket", 1);
+
+    TEST_ASSERT_EQUAL_INT(0, dist_param_from_env(&param));
+    TEST_ASSERT_EQUAL_INT(1, param.rank);
+    TEST_ASSERT_EQUAL_INT(4, param.world_size);
+    TEST_ASSERT_EQUAL_STRING("job", param.name);
+    TEST_ASSERT_EQUAL_INT(DIST_TRANSPORT_SOCKET, param.transport);
+
+    setenv("NNC_RANK", "4", 1);
+
+    TEST_ASSERT_EQUAL_INT(-1, dist_param_from_env(&param));
+
+    unsetenv("NNC_RANK");
+    unsetenv("NNC_WORLD_SIZE");
+    unsetenv("NNC_DIST_NAME");
+    unsetenv("NNC_DIST_TRANSPORT");
+}
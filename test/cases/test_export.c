@@ -0,0 +1,188 @@
+/**
+ * @file test_export.c
+ * @brief unit tests of export.c
+ * 
+ */
+#include "export.h"
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "layers.h"
+#include "random.h"
+
+#include "unity_fixture.h"
+
+TEST_GROUP(export);
+
+TEST_SETUP(export)
+{}
+
+TEST_TEAR_DOWN(export)
+{}
+
+#define EXPORT_FILE "test_export_out.c"
+#define EXPORT_LIB  "./test_export_out.so"
+
+// num of inputs compared between exported function and net_forward()
+#define N_PARITY_SAMPLES 16
+
+/**
+ * @brief read whole text file
+ * 
+ * @param filename path of file
+ * @return char* allocated string
+ */
+static char *read_file(const char *filename)
+{
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    char *text = malloc(size + 1);
+    size_t n = fread(text, 1, size, fp);
+    text[n] = '\0';
+
+    fclose(fp);
+
+    return text;
+}
+
+TEST(export, net_export_c)
+{
+    Net *net = net_create(
+        3,
+        (Layer*[]){
+            fc_layer((LayerParameter){ .in=3, .out=4 }),
+            relu_layer((LayerParameter){ .in=4 }),
+            softmax_layer((LayerParameter){ .in=4 })
+        }
+    );
+
+    rand_seed(0);
+    net_init_layer_params(net);
+    net->layers[0]->w[0] = 1.5f;
+
+    TEST_ASSERT_EQUAL_INT(0, net_export_c(net, EXPORT_FILE, "predict"));
+
+    char *text = read_file(EXPORT_FILE);
+    TEST_ASSERT_NOT_NULL(text);
+
+    TEST_ASSERT_NOT_NULL(strstr(text, "void predict(const float *x, float *y)\n{"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "static const _Alignas(64) float w0[12] = {\n    0x1.8p+0f,"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "static const _Alignas(64) float b0[4] = {"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "_Alignas(64) float y0[4];"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "for (int k = 0; k < 3; k++) {"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "const float *x0 = y1 + 0;"));
+    // no parameters for activation layers
+    TEST_ASSERT_NULL(strstr(text, "w1["));
+    // no dynamic allocation
+    TEST_ASSERT_NULL(strstr(text, "malloc"));
+
+    free(text);
+    remove(EXPORT_FILE);
+    net_free(&net);
+}
+
+TEST(export, net_export_c_fused_graph)
+{
+    Net *net = net_alloc();
+    net_append(net, fc_layer((LayerParameter){ .in=2, .out=3 }));
+    net_append(net, sigmoid_layer((LayerParameter){ .in=3 }));
+    net_connect(net, fc_layer((LayerParameter){ .in=2, .out=3 }), 1, (int[]){ -1 }, NULL);
+    net_connect(net, concat_layer((LayerParameter){ .n_in=2, .ins={ 3, 3 } }), 2, (int[]){ 1, 2 }, NULL);
+
+    rand_seed(0);
+    net_init_layer_params(net);
+    net_optimize(net);
+
+    TEST_ASSERT_EQUAL_INT(0, net_export_c(net, EXPORT_FILE, "branch_net"));
+
+    char *text = read_file(EXPORT_FILE);
+    TEST_ASSERT_NOT_NULL(text);
+
+    TEST_ASSERT_NOT_NULL(strstr(text, "void branch_net(const float *x, float *y)"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "1.0f / (1.0f + expf(-v))"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "y[3 + i] = x1[i];"));
+
+    free(text);
+    remove(EXPORT_FILE);
+    net_free(&net);
+}
+
+TEST(export, net_export_c_parity)
+{
+    // fused pair and branches
+    Net *net = net_alloc();
+    net_append(net, fc_layer((LayerParameter){ .in=4, .out=8 }));
+    net_append(net, relu_layer((LayerParameter){ .in=8 }));
+    net_append(net, fc_layer((LayerParameter){ .in=8, .out=3 }));
+    net_connect(net, fc_layer((LayerParameter){ .in=4, .out=3 }), 1, (int[]){ -1 }, NULL);
+    net_connect(net, sigmoid_layer((LayerParameter){ .in=3 }), 1, (int[]){ 3 }, NULL);
+    net_connect(net, concat_layer((LayerParameter){ .n_in=2, .ins={ 3, 3 } }), 2, (int[]){ 2, 4 }, NULL);
+    net_append(net, softmax_layer((LayerParameter){ .in=6 }));
+
+    rand_seed(0);
+    net_init_layer_params(net);
+    TEST_ASSERT(net_optimize(net) > 0);
+
+    TEST_ASSERT_EQUAL_INT(0, net_export_c(net, EXPORT_FILE, "parity_net"));
+
+    // generated code compiles without warnings
+    const char *command =
+        TEST_C_COMPILER " -std=c11 -Wall -Wextra -Wpedantic -Werror -O2 -fPIC -shared"
+        " -o " EXPORT_LIB " " EXPORT_FILE " -lm";
+    TEST_ASSERT_EQUAL_INT(0, system(command));
+
+    void *lib = dlopen(EXPORT_LIB, RTLD_NOW);
+    TEST_ASSERT_NOT_NULL(lib);
+
+    // conversion of object pointer to function pointer as POSIX specifies
+    void (*parity_net)(const float*, float*);
+    *(void**)(&parity_net) = dlsym(lib, "parity_net");
+    TEST_ASSERT_NOT_NULL(parity_net);
+
+    for (int n = 0; n < N_PARITY_SAMPLES; n++) {
+        float x[4];
+        for (int i = 0; i < 4; i++) {
+            x[i] = 4.0f * rand_uniform() - 2.0f;
+        }
+
+        float y[6];
+        parity_net(x, y);
+        net_forward(net, x);
+
+        for (int i = 0; i < 6; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-6f, net->output_layer->y[i], y[i]);
+        }
+    }
+
+    dlclose(lib);
+    remove(EXPORT_LIB);
+    remove(EXPORT_FILE);
+    net_free(&net);
+}
+
+TEST(export, net_export_c_invalid)
+{
+    Net *net = net_create(1, (Layer*[]){ fc_layer((LayerParameter){ .in=2, .out=2 }) });
+
+    TEST_ASSERT_EQUAL_INT(-1, net_export_c(NULL, EXPORT_FILE, "predict"));
+    TEST_ASSERT_EQUAL_INT(-1, net_export_c(net, NULL, "predict"));
+    TEST_ASSERT_EQUAL_INT(-1, net_export_c(net, EXPORT_FILE, "1predict"));
+    TEST_ASSERT_EQUAL_INT(-1, net_export_c(net, EXPORT_FILE, "pre-dict"));
+    TEST_ASSERT_EQUAL_INT(-1, net_export_c(net, "no_such_dir/out.c", "predict"));
+
+    net_free(&net);
+}
+
+#undef EXPORT_FILE
+#undef EXPORT_LIB
+#undef N_PARITY_SAMPLES
@@ -39,8 +39,9 @@ TEST(fc, fc_layer_and_free)
     TEST_ASSERT_NOT_NULL(fc->b);
     TEST_ASSERT_EQUAL_INT(param.out, fc->b_size);
 
-    TEST_ASSERT_EQUAL_INT(-1, fc->prev_id);
-    TEST_ASSERT_EQUAL_INT(-1, fc->next_id);
+    TEST_ASSERT_EQUAL_INT(1, fc->n_in);
+    TEST_ASSERT_EQUAL_INT(-1, fc->in_ids[0]);
+    TEST_ASSERT_EQUAL_INT(0, fc->n_out);
 
     TEST_ASSERT_NOT_NULL(fc->forward);
 
@@ -63,6 +64,26 @@ TEST(fc, fc_layer_invalid_param)
     TEST_ASSERT_NULL(fc);
 }
 
+TEST(fc, fc_cost)
+{
+    LayerParameter param = { .in = 2, .out = 10 };
+    Layer *fc = fc_layer(param);
+
+    double flops, bytes;
+
+    // Wx + b, reading x, W, b and writing y
+    layer_cost(fc, false, &flops, &bytes);
+    TEST_ASSERT_EQUAL_FLOAT(50, flops);
+    TEST_ASSERT_EQUAL_FLOAT(((20 + 2 + 10 + 10) * sizeof(float)), bytes);
+
+    // dx and dW, reading dy, W, x and writing dx, dW, db
+    layer_cost(fc, true, &flops, &bytes);
+    TEST_ASSERT_EQUAL_FLOAT(80, flops);
+    TEST_ASSERT_EQUAL_FLOAT(((10 + 20 + 2 + 2 + 20 + 10) * sizeof(float)), bytes);
+
+    layer_free(&fc);
+}
+
 TEST(fc, fc_forward)
 {
     LayerParameter param = { .in = 2, .out = 3 };
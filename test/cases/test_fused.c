@@ -0,0 +1,124 @@
+/**
+ * @file test_fused.c
+ * @brief unit tests of fused.c
+ * 
+ */
+#include "fused.h"
+
+#include "layers.h"
+#include "data.h"
+#include "random.h"
+
+#include "unity_fixture.h"
+
+TEST_GROUP(fused);
+
+TEST_SETUP(fused)
+{}
+
+TEST_TEAR_DOWN(fused)
+{}
+
+#define IN_SIZE 7
+#define OUT_SIZE 5
+
+/**
+ * @brief compare fused layer with two successive layers
+ * 
+ * @param fused fused layer
+ * @param first first layer
+ * @param second second layer
+ */
+static void assert_same_as_pair(Layer *fused, Layer *first, Layer *second)
+{
+    rand_seed(1);
+
+    float x[IN_SIZE];
+    fdata_rand_norm(x, first->x_size, 0, 1);
+
+    float dy[OUT_SIZE];
+    fdata_rand_norm(dy, second->y_size, 0, 1);
+
+    if (first->w != NULL) {
+        fdata_rand_norm(first->w, first->w_size, 0, 1);
+        fdata_rand_norm(first->b, first->b_size, 0, 1);
+        fdata_copy(first->w, first->w_size, fused->w);
+        fdata_copy(first->b, first->b_size, fused->b);
+    }
+
+    first->forward(first, x);
+    second->forward(second, first->y);
+    fused->forward(fused, x);
+
+    TEST_ASSERT_EQUAL_INT(second->y_size, fused->y_size);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(second->y, fused->y, fused->y_size);
+
+    second->backward(second, dy);
+    first->backward(first, second->dx);
+    fused->backward(fused, dy);
+
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(first->dx, fused->dx, fused->x_size);
+    if (first->w != NULL) {
+        TEST_ASSERT_EQUAL_FLOAT_ARRAY(first->dw, fused->dw, fused->w_size);
+        TEST_ASSERT_EQUAL_FLOAT_ARRAY(first->db, fused->db, fused->b_size);
+    }
+
+    layer_free(&fused);
+    layer_free(&first);
+    layer_free(&second);
+}
+
+TEST(fused, fc_sigmoid_layer)
+{
+    LayerParameter param = { .in = IN_SIZE, .out = OUT_SIZE };
+    Layer *fused = fc_sigmoid_layer(param);
+
+    TEST_ASSERT_NOT_NULL(fused);
+    TEST_ASSERT_EQUAL_INT(LAYER_TYPE_FC_SIGMOID, fused->type);
+
+    assert_same_as_pair(fused, fc_layer(param), sigmoid_layer((LayerParameter){ .in = OUT_SIZE }));
+}
+
+TEST(fused, fc_relu_layer)
+{
+    LayerParameter param = { .in = IN_SIZE, .out = OUT_SIZE };
+    Layer *fused = fc_relu_layer(param);
+
+    TEST_ASSERT_NOT_NULL(fused);
+    TEST_ASSERT_EQUAL_INT(LAYER_TYPE_FC_RELU, fused->type);
+
+    assert_same_as_pair(fused, fc_layer(param), relu_layer((LayerParameter){ .in = OUT_SIZE }));
+}
+
+TEST(fused, fc_softmax_layer)
+{
+    LayerParameter param = { .in = IN_SIZE, .out = OUT_SIZE };
+    Layer *fused = fc_softmax_layer(param);
+
+    TEST_ASSERT_NOT_NULL(fused);
+    TEST_ASSERT_EQUAL_INT(LAYER_TYPE_FC_SOFTMAX, fused->type);
+
+    assert_same_as_pair(fused, fc_layer(param), softmax_layer((LayerParameter){ .in = OUT_SIZE }));
+}
+
+TEST(fused, sigmoid_softmax_layer)
+{
+    LayerParameter param = { .in = OUT_SIZE };
+    Layer *fused = sigmoid_softmax_layer(param);
+
+    TEST_ASSERT_NOT_NULL(fused);
+    TEST_ASSERT_EQUAL_INT(LAYER_TYPE_SIGMOID_SOFTMAX, fused->type);
+
+    assert_same_as_pair(fused, sigmoid_layer(param), softmax_layer(param));
+}
+
+TEST(fused, fused_layer_invalid_param)
+{
+    TEST_ASSERT_NULL(fc_sigmoid_layer((LayerParameter){ .in = 0, .out = 1 }));
+    TEST_ASSERT_NULL(fc_relu_layer((LayerParameter){ .in = 1, .out = 0 }));
+    TEST_ASSERT_NULL(fc_softmax_layer((LayerParameter){ .in = 0, .out = 0 }));
+    TEST_ASSERT_NULL(sigmoid_softmax_layer((LayerParameter){ .in = 0 }));
+}
+
+#undef IN_SIZE
+#undef OUT_SIZE
@@ -0,0 +1,224 @@
+/**
+ * @file test_idx.c
+ * @brief unit tests of idx.c
+ * 
+ */
+#include "idx.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "fixture.h"
+
+#include "unity_fixture.h"
+
+TEST_GROUP(idx);
+
+TEST_SETUP(idx)
+{}
+
+TEST_TEAR_DOWN(idx)
+{}
+
+#define IDX_FILE "test_idx.bin"
+
+// 3 images of 2x2 pixels
+static const uint8_t IMAGES[] = {
+    0x00, 0x00, 0x08, 0x03,
+    0x00, 0x00, 0x00, 0x03,
+    0x00, 0x00, 0x00, 0x02,
+    0x00, 0x00, 0x00, 0x02,
+    0, 1, 2, 3,
+    4, 5, 6, 7,
+    8, 9, 10, 255
+};
+
+// 3 labels
+static const uint8_t LABELS[] = {
+    0x00, 0x00, 0x08, 0x01,
+    0x00, 0x00, 0x00, 0x03,
+    2, 0, 1
+};
+
+// IMAGES compressed with gzip
+static const uint8_t IMAGES_GZ[] = {
+    0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x63, 0x60, 0xE0, 0x60, 0x66, 0x60,
+    0x60, 0x00, 0x61, 0x26, 0x30, 0x66, 0x64, 0x62, 0x66, 0x61, 0x65, 0x63, 0xE7, 0xE0, 0xE4, 0xFA,
+    0x0F, 0x00, 0x66, 0x72, 0xBF, 0x7C, 0x1C, 0x00, 0x00, 0x00
+};
+
+TEST(idx, idx_type_size)
+{
+    TEST_ASSERT_EQUAL_INT(1, idx_type_size(IDX_TYPE_UBYTE));
+    TEST_ASSERT_EQUAL_INT(1, idx_type_size(IDX_TYPE_BYTE));
+    TEST_ASSERT_EQUAL_INT(2, idx_type_size(IDX_TYPE_SHORT));
+    TEST_ASSERT_EQUAL_INT(4, idx_type_size(IDX_TYPE_INT));
+    TEST_ASSERT_EQUAL_INT(4, idx_type_size(IDX_TYPE_FLOAT));
+    TEST_ASSERT_EQUAL_INT(8, idx_type_size(IDX_TYPE_DOUBLE));
+    TEST_ASSERT_EQUAL_INT(0, idx_type_size((IdxType)0x0A));
+}
+
+TEST(idx, idx_open_images)
+{
+    write_file(IDX_FILE, IMAGES, sizeof(IMAGES));
+
+    IdxFile *file = idx_open(IDX_FILE);
+
+    TEST_ASSERT_NOT_NULL(file);
+
+    TEST_ASSERT_EQUAL_INT(IDX_TYPE_UBYTE, file->type);
+    TEST_ASSERT_EQUAL_INT(3, file->n_dims);
+    TEST_ASSERT_EQUAL_INT(3, file->dims[0]);
+    TEST_ASSERT_EQUAL_INT(2, file->dims[1]);
+    TEST_ASSERT_EQUAL_INT(2, file->dims[2]);
+    TEST_ASSERT_EQUAL_INT(3, file->size);
+    TEST_ASSERT_EQUAL_INT(4, file->item_size);
+
+    // elements are in the mapped file
+    TEST_ASSERT_EQUAL_PTR(((const uint8_t*)file->map + 16), file->data);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY((IMAGES + 16), file->data, 12);
+
+    TEST_ASSERT_EQUAL_PTR((file->data + 8), idx_item(file, 2));
+    TEST_ASSERT_EQUAL_UINT8(255, idx_item(file, 2)[3]);
+    TEST_ASSERT_NULL(idx_item(file, -1));
+    TEST_ASSERT_NULL(idx_item(file, 3));
+
+    idx_close(&file);
+
+    TEST_ASSERT_NULL(file);
+
+    remove(IDX_FILE);
+}
+
+TEST(idx, idx_open_labels)
+{
+    write_file(IDX_FILE, LABELS, sizeof(LABELS));
+
+    IdxFile *file = idx_open(IDX_FILE);
+
+    TEST_ASSERT_NOT_NULL(file);
+
+    TEST_ASSERT_EQUAL_INT(1, file->n_dims);
+    TEST_ASSERT_EQUAL_INT(3, file->size);
+    TEST_ASSERT_EQUAL_INT(1, file->item_size);
+    TEST_ASSERT_EQUAL_UINT8(2, file->data[0]);
+    TEST_ASSERT_EQUAL_UINT8(1, file->data[2]);
+
+    idx_close(&file);
+
+    remove(IDX_FILE);
+}
+
+TEST(idx, idx_open_gzip)
+{
+    write_file(IDX_FILE, IMAGES_GZ, sizeof(IMAGES_GZ));
+
+    IdxFile *file = idx_open(IDX_FILE);
+
+    TEST_ASSERT_NOT_NULL(file);
+
+    TEST_ASSERT_EQUAL_INT(IDX_TYPE_UBYTE, file->type);
+    TEST_ASSERT_EQUAL_INT(3, file->n_dims);
+    TEST_ASSERT_EQUAL_INT(3, file->size);
+    TEST_ASSERT_EQUAL_INT(4, file->item_size);
+
+    // elements are decoded into buffer and the compressed file is unmapped
+    TEST_ASSERT_NULL(file->map);
+    TEST_ASSERT_EQUAL_PTR(file->buffer, file->data);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY((IMAGES + 16), file->data, 12);
+    TEST_ASSERT_EQUAL_UINT8(255, idx_item(file, 2)[3]);
+
+    idx_close(&file);
+
+    // truncated and corrupted files
+    write_file(IDX_FILE, IMAGES_GZ, (sizeof(IMAGES_GZ) - 1));
+    TEST_ASSERT_NULL(idx_open(IDX_FILE));
+
+    uint8_t bytes[sizeof(IMAGES_GZ)];
+    memcpy(bytes, IMAGES_GZ, sizeof(IMAGES_GZ));
+    bytes[sizeof(IMAGES_GZ) - 8] ^= 0x01;
+    write_file(IDX_FILE, bytes, sizeof(bytes));
+    TEST_ASSERT_NULL(idx_open(IDX_FILE));
+
+    remove(IDX_FILE);
+}
+
+TEST(idx, idx_read_header)
+{
+    IdxFile file;
+
+    write_file(IDX_FILE, IMAGES, sizeof(IMAGES));
+
+    TEST_ASSERT_EQUAL_INT(0, idx_read_header(IDX_FILE, &file));
+    TEST_ASSERT_EQUAL_INT(3, file.n_dims);
+    TEST_ASSERT_EQUAL_INT(3, file.size);
+    TEST_ASSERT_EQUAL_INT(4, file.item_size);
+    TEST_ASSERT_EQUAL_INT(16, idx_header_size(&file));
+    TEST_ASSERT_NULL(file.data);
+
+    // header of compressed file is decoded
+    write_file(IDX_FILE, IMAGES_GZ, sizeof(IMAGES_GZ));
+
+    TEST_ASSERT_EQUAL_INT(0, idx_read_header(IDX_FILE, &file));
+    TEST_ASSERT_EQUAL_INT(3, file.n_dims);
+    TEST_ASSERT_EQUAL_INT(3, file.size);
+    TEST_ASSERT_EQUAL_INT(4, file.item_size);
+    TEST_ASSERT_EQUAL_INT(16, idx_header_size(&file));
+    TEST_ASSERT_NULL(file.data);
+
+    write_file(IDX_FILE, IMAGES_GZ, 12);
+    TEST_ASSERT_EQUAL_INT(-1, idx_read_header(IDX_FILE, &file));
+
+    TEST_ASSERT_EQUAL_INT(-1, idx_read_header("no_such_file.idx", &file));
+
+    remove(IDX_FILE);
+}
+
+TEST(idx, idx_open_invalid)
+{
+    TEST_ASSERT_NULL(idx_open(NULL));
+    TEST_ASSERT_NULL(idx_open("no_such_file.idx"));
+
+    uint8_t bytes[sizeof(IMAGES)];
+
+    // magic number not starting with zeros
+    for (size_t i = 0; i < sizeof(IMAGES); i++) {
+        bytes[i] = IMAGES[i];
+    }
+    bytes[1] = 0x01;
+    write_file(IDX_FILE, bytes, sizeof(IMAGES));
+    TEST_ASSERT_NULL(idx_open(IDX_FILE));
+
+    // unknown element type
+    bytes[1] = 0x00;
+    bytes[2] = 0x0A;
+    write_file(IDX_FILE, bytes, sizeof(IMAGES));
+    TEST_ASSERT_NULL(idx_open(IDX_FILE));
+
+    // no dimension
+    bytes[2] = 0x08;
+    bytes[3] = 0x00;
+    write_file(IDX_FILE, bytes, sizeof(IMAGES));
+    TEST_ASSERT_NULL(idx_open(IDX_FILE));
+
+    // dimension of zero
+    bytes[3] = 0x03;
+    bytes[11] = 0x00;
+    write_file(IDX_FILE, bytes, sizeof(IMAGES));
+    TEST_ASSERT_NULL(idx_open(IDX_FILE));
+
+    // truncated elements and header
+    write_file(IDX_FILE, IMAGES, (sizeof(IMAGES) - 1));
+    TEST_ASSERT_NULL(idx_open(IDX_FILE));
+
+    write_file(IDX_FILE, IMAGES, 10);
+    TEST_ASSERT_NULL(idx_open(IDX_FILE));
+
+    // elements larger than bytes
+    bytes[2]  = 0x0D;
+    bytes[11] = 0x02;
+    write_file(IDX_FILE, bytes, sizeof(IMAGES));
+    TEST_ASSERT_NULL(idx_open(IDX_FILE));
+
+    remove(IDX_FILE);
+}
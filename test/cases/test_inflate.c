@@ -0,0 +1,175 @@
+/**
+ * @file test_inflate.c
+ * @brief unit tests of inflate.c
+ * 
+ */
+#include "inflate.h"
+
+#include <string.h>
+
+#include "unity_fixture.h"
+
+TEST_GROUP(inflate);
+
+TEST_SETUP(inflate)
+{}
+
+TEST_TEAR_DOWN(inflate)
+{}
+
+// "hello, hello, hello!" compressed with fixed Huffman codes
+static const uint8_t FIXED[] = {
+    0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xCB, 0x48, 0xCD, 0xC9, 0xC9, 0xD7,
+    0x51, 0xC8, 0x40, 0xA2, 0x14, 0x01, 0xA7, 0xBB, 0xD2, 0xFE, 0x14, 0x00, 0x00, 0x00
+};
+
+// "stored" in a stored block
+static const uint8_t STORED[] = {
+    0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x03, 0x01, 0x06, 0x00, 0xF9, 0xFF, 0x73,
+    0x74, 0x6F, 0x72, 0x65, 0x64, 0x0B, 0xF9, 0x43, 0x56, 0x06, 0x00, 0x00, 0x00
+};
+
+// 200 bytes of dynamic_bytes() compressed with dynamic Huffman codes
+static const uint8_t DYNAMIC[] = {
+    0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x35, 0x8E, 0x8B, 0x0D, 0x00, 0x31,
+    0x08, 0x42, 0x67, 0xE5, 0xB3, 0xFF, 0x0C, 0x57, 0xC0, 0x4B, 0x1A, 0xAB, 0xF0, 0x4A, 0xA5, 0x40,
+    0x00, 0x54, 0xCA, 0x3B, 0x84, 0x3A, 0xA8, 0xAA, 0xE1, 0xA8, 0xAA, 0x11, 0x80, 0x47, 0x2B, 0x52,
+    0xD0, 0xE8, 0x9E, 0x9D, 0x24, 0x3E, 0xAB, 0xC8, 0xC2, 0x28, 0x5F, 0xE2, 0xA1, 0x95, 0xC5, 0xF4,
+    0x54, 0x9F, 0xA6, 0xDB, 0x07, 0x2E, 0x80, 0x05, 0xFD, 0xB7, 0x55, 0x73, 0x3B, 0x55, 0x7C, 0x94,
+    0xBB, 0xDA, 0xC5, 0x8D, 0xFE, 0x00, 0xCB, 0x76, 0x34, 0x5C, 0xC8, 0x00, 0x00, 0x00
+};
+
+/**
+ * @brief generate bytes of skewed frequencies compressed in DYNAMIC
+ * 
+ * @param[out] bytes 200 bytes
+ */
+static void dynamic_bytes(uint8_t *bytes)
+{
+    static const char LETTERS[] = "aaaaaaaabbbbccd";
+
+    uint32_t x = 1;
+    for (int i = 0; i < 200; i++) {
+        x = (x * 1103515245U + 12345U) & 0x7FFFFFFF;
+        bytes[i] = (uint8_t)LETTERS[(x >> 16) % 15];
+    }
+}
+
+/**
+ * @brief decode gzip file in pieces
+ * 
+ * @param[in] src compressed file
+ * @param[in] size size of compressed file [byte]
+ * @param[in] piece num of bytes decoded by each read
+ * @param[out] dest destination of decoded bytes
+ * @param[in] dest_size size of dest [byte]
+ * @return int num of decoded bytes, -1 if failed
+ */
+static int inflate_pieces(const uint8_t *src, const size_t size, const size_t piece, uint8_t *dest, const size_t dest_size)
+{
+    Inflater *inflater = inflater_create(src, size);
+    TEST_ASSERT_NOT_NULL(inflater);
+
+    size_t total = 0;
+    size_t n_read;
+    do {
+        const size_t n = ((dest_size - total) < piece) ? (dest_size - total) : piece;
+        if (inflater_read(inflater, (dest + total), n, &n_read) != 0) {
+            inflater_free(&inflater);
+            return -1;
+        }
+        total += n_read;
+    } while ((n_read > 0) && (total < dest_size));
+
+    inflater_free(&inflater);
+
+    return (int)total;
+}
+
+TEST(inflate, gzip_check)
+{
+    TEST_ASSERT_TRUE(gzip_check(FIXED, sizeof(FIXED)));
+    TEST_ASSERT_FALSE(gzip_check(FIXED, 1));
+    TEST_ASSERT_FALSE(gzip_check(NULL, 2));
+    TEST_ASSERT_FALSE(gzip_check((const uint8_t[]){ 0x00, 0x00, 0x08, 0x01 }, 4));
+
+    TEST_ASSERT_NULL(inflater_create((const uint8_t[]){ 0x00, 0x00, 0x08, 0x01 }, 4));
+}
+
+TEST(inflate, inflater_read_fixed)
+{
+    const char *expected = "hello, hello, hello!";
+
+    uint8_t bytes[32];
+    for (size_t piece = 1; piece <= sizeof(bytes); piece *= 2) {
+        memset(bytes, 0, sizeof(bytes));
+        TEST_ASSERT_EQUAL_INT(20, inflate_pieces(FIXED, sizeof(FIXED), piece, bytes, sizeof(bytes)));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, bytes, 20);
+    }
+}
+
+TEST(inflate, inflater_read_stored)
+{
+    uint8_t bytes[8];
+    TEST_ASSERT_EQUAL_INT(6, inflate_pieces(STORED, sizeof(STORED), 4, bytes, sizeof(bytes)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY("stored", bytes, 6);
+}
+
+TEST(inflate, inflater_read_dynamic)
+{
+    uint8_t expected[200];
+    dynamic_bytes(expected);
+
+    uint8_t bytes[256];
+    for (size_t piece = 1; piece <= sizeof(bytes); piece *= 4) {
+        TEST_ASSERT_EQUAL_INT(200, inflate_pieces(DYNAMIC, sizeof(DYNAMIC), piece, bytes, sizeof(bytes)));
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, bytes, 200);
+    }
+}
+
+TEST(inflate, inflater_read_members)
+{
+    // concatenated members are decoded as a single file
+    uint8_t src[sizeof(FIXED) + sizeof(STORED)];
+    memcpy(src, FIXED, sizeof(FIXED));
+    memcpy((src + sizeof(FIXED)), STORED, sizeof(STORED));
+
+    uint8_t bytes[32];
+    TEST_ASSERT_EQUAL_INT(26, inflate_pieces(src, sizeof(src), 3, bytes, sizeof(bytes)));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY("hello, hello, hello!stored", bytes, 26);
+}
+
+TEST(inflate, inflater_read_corrupted)
+{
+    uint8_t src[sizeof(DYNAMIC)];
+    uint8_t bytes[256];
+
+    // CRC-32
+    memcpy(src, DYNAMIC, sizeof(DYNAMIC));
+    src[sizeof(DYNAMIC) - 8] ^= 0x01;
+    TEST_ASSERT_EQUAL_INT(-1, inflate_pieces(src, sizeof(src), sizeof(bytes), bytes, sizeof(bytes)));
+
+    // size
+    memcpy(src, DYNAMIC, sizeof(DYNAMIC));
+    src[sizeof(DYNAMIC) - 4] ^= 0x01;
+    TEST_ASSERT_EQUAL_INT(-1, inflate_pieces(src, sizeof(src), sizeof(bytes), bytes, sizeof(bytes)));
+
+    // truncated codes and trailer
+    TEST_ASSERT_EQUAL_INT(-1, inflate_pieces(DYNAMIC, 40, sizeof(bytes), bytes, sizeof(bytes)));
+    TEST_ASSERT_EQUAL_INT(-1, inflate_pieces(DYNAMIC, (sizeof(DYNAMIC) - 2), sizeof(bytes), bytes, sizeof(bytes)));
+
+    // reserved type of block
+    memcpy(src, STORED, sizeof(STORED));
+    src[10] = 0x07;
+    TEST_ASSERT_EQUAL_INT(-1, inflate_pieces(src, sizeof(STORED), sizeof(bytes), bytes, sizeof(bytes)));
+
+    // length of stored block not matching its complement
+    memcpy(src, STORED, sizeof(STORED));
+    src[13] = 0x00;
+    TEST_ASSERT_EQUAL_INT(-1, inflate_pieces(src, sizeof(STORED), sizeof(bytes), bytes, sizeof(bytes)));
+
+    // unknown compression method
+    memcpy(src, STORED, sizeof(STORED));
+    src[2] = 0x07;
+    TEST_ASSERT_EQUAL_INT(-1, inflate_pieces(src, sizeof(STORED), sizeof(bytes), bytes, sizeof(bytes)));
+}
@@ -3,6 +3,8 @@
  * @brief unit tests of layer.c
  * 
  */
+#include <string.h>
+
 #include "layer.h"
 
 #include "unity_fixture.h"
@@ -34,8 +36,9 @@ TEST(layer, layer_alloc_and_free)
     TEST_ASSERT_NULL(layer->dw);
     TEST_ASSERT_NULL(layer->db);
 
-    TEST_ASSERT_EQUAL_INT(-1, layer->prev_id);
-    TEST_ASSERT_EQUAL_INT(-1, layer->next_id);
+    TEST_ASSERT_EQUAL_INT(1, layer->n_in);
+    TEST_ASSERT_EQUAL_INT(-1, layer->in_ids[0]);
+    TEST_ASSERT_EQUAL_INT(0, layer->n_out);
 
     TEST_ASSERT_NULL(layer->forward);
     TEST_ASSERT_NULL(layer->backward);
@@ -70,3 +73,10 @@ TEST(layer, layer_alloc_and_free)
     TEST_ASSERT_NULL(ptr_dw);
     TEST_ASSERT_NULL(ptr_db);
 }
+
+TEST(layer, layer_type_name)
+{
+    TEST_ASSERT_EQUAL_STRING("none", layer_type_name(LAYER_TYPE_NONE));
+    TEST_ASSERT_EQUAL_STRING("fc", layer_type_name(LAYER_TYPE_FC));
+    TEST_ASSERT_EQUAL_STRING("sigmoid_softmax", layer_type_name(LAYER_TYPE_SIGMOID_SOFTMAX));
+}
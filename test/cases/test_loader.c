@@ -0,0 +1,242 @@
+/**
+ * @file test_loader.c
+ * @brief unit tests of loader.c
+ * 
+ */
+#include "loader.h"
+
+#include <stdint.h>
+
+#include "unity_fixture.h"
+
+TEST_GROUP(loader);
+
+TEST_SETUP(loader)
+{}
+
+TEST_TEAR_DOWN(loader)
+{}
+
+// num of data used in tests
+#define N_DATA 10
+
+// data: { i, i + 0.5 }, label: { -i }
+static float xs[N_DATA][2];
+static float ts[N_DATA][1];
+static float *x[N_DATA];
+static float *t[N_DATA];
+static Dataset data;
+
+/**
+ * @brief set up data of tests
+ * 
+ */
+static void init_data(void)
+{
+    for (int i = 0; i < N_DATA; i++) {
+        xs[i][0] = i;
+        xs[i][1] = i + 0.5f;
+        ts[i][0] = -i;
+        x[i] = xs[i];
+        t[i] = ts[i];
+    }
+
+    data = dataset_wrap(x, t, N_DATA, 2, 1);
+}
+
+/**
+ * @brief take all batches of an epoch and check that they follow the order of indices
+ * 
+ * @param[in,out] loader target loader
+ * @param[in] indices order of data
+ */
+static void check_epoch(Loader *loader, const int *indices)
+{
+    loader_start(loader, indices);
+
+    int n = 0;
+    int n_batches = 0;
+    const LoaderBatch *batch;
+    while ((batch = loader_next(loader)) != NULL) {
+        TEST_ASSERT_EQUAL_INT(n_batches, batch->index);
+        TEST_ASSERT_EQUAL_INT(0, ((uintptr_t)batch->x % 64));
+        TEST_ASSERT_EQUAL_INT(0, ((uintptr_t)batch->t % 64));
+
+        for (int i = 0; i < batch->size; i++, n++) {
+            TEST_ASSERT_EQUAL_FLOAT(xs[indices[n]][0], batch->x[i * 2]);
+            TEST_ASSERT_EQUAL_FLOAT(xs[indices[n]][1], batch->x[i * 2 + 1]);
+            TEST_ASSERT_EQUAL_FLOAT(ts[indices[n]][0], batch->t[i]);
+        }
+        n_batches++;
+    }
+
+    // 3 + 3 + 3 + 1 samples
+    TEST_ASSERT_EQUAL_INT(N_DATA, n);
+    TEST_ASSERT_EQUAL_INT(4, n_batches);
+
+    // stays at the end of epoch
+    TEST_ASSERT_NULL(loader_next(loader));
+}
+
+TEST(loader, loader_create_and_free)
+{
+    init_data();
+
+    Loader *loader = loader_create(&data, 3, 2, false);
+
+    TEST_ASSERT_NOT_NULL(loader);
+
+    TEST_ASSERT_EQUAL_INT(N_DATA, loader->data_size);
+    TEST_ASSERT_EQUAL_INT(2, loader->x_size);
+    TEST_ASSERT_EQUAL_INT(1, loader->t_size);
+    TEST_ASSERT_EQUAL_INT(3, loader->batch_size);
+    TEST_ASSERT_EQUAL_INT(2, loader->depth);
+
+    // no epoch is started
+    TEST_ASSERT_NULL(loader_next(loader));
+
+    loader_free(&loader);
+
+    TEST_ASSERT_NULL(loader);
+}
+
+TEST(loader, loader_create_invalid)
+{
+    init_data();
+
+    Dataset empty    = dataset_wrap(x, t, 0, 2, 1);
+    Dataset no_input = dataset_wrap(x, t, N_DATA, 0, 1);
+
+    TEST_ASSERT_NULL(loader_create(NULL, 3, 2, false));
+    TEST_ASSERT_NULL(loader_create(&empty, 3, 2, false));
+    TEST_ASSERT_NULL(loader_create(&no_input, 3, 2, false));
+    TEST_ASSERT_NULL(loader_create(&data, 0, 2, false));
+    TEST_ASSERT_NULL(loader_create(&data, 3, 0, false));
+}
+
+TEST(loader, loader_next)
+{
+    init_data();
+
+    int forward[N_DATA]  = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    int shuffled[N_DATA] = { 7, 2, 9, 0, 4, 1, 8, 3, 6, 5 };
+
+    // double buffering, and a ring deeper than num of batches
+    for (int depth = 1; depth <= 5; depth += 4) {
+        Loader *loader = loader_create(&data, 3, depth, false);
+        TEST_ASSERT_NOT_NULL(loader);
+
+        check_epoch(loader, forward);
+        check_epoch(loader, shuffled);
+
+        loader_free(&loader);
+    }
+}
+
+TEST(loader, loader_restart)
+{
+    init_data();
+
+    int forward[N_DATA]  = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    int backward[N_DATA] = { 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
+
+    Loader *loader = loader_create(&data, 3, 2, false);
+    TEST_ASSERT_NOT_NULL(loader);
+
+    // batches of an unfinished epoch are discarded
+    loader_start(loader, forward);
+    const LoaderBatch *batch = loader_next(loader);
+    TEST_ASSERT_NOT_NULL(batch);
+    TEST_ASSERT_EQUAL_FLOAT(0, batch->x[0]);
+
+    check_epoch(loader, backward);
+
+    loader_free(&loader);
+}
+
+TEST(loader, loader_class_labels)
+{
+    Dataset *dataset = dataset_create_bytes(N_DATA, 2, 3, 1.0f, 0.0f);
+    TEST_ASSERT_NOT_NULL(dataset);
+
+    for (int i = 0; i < N_DATA; i++) {
+        dataset->x_u8[i * 2]     = (uint8_t)i;
+        dataset->x_u8[i * 2 + 1] = (uint8_t)(i * 2);
+        dataset->t_u8[i]         = (uint8_t)(i % 3);
+    }
+
+    Loader *loader = loader_create(dataset, 4, 2, true);
+    TEST_ASSERT_NOT_NULL(loader);
+
+    int shuffled[N_DATA] = { 7, 2, 9, 0, 4, 1, 8, 3, 6, 5 };
+    loader_start(loader, shuffled);
+
+    int n = 0;
+    const LoaderBatch *batch;
+    while ((batch = loader_next(loader)) != NULL) {
+        TEST_ASSERT_NULL(batch->t);
+        TEST_ASSERT_NOT_NULL(batch->labels);
+
+        for (int i = 0; i < batch->size; i++, n++) {
+            TEST_ASSERT_EQUAL_FLOAT(shuffled[n], batch->x[i * 2]);
+            TEST_ASSERT_EQUAL_FLOAT((shuffled[n] * 2), batch->x[i * 2 + 1]);
+            TEST_ASSERT_EQUAL_INT((shuffled[n] % 3), batch->labels[i]);
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(N_DATA, n);
+
+    loader_free(&loader);
+
+    // float labels have no class indices
+    init_data();
+    TEST_ASSERT_NULL(loader_create(&data, 4, 2, true));
+
+    dataset_free(&dataset);
+}
+
+TEST(loader, loader_augment)
+{
+    init_data();
+
+    // a sample is a row of 2 pixels, flipped at random
+    AugmentParameter param = SET_AUGMENT_PARAM(.height=1, .width=2, .flip=true, .seed=7);
+    Augmenter *augmenter = augmenter_create(param);
+    Augmenter *expected_augmenter = augmenter_create(param);
+    TEST_ASSERT_NOT_NULL(augmenter);
+    TEST_ASSERT_NOT_NULL(expected_augmenter);
+
+    Loader *loader = loader_create(&data, 3, 2, false);
+    TEST_ASSERT_NOT_NULL(loader);
+
+    loader_set_augmenter(loader, augmenter);
+
+    int shuffled[N_DATA] = { 7, 2, 9, 0, 4, 1, 8, 3, 6, 5 };
+    for (int epoch = 0; epoch < 2; epoch++) {
+        float expected[N_DATA * 2];
+        for (int i = 0; i < N_DATA; i++) {
+            expected[i * 2]     = xs[shuffled[i]][0];
+            expected[i * 2 + 1] = xs[shuffled[i]][1];
+        }
+        augment_batch(expected_augmenter, expected, N_DATA, epoch, 0);
+
+        loader_start(loader, shuffled);
+
+        int n = 0;
+        const LoaderBatch *batch;
+        while ((batch = loader_next(loader)) != NULL) {
+            TEST_ASSERT_EQUAL_FLOAT_ARRAY(&expected[n * 2], batch->x, (batch->size * 2));
+            for (int i = 0; i < batch->size; i++, n++) {
+                TEST_ASSERT_EQUAL_FLOAT(ts[shuffled[n]][0], batch->t[i]);
+            }
+        }
+        TEST_ASSERT_EQUAL_INT(N_DATA, n);
+    }
+
+    // samples are gathered as they are without augmenter
+    loader_set_augmenter(loader, NULL);
+    check_epoch(loader, shuffled);
+
+    loader_free(&loader);
+    augmenter_free(&augmenter);
+    augmenter_free(&expected_augmenter);
+}
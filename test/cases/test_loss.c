@@ -5,6 +5,8 @@
  */
 #include "loss.h"
 
+#include <stddef.h>
+
 #include "unity_fixture.h"
 
 TEST_GROUP(loss);
@@ -34,3 +36,29 @@ TEST(loss, cross_entropy_loss)
 
     TEST_ASSERT_EQUAL(6.447238, loss);
 }
+
+TEST(loss, mean_squared_loss_label)
+{
+    float y[4] = { 0.1, 0.6, 0.2, 0.1 };
+    float t[4] = { 0, 1, 0, 0 };
+
+    TEST_ASSERT_EQUAL_FLOAT(mean_squared_loss(y, t, 4), mean_squared_loss_label(y, 1, 4));
+}
+
+TEST(loss, cross_entropy_loss_label)
+{
+    float y[4] = { 0.1, 0.6, 0.2, 0.1 };
+    float t[4] = { 0, 0, 1, 0 };
+
+    TEST_ASSERT_EQUAL_FLOAT(cross_entropy_loss(y, t, 4), cross_entropy_loss_label(y, 2, 4));
+
+    // out of classes
+    TEST_ASSERT_EQUAL_FLOAT(0, cross_entropy_loss_label(y, 4, 4));
+}
+
+TEST(loss, loss_label_func)
+{
+    TEST_ASSERT(loss_label_func(mean_squared_loss) == mean_squared_loss_label);
+    TEST_ASSERT(loss_label_func(cross_entropy_loss) == cross_entropy_loss_label);
+    TEST_ASSERT(loss_label_func(NULL) == NULL);
+}
@@ -383,6 +383,39 @@ TEST(mat, test_mat_mul_trans_a)
     TEST_ASSERT_EQUAL_FLOAT_ARRAY(ans, c, (3 * 4));
 }
 
+TEST(mat, test_mat_mul_trans_a_acc)
+{
+    float a[2 * 3] = {
+        0, 2, 4,
+        1, 3, 5
+    };
+
+    float b[2 * 4] = {
+        -2, -1, 0, 1,
+        0, 1, 2, 3,
+    };
+
+    float c[3 * 4] = {
+        1, 1, 1, 1,
+        2, 2, 2, 2,
+        3, 3, 3, 3
+    };
+
+    float ans[3 * 4] = {
+        1, 2, 3, 4,
+        -2, 3, 8, 13,
+        -5, 4, 13, 22
+    };
+
+    float *ptr = mat_mul_trans_a_acc(a, b, c, 2, 3, 4);
+
+    TEST_ASSERT_EQUAL_PTR(c, ptr);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(ans, c, (3 * 4));
+
+    TEST_ASSERT_NULL(mat_mul_trans_a_acc(a, b, c, 0, 3, 4));
+    TEST_ASSERT_NULL(mat_mul_trans_a_acc(NULL, b, c, 2, 3, 4));
+}
+
 TEST(mat, test_mat_mul_trans_a_invalid_sizes)
 {
     float a[2 * 3] = {
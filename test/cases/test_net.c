@@ -3,9 +3,12 @@
  * @brief unit test of net.c
  * 
  */
+#include <string.h>
+
 #include "data.h"
 #include "net.h"
 #include "layers.h"
+#include "loss.h"
 #include "mat.h"
 #include "random.h"
 #include "util.h"
@@ -27,10 +30,9 @@ TEST(net, net_alloc_and_free)
     TEST_ASSERT_NOT_NULL(net);
 
     TEST_ASSERT_EQUAL(0, net->size);
+    TEST_ASSERT_EQUAL(0, net->capacity);
 
-    for (int i = 0; i < NET_LAYER_MAX_SIZE; i++) {
-        TEST_ASSERT_NULL(net->layers[i]);
-    }
+    TEST_ASSERT_NULL(net->layers);
 
     TEST_ASSERT_NULL(net->input_layer);
     TEST_ASSERT_NULL(net->output_layer);
@@ -65,22 +67,24 @@ TEST(net, net_create_and_free)
     TEST_ASSERT_NOT_NULL(net->layers[0]->y);
     TEST_ASSERT_NOT_NULL(net->layers[0]->w);
     TEST_ASSERT_NOT_NULL(net->layers[0]->b);
-    TEST_ASSERT_EQUAL_INT(-1, net->layers[0]->prev_id);
-    TEST_ASSERT_EQUAL_INT(net->layers[1]->id, net->layers[0]->next_id);
+    TEST_ASSERT_EQUAL_INT(-1, net->layers[0]->in_ids[0]);
+    TEST_ASSERT_EQUAL_INT(1, net->layers[0]->n_out);
+    TEST_ASSERT_EQUAL_INT(net->layers[1]->id, net->layers[0]->out_ids[0]);
 
     TEST_ASSERT_EQUAL_INT(10, net->layers[1]->x_size);
     TEST_ASSERT_EQUAL_INT(10, net->layers[1]->y_size);
     TEST_ASSERT_EQUAL_PTR(net->layers[0]->y, net->layers[1]->x);
     TEST_ASSERT_NOT_NULL(net->layers[1]->y);
-    TEST_ASSERT_EQUAL_INT(net->layers[0]->id, net->layers[1]->prev_id);
-    TEST_ASSERT_EQUAL_INT(net->layers[2]->id, net->layers[1]->next_id);
+    TEST_ASSERT_EQUAL_INT(net->layers[0]->id, net->layers[1]->in_ids[0]);
+    TEST_ASSERT_EQUAL_INT(1, net->layers[1]->n_out);
+    TEST_ASSERT_EQUAL_INT(net->layers[2]->id, net->layers[1]->out_ids[0]);
 
     TEST_ASSERT_EQUAL_INT(10, net->layers[2]->x_size);
     TEST_ASSERT_EQUAL_INT(10, net->layers[2]->y_size);
     TEST_ASSERT_EQUAL_PTR(net->layers[1]->y, net->layers[2]->x);
     TEST_ASSERT_NOT_NULL(net->layers[2]->y);
-    TEST_ASSERT_EQUAL_INT(net->layers[1]->id, net->layers[2]->prev_id);
-    TEST_ASSERT_EQUAL_INT(-1, net->layers[2]->next_id);
+    TEST_ASSERT_EQUAL_INT(net->layers[1]->id, net->layers[2]->in_ids[0]);
+    TEST_ASSERT_EQUAL_INT(0, net->layers[2]->n_out);
 
     TEST_ASSERT_EQUAL_PTR(net->layers[0], net->input_layer);
     TEST_ASSERT_EQUAL_PTR(net->layers[2], net->output_layer);
@@ -90,20 +94,28 @@ TEST(net, net_create_and_free)
     TEST_ASSERT_NULL(net);
 }
 
-TEST(net, net_create_over_size)
+TEST(net, net_create_invalid_size)
 {
-    Net *net = net_create(
-        257,
-        (Layer*[]){
-            fc_layer((LayerParameter){ .in=2, .out=10 }),
-            sigmoid_layer((LayerParameter){ .in=10 }),
-            softmax_layer((LayerParameter){ .in=10 })
-        }
-    );
+    Net *net = net_create(0, (Layer*[]){ NULL });
 
     TEST_ASSERT_NULL(net);
 }
 
+TEST(net, net_create_many_layers)
+{
+    Net *net = net_alloc();
+
+    for (int i = 0; i < 300; i++) {
+        TEST_ASSERT_EQUAL_PTR(net, net_append(net, sigmoid_layer((LayerParameter){ .in=2 })));
+    }
+
+    TEST_ASSERT_EQUAL_INT(300, net->size);
+    TEST_ASSERT_GREATER_OR_EQUAL(300, net->capacity);
+    TEST_ASSERT_EQUAL_PTR(net->layers[298]->y, net->layers[299]->x);
+
+    net_free(&net);
+}
+
 TEST(net, net_append)
 {
     Net *net = net_alloc();
@@ -130,6 +142,32 @@ TEST(net, net_append_null)
     Net *net = net_alloc();
 
     TEST_ASSERT_NULL(net_append(net, NULL));
+
+    net_free(&net);
+}
+
+TEST(net, net_connect_invalid)
+{
+    Net *net = net_alloc();
+
+    net_append(net, fc_layer((LayerParameter){ .in=2, .out=3 }));
+
+    // size mismatch
+    Layer *sigmoid = sigmoid_layer((LayerParameter){ .in=4 });
+    TEST_ASSERT_NULL(net_connect(net, sigmoid, 1, (int[]){ 0 }, NULL));
+
+    // num of inputs mismatch
+    Layer *add = add_layer((LayerParameter){ .in=3, .n_in=2 });
+    TEST_ASSERT_NULL(net_connect(net, add, 1, (int[]){ 0 }, NULL));
+
+    // unknown layer
+    TEST_ASSERT_NULL(net_connect(net, add, 2, (int[]){ 0, 1 }, NULL));
+
+    TEST_ASSERT_EQUAL_INT(1, net->size);
+
+    layer_free(&sigmoid);
+    layer_free(&add);
+    net_free(&net);
 }
 
 TEST(net, net_init_layer_params)
@@ -250,3 +288,812 @@ TEST(net, net_backward)
 
     net_free(&net);
 }
+
+TEST(net, net_backward_label)
+{
+    // input is referenced by backward propagation
+    float x[] = { 0.1, 0.2 };
+
+    Net *nets[2];
+    for (int i = 0; i < 2; i++) {
+        nets[i] = net_create(
+            3,
+            (Layer*[]){
+                fc_layer((LayerParameter){ .in=2, .out=3 }),
+                sigmoid_layer((LayerParameter){ .in=3 }),
+                softmax_layer((LayerParameter){ .in=3 })
+            }
+        );
+        TEST_ASSERT_NOT_NULL(nets[i]);
+
+        float w[] = {
+            1, 2,
+            3, 4,
+            -1, 0.5
+        };
+        fdata_copy(w, nets[i]->layers[0]->w_size, nets[i]->layers[0]->w);
+
+        float b[] = { 0, 1, -1 };
+        fdata_copy(b, nets[i]->layers[0]->b_size, nets[i]->layers[0]->b);
+
+        net_forward(nets[i], x);
+    }
+
+    // same as one-hot vector
+    float t[] = { 0, 0, 1 };
+    net_backward(nets[0], t);
+    net_backward_label(nets[1], 2);
+
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(nets[0]->layers[0]->dx, nets[1]->layers[0]->dx, 2);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(nets[0]->layers[0]->dw, nets[1]->layers[0]->dw, 6);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(nets[0]->layers[0]->db, nets[1]->layers[0]->db, 3);
+
+    net_free(&nets[0]);
+    net_free(&nets[1]);
+}
+
+/**
+ * @brief create residual network: y = softmax(fc2(sigmoid(fc1(x))) + fc1(x))
+ *
+ * @return Net* pointer to network structure
+ */
+static Net *create_residual_net(void)
+{
+    Net *net = net_alloc();
+
+    net_append(net, fc_layer((LayerParameter){ .in=2, .out=2 }));        // 0
+    net_append(net, sigmoid_layer((LayerParameter){ .in=2 }));           // 1
+    net_append(net, fc_layer((LayerParameter){ .in=2, .out=2 }));        // 2
+    net_connect(net, add_layer((LayerParameter){ .in=2, .n_in=2 }), 2, (int[]){ 2, 0 }, NULL); // 3
+    net_append(net, softmax_layer((LayerParameter){ .in=2 }));           // 4
+
+    float w1[] = { 1, 2, 3, 4 };
+    float b1[] = { 0, 1 };
+    float w2[] = { 0.5, -1, 1, 0.5 };
+    float b2[] = { 0.1, -0.1 };
+    fdata_copy(w1, 4, net->layers[0]->w);
+    fdata_copy(b1, 2, net->layers[0]->b);
+    fdata_copy(w2, 4, net->layers[2]->w);
+    fdata_copy(b2, 2, net->layers[2]->b);
+
+    return net;
+}
+
+TEST(net, net_residual)
+{
+    Net *net = create_residual_net();
+
+    TEST_ASSERT_EQUAL_INT(5, net->size);
+    TEST_ASSERT_EQUAL_INT(2, net->layers[0]->n_out);
+    TEST_ASSERT_EQUAL_PTR(net->layers[2]->y, net->layers[3]->xs[0]);
+    TEST_ASSERT_EQUAL_PTR(net->layers[0]->y, net->layers[3]->xs[1]);
+
+    float x[] = { 0.1, 0.2 };
+
+    net_forward(net, x);
+
+    // fc1: { 0.7, 2 }, sigmoid: { 0.66818777, 0.88079708 }
+    // fc2: { 1.31489096, -0.32778923 }, add: { 2.01489096, 1.67221077 }
+    float y_add[] = { 2.01489096, 1.67221077 };
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(y_add, net->layers[3]->y, 2);
+
+    float t[] = { 0, 1 };
+
+    net_backward(net, t);
+
+    // diff of fc1 output is the sum of those from add and sigmoid
+    float dy_fc1[2];
+    mat_add(net->layers[3]->dxs[1], net->layers[1]->dx, dy_fc1, 1, 2);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(dy_fc1, net->layers[0]->dy, 2);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(dy_fc1, net->layers[0]->db, 2);
+
+    net_free(&net);
+}
+
+TEST(net, net_concat_and_split)
+{
+    Net *net = net_alloc();
+
+    // split input into 2 branches and concatenate them again
+    net_append(net, split_layer((LayerParameter){ .in=4, .n_out=2, .outs={ 1, 3 } }));     // 0
+    net_connect(net, sigmoid_layer((LayerParameter){ .in=1 }), 1, (int[]){ 0 }, (int[]){ 0 }); // 1
+    net_connect(net, fc_layer((LayerParameter){ .in=3, .out=2 }), 1, (int[]){ 0 }, (int[]){ 1 }); // 2
+    net_connect(net, concat_layer((LayerParameter){ .n_in=2, .ins={ 2, 1 } }), 2, (int[]){ 2, 1 }, NULL); // 3
+
+    TEST_ASSERT_EQUAL_INT(3, net->layers[3]->y_size);
+    TEST_ASSERT_EQUAL_PTR(net->layers[0]->y + 1, net->layers[2]->x);
+
+    float w[] = { 1, 0, 0, 1, 1, 1 };
+    float b[] = { 0, 0 };
+    fdata_copy(w, 6, net->layers[2]->w);
+    fdata_copy(b, 2, net->layers[2]->b);
+
+    float x[] = { 0, 1, 2, 3 };
+
+    net_forward(net, x);
+
+    float y[] = { 4, 5, 0.5 };
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(y, net->output_layer->y, 3);
+
+    float t[] = { 3, 5, 0 };
+
+    net_backward(net, t);
+
+    // dy = { 1, 0, 0.5 }, gathered into the ports of split layer
+    float dx[] = { 0.125, 1, 0, 1 };
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(dx, net->layers[0]->dx, 4);
+
+    net_free(&net);
+}
+
+TEST(net, net_shared_input)
+{
+    Net *net = net_alloc();
+
+    // the output of FC is taken twice by the same consumer
+    net_append(net, fc_layer((LayerParameter){ .in=2, .out=2 }));                           // 0
+    net_connect(net, add_layer((LayerParameter){ .in=2, .n_in=2 }), 2, (int[]){ 0, 0 }, NULL); // 1
+
+    float w[] = { 1, 0, 0, 1 };
+    float b[] = { 0, 0 };
+    fdata_copy(w, 4, net->layers[0]->w);
+    fdata_copy(b, 2, net->layers[0]->b);
+
+    float x[] = { 1, 2 };
+
+    net_forward(net, x);
+
+    float y[] = { 2, 4 };
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(y, net->output_layer->y, 2);
+
+    float t[] = { 1, 1 };
+
+    net_backward(net, t);
+
+    // dy = { 1, 3 } is gathered twice
+    float db[] = { 2, 6 };
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(db, net->layers[0]->db, 2);
+
+    net_free(&net);
+}
+
+TEST(net, net_split_ports_to_one_consumer)
+{
+    Net *net = net_alloc();
+
+    // both ports of split layer are concatenated by the same consumer
+    net_append(net, split_layer((LayerParameter){ .in=4, .n_out=2, .outs={ 2, 2 } }));                    // 0
+    net_connect(net, concat_layer((LayerParameter){ .n_in=2, .ins={ 2, 2 } }), 2, (int[]){ 0, 0 }, (int[]){ 1, 0 }); // 1
+
+    float x[] = { 0, 1, 2, 3 };
+
+    net_forward(net, x);
+
+    float y[] = { 2, 3, 0, 1 };
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(y, net->output_layer->y, 4);
+
+    float t[] = { 0, 0, 0, 0 };
+
+    net_backward(net, t);
+
+    // dy = y is gathered back into the ports of split layer
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(x, net->layers[0]->dx, 4);
+
+    net_free(&net);
+}
+
+TEST(net, net_schedule_levels)
+{
+    Net *net = create_residual_net();
+
+    float x[] = { 0.1, 0.2 };
+
+    net_forward(net, x);
+
+    TEST_ASSERT_EQUAL_INT(5, net->n_levels);
+
+    net_free(&net);
+
+    // two independent branches
+    net = net_alloc();
+    net_append(net, fc_layer((LayerParameter){ .in=2, .out=2 }));
+    net_connect(net, fc_layer((LayerParameter){ .in=2, .out=2 }), 1, (int[]){ -1 }, NULL);
+    net_connect(net, add_layer((LayerParameter){ .in=2, .n_in=2 }), 2, (int[]){ 0, 1 }, NULL);
+
+    net_forward(net, x);
+
+    TEST_ASSERT_EQUAL_INT(2, net->n_levels);
+    TEST_ASSERT_EQUAL_INT(0, net->level_start[0]);
+    TEST_ASSERT_EQUAL_INT(2, net->level_start[1]);
+    TEST_ASSERT_EQUAL_INT(3, net->level_start[2]);
+    TEST_ASSERT_EQUAL_PTR(x, net->layers[1]->x);
+
+    net_free(&net);
+}
+
+TEST(net, net_parallel_branches)
+{
+    Net *serial   = net_alloc();
+    Net *parallel = net_alloc();
+    Net *nets[] = { serial, parallel };
+
+    for (int n = 0; n < 2; n++) {
+        rand_seed(0);
+        for (int i = 0; i < 4; i++) {
+            net_connect(nets[n], fc_layer((LayerParameter){ .in=3, .out=5 }), 1, (int[]){ -1 }, NULL);
+            net_append(nets[n], sigmoid_layer((LayerParameter){ .in=5 }));
+        }
+        net_connect(nets[n], add_layer((LayerParameter){ .in=5, .n_in=4 }), 4, (int[]){ 1, 3, 5, 7 }, NULL);
+        net_append(nets[n], softmax_layer((LayerParameter){ .in=5 }));
+        net_init_layer_params(nets[n]);
+    }
+
+    ThreadPool *pool = thread_pool_create(4);
+    net_set_thread_pool(parallel, pool);
+
+    float x[] = { 0.1, -0.2, 0.3 };
+    float t[] = { 0, 0, 1, 0, 0 };
+
+    for (int n = 0; n < 2; n++) {
+        net_forward(nets[n], x);
+        net_backward(nets[n], t);
+    }
+
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(serial->output_layer->y, parallel->output_layer->y, 5);
+    for (int i = 0; i < 8; i += 2) {
+        TEST_ASSERT_EQUAL_FLOAT_ARRAY(serial->layers[i]->dw, parallel->layers[i]->dw, 15);
+    }
+
+    thread_pool_free(&pool);
+    net_free(&serial);
+    net_free(&parallel);
+}
+
+/**
+ * @brief create network with the same structure as MNIST example
+ * 
+ * @return Net* pointer to network structure
+ */
+static Net *create_mnist_like_net(void)
+{
+    Net *net = net_create(
+        5,
+        (Layer*[]){
+            fc_layer((LayerParameter){ .in=12, .out=8 }),
+            sigmoid_layer((LayerParameter){ .in=8 }),
+            fc_layer((LayerParameter){ .in=8, .out=4 }),
+            sigmoid_layer((LayerParameter){ .in=4 }),
+            softmax_layer((LayerParameter){ .in=4 })
+        }
+    );
+
+    rand_seed(0);
+
+    net_init_layer_params(net);
+
+    return net;
+}
+
+TEST(net, net_optimize)
+{
+    Net *net = create_mnist_like_net();
+    Net *ref = create_mnist_like_net();
+
+    int y_size = 0;
+    for (int i = 0; i < net->size; i++) {
+        y_size += net->layers[i]->y_size;
+    }
+
+    TEST_ASSERT_EQUAL_INT(2, net_optimize(net));
+
+    // FC->Sigmoid, FC, Sigmoid->Softmax
+    TEST_ASSERT_EQUAL_INT(3, net->size);
+    TEST_ASSERT_EQUAL_INT(LAYER_TYPE_FC_SIGMOID, net->layers[0]->type);
+    TEST_ASSERT_EQUAL_INT(LAYER_TYPE_FC, net->layers[1]->type);
+    TEST_ASSERT_EQUAL_INT(LAYER_TYPE_SIGMOID_SOFTMAX, net->layers[2]->type);
+    TEST_ASSERT_EQUAL_PTR(net->layers[0], net->input_layer);
+    TEST_ASSERT_EQUAL_PTR(net->layers[2], net->output_layer);
+    TEST_ASSERT_EQUAL_PTR(net->layers[0]->y, net->layers[1]->x);
+    TEST_ASSERT_EQUAL_PTR(net->layers[1]->y, net->layers[2]->x);
+
+    // intermediate outputs are no longer written
+    int fused_y_size = 0;
+    for (int i = 0; i < net->size; i++) {
+        fused_y_size += net->layers[i]->y_size;
+    }
+    TEST_ASSERT_EQUAL_INT((y_size - 8 - 4), fused_y_size);
+
+    float x[12];
+    fdata_rand_uniform(x, 12);
+    float t[] = { 0, 1, 0, 0 };
+
+    net_forward(net, x);
+    net_forward(ref, x);
+
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(ref->output_layer->y, net->output_layer->y, 4);
+
+    net_backward(net, t);
+    net_backward(ref, t);
+
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(ref->layers[0]->dx, net->layers[0]->dx, 12);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(ref->layers[0]->dw, net->layers[0]->dw, (12 * 8));
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(ref->layers[2]->dw, net->layers[1]->dw, (8 * 4));
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(ref->layers[2]->db, net->layers[1]->db, 4);
+
+    // nothing left to fuse
+    TEST_ASSERT_EQUAL_INT(0, net_optimize(net));
+
+    net_free(&net);
+    net_free(&ref);
+}
+
+TEST(net, net_optimize_branch)
+{
+    Net *net = create_residual_net();
+
+    // fc1 has two consumers, fc2 feeds add
+    TEST_ASSERT_EQUAL_INT(0, net_optimize(net));
+    TEST_ASSERT_EQUAL_INT(5, net->size);
+
+    net_free(&net);
+
+    // fc2->ReLU and ReLU->add in a branch
+    net = net_alloc();
+    net_append(net, fc_layer((LayerParameter){ .in=2, .out=2 }));
+    net_append(net, relu_layer((LayerParameter){ .in=2 }));
+    net_connect(net, fc_layer((LayerParameter){ .in=2, .out=2 }), 1, (int[]){ -1 }, NULL);
+    net_append(net, relu_layer((LayerParameter){ .in=2 }));
+    net_connect(net, add_layer((LayerParameter){ .in=2, .n_in=2 }), 2, (int[]){ 1, 3 }, NULL);
+
+    rand_seed(0);
+    net_init_layer_params(net);
+
+    TEST_ASSERT_EQUAL_INT(2, net_optimize(net));
+    TEST_ASSERT_EQUAL_INT(3, net->size);
+    TEST_ASSERT_EQUAL_INT(LAYER_TYPE_FC_RELU, net->layers[0]->type);
+    TEST_ASSERT_EQUAL_INT(LAYER_TYPE_FC_RELU, net->layers[1]->type);
+    TEST_ASSERT_EQUAL_INT(0, net->layers[2]->in_ids[0]);
+    TEST_ASSERT_EQUAL_INT(1, net->layers[2]->in_ids[1]);
+    TEST_ASSERT_EQUAL_INT(-1, net->layers[1]->in_ids[0]);
+    TEST_ASSERT_EQUAL_INT(1, net->layers[0]->n_out);
+    TEST_ASSERT_EQUAL_INT(2, net->layers[0]->out_ids[0]);
+
+    float x[] = { 0.5, -0.5 };
+
+    net_forward(net, x);
+
+    TEST_ASSERT_EQUAL_INT(2, net->n_levels);
+
+    net_free(&net);
+}
+
+TEST(net, net_profile_report)
+{
+    Net *net = create_mnist_like_net();
+
+    float x[12] = { 0 };
+    float t[] = { 0, 1, 0, 0 };
+
+    for (int i = 0; i < 3; i++) {
+        net_forward(net, x);
+        net_backward(net, t);
+    }
+    net_forward(net, x);
+
+    FILE *fp = tmpfile();
+
+#ifdef NNC_PROFILE
+    for (int i = 0; i < net->size; i++) {
+        TEST_ASSERT_EQUAL_INT(4, net->layers[i]->profile.forward.count);
+        TEST_ASSERT_EQUAL_INT(3, net->layers[i]->profile.backward.count);
+        TEST_ASSERT(net->layers[i]->profile.forward.min <= net->layers[i]->profile.forward.max);
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, net_profile_report(net, fp, PROFILE_FORMAT_JSON));
+
+    char text[8192];
+    rewind(fp);
+    size_t n = fread(text, 1, (sizeof(text) - 1), fp);
+    text[n] = '\0';
+
+    TEST_ASSERT_NOT_NULL(strstr(text, "{\"id\": 0, \"type\": \"fc\", \"forward\": {\"count\": 4,"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "\"type\": \"softmax\""));
+    TEST_ASSERT_NOT_NULL(strstr(text, "\"flops\": 200, \"bytes\": 496"));
+#ifndef NNC_PROFILE_PERF
+    TEST_ASSERT_NOT_NULL(strstr(text, "\"cycles\": null"));
+#endif
+
+    TEST_ASSERT_EQUAL_INT(0, net_profile_report(net, fp, PROFILE_FORMAT_TABLE));
+
+    net_profile_reset(net);
+
+    TEST_ASSERT_EQUAL_INT(0, net->layers[0]->profile.forward.count);
+#else
+    // instrumentation is compiled out
+    for (int i = 0; i < net->size; i++) {
+        TEST_ASSERT_EQUAL_INT(0, net->layers[i]->profile.forward.count);
+        TEST_ASSERT_EQUAL_INT(0, net->layers[i]->profile.backward.count);
+    }
+
+    TEST_ASSERT_EQUAL_INT(-1, net_profile_report(net, fp, PROFILE_FORMAT_TABLE));
+#endif
+
+    fclose(fp);
+    net_free(&net);
+}
+
+TEST(net, net_replicate)
+{
+    Net *net = create_residual_net();
+
+    Net *replica = net_replicate(net);
+
+    TEST_ASSERT_NOT_NULL(replica);
+    TEST_ASSERT_EQUAL_INT(net->size, replica->size);
+
+    for (int i = 0; i < net->size; i++) {
+        Layer *src   = net->layers[i];
+        Layer *layer = replica->layers[i];
+
+        TEST_ASSERT_EQUAL_INT(src->type, layer->type);
+        TEST_ASSERT_EQUAL_INT(src->n_in, layer->n_in);
+        TEST_ASSERT_EQUAL_INT_ARRAY(src->in_ids, layer->in_ids, src->n_in);
+
+        // shared parameters, own outputs
+        TEST_ASSERT_EQUAL_PTR(src->w, layer->w);
+        TEST_ASSERT_EQUAL_PTR(src->b, layer->b);
+        TEST_ASSERT(src->y != layer->y);
+        TEST_ASSERT(layer->shared_params);
+    }
+
+    float x[] = { 0.1, 0.2 };
+    float t[] = { 1, 0 };
+
+    net_forward(net, x);
+    net_forward(replica, x);
+
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(net->output_layer->y, replica->output_layer->y, 2);
+
+    // update through the replica is visible to the source
+    net_backward(replica, t);
+    replica->layers[0]->update(replica->layers[0], 0.1);
+
+    TEST_ASSERT_EQUAL_FLOAT((1 - 0.1 * replica->layers[0]->dw[0]), net->layers[0]->w[0]);
+
+    net_free(&replica);
+
+    TEST_ASSERT_NULL(replica);
+
+    // parameters are still owned by the source
+    net_forward(net, x);
+    TEST_ASSERT_EQUAL_FLOAT(1, (net->output_layer->y[0] + net->output_layer->y[1]));
+
+    net_free(&net);
+
+    TEST_ASSERT_NULL(net_replicate(NULL));
+}
+
+TEST(net, net_evaluate)
+{
+    Net *net = net_create(
+        2,
+        (Layer*[]){
+            fc_layer((LayerParameter){ .in=3, .out=3 }),
+            softmax_layer((LayerParameter){ .in=3 })
+        }
+    );
+
+    // identity, the class is the index of the max input
+    float w[] = {
+        1, 0, 0,
+        0, 1, 0,
+        0, 0, 1
+    };
+    fdata_copy(w, 9, net->layers[0]->w);
+    fdata_copy((float[]){ 0, 0, 0 }, 3, net->layers[0]->b);
+
+    for (int i = 0; i < 9; i++) {
+        net->layers[0]->dw[i] = -1;
+    }
+
+    float *x[] = {
+        (float[3]){ 3, 1, 0 },
+        (float[3]){ 0, 2, 1 },
+        (float[3]){ 0, 1, 2 },
+        (float[3]){ 2, 1, 0 },
+        (float[3]){ 0, 0, 1 },
+        (float[3]){ 2, 1, 0 }
+    };
+
+    float *t[] = {
+        (float[3]){ 1, 0, 0 },
+        (float[3]){ 0, 1, 0 },
+        (float[3]){ 0, 0, 1 },
+        (float[3]){ 0, 1, 0 },
+        (float[3]){ 1, 0, 0 },
+        (float[3]){ 0, 0, 1 }
+    };
+
+    float loss = 0;
+    for (int i = 0; i < 6; i++) {
+        net_forward(net, x[i]);
+        loss += cross_entropy_loss(net->output_layer->y, t[i], 3);
+    }
+    loss /= 6;
+
+    int confusion[] = {
+        1, 0, 1,
+        1, 1, 0,
+        1, 0, 1
+    };
+
+    // serial, with a temporary thread pool and with the thread pool of network
+    ThreadPool *pool = thread_pool_create(2);
+    const int n_threads[] = { 0, 4, 0 };
+
+    for (int i = 0; i < 3; i++) {
+        net_set_thread_pool(net, ((i == 2) ? pool : NULL));
+
+        EvalResult *result = net_evaluate(
+            net, x, t, 6, SET_EVAL_PARAM(.loss_func=cross_entropy_loss, .top_k=2, .n_threads=n_threads[i])
+        );
+
+        TEST_ASSERT_NOT_NULL(result);
+
+        TEST_ASSERT_EQUAL_INT(6, result->count);
+        TEST_ASSERT_FLOAT_WITHIN(1e-6, loss, result->loss);
+        TEST_ASSERT_EQUAL_FLOAT((3.0f / 6), result->accuracy);
+        TEST_ASSERT_EQUAL_FLOAT((5.0f / 6), result->top_k_accuracy);
+        TEST_ASSERT_EQUAL_INT(2, result->top_k);
+        TEST_ASSERT_EQUAL_INT(3, result->n_classes);
+        TEST_ASSERT_EQUAL_INT_ARRAY(confusion, result->confusion, 9);
+
+        net_eval_result_free(&result);
+
+        TEST_ASSERT_NULL(result);
+    }
+
+    net_set_thread_pool(net, NULL);
+    thread_pool_free(&pool);
+
+    // diffs are not touched
+    for (int i = 0; i < 9; i++) {
+        TEST_ASSERT_EQUAL_FLOAT(-1, net->layers[0]->dw[i]);
+    }
+
+    // loss is not calculated, top-1 by default
+    EvalResult *result = net_evaluate(net, x, t, 6, SET_EVAL_PARAM(.loss_func=NULL));
+    TEST_ASSERT_NOT_NULL(result);
+    TEST_ASSERT_EQUAL_FLOAT(0, result->loss);
+    TEST_ASSERT_EQUAL_INT(1, result->top_k);
+    TEST_ASSERT_EQUAL_FLOAT(result->accuracy, result->top_k_accuracy);
+    net_eval_result_free(&result);
+
+    TEST_ASSERT_NULL(net_evaluate(NULL, x, t, 6, SET_EVAL_PARAM(.loss_func=NULL)));
+    TEST_ASSERT_NULL(net_evaluate(net, x, t, 0, SET_EVAL_PARAM(.loss_func=NULL)));
+    TEST_ASSERT_NULL(net_evaluate(net, x, t, 6, SET_EVAL_PARAM(.top_k=-1)));
+
+    net_free(&net);
+}
+
+TEST(net, evaluator_run)
+{
+    Net *net = net_create(
+        2,
+        (Layer*[]){
+            fc_layer((LayerParameter){ .in=3, .out=3 }),
+            softmax_layer((LayerParameter){ .in=3 })
+        }
+    );
+
+    // identity, the class is the index of the max input
+    float w[] = {
+        1, 0, 0,
+        0, 1, 0,
+        0, 0, 1
+    };
+    fdata_copy(w, 9, net->layers[0]->w);
+    fdata_copy((float[]){ 0, 0, 0 }, 3, net->layers[0]->b);
+
+    float *x[] = {
+        (float[3]){ 3, 1, 0 },
+        (float[3]){ 0, 2, 1 },
+        (float[3]){ 0, 1, 2 },
+        (float[3]){ 2, 1, 0 }
+    };
+
+    float *t[] = {
+        (float[3]){ 1, 0, 0 },
+        (float[3]){ 0, 1, 0 },
+        (float[3]){ 0, 0, 1 },
+        (float[3]){ 0, 1, 0 }
+    };
+
+    Evaluator *evaluator = evaluator_create(net, 2);
+
+    TEST_ASSERT_NOT_NULL(evaluator);
+    TEST_ASSERT_EQUAL_INT(2, evaluator->n_replicas);
+
+    EvalResult *result = evaluator_run(evaluator, x, t, 4, SET_EVAL_PARAM(.loss_func=cross_entropy_loss));
+    TEST_ASSERT_NOT_NULL(result);
+    TEST_ASSERT_EQUAL_FLOAT((3.0f / 4), result->accuracy);
+    net_eval_result_free(&result);
+
+    // updated parameters are seen by the replicas, with the same result as net_evaluate()
+    net->layers[0]->w[4] = 0;
+
+    result = evaluator_run(evaluator, x, t, 4, SET_EVAL_PARAM(.loss_func=cross_entropy_loss));
+    EvalResult *expected = net_evaluate(net, x, t, 4, SET_EVAL_PARAM(.loss_func=cross_entropy_loss));
+    TEST_ASSERT_NOT_NULL(result);
+    TEST_ASSERT_NOT_NULL(expected);
+    TEST_ASSERT_EQUAL_FLOAT((2.0f / 4), result->accuracy);
+    TEST_ASSERT_EQUAL_FLOAT(expected->loss, result->loss);
+    TEST_ASSERT_EQUAL_INT_ARRAY(expected->confusion, result->confusion, 9);
+    net_eval_result_free(&result);
+    net_eval_result_free(&expected);
+
+    TEST_ASSERT_NULL(evaluator_run(evaluator, x, t, 0, SET_EVAL_PARAM(.loss_func=NULL)));
+    TEST_ASSERT_NULL(evaluator_run(NULL, x, t, 4, SET_EVAL_PARAM(.loss_func=NULL)));
+
+    evaluator_free(&evaluator);
+
+    TEST_ASSERT_NULL(evaluator);
+    TEST_ASSERT_NULL(evaluator_create(NULL, 2));
+    TEST_ASSERT_NULL(evaluator_create(net, -1));
+
+    net_free(&net);
+}
+
+TEST(net, net_accumulate)
+{
+    float x0[] = { 0.1, 0.2 };
+    float x1[] = { 0.4, -0.3 };
+    float t0[] = { 1, 0 };
+    float t1[] = { 0, 1 };
+
+    // plain and fused layers
+    for (int fused = 0; fused < 2; fused++) {
+        rand_seed(0);
+
+        Net *net = net_create(
+            4,
+            (Layer*[]){
+                fc_layer((LayerParameter){ .in=2, .out=3 }),
+                relu_layer((LayerParameter){ .in=3 }),
+                fc_layer((LayerParameter){ .in=3, .out=2 }),
+                softmax_layer((LayerParameter){ .in=2 })
+            }
+        );
+        net_init_layer_params(net);
+        if (fused) {
+            TEST_ASSERT_EQUAL_INT(2, net_optimize(net));
+        }
+
+        // gradients of each sample
+        float dw0[6], db0[3], dw1[6], db1[3];
+        net_forward(net, x0);
+        net_backward(net, t0);
+        fdata_copy(net->layers[0]->dw, 6, dw0);
+        fdata_copy(net->layers[0]->db, 3, db0);
+
+        net_forward(net, x1);
+        net_backward(net, t1);
+        fdata_copy(net->layers[0]->dw, 6, dw1);
+        fdata_copy(net->layers[0]->db, 3, db1);
+
+        // mean of accumulated gradients
+        net_set_accumulate(net, true);
+        net_zero_grad(net);
+
+        net_forward(net, x0);
+        net_backward(net, t0);
+        net_forward(net, x1);
+        net_backward(net, t1);
+
+        net_scale_grad(net, 0.5);
+
+        for (int i = 0; i < 6; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-6, ((dw0[i] + dw1[i]) * 0.5f), net->layers[0]->dw[i]);
+        }
+        for (int i = 0; i < 3; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-6, ((db0[i] + db1[i]) * 0.5f), net->layers[0]->db[i]);
+        }
+
+        net_zero_grad(net);
+        for (int i = 0; i < 6; i++) {
+            TEST_ASSERT_EQUAL_FLOAT(0, net->layers[0]->dw[i]);
+        }
+
+        net_free(&net);
+    }
+}
+
+TEST(net, net_forward_sparse)
+{
+    // nonzeros at 1, 5 and 11 of 12 inputs
+    SparseMatrix *x = sparse_create(1, 12, 3);
+    TEST_ASSERT_NOT_NULL(x);
+    x->row_ptr[1] = 3;
+    x->nnz        = 3;
+    x->col_idx[0] = 1;
+    x->col_idx[1] = 5;
+    x->col_idx[2] = 11;
+    x->values[0]  = 0.5;
+    x->values[1]  = -1;
+    x->values[2]  = 2;
+
+    float dense[12];
+    sparse_to_dense(x, dense);
+    float t[] = { 0, 1, 0, 0 };
+
+    // plain and fused layers
+    for (int fused = 0; fused < 2; fused++) {
+        Net *net = create_mnist_like_net();
+        Net *ref = create_mnist_like_net();
+        if (fused) {
+            TEST_ASSERT_EQUAL_INT(2, net_optimize(net));
+        }
+
+        // gradients of a dense input are overwritten
+        net_forward(net, dense);
+        net_backward(net, t);
+
+        TEST_ASSERT_EQUAL_INT(0, net_forward_sparse(net, x));
+        net_forward(ref, dense);
+
+        TEST_ASSERT_NULL(net->layers[0]->x);
+        for (int i = 0; i < 4; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-6, ref->output_layer->y[i], net->output_layer->y[i]);
+        }
+
+        net_backward(net, t);
+        net_backward(ref, t);
+
+        for (int i = 0; i < (12 * 8); i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-6, ref->layers[0]->dw[i], net->layers[0]->dw[i]);
+        }
+        for (int i = 0; i < 8; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-6, ref->layers[0]->db[i], net->layers[0]->db[i]);
+        }
+
+        // accumulated to gradients of the previous sample
+        net_set_accumulate(net, true);
+        net_set_accumulate(ref, true);
+        TEST_ASSERT_EQUAL_INT(0, net_forward_sparse(net, x));
+        net_backward(net, t);
+        net_forward(ref, dense);
+        net_backward(ref, t);
+
+        for (int i = 0; i < (12 * 8); i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-6, ref->layers[0]->dw[i], net->layers[0]->dw[i]);
+        }
+
+        // dense input is bound again
+        net_forward(net, dense);
+        TEST_ASSERT_NULL(net->layers[0]->sx);
+        TEST_ASSERT_EQUAL_PTR(dense, net->layers[0]->x);
+
+        net_free(&net);
+        net_free(&ref);
+    }
+
+    // input size mismatched
+    Net *net = create_mnist_like_net();
+    x->n_cols = 11;
+    TEST_ASSERT_EQUAL_INT(-1, net_forward_sparse(net, x));
+    x->n_cols = 12;
+    net_free(&net);
+
+    // input layer which is not Fully connected
+    net = net_create(
+        2,
+        (Layer*[]){
+            sigmoid_layer((LayerParameter){ .in=12 }),
+            fc_layer((LayerParameter){ .in=12, .out=2 })
+        }
+    );
+    TEST_ASSERT_EQUAL_INT(-1, net_forward_sparse(net, x));
+    net_free(&net);
+
+    sparse_free(&x);
+}
@@ -0,0 +1,347 @@
+/**
+ * @file test_optimizer.c
+ * @brief unit tests of optimizer.c
+ * 
+ */
+#include "optimizer.h"
+
+#include <math.h>
+
+#include "layers.h"
+
+#include "unity_fixture.h"
+
+// num of parameters, not multiple of vector width
+#define IN  3
+#define OUT 5
+
+static Net *net;
+
+static float w0[IN * OUT];
+static float b0[OUT];
+
+TEST_GROUP(optimizer);
+
+TEST_SETUP(optimizer)
+{
+    net = net_create(1, (Layer*[]){ fc_layer(SET_PARAM(.in=IN, .out=OUT)) });
+
+    Layer *fc = net->layers[0];
+    for (int i = 0; i < fc->w_size; i++) {
+        fc->w[i]  = w0[i] = 0.1f * (i - 7);
+        fc->dw[i] = 0.05f * (i - 6);
+    }
+    for (int i = 0; i < fc->b_size; i++) {
+        fc->b[i]  = b0[i] = 0.2f * i;
+        fc->db[i] = -0.1f * (i + 1);
+    }
+}
+
+TEST_TEAR_DOWN(optimizer)
+{
+    net_free(&net);
+}
+
+/**
+ * @brief sign of value
+ * 
+ * @param[in] x value
+ * @return float -1, 0 or 1
+ */
+static float sign(const float x)
+{
+    return (x > 0) ? 1 : ((x < 0) ? -1 : 0);
+}
+
+TEST(optimizer, optimizer_create_and_free)
+{
+    Optimizer *optimizer = optimizer_create(net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_ADAM, .learning_rate=0.01f));
+
+    TEST_ASSERT_NOT_NULL(optimizer);
+
+    // default values
+    TEST_ASSERT_EQUAL_FLOAT(0.9f, optimizer->param.beta1);
+    TEST_ASSERT_EQUAL_FLOAT(0.999f, optimizer->param.beta2);
+    TEST_ASSERT_EQUAL_FLOAT(1e-8f, optimizer->param.epsilon);
+
+    TEST_ASSERT_EQUAL_INT(1, optimizer->size);
+    TEST_ASSERT_NOT_NULL(optimizer->states[0].mw);
+    TEST_ASSERT_NOT_NULL(optimizer->states[0].vw);
+    TEST_ASSERT_NOT_NULL(optimizer->states[0].mb);
+    TEST_ASSERT_NOT_NULL(optimizer->states[0].vb);
+
+    optimizer_free(&optimizer);
+
+    TEST_ASSERT_NULL(optimizer);
+
+    // momentum has no 2nd moment
+    optimizer = optimizer_create(net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_MOMENTUM, .learning_rate=0.01f));
+
+    TEST_ASSERT_NOT_NULL(optimizer->states[0].mw);
+    TEST_ASSERT_NULL(optimizer->states[0].vw);
+
+    optimizer_free(&optimizer);
+}
+
+TEST(optimizer, optimizer_create_invalid)
+{
+    TEST_ASSERT_NULL(optimizer_create(NULL, SET_OPTIMIZER_PARAM(.learning_rate=0.01f)));
+    TEST_ASSERT_NULL(optimizer_create(net, SET_OPTIMIZER_PARAM(.learning_rate=0)));
+    TEST_ASSERT_NULL(optimizer_create(net, SET_OPTIMIZER_PARAM(.type=(OptimizerType)-1, .learning_rate=0.01f)));
+}
+
+TEST(optimizer, optimizer_type_name)
+{
+    TEST_ASSERT_EQUAL_STRING("sgd", optimizer_type_name(OPTIMIZER_TYPE_SGD));
+    TEST_ASSERT_EQUAL_STRING("nesterov", optimizer_type_name(OPTIMIZER_TYPE_NESTEROV));
+    TEST_ASSERT_EQUAL_STRING("adamw", optimizer_type_name(OPTIMIZER_TYPE_ADAMW));
+}
+
+TEST(optimizer, optimizer_step_sgd)
+{
+    const float lr = 0.1f;
+    Optimizer *optimizer = optimizer_create(net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_SGD, .learning_rate=lr));
+
+    optimizer_step(optimizer, net);
+
+    Layer *fc = net->layers[0];
+    for (int i = 0; i < fc->w_size; i++) {
+        TEST_ASSERT_EQUAL_FLOAT((w0[i] - lr * fc->dw[i]), fc->w[i]);
+    }
+    for (int i = 0; i < fc->b_size; i++) {
+        TEST_ASSERT_EQUAL_FLOAT((b0[i] - lr * fc->db[i]), fc->b[i]);
+    }
+
+    optimizer_free(&optimizer);
+}
+
+TEST(optimizer, optimizer_step_momentum)
+{
+    const float lr = 0.1f;
+    Optimizer *optimizer = optimizer_create(net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_MOMENTUM, .learning_rate=lr));
+
+    // v1 = g, v2 = 0.9 * g + g
+    optimizer_step(optimizer, net);
+    optimizer_step(optimizer, net);
+
+    Layer *fc = net->layers[0];
+    for (int i = 0; i < fc->w_size; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-6, (w0[i] - lr * 2.9f * fc->dw[i]), fc->w[i]);
+        TEST_ASSERT_FLOAT_WITHIN(1e-6, (1.9f * fc->dw[i]), optimizer->states[0].mw[i]);
+    }
+    for (int i = 0; i < fc->b_size; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-6, (b0[i] - lr * 2.9f * fc->db[i]), fc->b[i]);
+    }
+
+    optimizer_free(&optimizer);
+}
+
+TEST(optimizer, optimizer_step_nesterov)
+{
+    const float lr = 0.1f;
+    Optimizer *optimizer = optimizer_create(net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_NESTEROV, .learning_rate=lr));
+
+    // p -= lr * (g + 0.9 * v1)
+    optimizer_step(optimizer, net);
+
+    Layer *fc = net->layers[0];
+    for (int i = 0; i < fc->w_size; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-6, (w0[i] - lr * 1.9f * fc->dw[i]), fc->w[i]);
+    }
+    for (int i = 0; i < fc->b_size; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-6, (b0[i] - lr * 1.9f * fc->db[i]), fc->b[i]);
+    }
+
+    optimizer_free(&optimizer);
+}
+
+TEST(optimizer, optimizer_step_adam)
+{
+    const float lr = 0.01f;
+    Optimizer *optimizer = optimizer_create(net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_ADAM, .learning_rate=lr));
+
+    // bias corrected moments are g and g^2 at the 1st step
+    optimizer_step(optimizer, net);
+
+    Layer *fc = net->layers[0];
+    for (int i = 0; i < fc->w_size; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-6, (w0[i] - lr * sign(fc->dw[i])), fc->w[i]);
+    }
+    for (int i = 0; i < fc->b_size; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-6, (b0[i] - lr * sign(fc->db[i])), fc->b[i]);
+    }
+
+    // same gradient keeps the step size
+    float w1 = fc->w[3];
+    optimizer_step(optimizer, net);
+
+    TEST_ASSERT_EQUAL_INT(2, optimizer->step);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, (w1 - lr * sign(fc->dw[3])), fc->w[3]);
+
+    optimizer_free(&optimizer);
+}
+
+TEST(optimizer, optimizer_step_adamw)
+{
+    const float lr = 0.01f;
+    const float wd = 0.5f;
+    Optimizer *optimizer = optimizer_create(
+        net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_ADAMW, .learning_rate=lr, .weight_decay=wd)
+    );
+
+    optimizer_step(optimizer, net);
+
+    // weights are decayed, biases are not
+    Layer *fc = net->layers[0];
+    for (int i = 0; i < fc->w_size; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-6, (w0[i] * (1 - lr * wd) - lr * sign(fc->dw[i])), fc->w[i]);
+    }
+    for (int i = 0; i < fc->b_size; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-6, (b0[i] - lr * sign(fc->db[i])), fc->b[i]);
+    }
+
+    optimizer_free(&optimizer);
+}
+
+TEST(optimizer, optimizer_step_adamw_no_decay)
+{
+    const float lr = 0.01f;
+    Optimizer *optimizer = optimizer_create(
+        net,
+        SET_OPTIMIZER_PARAM(
+            .type=OPTIMIZER_TYPE_ADAMW, .learning_rate=lr, .weight_decay=0, .zeros=OPTIMIZER_ZERO_WEIGHT_DECAY
+        )
+    );
+
+    TEST_ASSERT_EQUAL_FLOAT(0, optimizer->param.weight_decay);
+
+    // same as Adam without decay
+    optimizer_step(optimizer, net);
+
+    Layer *fc = net->layers[0];
+    for (int i = 0; i < fc->w_size; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-6, (w0[i] - lr * sign(fc->dw[i])), fc->w[i]);
+    }
+
+    optimizer_free(&optimizer);
+
+    // zero without the flag is the default
+    optimizer = optimizer_create(
+        net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_ADAMW, .learning_rate=lr, .weight_decay=0)
+    );
+
+    TEST_ASSERT_EQUAL_FLOAT(0.01f, optimizer->param.weight_decay);
+
+    optimizer_free(&optimizer);
+}
+
+TEST(optimizer, optimizer_step_momentum_zero)
+{
+    const float lr = 0.1f;
+    Optimizer *optimizer = optimizer_create(
+        net,
+        SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_MOMENTUM, .learning_rate=lr, .zeros=OPTIMIZER_ZERO_MOMENTUM)
+    );
+
+    // same as SGD without momentum
+    optimizer_step(optimizer, net);
+    optimizer_step(optimizer, net);
+
+    Layer *fc = net->layers[0];
+    for (int i = 0; i < fc->w_size; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-6, (w0[i] - 2 * lr * fc->dw[i]), fc->w[i]);
+    }
+
+    optimizer_free(&optimizer);
+}
+
+TEST(optimizer, optimizer_step_sparse_rows)
+{
+    // rows of 3 weights of 6 inputs, nonzeros at 1 and 4, and at 4 of the next sample
+    const int rows[][2] = { { 1, 4 }, { 4, -1 } };
+    const int untouched[] = { 0, 2, 3, 5 };
+    const float sentinel = 7.0f;
+
+    // plain and fused layers, without and with accumulation
+    for (int n = 0; n < 4; n++) {
+        const bool fused = (n % 2 == 1);
+        const bool accumulate = (n >= 2);
+
+        Net *sparse_net = net_create(
+            2,
+            (Layer*[]){
+                fc_layer(SET_PARAM(.in=6, .out=3)),
+                sigmoid_layer(SET_PARAM(.in=3))
+            }
+        );
+        net_init_layer_params(sparse_net);
+        if (fused) {
+            TEST_ASSERT_EQUAL_INT(1, net_optimize(sparse_net));
+        }
+        net_set_accumulate(sparse_net, accumulate);
+
+        Optimizer *optimizer = optimizer_create(
+            sparse_net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_ADAM, .learning_rate=0.1f)
+        );
+        Layer *fc = sparse_net->layers[0];
+        float w[6 * 3];
+
+        for (int j = 0; j < 2; j++) {
+            const int nnz = (rows[j][1] < 0) ? 1 : 2;
+            SparseMatrix *x = sparse_create(1, 6, nnz);
+            TEST_ASSERT_NOT_NULL(x);
+            x->row_ptr[1] = nnz;
+            x->nnz        = nnz;
+            for (int k = 0; k < nnz; k++) {
+                x->col_idx[k] = rows[j][k];
+                x->values[k]  = 1.0f + k;
+            }
+
+            // rows are tracked after the first clear of gradients
+            TEST_ASSERT_EQUAL_INT(0, net_forward_sparse(sparse_net, x));
+            if (accumulate) {
+                net_zero_grad(sparse_net);
+            }
+            net_backward_label(sparse_net, 1);
+
+            // untouched rows of dw are not cleared, and the same rows of w are not updated
+            if (j == 1) {
+                for (int k = 0; k < 4; k++) {
+                    for (int m = 0; m < 3; m++) {
+                        TEST_ASSERT_EQUAL_FLOAT(sentinel, fc->dw[untouched[k] * 3 + m]);
+                    }
+                }
+                for (int m = 0; m < 3; m++) {
+                    TEST_ASSERT_EQUAL_FLOAT(0, fc->dw[1 * 3 + m]);
+                }
+            }
+
+            for (int k = 0; k < (6 * 3); k++) {
+                w[k] = fc->w[k];
+            }
+            optimizer_step(optimizer, sparse_net);
+
+            if (j == 0) {
+                for (int k = 0; k < 4; k++) {
+                    for (int m = 0; m < 3; m++) {
+                        TEST_ASSERT_EQUAL_FLOAT(w[untouched[k] * 3 + m], fc->w[untouched[k] * 3 + m]);
+                        fc->dw[untouched[k] * 3 + m] = sentinel;
+                    }
+                }
+            } else {
+                for (int k = 0; k < (6 * 3); k++) {
+                    if ((k / 3) == 4) {
+                        TEST_ASSERT(w[k] != fc->w[k]);
+                    } else {
+                        TEST_ASSERT_EQUAL_FLOAT(w[k], fc->w[k]);
+                    }
+                }
+            }
+
+            sparse_free(&x);
+        }
+
+        optimizer_free(&optimizer);
+        net_free(&sparse_net);
+    }
+}
@@ -0,0 +1,129 @@
+/**
+ * @file test_profile.c
+ * @brief unit tests of profile.c
+ * 
+ */
+#include "profile.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "unity_fixture.h"
+
+// num of threads sampling counters
+#define N_THREADS 4
+
+TEST_GROUP(profile);
+
+TEST_SETUP(profile)
+{}
+
+TEST_TEAR_DOWN(profile)
+{}
+
+/**
+ * @brief take a sample in a thread
+ * 
+ * @param[out] arg sample
+ * @return void* NULL
+ */
+static void *sample_func(void *arg)
+{
+    profile_sample(arg);
+
+    return NULL;
+}
+
+/**
+ * @brief get the lowest unused file descriptor
+ * 
+ * @return int file descriptor
+ */
+static int lowest_free_fd(void)
+{
+    const int fd = dup(0);
+    close(fd);
+
+    return fd;
+}
+
+TEST(profile, profile_now)
+{
+    double t0 = profile_now();
+    double t1 = profile_now();
+
+    TEST_ASSERT(t0 > 0);
+    TEST_ASSERT(t1 >= t0);
+}
+
+TEST(profile, profile_stat_add)
+{
+    ProfileStat stat;
+
+    profile_stat_reset(&stat);
+
+    TEST_ASSERT_EQUAL_INT(0, stat.count);
+
+    profile_stat_add(&stat, 2.0);
+    profile_stat_add(&stat, 1.0);
+    profile_stat_add(&stat, 3.0);
+
+    TEST_ASSERT_EQUAL_INT(3, stat.count);
+    TEST_ASSERT_EQUAL_FLOAT(6.0, stat.total);
+    TEST_ASSERT_EQUAL_FLOAT(1.0, stat.min);
+    TEST_ASSERT_EQUAL_FLOAT(3.0, stat.max);
+
+    profile_stat_reset(&stat);
+
+    TEST_ASSERT_EQUAL_INT(0, stat.count);
+    TEST_ASSERT_EQUAL_FLOAT(0, stat.total);
+}
+
+TEST(profile, profile_stat_add_since)
+{
+    ProfileStat stat;
+    profile_stat_reset(&stat);
+
+    ProfileSample start;
+    profile_sample(&start);
+
+    profile_stat_add_since(&stat, &start);
+
+    TEST_ASSERT_EQUAL_INT(1, stat.count);
+    TEST_ASSERT(stat.total >= 0);
+
+    if (start.has_counters) {
+        TEST_ASSERT_EQUAL_INT(1, stat.counted);
+        TEST_ASSERT(stat.counters[PROFILE_COUNTER_INSTRUCTIONS] > 0);
+    } else {
+        // counters are disabled or not available
+        TEST_ASSERT_EQUAL_INT(0, stat.counted);
+        TEST_ASSERT_EQUAL_UINT32(0, stat.counters[PROFILE_COUNTER_CYCLES]);
+    }
+}
+
+TEST(profile, profile_counter_name)
+{
+    TEST_ASSERT_EQUAL_STRING("cycles", profile_counter_name(PROFILE_COUNTER_CYCLES));
+    TEST_ASSERT_EQUAL_STRING("instructions", profile_counter_name(PROFILE_COUNTER_INSTRUCTIONS));
+    TEST_ASSERT_EQUAL_STRING("llc_misses", profile_counter_name(PROFILE_COUNTER_LLC_MISSES));
+    TEST_ASSERT_EQUAL_STRING("branch_misses", profile_counter_name(PROFILE_COUNTER_BRANCH_MISSES));
+    TEST_ASSERT_EQUAL_STRING("unknown", profile_counter_name(PROFILE_COUNTER_NUM));
+}
+
+TEST(profile, profile_sample_thread_exit)
+{
+    const int fd = lowest_free_fd();
+
+    // counters of exited threads are closed
+    for (int i = 0; i < N_THREADS; i++) {
+        ProfileSample sample;
+        pthread_t thread;
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, NULL, sample_func, &sample));
+        TEST_ASSERT_EQUAL_INT(0, pthread_join(thread, NULL));
+
+        TEST_ASSERT(sample.time > 0);
+    }
+
+    TEST_ASSERT_EQUAL_INT(fd, lowest_free_fd());
+}
@@ -84,3 +84,72 @@ TEST(random, get_rand_uniform)
 //        float rnd = rand_norm(0, 1);
 //    }
 //}
+
+TEST(random, get_rand_range)
+{
+    rand_seed(0);
+
+    int counts[3] = { 0 };
+    for (int i = 0; i < 30000; i++) {
+        uint32_t rnd = rand_range(3);
+        TEST_ASSERT(rnd < 3);
+        counts[rnd]++;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(500, 10000, counts[i]);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, rand_range(1));
+}
+
+TEST(random, rand_shuffle)
+{
+    rand_seed(0);
+
+    // all 6 permutations of 3 elements appear evenly
+    int counts[3][3] = { { 0 } };
+    for (int i = 0; i < 30000; i++) {
+        int array[] = { 0, 1, 2 };
+        rand_shuffle(array, 3);
+
+        TEST_ASSERT_EQUAL_INT(3, (array[0] + array[1] + array[2]));
+        TEST_ASSERT((array[0] != array[1]) && (array[1] != array[2]) && (array[0] != array[2]));
+
+        counts[array[0]][array[1]]++;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            if (i != j) {
+                TEST_ASSERT_FLOAT_WITHIN(400, 5000, counts[i][j]);
+            }
+        }
+    }
+}
+
+TEST(random, rand_block_shuffle)
+{
+    rand_seed(0);
+
+    int array[10];
+    TEST_ASSERT_EQUAL_INT(0, rand_block_shuffle(array, 10, 4));
+
+    // blocks { 0-3 }, { 4-7 } and { 8, 9 } in some order, each shuffled
+    int seen[10] = { 0 };
+    int i = 0;
+    while (i < 10) {
+        const int block = array[i] / 4;
+        const int size  = (block == 2) ? 2 : 4;
+        for (int j = 0; j < size; j++, i++) {
+            TEST_ASSERT_EQUAL_INT(block, (array[i] / 4));
+            seen[array[i]]++;
+        }
+    }
+    for (int j = 0; j < 10; j++) {
+        TEST_ASSERT_EQUAL_INT(1, seen[j]);
+    }
+
+    TEST_ASSERT_EQUAL_INT(-1, rand_block_shuffle(array, 10, 0));
+    TEST_ASSERT_EQUAL_INT(-1, rand_block_shuffle(array, 0, 4));
+}
@@ -0,0 +1,110 @@
+/**
+ * @file test_relu.c
+ * @brief unit tests of relu.c
+ * 
+ */
+#include "relu.h"
+
+#include "mat.h"
+
+#include "unity_fixture.h"
+
+TEST_GROUP(relu);
+
+TEST_SETUP(relu)
+{}
+
+TEST_TEAR_DOWN(relu)
+{}
+
+TEST(relu, relu_layer_and_free)
+{
+    LayerParameter param = { .in = 10 };
+    Layer *relu = relu_layer(param);
+
+    TEST_ASSERT_NOT_NULL(relu);
+
+    TEST_ASSERT_EQUAL_INT(param.in, relu->x_dim[1]);
+    TEST_ASSERT_EQUAL_INT(param.in, relu->x_size);
+    TEST_ASSERT_NULL(relu->x);
+
+    TEST_ASSERT_EQUAL_INT(param.in, relu->y_dim[1]);
+    TEST_ASSERT_EQUAL_INT(param.in, relu->y_size);
+    TEST_ASSERT_NOT_NULL(relu->y);
+
+    TEST_ASSERT_NULL(relu->w);
+    TEST_ASSERT_EQUAL_INT(0, relu->w_size);
+    TEST_ASSERT_NULL(relu->b);
+    TEST_ASSERT_EQUAL_INT(0, relu->b_size);
+
+    TEST_ASSERT_NOT_NULL(relu->dx);
+    TEST_ASSERT_NULL(relu->dw);
+    TEST_ASSERT_NULL(relu->db);
+
+    TEST_ASSERT_EQUAL_INT(1, relu->n_in);
+    TEST_ASSERT_EQUAL_INT(-1, relu->in_ids[0]);
+    TEST_ASSERT_EQUAL_INT(0, relu->n_out);
+
+    TEST_ASSERT_EQUAL_INT(LAYER_TYPE_RELU, relu->type);
+
+    TEST_ASSERT_NOT_NULL(relu->forward);
+    TEST_ASSERT_NOT_NULL(relu->backward);
+
+    layer_free(&relu);
+
+    TEST_ASSERT_NULL(relu);
+}
+
+TEST(relu, relu_layer_invalid_param)
+{
+    LayerParameter param = { .in = 0 };
+    Layer *relu = relu_layer(param);
+
+    TEST_ASSERT_NULL(relu);
+}
+
+TEST(relu, relu_forward)
+{
+    LayerParameter param = { .in = 11 };
+    Layer *relu = relu_layer(param);
+
+    float x[] = {
+        -5, -4, -3, -2, -1, 0, 1, 2, 3, 4, 5
+    };
+    
+    float ans[] = {
+        0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 5
+    };
+
+    relu->forward(relu, x);
+
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(ans, relu->y, (1 * 11));
+
+    layer_free(&relu);
+}
+
+TEST(relu, relu_backward)
+{
+    LayerParameter param = { .in = 11 };
+    Layer *relu = relu_layer(param);
+
+    float x[] = {
+        -5, -4, -3, -2, -1, 0, 1, 2, 3, 4, 5
+    };
+
+    relu->forward(relu, x);
+
+    float dy[] = {
+        1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11
+    };
+
+    relu->backward(relu, dy);
+    
+    float dx_ans[] = {
+        0, 0, 0, 0, 0, 0, 7, 8, 9, 10, 11
+    };
+
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(dx_ans, relu->dx, 11);
+
+    layer_free(&relu);
+}
@@ -41,8 +41,9 @@ TEST(sigmoid, sigmoid_layer_and_free)
     TEST_ASSERT_NULL(sigmoid->dw);
     TEST_ASSERT_NULL(sigmoid->db);
 
-    TEST_ASSERT_EQUAL_INT(-1, sigmoid->prev_id);
-    TEST_ASSERT_EQUAL_INT(-1, sigmoid->next_id);
+    TEST_ASSERT_EQUAL_INT(1, sigmoid->n_in);
+    TEST_ASSERT_EQUAL_INT(-1, sigmoid->in_ids[0]);
+    TEST_ASSERT_EQUAL_INT(0, sigmoid->n_out);
 
     TEST_ASSERT_NOT_NULL(sigmoid->forward);
     TEST_ASSERT_NOT_NULL(sigmoid->backward);
@@ -41,8 +41,9 @@ TEST(softmax, softmax_layer_and_free)
     TEST_ASSERT_NULL(softmax->dw);
     TEST_ASSERT_NULL(softmax->db);
 
-    TEST_ASSERT_EQUAL_INT(-1, softmax->prev_id);
-    TEST_ASSERT_EQUAL_INT(-1, softmax->next_id);
+    TEST_ASSERT_EQUAL_INT(1, softmax->n_in);
+    TEST_ASSERT_EQUAL_INT(-1, softmax->in_ids[0]);
+    TEST_ASSERT_EQUAL_INT(0, softmax->n_out);
 
     TEST_ASSERT_NOT_NULL(softmax->forward);
     TEST_ASSERT_NOT_NULL(softmax->backward);
@@ -81,6 +82,27 @@ TEST(softmax, softmax_forward)
     layer_free(&softmax);
 }
 
+TEST(softmax, softmax_forward_large_input)
+{
+    LayerParameter param = { .in = 4 };
+    Layer *softmax = softmax_layer(param);
+
+    // exp of each input overflows floats
+    float x[] = {
+        1000, 1001, 1002, 1003
+    };
+
+    float ans[] = {
+        0.0320586, 0.08714432, 0.23688282, 0.64391426
+    };
+
+    softmax->forward(softmax, x);
+
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(ans, softmax->y, (1 * 4));
+
+    layer_free(&softmax);
+}
+
 TEST(softmax, softmax_backward)
 {
     LayerParameter param = { .in = 4 };
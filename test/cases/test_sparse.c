@@ -0,0 +1,241 @@
+/**
+ * @file test_sparse.c
+ * @brief unit tests of sparse.c
+ * 
+ */
+#include "sparse.h"
+
+#include <stdio.h>
+
+#include "mat.h"
+#include "util.h"
+
+#include "unity_fixture.h"
+
+TEST_GROUP(sparse);
+
+TEST_SETUP(sparse)
+{}
+
+TEST_TEAR_DOWN(sparse)
+{}
+
+#define LIBSVM_FILE "test_sparse.txt"
+
+/**
+ * @brief create 3x4 sparse matrix
+ *     | 1 0 0 2 |
+ *     | 0 0 0 0 |
+ *     | 0 3 4 0 |
+ * 
+ * @return SparseMatrix* pointer to sparse matrix
+ */
+static SparseMatrix *create_matrix(void)
+{
+    SparseMatrix *a = sparse_create(3, 4, 4);
+    TEST_ASSERT_NOT_NULL(a);
+
+    const int row_ptr[] = { 0, 2, 2, 4 };
+    const int col_idx[] = { 0, 3, 1, 2 };
+    const float values[] = { 1, 2, 3, 4 };
+    for (int i = 0; i < 4; i++) {
+        a->row_ptr[i] = row_ptr[i];
+        a->col_idx[i] = col_idx[i];
+        a->values[i]  = values[i];
+    }
+    a->nnz = 4;
+
+    return a;
+}
+
+/**
+ * @brief write text to file
+ * 
+ * @param[in] text text to be written
+ */
+static void write_text(const char *text)
+{
+    FILE *fp = fopen(LIBSVM_FILE, "w");
+    TEST_ASSERT_NOT_NULL(fp);
+    fputs(text, fp);
+    fclose(fp);
+}
+
+TEST(sparse, sparse_create_and_free)
+{
+    SparseMatrix *a = sparse_create(3, 4, 10);
+
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_EQUAL_INT(3, a->n_rows);
+    TEST_ASSERT_EQUAL_INT(4, a->n_cols);
+    TEST_ASSERT_EQUAL_INT(0, a->nnz);
+    TEST_ASSERT_EQUAL_INT(10, a->capacity);
+    for (int i = 0; i <= 3; i++) {
+        TEST_ASSERT_EQUAL_INT(0, a->row_ptr[i]);
+    }
+
+    sparse_free(&a);
+
+    TEST_ASSERT_NULL(a);
+
+    TEST_ASSERT_NULL(sparse_create(-1, 4, 10));
+    TEST_ASSERT_NULL(sparse_create(3, 0, 10));
+}
+
+TEST(sparse, sparse_row_and_to_dense)
+{
+    SparseMatrix *a = create_matrix();
+
+    float dense[12];
+    sparse_to_dense(a, dense);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(((float[]){ 1, 0, 0, 2, 0, 0, 0, 0, 0, 3, 4, 0 }), dense, 12);
+
+    // view shares arrays
+    SparseMatrix row = sparse_row(a, 2);
+    TEST_ASSERT_EQUAL_INT(1, row.n_rows);
+    TEST_ASSERT_EQUAL_INT(4, row.n_cols);
+    TEST_ASSERT_EQUAL_INT(2, row.nnz);
+    TEST_ASSERT_EQUAL_PTR(a->values, row.values);
+
+    sparse_to_dense(&row, dense);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(((float[]){ 0, 3, 4, 0 }), dense, 4);
+
+    row = sparse_row(a, 1);
+    TEST_ASSERT_EQUAL_INT(0, row.nnz);
+
+    sparse_free(&a);
+}
+
+TEST(sparse, sparse_mat_mul)
+{
+    SparseMatrix *a = create_matrix();
+
+    float dense[12];
+    sparse_to_dense(a, dense);
+
+    float b[] = {
+        1, 2,
+        3, 4,
+        5, 6,
+        7, 8
+    };
+
+    // same as product of dense matrix
+    float c[6], expected[6];
+    TEST_ASSERT_EQUAL_PTR(c, sparse_mat_mul(a, b, c, 2));
+    mat_mul(dense, b, expected, 3, 4, 2);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(expected, c, 6);
+
+    sparse_free(&a);
+}
+
+TEST(sparse, sparse_mat_mul_trans_a_acc)
+{
+    SparseMatrix *a = create_matrix();
+
+    float dense[12];
+    sparse_to_dense(a, dense);
+
+    float b[] = {
+        1, 2,
+        3, 4,
+        5, 6
+    };
+
+    float c[8] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+    float expected[8] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+    TEST_ASSERT_EQUAL_PTR(c, sparse_mat_mul_trans_a_acc(a, b, c, 2));
+    mat_mul_trans_a_acc(dense, b, expected, 3, 4, 2);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(expected, c, 8);
+
+    sparse_free(&a);
+}
+
+TEST(sparse, sparse_load_libsvm)
+{
+    write_text(
+        "# comment line\n"
+        "+1 1:0.5 4:2 # trailing comment\n"
+        "-1 qid:3 2:1.5 3:0\n"
+        "\n"
+        "2 5:-1\n"
+    );
+
+    int *labels = NULL;
+    SparseMatrix *x = sparse_load_libsvm(LIBSVM_FILE, 0, &labels);
+
+    TEST_ASSERT_NOT_NULL(x);
+    TEST_ASSERT_NOT_NULL(labels);
+
+    TEST_ASSERT_EQUAL_INT(3, x->n_rows);
+    TEST_ASSERT_EQUAL_INT(5, x->n_cols);
+    // explicit zero is not stored
+    TEST_ASSERT_EQUAL_INT(4, x->nnz);
+    TEST_ASSERT_EQUAL_INT_ARRAY(((int[]){ 1, 0, 2 }), labels, 3);
+
+    float dense[15];
+    sparse_to_dense(x, dense);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(((float[]){ 0.5, 0, 0, 2, 0, 0, 1.5, 0, 0, 0, 0, 0, 0, 0, -1 }), dense, 15);
+
+    FREE_WITH_NULL(&labels);
+    sparse_free(&x);
+
+    // num of features larger than the largest index
+    x = sparse_load_libsvm(LIBSVM_FILE, 8, &labels);
+    TEST_ASSERT_NOT_NULL(x);
+    TEST_ASSERT_EQUAL_INT(8, x->n_cols);
+
+    FREE_WITH_NULL(&labels);
+    sparse_free(&x);
+
+    remove(LIBSVM_FILE);
+}
+
+TEST(sparse, sparse_load_libsvm_invalid)
+{
+    int *labels = NULL;
+
+    TEST_ASSERT_NULL(sparse_load_libsvm("no_such_file.txt", 0, &labels));
+    TEST_ASSERT_NULL(labels);
+
+    // index larger than num of features
+    write_text("1 1:1 5:1\n");
+    TEST_ASSERT_NULL(sparse_load_libsvm(LIBSVM_FILE, 4, &labels));
+    TEST_ASSERT_NULL(labels);
+
+    // descending, zero and malformed indices
+    write_text("1 3:1 2:1\n");
+    TEST_ASSERT_NULL(sparse_load_libsvm(LIBSVM_FILE, 0, &labels));
+
+    write_text("1 0:1\n");
+    TEST_ASSERT_NULL(sparse_load_libsvm(LIBSVM_FILE, 0, &labels));
+
+    write_text("1 2=1\n");
+    TEST_ASSERT_NULL(sparse_load_libsvm(LIBSVM_FILE, 0, &labels));
+
+    // labels which are not class indices
+    write_text("0.5 1:1\n");
+    TEST_ASSERT_NULL(sparse_load_libsvm(LIBSVM_FILE, 0, &labels));
+
+    write_text("-2 1:1\n");
+    TEST_ASSERT_NULL(sparse_load_libsvm(LIBSVM_FILE, 0, &labels));
+
+    write_text("1e20 1:1\n");
+    TEST_ASSERT_NULL(sparse_load_libsvm(LIBSVM_FILE, 0, &labels));
+
+    write_text("nan 1:1\n");
+    TEST_ASSERT_NULL(sparse_load_libsvm(LIBSVM_FILE, 0, &labels));
+
+    // query IDs without digits
+    write_text("1 qid: 1:1\n");
+    TEST_ASSERT_NULL(sparse_load_libsvm(LIBSVM_FILE, 0, &labels));
+
+    write_text("1 qid:x 1:1\n");
+    TEST_ASSERT_NULL(sparse_load_libsvm(LIBSVM_FILE, 0, &labels));
+
+    // no sample
+    write_text("# empty\n");
+    TEST_ASSERT_NULL(sparse_load_libsvm(LIBSVM_FILE, 0, &labels));
+
+    remove(LIBSVM_FILE);
+}
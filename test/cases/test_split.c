@@ -0,0 +1,77 @@
+/**
+ * @file test_split.c
+ * @brief unit tests of split.c
+ * 
+ */
+#include "split.h"
+
+#include "unity_fixture.h"
+
+TEST_GROUP(split);
+
+TEST_SETUP(split)
+{}
+
+TEST_TEAR_DOWN(split)
+{}
+
+TEST(split, split_layer_and_free)
+{
+    LayerParameter param = { .in = 8, .n_out = 2, .outs = { 3, 5 } };
+    Layer *split = split_layer(param);
+
+    TEST_ASSERT_NOT_NULL(split);
+
+    TEST_ASSERT_EQUAL_INT(8, split->x_size);
+    TEST_ASSERT_EQUAL_INT(8, split->y_size);
+    TEST_ASSERT_NOT_NULL(split->y);
+
+    TEST_ASSERT_NULL(split->w);
+    TEST_ASSERT_NULL(split->b);
+
+    TEST_ASSERT_NOT_NULL(split->dx);
+
+    TEST_ASSERT_EQUAL_INT(2, split->n_ys);
+    TEST_ASSERT_EQUAL_INT(0, split->ys_offset[0]);
+    TEST_ASSERT_EQUAL_INT(3, split->ys_size[0]);
+    TEST_ASSERT_EQUAL_INT(3, split->ys_offset[1]);
+    TEST_ASSERT_EQUAL_INT(5, split->ys_size[1]);
+
+    layer_free(&split);
+
+    TEST_ASSERT_NULL(split);
+}
+
+TEST(split, split_layer_invalid_param)
+{
+    TEST_ASSERT_NULL(split_layer((LayerParameter){ .in = 0, .n_out = 1, .outs = { 1 } }));
+    TEST_ASSERT_NULL(split_layer((LayerParameter){ .in = 4, .n_out = 0 }));
+    TEST_ASSERT_NULL(split_layer((LayerParameter){ .in = 4, .n_out = 2, .outs = { 1, 2 } }));
+}
+
+TEST(split, split_forward)
+{
+    Layer *split = split_layer((LayerParameter){ .in = 3, .n_out = 2, .outs = { 1, 2 } });
+
+    float x[] = { 1, 2, 3 };
+
+    split->forward(split, x);
+
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(&x[0], (split->y + split->ys_offset[0]), 1);
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(&x[1], (split->y + split->ys_offset[1]), 2);
+
+    layer_free(&split);
+}
+
+TEST(split, split_backward)
+{
+    Layer *split = split_layer((LayerParameter){ .in = 3, .n_out = 2, .outs = { 1, 2 } });
+
+    float dy[] = { 0.1, -0.2, 0.3 };
+
+    split->backward(split, dy);
+
+    TEST_ASSERT_EQUAL_FLOAT_ARRAY(dy, split->dx, 3);
+
+    layer_free(&split);
+}
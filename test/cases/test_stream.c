@@ -0,0 +1,345 @@
+/**
+ * @file test_stream.c
+ * @brief unit tests of stream.c
+ * 
+ */
+#include "stream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fixture.h"
+#include "loader.h"
+#include "random.h"
+
+#include "unity_fixture.h"
+
+TEST_GROUP(stream);
+
+TEST_SETUP(stream)
+{}
+
+TEST_TEAR_DOWN(stream)
+{}
+
+// num of samples of each shard
+#define SHARD_SIZE_0 5
+#define SHARD_SIZE_1 3
+#define N_SAMPLES (SHARD_SIZE_0 + SHARD_SIZE_1)
+
+static const char *IMAGE_FILES[] = { "test_stream_x0.idx", "test_stream_x1.idx" };
+static const char *LABEL_FILES[] = { "test_stream_t0.idx", "test_stream_t1.idx" };
+
+// files of the first shard compressed with gzip
+static const char *GZIP_IMAGE_FILE = "test_stream_x0.idx.gz";
+static const char *GZIP_LABEL_FILE = "test_stream_t0.idx.gz";
+
+static const uint8_t GZIP_IMAGES[] = {
+    0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x63, 0x60, 0xE0, 0x60, 0x62, 0x60,
+    0x60, 0x60, 0x05, 0x62, 0x26, 0x06, 0x46, 0x26, 0x66, 0x16, 0x56, 0x36, 0x76, 0x0E, 0x4E, 0x00,
+    0xD9, 0xD9, 0x4B, 0x8C, 0x16, 0x00, 0x00, 0x00
+};
+
+static const uint8_t GZIP_LABELS[] = {
+    0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x63, 0x60, 0xE0, 0x60, 0x64, 0x60,
+    0x60, 0x60, 0x65, 0x60, 0x64, 0x62, 0x60, 0x04, 0x00, 0xD7, 0xDE, 0x87, 0xC6, 0x0D, 0x00, 0x00,
+    0x00
+};
+
+/**
+ * @brief write IDX file of bytes
+ * 
+ * @param[in] filename path of file
+ * @param[in] n_dims num of dimensions
+ * @param[in] dims size of each dimension
+ * @param[in] data elements
+ * @param[in] size num of elements
+ */
+static void write_idx(const char *filename, const int n_dims, const int *dims, const uint8_t *data, const int size)
+{
+    const size_t header_size = 4 + 4 * (size_t)n_dims;
+    uint8_t *bytes = malloc(header_size + size);
+    TEST_ASSERT_NOT_NULL(bytes);
+
+    const uint8_t magic[] = { 0x00, 0x00, 0x08, (uint8_t)n_dims };
+    memcpy(bytes, magic, 4);
+    for (int i = 0; i < n_dims; i++) {
+        const uint8_t dim[] = {
+            (uint8_t)(dims[i] >> 24), (uint8_t)(dims[i] >> 16), (uint8_t)(dims[i] >> 8), (uint8_t)dims[i]
+        };
+        memcpy((bytes + 4 + 4 * i), dim, 4);
+    }
+    memcpy((bytes + header_size), data, size);
+
+    write_file(filename, bytes, (header_size + size));
+
+    free(bytes);
+}
+
+/**
+ * @brief write 2 shards of samples { 2 * i, 2 * i + 1 } and labels i % 3 of the i-th sample
+ * 
+ */
+static void write_shards(void)
+{
+    uint8_t x[N_SAMPLES * 2];
+    uint8_t t[N_SAMPLES];
+    for (int i = 0; i < N_SAMPLES; i++) {
+        x[i * 2]     = (uint8_t)(i * 2);
+        x[i * 2 + 1] = (uint8_t)(i * 2 + 1);
+        t[i]         = (uint8_t)(i % 3);
+    }
+
+    write_idx(IMAGE_FILES[0], 2, (int[]){ SHARD_SIZE_0, 2 }, x, (SHARD_SIZE_0 * 2));
+    write_idx(LABEL_FILES[0], 1, (int[]){ SHARD_SIZE_0 }, t, SHARD_SIZE_0);
+    write_idx(IMAGE_FILES[1], 2, (int[]){ SHARD_SIZE_1, 2 }, (x + SHARD_SIZE_0 * 2), (SHARD_SIZE_1 * 2));
+    write_idx(LABEL_FILES[1], 1, (int[]){ SHARD_SIZE_1 }, (t + SHARD_SIZE_0), SHARD_SIZE_1);
+}
+
+/**
+ * @brief remove files of shards
+ * 
+ */
+static void remove_shards(void)
+{
+    for (int i = 0; i < 2; i++) {
+        remove(IMAGE_FILES[i]);
+        remove(LABEL_FILES[i]);
+    }
+}
+
+TEST(stream, stream_open_and_close)
+{
+    write_shards();
+
+    Stream *stream = stream_open(IMAGE_FILES, LABEL_FILES, 2, 3, SET_STREAM_PARAM(.shuffle_size=4));
+
+    TEST_ASSERT_NOT_NULL(stream);
+
+    TEST_ASSERT_EQUAL_INT(2, stream->n_shards);
+    TEST_ASSERT_EQUAL_INT(N_SAMPLES, stream->size);
+    TEST_ASSERT_EQUAL_INT(2, stream->x_size);
+    TEST_ASSERT_EQUAL_INT(3, stream->n_classes);
+    TEST_ASSERT_EQUAL_INT(4, stream->param.shuffle_size);
+    TEST_ASSERT_EQUAL_INT(STREAM_READ_SIZE, stream->param.read_size);
+    TEST_ASSERT_EQUAL_FLOAT((1.0f / 255), stream->param.scale);
+
+    // nothing is read before rewinding
+    float x[2];
+    TEST_ASSERT_EQUAL_INT(0, stream_read(stream, 1, x, NULL, NULL));
+
+    stream_close(&stream);
+
+    TEST_ASSERT_NULL(stream);
+
+    remove_shards();
+}
+
+TEST(stream, stream_open_invalid)
+{
+    write_shards();
+
+    TEST_ASSERT_NULL(stream_open(NULL, LABEL_FILES, 2, 3, SET_STREAM_PARAM(.shuffle_size=4)));
+    TEST_ASSERT_NULL(stream_open(IMAGE_FILES, LABEL_FILES, 0, 3, SET_STREAM_PARAM(.shuffle_size=4)));
+    TEST_ASSERT_NULL(stream_open(IMAGE_FILES, LABEL_FILES, 2, 3, SET_STREAM_PARAM(.shuffle_size=-1)));
+
+    // labels of another shard
+    const char *mismatched[] = { LABEL_FILES[1], LABEL_FILES[0] };
+    TEST_ASSERT_NULL(stream_open(IMAGE_FILES, mismatched, 2, 3, SET_STREAM_PARAM(.shuffle_size=4)));
+
+    // missing file
+    const char *missing[] = { IMAGE_FILES[0], "no_such_file.idx" };
+    TEST_ASSERT_NULL(stream_open(missing, LABEL_FILES, 2, 3, SET_STREAM_PARAM(.shuffle_size=4)));
+
+    remove_shards();
+}
+
+TEST(stream, stream_read_in_order)
+{
+    write_shards();
+
+    // small reads cross the boundary of buffer, O_DIRECT falls back if not supported
+    Stream *stream = stream_open(
+        IMAGE_FILES, LABEL_FILES, 2, 3,
+        SET_STREAM_PARAM(.shuffle_size=1, .read_size=1, .direct=true, .scale=0.5f, .offset=1.0f)
+    );
+    TEST_ASSERT_NOT_NULL(stream);
+
+    for (int epoch = 0; epoch < 2; epoch++) {
+        stream_rewind(stream);
+
+        float x[3 * 2];
+        float t[3 * 3];
+        int labels[3];
+
+        int n = 0;
+        int n_read;
+        while ((n_read = stream_read(stream, 3, x, t, labels)) > 0) {
+            for (int i = 0; i < n_read; i++, n++) {
+                TEST_ASSERT_EQUAL_FLOAT((n * 2 * 0.5f + 1.0f), x[i * 2]);
+                TEST_ASSERT_EQUAL_FLOAT(((n * 2 + 1) * 0.5f + 1.0f), x[i * 2 + 1]);
+                TEST_ASSERT_EQUAL_INT((n % 3), labels[i]);
+                for (int k = 0; k < 3; k++) {
+                    TEST_ASSERT_EQUAL_FLOAT(((k == (n % 3)) ? 1 : 0), t[i * 3 + k]);
+                }
+            }
+        }
+        TEST_ASSERT_EQUAL_INT(N_SAMPLES, n);
+    }
+
+    stream_close(&stream);
+
+    remove_shards();
+}
+
+TEST(stream, stream_read_shuffled)
+{
+    write_shards();
+
+    Stream *stream = stream_open(
+        IMAGE_FILES, LABEL_FILES, 2, 3, SET_STREAM_PARAM(.shuffle_size=4, .scale=1.0f)
+    );
+    TEST_ASSERT_NOT_NULL(stream);
+
+    rand_seed(0);
+
+    bool in_order = true;
+    for (int epoch = 0; epoch < 3; epoch++) {
+        stream_rewind(stream);
+
+        float x[N_SAMPLES * 2];
+        int labels[N_SAMPLES];
+        TEST_ASSERT_EQUAL_INT(N_SAMPLES, stream_read(stream, (N_SAMPLES + 1), x, NULL, labels));
+
+        // every sample is read once
+        int count[N_SAMPLES] = { 0 };
+        for (int i = 0; i < N_SAMPLES; i++) {
+            int k = (int)x[i * 2] / 2;
+            TEST_ASSERT_EQUAL_FLOAT((k * 2 + 1), x[i * 2 + 1]);
+            TEST_ASSERT_EQUAL_INT((k % 3), labels[i]);
+            count[k]++;
+
+            if (k != i) {
+                in_order = false;
+            }
+        }
+        TEST_ASSERT_EACH_EQUAL_INT(1, count, N_SAMPLES);
+    }
+    TEST_ASSERT_FALSE(in_order);
+
+    stream_close(&stream);
+
+    remove_shards();
+}
+
+TEST(stream, stream_read_failure)
+{
+    write_shards();
+
+    Stream *stream = stream_open(IMAGE_FILES, LABEL_FILES, 2, 3, SET_STREAM_PARAM(.shuffle_size=1));
+    TEST_ASSERT_NOT_NULL(stream);
+
+    float x[N_SAMPLES * 2];
+    float t[N_SAMPLES * 3];
+
+    // label out of range of classes in the second shard
+    const uint8_t invalid[SHARD_SIZE_1] = { 0, 3, 1 };
+    write_idx(LABEL_FILES[1], 1, (int[]){ SHARD_SIZE_1 }, invalid, SHARD_SIZE_1);
+
+    stream_rewind(stream);
+    TEST_ASSERT_FALSE(stream_failed(stream));
+    TEST_ASSERT_EQUAL_INT((SHARD_SIZE_0 + 1), stream_read(stream, N_SAMPLES, x, t, NULL));
+    TEST_ASSERT_TRUE(stream_failed(stream));
+
+    // images of the first shard truncated after the stream is opened
+    write_shards();
+    write_idx(IMAGE_FILES[0], 2, (int[]){ SHARD_SIZE_0, 2 }, (const uint8_t[]){ 0 }, 1);
+
+    stream_rewind(stream);
+    TEST_ASSERT_FALSE(stream_failed(stream));
+    TEST_ASSERT_EQUAL_INT(0, stream_read(stream, N_SAMPLES, x, t, NULL));
+    TEST_ASSERT_TRUE(stream_failed(stream));
+
+    // the end of epoch is not a failure
+    write_shards();
+
+    stream_rewind(stream);
+    TEST_ASSERT_EQUAL_INT(N_SAMPLES, stream_read(stream, (N_SAMPLES + 1), x, t, NULL));
+    TEST_ASSERT_FALSE(stream_failed(stream));
+
+    stream_close(&stream);
+
+    TEST_ASSERT_FALSE(stream_failed(NULL));
+
+    remove_shards();
+}
+
+TEST(stream, loader_create_stream)
+{
+    write_shards();
+
+    Stream *stream = stream_open(
+        IMAGE_FILES, LABEL_FILES, 2, 3, SET_STREAM_PARAM(.shuffle_size=1, .scale=1.0f)
+    );
+    TEST_ASSERT_NOT_NULL(stream);
+
+    Loader *loader = loader_create_stream(stream, 3, 2, true);
+    TEST_ASSERT_NOT_NULL(loader);
+
+    for (int epoch = 0; epoch < 2; epoch++) {
+        loader_start(loader, NULL);
+
+        int n = 0;
+        const LoaderBatch *batch;
+        while ((batch = loader_next(loader)) != NULL) {
+            for (int i = 0; i < batch->size; i++, n++) {
+                TEST_ASSERT_EQUAL_FLOAT((n * 2), batch->x[i * 2]);
+                TEST_ASSERT_EQUAL_INT((n % 3), batch->labels[i]);
+            }
+        }
+        TEST_ASSERT_EQUAL_INT(N_SAMPLES, n);
+    }
+
+    loader_free(&loader);
+    stream_close(&stream);
+
+    TEST_ASSERT_NULL(loader_create_stream(NULL, 3, 2, true));
+
+    remove_shards();
+}
+
+TEST(stream, stream_read_gzip)
+{
+    write_shards();
+
+    write_file(GZIP_IMAGE_FILE, GZIP_IMAGES, sizeof(GZIP_IMAGES));
+    write_file(GZIP_LABEL_FILE, GZIP_LABELS, sizeof(GZIP_LABELS));
+
+    // compressed and uncompressed shards are mixed
+    const char *image_files[] = { GZIP_IMAGE_FILE, IMAGE_FILES[1] };
+    const char *label_files[] = { GZIP_LABEL_FILE, LABEL_FILES[1] };
+
+    Stream *stream = stream_open(
+        image_files, label_files, 2, 3, SET_STREAM_PARAM(.shuffle_size=1, .scale=1.0f)
+    );
+    TEST_ASSERT_NOT_NULL(stream);
+    TEST_ASSERT_EQUAL_INT(N_SAMPLES, stream->size);
+
+    stream_rewind(stream);
+
+    float x[N_SAMPLES * 2];
+    int labels[N_SAMPLES];
+    TEST_ASSERT_EQUAL_INT(N_SAMPLES, stream_read(stream, N_SAMPLES, x, NULL, labels));
+    for (int i = 0; i < N_SAMPLES; i++) {
+        TEST_ASSERT_EQUAL_FLOAT((i * 2), x[i * 2]);
+        TEST_ASSERT_EQUAL_FLOAT((i * 2 + 1), x[i * 2 + 1]);
+        TEST_ASSERT_EQUAL_INT((i % 3), labels[i]);
+    }
+
+    stream_close(&stream);
+
+    remove(GZIP_IMAGE_FILE);
+    remove(GZIP_LABEL_FILE);
+    remove_shards();
+}
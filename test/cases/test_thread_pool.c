@@ -0,0 +1,81 @@
+/**
+ * @file test_thread_pool.c
+ * @brief unit tests of thread_pool.c
+ * 
+ */
+#include "thread_pool.h"
+
+#include "unity_fixture.h"
+
+TEST_GROUP(thread_pool);
+
+TEST_SETUP(thread_pool)
+{}
+
+TEST_TEAR_DOWN(thread_pool)
+{}
+
+/**
+ * @brief task to square an integer
+ * 
+ * @param arg pointer to integer
+ */
+static void square(void *arg)
+{
+    int *value = (int*)arg;
+    *value = (*value) * (*value);
+}
+
+TEST(thread_pool, thread_pool_create_and_free)
+{
+    ThreadPool *pool = thread_pool_create(4);
+
+    TEST_ASSERT_NOT_NULL(pool);
+
+    TEST_ASSERT_EQUAL_INT(4, pool->size);
+    TEST_ASSERT_EQUAL_INT(0, pool->count);
+    TEST_ASSERT_EQUAL_INT(0, pool->pending);
+
+    thread_pool_free(&pool);
+
+    TEST_ASSERT_NULL(pool);
+}
+
+TEST(thread_pool, thread_pool_create_invalid_size)
+{
+    TEST_ASSERT_NULL(thread_pool_create(0));
+}
+
+TEST(thread_pool, thread_pool_submit_and_wait)
+{
+#define N_TASKS 100
+
+    ThreadPool *pool = thread_pool_create(3);
+
+    int values[N_TASKS];
+    for (int i = 0; i < N_TASKS; i++) {
+        values[i] = i;
+        TEST_ASSERT_EQUAL_PTR(pool, thread_pool_submit(pool, square, &values[i]));
+    }
+
+    thread_pool_wait(pool);
+
+    TEST_ASSERT_EQUAL_INT(0, pool->pending);
+    for (int i = 0; i < N_TASKS; i++) {
+        TEST_ASSERT_EQUAL_INT((i * i), values[i]);
+    }
+
+    thread_pool_free(&pool);
+
+#undef N_TASKS
+}
+
+TEST(thread_pool, thread_pool_submit_null)
+{
+    ThreadPool *pool = thread_pool_create(1);
+
+    TEST_ASSERT_NULL(thread_pool_submit(pool, NULL, NULL));
+    TEST_ASSERT_NULL(thread_pool_submit(NULL, square, NULL));
+
+    thread_pool_free(&pool);
+}
@@ -0,0 +1,195 @@
+/**
+ * @file test_trace.c
+ * @brief unit tests of trace.c
+ * 
+ */
+#include "trace.h"
+
+#include <string.h>
+
+#include "thread_pool.h"
+
+#include "unity_fixture.h"
+
+TEST_GROUP(trace);
+
+TEST_SETUP(trace)
+{}
+
+TEST_TEAR_DOWN(trace)
+{
+    trace_free();
+}
+
+/**
+ * @brief read whole contents of stream
+ * 
+ * @param[in] fp stream
+ * @param[out] text buffer
+ * @param[in] size size of buffer
+ */
+static void read_all(FILE *fp, char *text, const size_t size)
+{
+    rewind(fp);
+    size_t n = fread(text, 1, (size - 1), fp);
+    text[n] = '\0';
+}
+
+/**
+ * @brief count occurrences of substring
+ * 
+ * @param[in] text text
+ * @param[in] pattern substring
+ * @return int num of occurrences
+ */
+static int count_of(const char *text, const char *pattern)
+{
+    int count = 0;
+    for (const char *p = strstr(text, pattern); p != NULL; p = strstr((p + 1), pattern)) {
+        count++;
+    }
+
+    return count;
+}
+
+/**
+ * @brief task to record an event
+ * 
+ * @param arg unused
+ */
+static void record_task(void *arg)
+{
+    (void)arg;
+
+    double start = trace_now();
+    trace_record(TRACE_CATEGORY_DATA, "batch", 1, start);
+}
+
+TEST(trace, trace_enable_invalid)
+{
+    TEST_ASSERT_EQUAL_INT(-1, trace_enable(NULL, 0));
+
+    // not enabled with a file
+    TEST_ASSERT_EQUAL_INT(-1, trace_dump());
+}
+
+TEST(trace, trace_record_and_write)
+{
+    TEST_ASSERT_EQUAL_INT(0, trace_enable(NULL, 16));
+
+    double start = trace_now();
+    TEST_ASSERT(start > 0);
+
+    trace_record(TRACE_CATEGORY_FORWARD, "fc", 0, start);
+    trace_record(TRACE_CATEGORY_TRAIN, "epoch", -1, start);
+
+    FILE *fp = tmpfile();
+    TEST_ASSERT_EQUAL_INT(2, trace_write(fp));
+
+    char text[4096];
+    read_all(fp, text, sizeof(text));
+
+    TEST_ASSERT_EQUAL_INT(0, strncmp(text, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [", 42));
+    TEST_ASSERT_NOT_NULL(strstr(text, "\"name\": \"thread_name\", \"ph\": \"M\""));
+    TEST_ASSERT_NOT_NULL(strstr(text, "{\"name\": \"fc\", \"cat\": \"forward\", \"ph\": \"X\""));
+    TEST_ASSERT_NOT_NULL(strstr(text, "\"args\": {\"id\": 0}"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "{\"name\": \"epoch\", \"cat\": \"train\", \"ph\": \"X\""));
+    TEST_ASSERT_EQUAL_INT(1, count_of(text, "\"args\": {\"id\""));
+
+    fclose(fp);
+}
+
+TEST(trace, trace_disable)
+{
+    TEST_ASSERT_EQUAL_INT(0, trace_enable(NULL, 16));
+
+    trace_record(TRACE_CATEGORY_FORWARD, "fc", 0, trace_now());
+
+    trace_disable();
+
+    // start time taken while disabled is ignored
+    TEST_ASSERT_EQUAL_FLOAT(0, trace_now());
+    trace_record(TRACE_CATEGORY_FORWARD, "fc", 0, 1.0);
+
+    FILE *fp = tmpfile();
+    TEST_ASSERT_EQUAL_INT(1, trace_write(fp));
+    fclose(fp);
+}
+
+TEST(trace, trace_ring_buffer)
+{
+    TEST_ASSERT_EQUAL_INT(0, trace_enable(NULL, 4));
+
+    for (int i = 0; i < 10; i++) {
+        trace_record(TRACE_CATEGORY_OPTIMIZER, "sgd", i, trace_now());
+    }
+
+    FILE *fp = tmpfile();
+    TEST_ASSERT_EQUAL_INT(4, trace_write(fp));
+
+    char text[4096];
+    read_all(fp, text, sizeof(text));
+
+    // only the latest events are kept
+    TEST_ASSERT_NULL(strstr(text, "\"args\": {\"id\": 5}"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "\"args\": {\"id\": 6}"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "\"args\": {\"id\": 9}"));
+
+    fclose(fp);
+}
+
+TEST(trace, trace_multi_thread)
+{
+    TEST_ASSERT_EQUAL_INT(0, trace_enable(NULL, 64));
+
+    ThreadPool *pool = thread_pool_create(4);
+
+    for (int i = 0; i < 32; i++) {
+        thread_pool_submit(pool, record_task, NULL);
+    }
+    thread_pool_wait(pool);
+
+    FILE *fp = tmpfile();
+    int count = trace_write(fp);
+
+    char text[16384];
+    read_all(fp, text, sizeof(text));
+
+    TEST_ASSERT_EQUAL_INT(32, count_of(text, "\"name\": \"batch\""));
+
+    // each worker thread has its own buffer
+    int n_threads = count_of(text, "\"thread_name\"");
+    TEST_ASSERT(n_threads >= 1);
+    TEST_ASSERT(n_threads <= 4);
+
+#ifdef NNC_TRACE
+    // pool tasks are traced by the library
+    TEST_ASSERT_EQUAL_INT(64, count);
+#else
+    TEST_ASSERT_EQUAL_INT(32, count);
+#endif
+
+    fclose(fp);
+    thread_pool_free(&pool);
+}
+
+TEST(trace, trace_dump)
+{
+    const char *filename = "trace_test.json";
+
+    TEST_ASSERT_EQUAL_INT(0, trace_enable(filename, 8));
+
+    trace_record(TRACE_CATEGORY_DATA, "batch", 0, trace_now());
+
+    TEST_ASSERT_EQUAL_INT(1, trace_dump());
+
+    FILE *fp = fopen(filename, "r");
+    TEST_ASSERT_NOT_NULL(fp);
+
+    char text[4096];
+    read_all(fp, text, sizeof(text));
+    TEST_ASSERT_NOT_NULL(strstr(text, "\"cat\": \"data\""));
+
+    fclose(fp);
+    remove(filename);
+}
@@ -3,6 +3,9 @@
  * @brief unit test of trainer.c
  * 
  */
+#include <stdio.h>
+#include <string.h>
+
 #include "data.h"
 #include "layers.h"
 #include "mat.h"
@@ -82,3 +85,967 @@ TEST(trainer, train_sgd)
 
     net_free(&net);
 }
+
+TEST(trainer, train_adam)
+{
+    rand_seed(0);
+
+    Net *net = net_create(
+        4,
+        (Layer*[]){
+            fc_layer((LayerParameter){ .in=2, .out=10 }),
+            sigmoid_layer((LayerParameter){ .in=10 }),
+            fc_layer((LayerParameter){ .in=10, .out=1 }),
+            sigmoid_layer((LayerParameter){ .in=1 })
+        }
+    );
+
+    net_init_layer_params(net);
+
+    float *x[] = {
+        (float[2]){ 0, 0 },
+        (float[2]){ 0, 1 },
+        (float[2]){ 1, 0 },
+        (float[2]){ 1, 1 },
+    };
+
+    float *t[] = {
+        (float[1]){ 0 },
+        (float[1]){ 1 },
+        (float[1]){ 1 },
+        (float[1]){ 0 }
+    };
+
+    Optimizer *optimizer = optimizer_create(
+        net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_ADAM, .learning_rate=0.02)
+    );
+
+    printf("\n");
+
+    TEST_ASSERT_EQUAL_INT(
+        0,
+        train(
+            net, x, t, NULL, NULL, 4, 0,
+            SET_TRAIN_PARAM(.epoch=200, .optimizer=optimizer, .loss_func=mean_squared_loss)
+        )
+    );
+
+    TEST_ASSERT_EQUAL_INT((200 * 4), optimizer->step);
+
+    // XOR is solved with Adam in the same epochs as SGD
+    for (int i = 0; i < 4; i++) {
+        net_forward(net, x[i]);
+        TEST_ASSERT_EQUAL_INT((int)t[i][0], (net->output_layer->y[0] > 0.5));
+    }
+
+    optimizer_free(&optimizer);
+    net_free(&net);
+}
+
+/**
+ * @brief calculate mean loss over data
+ * 
+ * @param[in,out] net target network
+ * @param[in] x array of data
+ * @param[in] t array of labels
+ * @param[in] size num of data
+ * @return float mean loss
+ */
+static float mean_loss(Net *net, float **x, float **t, const int size)
+{
+    float loss = 0;
+    for (int i = 0; i < size; i++) {
+        net_forward(net, x[i]);
+        loss += mean_squared_loss(net->output_layer->y, t[i], net->output_layer->y_size);
+    }
+
+    return loss / size;
+}
+
+TEST(trainer, train_hogwild)
+{
+    rand_seed(0);
+
+    Net *net = net_create(
+        4,
+        (Layer*[]){
+            fc_layer((LayerParameter){ .in=2, .out=10 }),
+            sigmoid_layer((LayerParameter){ .in=10 }),
+            fc_layer((LayerParameter){ .in=10, .out=1 }),
+            sigmoid_layer((LayerParameter){ .in=1 })
+        }
+    );
+
+    net_init_layer_params(net);
+
+    // XOR, repeated to give each thread several samples
+    float *x[16], *t[16];
+    float xs[4][2] = { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 } };
+    float ts[4][1] = { { 0 }, { 1 }, { 1 }, { 0 } };
+    for (int i = 0; i < 16; i++) {
+        x[i] = xs[i % 4];
+        t[i] = ts[i % 4];
+    }
+
+    float prev_loss = mean_loss(net, x, t, 16);
+
+    Optimizer *optimizer = optimizer_create(
+        net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_ADAM, .learning_rate=0.01)
+    );
+
+    printf("\n");
+
+    TEST_ASSERT_EQUAL_INT(
+        0,
+        train_hogwild(
+            net, x, t, NULL, NULL, 16, 0,
+            SET_TRAIN_PARAM(.epoch=100, .optimizer=optimizer, .loss_func=mean_squared_loss), 4
+        )
+    );
+
+    // steps and moments of threads are not merged into the given optimizer
+    TEST_ASSERT_EQUAL_INT(0, optimizer->step);
+
+    float loss = mean_loss(net, x, t, 16);
+
+    printf("loss: prev=%f, now=%f\n", prev_loss, loss);
+
+    TEST_ASSERT(loss < prev_loss);
+
+    // invalid num of threads
+    TEST_ASSERT_EQUAL_INT(
+        -1,
+        train_hogwild(
+            net, x, t, NULL, NULL, 16, 0,
+            SET_TRAIN_PARAM(.epoch=1, .optimizer=optimizer, .loss_func=mean_squared_loss), 0
+        )
+    );
+
+    optimizer_free(&optimizer);
+    net_free(&net);
+}
+
+/**
+ * @brief create network for XOR with initialized parameters
+ * 
+ * @return Net* pointer to network structure
+ */
+static Net *create_xor_net(void)
+{
+    rand_seed(0);
+
+    Net *net = net_create(
+        4,
+        (Layer*[]){
+            fc_layer((LayerParameter){ .in=2, .out=10 }),
+            sigmoid_layer((LayerParameter){ .in=10 }),
+            fc_layer((LayerParameter){ .in=10, .out=1 }),
+            sigmoid_layer((LayerParameter){ .in=1 })
+        }
+    );
+
+    net_init_layer_params(net);
+
+    return net;
+}
+
+/**
+ * @brief train XOR network with mini-batch updates
+ * 
+ * @param[in] data_parallel use train_data_parallel() if true, train() otherwise
+ * @param[in] batch_size batch size
+ * @param[in] accumulation num of micro-batches per update
+ * @param[in] n_threads num of threads
+ * @return Net* trained network
+ */
+static Net *train_xor(const bool data_parallel, const int batch_size, const int accumulation, const int n_threads)
+{
+    Net *net = create_xor_net();
+
+    // XOR, repeated to give each thread several samples
+    static float xs[4][2] = { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 } };
+    static float ts[4][1] = { { 0 }, { 1 }, { 1 }, { 0 } };
+    float *x[18], *t[18];
+    for (int i = 0; i < 18; i++) {
+        x[i] = xs[i % 4];
+        t[i] = ts[i % 4];
+    }
+
+    Optimizer *optimizer = optimizer_create(
+        net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_MOMENTUM, .learning_rate=0.1)
+    );
+
+    TrainParameter param = SET_TRAIN_PARAM(
+        .epoch=20, .batch_size=batch_size, .optimizer=optimizer, .loss_func=mean_squared_loss,
+        .accumulation=accumulation
+    );
+
+    rand_seed(1);
+    int ret = data_parallel ?
+        train_data_parallel(net, x, t, NULL, NULL, 18, 0, param, n_threads) :
+        train(net, x, t, NULL, NULL, 18, 0, param);
+    TEST_ASSERT_EQUAL_INT(0, ret);
+
+    optimizer_free(&optimizer);
+
+    return net;
+}
+
+/**
+ * @brief check that parameters of networks are bit-identical
+ * 
+ * @param[in] a network
+ * @param[in] b network
+ * @return true if identical
+ */
+static bool same_params(const Net *a, const Net *b)
+{
+    for (int i = 0; i < a->size; i++) {
+        const Layer *la = a->layers[i];
+        const Layer *lb = b->layers[i];
+        if ((la->w != NULL) && (memcmp(la->w, lb->w, (sizeof(float) * la->w_size)) != 0)) {
+            return false;
+        }
+        if ((la->b != NULL) && (memcmp(la->b, lb->b, (sizeof(float) * la->b_size)) != 0)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+TEST(trainer, train_data_parallel)
+{
+    printf("\n");
+
+    // batch size is not divisible by num of threads, last batch is partial
+    Net *net0 = train_xor(true, 8, 1, 3);
+    Net *net1 = train_xor(true, 8, 1, 3);
+
+    TEST_ASSERT(same_params(net0, net1));
+
+    // result with different num of threads is close but can differ in rounding
+    Net *net2 = train_xor(true, 8, 1, 2);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, net0->layers[2]->w[0], net2->layers[2]->w[0]);
+
+    net_free(&net0);
+    net_free(&net1);
+    net_free(&net2);
+
+    // same as sequential training with batch size 1
+    Net *seq = train_xor(false, 1, 1, 1);
+    Net *par = train_xor(true, 1, 1, 1);
+
+    TEST_ASSERT(same_params(seq, par));
+
+    net_free(&seq);
+    net_free(&par);
+}
+
+TEST(trainer, train_accumulation)
+{
+    printf("\n");
+
+    // micro-batches accumulated in replicas are same as a large batch
+    Net *batch = train_xor(true, 4, 1, 1);
+    Net *micro = train_xor(true, 1, 4, 1);
+
+    TEST_ASSERT(same_params(batch, micro));
+
+    // same as samples accumulated sequentially
+    Net *seq = train_xor(false, 0, 4, 1);
+
+    TEST_ASSERT(same_params(batch, seq));
+
+    // result with threads is close but can differ in rounding
+    Net *par = train_xor(true, 2, 3, 2);
+    Net *ref = train_xor(true, 6, 1, 1);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, ref->layers[2]->w[0], par->layers[2]->w[0]);
+
+    net_free(&batch);
+    net_free(&micro);
+    net_free(&seq);
+    net_free(&par);
+    net_free(&ref);
+}
+
+TEST(trainer, train_dataset)
+{
+    float *x[] = {
+        (float[2]){ 0, 0 },
+        (float[2]){ 0, 1 },
+        (float[2]){ 1, 0 },
+        (float[2]){ 1, 1 },
+    };
+
+    float *t[] = {
+        (float[1]){ 0 },
+        (float[1]){ 1 },
+        (float[1]){ 1 },
+        (float[1]){ 0 }
+    };
+
+    Dataset *dataset = dataset_from_arrays(x, t, 4, 2, 1);
+    TEST_ASSERT_NOT_NULL(dataset);
+
+    printf("\n");
+
+    // same result with contiguous dataset and arrays
+    Net *nets[2];
+    for (int i = 0; i < 2; i++) {
+        nets[i] = create_xor_net();
+
+        Optimizer *optimizer = optimizer_create(
+            nets[i], SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_SGD, .learning_rate=0.1)
+        );
+        TrainParameter param = SET_TRAIN_PARAM(.epoch=10, .optimizer=optimizer, .loss_func=mean_squared_loss);
+
+        rand_seed(1);
+        TEST_ASSERT_EQUAL_INT(
+            0,
+            (i == 0) ?
+                train_dataset(nets[i], dataset, dataset, param) :
+                train(nets[i], x, t, x, t, 4, 4, param)
+        );
+
+        optimizer_free(&optimizer);
+    }
+
+    TEST_ASSERT(same_params(nets[0], nets[1]));
+
+    // sizes mismatch to the network
+    Dataset wrong = dataset_wrap(x, t, 4, 1, 1);
+    Optimizer *optimizer = optimizer_create(
+        nets[0], SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_SGD, .learning_rate=0.1)
+    );
+    TrainParameter param = SET_TRAIN_PARAM(.epoch=1, .optimizer=optimizer, .loss_func=mean_squared_loss);
+
+    TEST_ASSERT_EQUAL_INT(-1, train_dataset(nets[0], &wrong, NULL, param));
+    TEST_ASSERT_EQUAL_INT(-1, train_dataset(nets[0], dataset, &wrong, param));
+    TEST_ASSERT_EQUAL_INT(-1, train_dataset(nets[0], NULL, NULL, param));
+    TEST_ASSERT_EQUAL_INT(-1, train_hogwild_dataset(nets[0], &wrong, NULL, param, 1));
+    TEST_ASSERT_EQUAL_INT(-1, train_data_parallel_dataset(nets[0], &wrong, NULL, param, 1));
+    TEST_ASSERT_EQUAL_INT(-1, train_distributed_dataset(nets[0], &wrong, NULL, param, NULL));
+
+    optimizer_free(&optimizer);
+
+    net_free(&nets[0]);
+    net_free(&nets[1]);
+    dataset_free(&dataset);
+}
+
+TEST(trainer, train_byte_dataset)
+{
+    // XOR of bytes, and labels of 2 classes
+    static const uint8_t images[] = { 0, 0, 0, 255, 255, 0, 255, 255 };
+    static const uint8_t labels[] = { 0, 1, 1, 0 };
+
+    IdxFile image_file = {
+        .type = IDX_TYPE_UBYTE, .n_dims = 2, .dims = { 4, 2 }, .size = 4, .item_size = 2, .data = images
+    };
+    IdxFile label_file = {
+        .type = IDX_TYPE_UBYTE, .n_dims = 1, .dims = { 4 }, .size = 4, .item_size = 1, .data = labels
+    };
+
+    Dataset *bytes = dataset_from_idx(&image_file, &label_file, 2);
+    TEST_ASSERT_NOT_NULL(bytes);
+
+    float *x[] = {
+        (float[2]){ 0, 0 },
+        (float[2]){ 0, 1 },
+        (float[2]){ 1, 0 },
+        (float[2]){ 1, 1 },
+    };
+
+    float *t[] = {
+        (float[2]){ 1, 0 },
+        (float[2]){ 0, 1 },
+        (float[2]){ 0, 1 },
+        (float[2]){ 1, 0 }
+    };
+
+    Dataset floats = dataset_wrap(x, t, 4, 2, 2);
+
+    printf("\n");
+
+    // bytes converted by the loader are the same as floats
+    Net *nets[2];
+    for (int i = 0; i < 2; i++) {
+        rand_seed(1);
+
+        nets[i] = net_create(
+            4,
+            (Layer*[]){
+                fc_layer((LayerParameter){ .in=2, .out=10 }),
+                sigmoid_layer((LayerParameter){ .in=10 }),
+                fc_layer((LayerParameter){ .in=10, .out=2 }),
+                sigmoid_layer((LayerParameter){ .in=2 })
+            }
+        );
+        TEST_ASSERT_NOT_NULL(nets[i]);
+        net_init_layer_params(nets[i]);
+
+        Optimizer *optimizer = optimizer_create(
+            nets[i], SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_SGD, .learning_rate=0.1)
+        );
+        TrainParameter param = SET_TRAIN_PARAM(
+            .epoch=10, .optimizer=optimizer, .loss_func=mean_squared_loss, .loss_mode=TRAIN_LOSS_FULL,
+            .prefetch=((i == 0) ? 0 : 1)
+        );
+
+        TEST_ASSERT_EQUAL_INT(
+            0,
+            (i == 0) ?
+                train_dataset(nets[i], bytes, bytes, param) :
+                train_dataset(nets[i], &floats, &floats, param)
+        );
+
+        optimizer_free(&optimizer);
+    }
+
+    TEST_ASSERT(same_params(nets[0], nets[1]));
+
+    // bytes are supported only by train_dataset()
+    Optimizer *optimizer = optimizer_create(
+        nets[0], SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_SGD, .learning_rate=0.1)
+    );
+    TrainParameter param = SET_TRAIN_PARAM(.epoch=1, .optimizer=optimizer, .loss_func=mean_squared_loss);
+
+    TEST_ASSERT_EQUAL_INT(-1, train_hogwild_dataset(nets[0], bytes, NULL, param, 1));
+    TEST_ASSERT_EQUAL_INT(-1, train_data_parallel_dataset(nets[0], &floats, bytes, param, 1));
+
+    optimizer_free(&optimizer);
+
+    net_free(&nets[0]);
+    net_free(&nets[1]);
+    dataset_free(&bytes);
+}
+
+TEST(trainer, train_stream)
+{
+    // XOR of bytes, and labels of 2 classes, in IDX files
+    static const uint8_t header_x[] = { 0, 0, 0x08, 2, 0, 0, 0, 4, 0, 0, 0, 2 };
+    static const uint8_t images[] = { 0, 0, 0, 255, 255, 0, 255, 255 };
+    static const uint8_t header_t[] = { 0, 0, 0x08, 1, 0, 0, 0, 4 };
+    static const uint8_t labels[] = { 0, 1, 1, 0 };
+
+    const char *image_files[] = { "test_trainer_x.idx" };
+    const char *label_files[] = { "test_trainer_t.idx" };
+
+    FILE *fp = fopen(image_files[0], "wb");
+    TEST_ASSERT_NOT_NULL(fp);
+    fwrite(header_x, 1, sizeof(header_x), fp);
+    fwrite(images, 1, sizeof(images), fp);
+    fclose(fp);
+
+    fp = fopen(label_files[0], "wb");
+    TEST_ASSERT_NOT_NULL(fp);
+    fwrite(header_t, 1, sizeof(header_t), fp);
+    fwrite(labels, 1, sizeof(labels), fp);
+    fclose(fp);
+
+    Stream *stream = stream_open(image_files, label_files, 1, 2, SET_STREAM_PARAM(.shuffle_size=4));
+    TEST_ASSERT_NOT_NULL(stream);
+
+    rand_seed(1);
+
+    Net *net = net_create(
+        4,
+        (Layer*[]){
+            fc_layer((LayerParameter){ .in=2, .out=10 }),
+            sigmoid_layer((LayerParameter){ .in=10 }),
+            fc_layer((LayerParameter){ .in=10, .out=2 }),
+            sigmoid_layer((LayerParameter){ .in=2 })
+        }
+    );
+    TEST_ASSERT_NOT_NULL(net);
+    net_init_layer_params(net);
+
+    Optimizer *optimizer = optimizer_create(
+        net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_SGD, .learning_rate=0.1)
+    );
+    TrainParameter param = SET_TRAIN_PARAM(
+        .epoch=10, .optimizer=optimizer, .loss_func=mean_squared_loss, .loss_mode=TRAIN_LOSS_FULL
+    );
+
+    printf("\n");
+
+    TEST_ASSERT_EQUAL_INT(0, train_stream(net, stream, NULL, param));
+
+    // shape of net must match samples of stream
+    Net *mismatched = net_create(
+        2,
+        (Layer*[]){
+            fc_layer((LayerParameter){ .in=2, .out=3 }),
+            sigmoid_layer((LayerParameter){ .in=3 })
+        }
+    );
+    TEST_ASSERT_NOT_NULL(mismatched);
+
+    TEST_ASSERT_EQUAL_INT(-1, train_stream(mismatched, stream, NULL, param));
+    TEST_ASSERT_EQUAL_INT(-1, train_stream(net, NULL, NULL, param));
+
+    // label out of range of classes stops training
+    static const uint8_t invalid[] = { 0, 1, 2, 0 };
+    fp = fopen(label_files[0], "wb");
+    TEST_ASSERT_NOT_NULL(fp);
+    fwrite(header_t, 1, sizeof(header_t), fp);
+    fwrite(invalid, 1, sizeof(invalid), fp);
+    fclose(fp);
+
+    TEST_ASSERT_EQUAL_INT(-1, train_stream(net, stream, NULL, param));
+
+    optimizer_free(&optimizer);
+    net_free(&mismatched);
+    net_free(&net);
+    stream_close(&stream);
+
+    remove(image_files[0]);
+    remove(label_files[0]);
+}
+
+TEST(trainer, train_sparse)
+{
+    // XOR of 4 inputs, where the first 2 of them are used
+    SparseMatrix *x = sparse_create(4, 4, 4);
+    TEST_ASSERT_NOT_NULL(x);
+    const int row_ptr[] = { 0, 0, 1, 2, 4 };
+    const int col_idx[] = { 1, 0, 0, 1 };
+    for (int i = 0; i < 5; i++) {
+        x->row_ptr[i] = row_ptr[i];
+    }
+    for (int i = 0; i < 4; i++) {
+        x->col_idx[i] = col_idx[i];
+        x->values[i]  = 1;
+    }
+    x->nnz = 4;
+    const int labels[] = { 0, 1, 1, 0 };
+
+    // dense copy of samples
+    float dense[4][4];
+    float *xs[4];
+    float *ts[4];
+    float onehot[4][2];
+    for (int i = 0; i < 4; i++) {
+        SparseMatrix row = sparse_row(x, i);
+        sparse_to_dense(&row, dense[i]);
+        onehot[i][0] = (labels[i] == 0) ? 1 : 0;
+        onehot[i][1] = (labels[i] == 1) ? 1 : 0;
+        xs[i] = dense[i];
+        ts[i] = onehot[i];
+    }
+
+    printf("\n");
+
+    // sparse samples are trained as dense ones
+    Net *nets[2];
+    for (int i = 0; i < 2; i++) {
+        rand_seed(1);
+
+        nets[i] = net_create(
+            3,
+            (Layer*[]){
+                fc_layer((LayerParameter){ .in=4, .out=10 }),
+                sigmoid_layer((LayerParameter){ .in=10 }),
+                fc_layer((LayerParameter){ .in=10, .out=2 })
+            }
+        );
+        TEST_ASSERT_NOT_NULL(nets[i]);
+        net_init_layer_params(nets[i]);
+
+        Optimizer *optimizer = optimizer_create(
+            nets[i], SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_SGD, .learning_rate=0.1)
+        );
+        TrainParameter param = SET_TRAIN_PARAM(
+            .epoch=10, .optimizer=optimizer, .loss_func=mean_squared_loss, .accumulation=2
+        );
+
+        if (i == 0) {
+            TEST_ASSERT_EQUAL_INT(0, train_sparse(nets[i], x, labels, x, labels, param));
+        } else {
+            TEST_ASSERT_EQUAL_INT(0, train(nets[i], xs, ts, xs, ts, 4, 4, param));
+        }
+
+        optimizer_free(&optimizer);
+    }
+
+    for (int i = 0; i < nets[0]->layers[0]->w_size; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-5, nets[1]->layers[0]->w[i], nets[0]->layers[0]->w[i]);
+    }
+    for (int i = 0; i < nets[0]->layers[2]->w_size; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-5, nets[1]->layers[2]->w[i], nets[0]->layers[2]->w[i]);
+    }
+
+    Optimizer *optimizer = optimizer_create(
+        nets[0], SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_SGD, .learning_rate=0.1)
+    );
+    TrainParameter param = SET_TRAIN_PARAM(.epoch=1, .optimizer=optimizer, .loss_func=mean_squared_loss);
+
+    // labels out of classes
+    TEST_ASSERT_EQUAL_INT(-1, train_sparse(nets[0], x, (int[]){ 0, 1, 2, 0 }, NULL, NULL, param));
+
+    // columns mismatched to the input
+    x->n_cols = 3;
+    TEST_ASSERT_EQUAL_INT(-1, train_sparse(nets[0], x, labels, NULL, NULL, param));
+    x->n_cols = 4;
+
+    optimizer_free(&optimizer);
+
+    net_free(&nets[0]);
+    net_free(&nets[1]);
+    sparse_free(&x);
+}
+
+TEST(trainer, train_prefetch)
+{
+    float *x[] = {
+        (float[2]){ 0, 0 },
+        (float[2]){ 0, 1 },
+        (float[2]){ 1, 0 },
+        (float[2]){ 1, 1 },
+        (float[2]){ 0, 1 },
+    };
+
+    float *t[] = {
+        (float[1]){ 0 },
+        (float[1]){ 1 },
+        (float[1]){ 1 },
+        (float[1]){ 0 },
+        (float[1]){ 1 }
+    };
+
+    printf("\n");
+
+    // same result with data read in place and gathered by loader
+    Net *nets[2];
+    for (int i = 0; i < 2; i++) {
+        nets[i] = create_xor_net();
+
+        Optimizer *optimizer = optimizer_create(
+            nets[i], SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_SGD, .learning_rate=0.1)
+        );
+
+        rand_seed(1);
+        TEST_ASSERT_EQUAL_INT(
+            0,
+            train(
+                nets[i], x, t, NULL, NULL, 5, 0,
+                SET_TRAIN_PARAM(
+                    .epoch=10, .batch_size=2, .optimizer=optimizer, .loss_func=mean_squared_loss,
+                    .prefetch=i
+                )
+            )
+        );
+        TEST_ASSERT_EQUAL_INT((10 * 5), optimizer->step);
+
+        optimizer_free(&optimizer);
+    }
+
+    TEST_ASSERT(same_params(nets[0], nets[1]));
+
+    net_free(&nets[0]);
+    net_free(&nets[1]);
+}
+
+TEST(trainer, train_augment)
+{
+    float *x[] = {
+        (float[2]){ 0, 0 },
+        (float[2]){ 0, 1 },
+        (float[2]){ 1, 0 },
+        (float[2]){ 1, 1 },
+        (float[2]){ 0, 1 },
+    };
+
+    float *t[] = {
+        (float[1]){ 0 },
+        (float[1]){ 1 },
+        (float[1]){ 1 },
+        (float[1]){ 0 },
+        (float[1]){ 1 }
+    };
+
+    printf("\n");
+
+    // a sample is a row of 2 pixels, kept by the identity and flipped at random
+    Augmenter *augmenters[] = {
+        NULL,
+        augmenter_create(SET_AUGMENT_PARAM(.height=1, .width=2)),
+        augmenter_create(SET_AUGMENT_PARAM(.height=1, .width=2, .flip=true, .seed=1, .n_threads=2))
+    };
+    TEST_ASSERT_NOT_NULL(augmenters[1]);
+    TEST_ASSERT_NOT_NULL(augmenters[2]);
+
+    // augmented in the loader thread even if prefetch is not set
+    Net *nets[3];
+    for (int i = 0; i < 3; i++) {
+        nets[i] = create_xor_net();
+
+        Optimizer *optimizer = optimizer_create(
+            nets[i], SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_SGD, .learning_rate=0.1)
+        );
+
+        rand_seed(1);
+        TEST_ASSERT_EQUAL_INT(
+            0,
+            train(
+                nets[i], x, t, NULL, NULL, 5, 0,
+                SET_TRAIN_PARAM(
+                    .epoch=10, .batch_size=2, .optimizer=optimizer, .loss_func=mean_squared_loss,
+                    .augmenter=augmenters[i]
+                )
+            )
+        );
+        TEST_ASSERT_EQUAL_INT((10 * 5), optimizer->step);
+
+        optimizer_free(&optimizer);
+    }
+
+    TEST_ASSERT(same_params(nets[0], nets[1]));
+    TEST_ASSERT_FALSE(same_params(nets[0], nets[2]));
+
+    // augmenter of another shape
+    Augmenter *mismatched = augmenter_create(SET_AUGMENT_PARAM(.height=1, .width=3));
+    Optimizer *optimizer = optimizer_create(
+        nets[0], SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_SGD, .learning_rate=0.1)
+    );
+    TEST_ASSERT_EQUAL_INT(
+        -1,
+        train(
+            nets[0], x, t, NULL, NULL, 5, 0,
+            SET_TRAIN_PARAM(.epoch=1, .optimizer=optimizer, .loss_func=mean_squared_loss, .augmenter=mismatched)
+        )
+    );
+
+    optimizer_free(&optimizer);
+    augmenter_free(&mismatched);
+    for (int i = 0; i < 3; i++) {
+        augmenter_free(&augmenters[i]);
+        net_free(&nets[i]);
+    }
+}
+
+TEST(trainer, train_checkpoint)
+{
+    float *x[] = {
+        (float[2]){ 0, 0 },
+        (float[2]){ 0, 1 },
+        (float[2]){ 1, 0 },
+        (float[2]){ 1, 1 },
+    };
+
+    float *t[] = {
+        (float[1]){ 0 },
+        (float[1]){ 1 },
+        (float[1]){ 1 },
+        (float[1]){ 0 }
+    };
+
+    printf("\n");
+
+    Net *net = create_xor_net();
+    Optimizer *optimizer = optimizer_create(
+        net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_ADAM, .learning_rate=0.01)
+    );
+    Checkpointer *checkpointer = checkpointer_create("test_train_checkpoint.bin");
+    TEST_ASSERT_NOT_NULL(checkpointer);
+
+    // snapshots after the 2nd and the last epochs
+    rand_seed(1);
+    TEST_ASSERT_EQUAL_INT(
+        0,
+        train(
+            net, x, t, NULL, NULL, 4, 0,
+            SET_TRAIN_PARAM(
+                .epoch=3, .optimizer=optimizer, .loss_func=mean_squared_loss,
+                .checkpointer=checkpointer, .checkpoint_interval=2
+            )
+        )
+    );
+    TEST_ASSERT_EQUAL_INT(2, checkpointer->written);
+
+    // training is resumed exactly from the last checkpoint
+    Net *resumed = net_load("test_train_checkpoint.bin");
+    TEST_ASSERT_NOT_NULL(resumed);
+    Optimizer *resumed_optimizer = optimizer_load(resumed, "test_train_checkpoint.bin");
+    TEST_ASSERT_NOT_NULL(resumed_optimizer);
+    TEST_ASSERT_EQUAL_INT(optimizer->step, resumed_optimizer->step);
+    TEST_ASSERT(same_params(net, resumed));
+
+    rand_seed(2);
+    train(net, x, t, NULL, NULL, 4, 0, SET_TRAIN_PARAM(.epoch=2, .optimizer=optimizer, .loss_func=mean_squared_loss));
+    rand_seed(2);
+    train(
+        resumed, x, t, NULL, NULL, 4, 0,
+        SET_TRAIN_PARAM(.epoch=2, .optimizer=resumed_optimizer, .loss_func=mean_squared_loss)
+    );
+    TEST_ASSERT(same_params(net, resumed));
+
+    // a failed write fails training
+    checkpointer_free(&checkpointer);
+    checkpointer = checkpointer_create("no_such_dir/test_train_checkpoint.bin");
+    TEST_ASSERT_EQUAL_INT(
+        -1,
+        train(
+            net, x, t, NULL, NULL, 4, 0,
+            SET_TRAIN_PARAM(.epoch=1, .optimizer=optimizer, .loss_func=mean_squared_loss, .checkpointer=checkpointer)
+        )
+    );
+
+    checkpointer_free(&checkpointer);
+    optimizer_free(&resumed_optimizer);
+    optimizer_free(&optimizer);
+    net_free(&resumed);
+    net_free(&net);
+
+    remove("test_train_checkpoint.bin");
+}
+
+TEST(trainer, train_loss_mode)
+{
+    float *x[] = {
+        (float[2]){ 0, 0 },
+        (float[2]){ 0, 1 },
+        (float[2]){ 1, 0 },
+        (float[2]){ 1, 1 },
+    };
+
+    float *t[] = {
+        (float[1]){ 0 },
+        (float[1]){ 1 },
+        (float[1]){ 1 },
+        (float[1]){ 0 }
+    };
+
+    printf("\n");
+
+    // evaluation after each epoch does not affect training
+    const TrainLossMode modes[] = { TRAIN_LOSS_RUNNING, TRAIN_LOSS_SAMPLED, TRAIN_LOSS_FULL, TRAIN_LOSS_FULL };
+    const int eval_threads[]    = { 0, 0, 1, 3 };
+
+    Net *nets[4];
+    for (int i = 0; i < 4; i++) {
+        nets[i] = create_xor_net();
+
+        Optimizer *optimizer = optimizer_create(
+            nets[i], SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_SGD, .learning_rate=0.1)
+        );
+
+        rand_seed(1);
+        TEST_ASSERT_EQUAL_INT(
+            0,
+            train(
+                nets[i], x, t, NULL, NULL, 4, 0,
+                SET_TRAIN_PARAM(
+                    .epoch=5, .optimizer=optimizer, .loss_func=mean_squared_loss,
+                    .loss_mode=modes[i], .loss_samples=2, .eval_threads=eval_threads[i]
+                )
+            )
+        );
+
+        optimizer_free(&optimizer);
+    }
+
+    for (int i = 1; i < 4; i++) {
+        TEST_ASSERT(same_params(nets[0], nets[i]));
+    }
+
+    for (int i = 0; i < 4; i++) {
+        net_free(&nets[i]);
+    }
+}
+
+/**
+ * @brief train XOR network in a process and check that all replicas are identical
+ * 
+ * @param[in] param configuration of the process group
+ * @param[in] arg unused
+ * @return int 0 if succeeded
+ */
+static int train_distributed_func(const DistParameter param, void *arg)
+{
+    (void)arg;
+
+    Dist *dist = dist_create(param);
+    if (dist == NULL) {
+        return 1;
+    }
+
+    // different initial parameters in each process are replaced with those of rank 0
+    rand_seed(param.rank + 1);
+    Net *net = net_create(
+        4,
+        (Layer*[]){
+            fc_layer((LayerParameter){ .in=2, .out=10 }),
+            sigmoid_layer((LayerParameter){ .in=10 }),
+            fc_layer((LayerParameter){ .in=10, .out=1 }),
+            sigmoid_layer((LayerParameter){ .in=1 })
+        }
+    );
+    net_init_layer_params(net);
+
+    static float xs[4][2] = { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 } };
+    static float ts[4][1] = { { 0 }, { 1 }, { 1 }, { 0 } };
+    float *x[18], *t[18];
+    for (int i = 0; i < 18; i++) {
+        x[i] = xs[i % 4];
+        t[i] = ts[i % 4];
+    }
+
+    Optimizer *optimizer = optimizer_create(
+        net, SET_OPTIMIZER_PARAM(.type=OPTIMIZER_TYPE_MOMENTUM, .learning_rate=0.1)
+    );
+
+    // same random state to shuffle
+    rand_seed(1);
+    int ret = train_distributed(
+        net, x, t, NULL, NULL, 18, 0,
+        SET_TRAIN_PARAM(.epoch=20, .batch_size=8, .optimizer=optimizer, .loss_func=mean_squared_loss),
+        dist
+    );
+
+    // sum of the same values over processes is exactly the multiple
+    Layer *fc = net->layers[2];
+    float w[10];
+    fdata_copy(fc->w, 10, w);
+    if ((ret != 0) || (dist_allreduce(dist, w, 10) != 0)) {
+        ret = 1;
+    }
+    for (int i = 0; i < 10; i++) {
+        if (w[i] != (fc->w[i] * param.world_size)) {
+            ret = 1;
+        }
+    }
+
+    optimizer_free(&optimizer);
+    net_free(&net);
+    dist_free(&dist);
+
+    return ret;
+}
+
+TEST(trainer, train_distributed)
+{
+    printf("\n");
+
+    TEST_ASSERT_EQUAL_INT(
+        0, dist_launch(SET_DIST_PARAM(.world_size=3), train_distributed_func, NULL)
+    );
+}
+
+TEST(trainer, train_invalid)
+{
+    float *x[] = { (float[2]){ 0, 0 } };
+    float *t[] = { (float[1]){ 0 } };
+
+    Net *net = net_create(1, (Layer*[]){ fc_layer((LayerParameter){ .in=2, .out=1 }) });
+
+    // no optimizer
+    TEST_ASSERT_EQUAL_INT(
+        -1, train(net, x, t, NULL, NULL, 1, 0, SET_TRAIN_PARAM(.epoch=1, .loss_func=mean_squared_loss))
+    );
+
+    net_free(&net);
+}
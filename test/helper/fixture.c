@@ -0,0 +1,20 @@
+/**
+ * @file fixture.c
+ * @brief fixtures shared by unit tests
+ * 
+ */
+#include "fixture.h"
+
+#include <stdio.h>
+
+#include "unity_fixture.h"
+
+void write_file(const char *filename, const uint8_t *bytes, const size_t size)
+{
+    FILE *fp = fopen(filename, "wb");
+    TEST_ASSERT_NOT_NULL(fp);
+
+    TEST_ASSERT_EQUAL_INT(size, fwrite(bytes, 1, size, fp));
+
+    fclose(fp);
+}
@@ -0,0 +1,21 @@
+/**
+ * @file fixture.h
+ * @brief fixtures shared by unit tests
+ * 
+ */
+#ifndef FIXTURE_H
+#define FIXTURE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief write bytes to file
+ * 
+ * @param[in] filename path of file
+ * @param[in] bytes bytes to be written
+ * @param[in] size num of bytes
+ */
+void write_file(const char *filename, const uint8_t *bytes, const size_t size);
+
+#endif // FIXTURE_H
@@ -9,12 +9,36 @@ static void RunAllTests(void)
 {
     RUN_TEST_GROUP(data);
 
+    RUN_TEST_GROUP(inflate);
+
+    RUN_TEST_GROUP(idx);
+
+    RUN_TEST_GROUP(dataset);
+
+    RUN_TEST_GROUP(cache);
+
     RUN_TEST_GROUP(util);
 
     RUN_TEST_GROUP(random);
 
+    RUN_TEST_GROUP(thread_pool);
+
+    RUN_TEST_GROUP(profile);
+
+    RUN_TEST_GROUP(trace);
+
+    RUN_TEST_GROUP(dist);
+
+    RUN_TEST_GROUP(stream);
+
+    RUN_TEST_GROUP(augment);
+
+    RUN_TEST_GROUP(loader);
+
     RUN_TEST_GROUP(mat);
 
+    RUN_TEST_GROUP(sparse);
+
     RUN_TEST_GROUP(layer);
 
     RUN_TEST_GROUP(fc);
@@ -23,10 +47,26 @@ static void RunAllTests(void)
 
     RUN_TEST_GROUP(softmax);
 
+    RUN_TEST_GROUP(relu);
+
+    RUN_TEST_GROUP(add);
+
+    RUN_TEST_GROUP(concat);
+
+    RUN_TEST_GROUP(split);
+
+    RUN_TEST_GROUP(fused);
+
     RUN_TEST_GROUP(net);
 
+    RUN_TEST_GROUP(export);
+
+    RUN_TEST_GROUP(checkpoint);
+
     RUN_TEST_GROUP(loss);
 
+    RUN_TEST_GROUP(optimizer);
+
     RUN_TEST_GROUP(trainer);
 }
 
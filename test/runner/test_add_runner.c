@@ -0,0 +1,17 @@
+/**
+ * @file test_add_runner.c
+ * @brief test runner of add.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(add)
+{
+    RUN_TEST_CASE(add, add_layer_and_free);
+
+    RUN_TEST_CASE(add, add_layer_invalid_param);
+
+    RUN_TEST_CASE(add, add_forward);
+
+    RUN_TEST_CASE(add, add_backward);
+}
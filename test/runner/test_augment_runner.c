@@ -0,0 +1,23 @@
+/**
+ * @file test_augment_runner.c
+ * @brief test runner of augment.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(augment)
+{
+    RUN_TEST_CASE(augment, augmenter_create_and_free);
+
+    RUN_TEST_CASE(augment, augmenter_create_invalid);
+
+    RUN_TEST_CASE(augment, augment_identity);
+
+    RUN_TEST_CASE(augment, augment_shift);
+
+    RUN_TEST_CASE(augment, augment_flip);
+
+    RUN_TEST_CASE(augment, augment_rotation_and_crop);
+
+    RUN_TEST_CASE(augment, augment_reproducible);
+}
@@ -0,0 +1,19 @@
+/**
+ * @file test_cache_runner.c
+ * @brief test runner of cache.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(cache)
+{
+    RUN_TEST_CASE(cache, cache_build_and_open);
+
+    RUN_TEST_CASE(cache, cache_class_labels);
+
+    RUN_TEST_CASE(cache, cache_build_invalid);
+
+    RUN_TEST_CASE(cache, cache_open_invalid);
+
+    RUN_TEST_CASE(cache, cache_load);
+}
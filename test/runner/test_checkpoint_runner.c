@@ -0,0 +1,23 @@
+/**
+ * @file test_checkpoint_runner.c
+ * @brief test runner of checkpoint.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(checkpoint)
+{
+    RUN_TEST_CASE(checkpoint, net_save_and_load);
+
+    RUN_TEST_CASE(checkpoint, net_load_mmap);
+
+    RUN_TEST_CASE(checkpoint, net_save_with_optimizer);
+
+    RUN_TEST_CASE(checkpoint, optimizer_load_invalid);
+
+    RUN_TEST_CASE(checkpoint, checkpointer_snapshot);
+
+    RUN_TEST_CASE(checkpoint, net_save_invalid);
+
+    RUN_TEST_CASE(checkpoint, net_load_invalid);
+}
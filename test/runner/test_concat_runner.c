@@ -0,0 +1,17 @@
+/**
+ * @file test_concat_runner.c
+ * @brief test runner of concat.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(concat)
+{
+    RUN_TEST_CASE(concat, concat_layer_and_free);
+
+    RUN_TEST_CASE(concat, concat_layer_invalid_param);
+
+    RUN_TEST_CASE(concat, concat_forward);
+
+    RUN_TEST_CASE(concat, concat_backward);
+}
@@ -8,9 +8,12 @@
 TEST_GROUP_RUNNER(data)
 {
     RUN_TEST_CASE(data, fdata_alloc);
+    RUN_TEST_CASE(data, fdata_alloc_aligned);
 
     RUN_TEST_CASE(data, fdata_copy);
 
+    RUN_TEST_CASE(data, fdata_from_bytes);
+
     RUN_TEST_CASE(data, fdata_rand_uniform);
     RUN_TEST_CASE(data, fdata_rand_norm);
 }
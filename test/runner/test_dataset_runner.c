@@ -0,0 +1,25 @@
+/**
+ * @file test_dataset_runner.c
+ * @brief test runner of dataset.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(dataset)
+{
+    RUN_TEST_CASE(dataset, dataset_create_and_free);
+
+    RUN_TEST_CASE(dataset, dataset_from_arrays);
+
+    RUN_TEST_CASE(dataset, dataset_wrap);
+
+    RUN_TEST_CASE(dataset, dataset_view);
+
+    RUN_TEST_CASE(dataset, dataset_from_idx);
+
+    RUN_TEST_CASE(dataset, dataset_gather);
+
+    RUN_TEST_CASE(dataset, dataset_create_bytes);
+
+    RUN_TEST_CASE(dataset, dataset_check_labels);
+}
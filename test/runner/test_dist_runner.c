@@ -0,0 +1,31 @@
+/**
+ * @file test_dist_runner.c
+ * @brief test runner of dist.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(dist)
+{
+    RUN_TEST_CASE(dist, dist_create_invalid);
+
+    RUN_TEST_CASE(dist, dist_single_process);
+
+    RUN_TEST_CASE(dist, dist_allreduce_shm);
+
+    RUN_TEST_CASE(dist, dist_allreduce_socket);
+
+    RUN_TEST_CASE(dist, dist_allreduce_two_processes);
+
+    RUN_TEST_CASE(dist, dist_broadcast);
+
+    RUN_TEST_CASE(dist, dist_peer_timeout);
+
+    RUN_TEST_CASE(dist, dist_launch_affinity);
+
+    RUN_TEST_CASE(dist, dist_launch_failure);
+
+    RUN_TEST_CASE(dist, dist_launch_other_child);
+
+    RUN_TEST_CASE(dist, dist_param_from_env);
+}
@@ -0,0 +1,17 @@
+/**
+ * @file test_export_runner.c
+ * @brief test runner of export.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(export)
+{
+    RUN_TEST_CASE(export, net_export_c);
+
+    RUN_TEST_CASE(export, net_export_c_fused_graph);
+
+    RUN_TEST_CASE(export, net_export_c_parity);
+
+    RUN_TEST_CASE(export, net_export_c_invalid);
+}
@@ -11,6 +11,8 @@ TEST_GROUP_RUNNER(fc)
 
     RUN_TEST_CASE(fc, fc_layer_invalid_param);
 
+    RUN_TEST_CASE(fc, fc_cost);
+
     RUN_TEST_CASE(fc, fc_forward);
 
     RUN_TEST_CASE(fc, fc_backward);
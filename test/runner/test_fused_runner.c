@@ -0,0 +1,19 @@
+/**
+ * @file test_fused_runner.c
+ * @brief test runner of fused.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(fused)
+{
+    RUN_TEST_CASE(fused, fc_sigmoid_layer);
+
+    RUN_TEST_CASE(fused, fc_relu_layer);
+
+    RUN_TEST_CASE(fused, fc_softmax_layer);
+
+    RUN_TEST_CASE(fused, sigmoid_softmax_layer);
+
+    RUN_TEST_CASE(fused, fused_layer_invalid_param);
+}
@@ -0,0 +1,21 @@
+/**
+ * @file test_idx_runner.c
+ * @brief test runner of idx.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(idx)
+{
+    RUN_TEST_CASE(idx, idx_type_size);
+
+    RUN_TEST_CASE(idx, idx_open_images);
+
+    RUN_TEST_CASE(idx, idx_open_labels);
+
+    RUN_TEST_CASE(idx, idx_open_gzip);
+
+    RUN_TEST_CASE(idx, idx_read_header);
+
+    RUN_TEST_CASE(idx, idx_open_invalid);
+}
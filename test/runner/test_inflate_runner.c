@@ -0,0 +1,21 @@
+/**
+ * @file test_inflate_runner.c
+ * @brief test runner of inflate.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(inflate)
+{
+    RUN_TEST_CASE(inflate, gzip_check);
+
+    RUN_TEST_CASE(inflate, inflater_read_fixed);
+
+    RUN_TEST_CASE(inflate, inflater_read_stored);
+
+    RUN_TEST_CASE(inflate, inflater_read_dynamic);
+
+    RUN_TEST_CASE(inflate, inflater_read_members);
+
+    RUN_TEST_CASE(inflate, inflater_read_corrupted);
+}
@@ -8,4 +8,6 @@
 TEST_GROUP_RUNNER(layer)
 {
     RUN_TEST_CASE(layer, layer_alloc_and_free);
+
+    RUN_TEST_CASE(layer, layer_type_name);
 }
@@ -0,0 +1,21 @@
+/**
+ * @file test_loader_runner.c
+ * @brief test runner of loader.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(loader)
+{
+    RUN_TEST_CASE(loader, loader_create_and_free);
+
+    RUN_TEST_CASE(loader, loader_create_invalid);
+
+    RUN_TEST_CASE(loader, loader_next);
+
+    RUN_TEST_CASE(loader, loader_restart);
+
+    RUN_TEST_CASE(loader, loader_class_labels);
+
+    RUN_TEST_CASE(loader, loader_augment);
+}
@@ -10,4 +10,10 @@ TEST_GROUP_RUNNER(loss)
     RUN_TEST_CASE(loss, mean_squared_loss);
 
     RUN_TEST_CASE(loss, cross_entropy_loss);
+
+    RUN_TEST_CASE(loss, mean_squared_loss_label);
+
+    RUN_TEST_CASE(loss, cross_entropy_loss_label);
+
+    RUN_TEST_CASE(loss, loss_label_func);
 }
@@ -26,6 +26,7 @@ TEST_GROUP_RUNNER(mat)
     RUN_TEST_CASE(mat, test_mat_mul_trans_a);
     RUN_TEST_CASE(mat, test_mat_mul_trans_a_invalid_sizes);
     RUN_TEST_CASE(mat, test_mat_mul_trans_a_null);
+    RUN_TEST_CASE(mat, test_mat_mul_trans_a_acc);
 
     RUN_TEST_CASE(mat, test_mat_mul_trans_b);
     RUN_TEST_CASE(mat, test_mat_mul_trans_b_invalid_sizes);
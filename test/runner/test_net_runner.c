@@ -11,15 +11,49 @@ TEST_GROUP_RUNNER(net)
 
     RUN_TEST_CASE(net, net_create_and_free);
 
-    RUN_TEST_CASE(net, net_create_over_size);
+    RUN_TEST_CASE(net, net_create_invalid_size);
+
+    RUN_TEST_CASE(net, net_create_many_layers);
 
     RUN_TEST_CASE(net, net_append);
 
     RUN_TEST_CASE(net, net_append_null);
 
+    RUN_TEST_CASE(net, net_connect_invalid);
+
     RUN_TEST_CASE(net, net_init_layer_params);
 
     RUN_TEST_CASE(net, net_forward);
 
     RUN_TEST_CASE(net, net_backward);
+
+    RUN_TEST_CASE(net, net_backward_label);
+
+    RUN_TEST_CASE(net, net_residual);
+
+    RUN_TEST_CASE(net, net_concat_and_split);
+
+    RUN_TEST_CASE(net, net_shared_input);
+
+    RUN_TEST_CASE(net, net_split_ports_to_one_consumer);
+
+    RUN_TEST_CASE(net, net_schedule_levels);
+
+    RUN_TEST_CASE(net, net_parallel_branches);
+
+    RUN_TEST_CASE(net, net_optimize);
+
+    RUN_TEST_CASE(net, net_optimize_branch);
+
+    RUN_TEST_CASE(net, net_profile_report);
+
+    RUN_TEST_CASE(net, net_replicate);
+
+    RUN_TEST_CASE(net, net_evaluate);
+
+    RUN_TEST_CASE(net, evaluator_run);
+
+    RUN_TEST_CASE(net, net_accumulate);
+
+    RUN_TEST_CASE(net, net_forward_sparse);
 }
@@ -0,0 +1,31 @@
+/**
+ * @file test_optimizer_runner.c
+ * @brief test runner of optimizer.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(optimizer)
+{
+    RUN_TEST_CASE(optimizer, optimizer_create_and_free);
+
+    RUN_TEST_CASE(optimizer, optimizer_create_invalid);
+
+    RUN_TEST_CASE(optimizer, optimizer_type_name);
+
+    RUN_TEST_CASE(optimizer, optimizer_step_sgd);
+
+    RUN_TEST_CASE(optimizer, optimizer_step_momentum);
+
+    RUN_TEST_CASE(optimizer, optimizer_step_nesterov);
+
+    RUN_TEST_CASE(optimizer, optimizer_step_adam);
+
+    RUN_TEST_CASE(optimizer, optimizer_step_adamw);
+
+    RUN_TEST_CASE(optimizer, optimizer_step_adamw_no_decay);
+
+    RUN_TEST_CASE(optimizer, optimizer_step_momentum_zero);
+
+    RUN_TEST_CASE(optimizer, optimizer_step_sparse_rows);
+}
@@ -0,0 +1,19 @@
+/**
+ * @file test_profile_runner.c
+ * @brief test runner of profile.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(profile)
+{
+    RUN_TEST_CASE(profile, profile_now);
+
+    RUN_TEST_CASE(profile, profile_stat_add);
+
+    RUN_TEST_CASE(profile, profile_stat_add_since);
+
+    RUN_TEST_CASE(profile, profile_counter_name);
+
+    RUN_TEST_CASE(profile, profile_sample_thread_exit);
+}
@@ -12,4 +12,10 @@ TEST_GROUP_RUNNER(random)
     RUN_TEST_CASE(random, get_rand_xorshift_with_diff_seed);
 
     RUN_TEST_CASE(random, get_rand_uniform);
+
+    RUN_TEST_CASE(random, get_rand_range);
+
+    RUN_TEST_CASE(random, rand_shuffle);
+
+    RUN_TEST_CASE(random, rand_block_shuffle);
 }
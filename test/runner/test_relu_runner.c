@@ -0,0 +1,17 @@
+/**
+ * @file test_relu_runner.c
+ * @brief test runner of relu.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(relu)
+{
+    RUN_TEST_CASE(relu, relu_layer_and_free);
+
+    RUN_TEST_CASE(relu, relu_layer_invalid_param);
+
+    RUN_TEST_CASE(relu, relu_forward);
+
+    RUN_TEST_CASE(relu, relu_backward);
+}
@@ -13,5 +13,7 @@ TEST_GROUP_RUNNER(softmax)
 
     RUN_TEST_CASE(softmax, softmax_forward);
 
+    RUN_TEST_CASE(softmax, softmax_forward_large_input);
+
     RUN_TEST_CASE(softmax, softmax_backward);
 }
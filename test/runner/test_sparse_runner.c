@@ -0,0 +1,21 @@
+/**
+ * @file test_sparse_runner.c
+ * @brief test runner of sparse.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(sparse)
+{
+    RUN_TEST_CASE(sparse, sparse_create_and_free);
+
+    RUN_TEST_CASE(sparse, sparse_row_and_to_dense);
+
+    RUN_TEST_CASE(sparse, sparse_mat_mul);
+
+    RUN_TEST_CASE(sparse, sparse_mat_mul_trans_a_acc);
+
+    RUN_TEST_CASE(sparse, sparse_load_libsvm);
+
+    RUN_TEST_CASE(sparse, sparse_load_libsvm_invalid);
+}
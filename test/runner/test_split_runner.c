@@ -0,0 +1,17 @@
+/**
+ * @file test_split_runner.c
+ * @brief test runner of split.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(split)
+{
+    RUN_TEST_CASE(split, split_layer_and_free);
+
+    RUN_TEST_CASE(split, split_layer_invalid_param);
+
+    RUN_TEST_CASE(split, split_forward);
+
+    RUN_TEST_CASE(split, split_backward);
+}
@@ -0,0 +1,23 @@
+/**
+ * @file test_stream_runner.c
+ * @brief test runner of stream.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(stream)
+{
+    RUN_TEST_CASE(stream, stream_open_and_close);
+
+    RUN_TEST_CASE(stream, stream_open_invalid);
+
+    RUN_TEST_CASE(stream, stream_read_in_order);
+
+    RUN_TEST_CASE(stream, stream_read_shuffled);
+
+    RUN_TEST_CASE(stream, stream_read_gzip);
+
+    RUN_TEST_CASE(stream, stream_read_failure);
+
+    RUN_TEST_CASE(stream, loader_create_stream);
+}
@@ -0,0 +1,17 @@
+/**
+ * @file test_thread_pool_runner.c
+ * @brief test runner of thread_pool.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(thread_pool)
+{
+    RUN_TEST_CASE(thread_pool, thread_pool_create_and_free);
+
+    RUN_TEST_CASE(thread_pool, thread_pool_create_invalid_size);
+
+    RUN_TEST_CASE(thread_pool, thread_pool_submit_and_wait);
+
+    RUN_TEST_CASE(thread_pool, thread_pool_submit_null);
+}
@@ -0,0 +1,21 @@
+/**
+ * @file test_trace_runner.c
+ * @brief test runner of trace.c
+ * 
+ */
+#include "unity_fixture.h"
+
+TEST_GROUP_RUNNER(trace)
+{
+    RUN_TEST_CASE(trace, trace_enable_invalid);
+
+    RUN_TEST_CASE(trace, trace_record_and_write);
+
+    RUN_TEST_CASE(trace, trace_disable);
+
+    RUN_TEST_CASE(trace, trace_ring_buffer);
+
+    RUN_TEST_CASE(trace, trace_multi_thread);
+
+    RUN_TEST_CASE(trace, trace_dump);
+}
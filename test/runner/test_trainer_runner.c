@@ -8,4 +8,32 @@
 TEST_GROUP_RUNNER(trainer)
 {
     RUN_TEST_CASE(trainer, train_sgd);
+
+    RUN_TEST_CASE(trainer, train_adam);
+
+    RUN_TEST_CASE(trainer, train_hogwild);
+
+    RUN_TEST_CASE(trainer, train_data_parallel);
+
+    RUN_TEST_CASE(trainer, train_accumulation);
+
+    RUN_TEST_CASE(trainer, train_dataset);
+
+    RUN_TEST_CASE(trainer, train_byte_dataset);
+
+    RUN_TEST_CASE(trainer, train_stream);
+
+    RUN_TEST_CASE(trainer, train_sparse);
+
+    RUN_TEST_CASE(trainer, train_prefetch);
+
+    RUN_TEST_CASE(trainer, train_augment);
+
+    RUN_TEST_CASE(trainer, train_checkpoint);
+
+    RUN_TEST_CASE(trainer, train_loss_mode);
+
+    RUN_TEST_CASE(trainer, train_distributed);
+
+    RUN_TEST_CASE(trainer, train_invalid);
 }